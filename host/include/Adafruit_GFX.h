@@ -0,0 +1,53 @@
+// Adafruit_GFX.h
+// Host HAL: the drawing subset of Adafruit GFX the display code uses.
+// Text is drawn in the library's 6x8 cell, but glyphs are derived from
+// the character code rather than the real font: frames differ where the
+// text differs, which is what traffic measurements need. The same calls
+// are virtual as in the library, so a backend can count or redirect them.
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h);
+    
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    
+    virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    virtual void fillScreen(uint16_t color);
+    void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+    
+    void setCursor(int16_t x, int16_t y) { _cursorX = x; _cursorY = y; }
+    void setTextSize(uint8_t size) { _textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t color) { _textColor = color; }
+    void setTextWrap(bool wrap) { _wrap = wrap; }
+    int16_t getCursorX() const { return _cursorX; }
+    int16_t getCursorY() const { return _cursorY; }
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+    
+    using Print::write;
+    size_t write(uint8_t c) override;
+
+protected:
+    int16_t _width;
+    int16_t _height;
+
+private:
+    int16_t _cursorX;
+    int16_t _cursorY;
+    uint8_t _textSize;
+    uint16_t _textColor;
+    bool _wrap;
+    
+    void drawChar(int16_t x, int16_t y, uint8_t c);
+};
+
+#endif // HOST_ADAFRUIT_GFX_H
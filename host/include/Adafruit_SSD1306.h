@@ -0,0 +1,49 @@
+// Adafruit_SSD1306.h
+// Host HAL: SSD1306 frame buffer (same page layout as the panel) that
+// talks to the host Wire like the library does: display() sends the
+// whole buffer, commands go one transaction each.
+#ifndef HOST_ADAFRUIT_SSD1306_H
+#define HOST_ADAFRUIT_SSD1306_H
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_MEMORYMODE 0x20
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t rst,
+                     uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL);
+    ~Adafruit_SSD1306();
+    
+    bool begin(uint8_t vcs = SSD1306_SWITCHCAPVCC, uint8_t addr = 0, bool reset = true,
+               bool periphBegin = true);
+    void display();
+    void clearDisplay();
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void ssd1306_command(uint8_t c);
+    void dim(bool dim);
+    void invertDisplay(bool invert);
+    uint8_t* getBuffer() { return _buffer; }
+
+private:
+    TwoWire* _wire;
+    uint8_t _address;
+    uint32_t _clkDuring;
+    uint32_t _clkAfter;
+    uint8_t* _buffer;
+    
+    void sendCommands(const uint8_t* commands, size_t count);
+};
+
+#endif // HOST_ADAFRUIT_SSD1306_H
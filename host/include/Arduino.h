@@ -0,0 +1,206 @@
+// Arduino.h
+// Host HAL: the subset of the Arduino core used by the firmware core,
+// implemented for Linux (native build only; see host_hal.h).
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+    return value < (T)low ? (T)low : (value > (T)high ? (T)high : value);
+}
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+inline bool isAlphaNumeric(char c) { return isDigit(c) || isAlpha(c); }
+inline bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+// ==================== CLOCK ====================
+// Simulated: starts at 0 and only moves through delay() / HostHal
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// ==================== GPIO ====================
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeoutUs = 1000000UL);
+
+// Called from digitalWrite() / HostHal::setPinLevel() on a matching edge
+typedef void (*voidFuncPtrArg)(void*);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterruptArg(uint8_t pin, voidFuncPtrArg handler, void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// ==================== CRITICAL SECTIONS ====================
+// The host build is single-threaded
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+// ==================== STRING ====================
+class String {
+public:
+    String() {}
+    String(const char* str) : _s(str ? str : "") {}
+    String(const std::string& str) : _s(str) {}
+    explicit String(char c) : _s(1, c) {}
+    String(int value) : _s(std::to_string(value)) {}
+    String(unsigned int value) : _s(std::to_string(value)) {}
+    String(long value) : _s(std::to_string(value)) {}
+    String(unsigned long value) : _s(std::to_string(value)) {}
+    String(long long value) : _s(std::to_string(value)) {}
+    String(unsigned long long value) : _s(std::to_string(value)) {}
+    String(float value, unsigned int decimals = 2) { setFloat(value, decimals); }
+    String(double value, unsigned int decimals = 2) { setFloat(value, decimals); }
+    
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    
+    char charAt(unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    
+    bool concat(const String& str) { _s += str._s; return true; }
+    bool concat(const char* str) { if (str) _s += str; return true; }
+    bool concat(char c) { _s += c; return true; }
+    bool concat(const char* str, unsigned int len) { _s.append(str, len); return true; }
+    String& operator+=(const String& str) { concat(str); return *this; }
+    String& operator+=(const char* str) { concat(str); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    
+    bool equals(const String& str) const { return _s == str._s; }
+    bool operator==(const String& str) const { return _s == str._s; }
+    bool operator==(const char* str) const { return _s == (str ? str : ""); }
+    bool operator!=(const String& str) const { return _s != str._s; }
+    bool operator!=(const char* str) const { return !(*this == str); }
+    bool operator<(const String& str) const { return _s < str._s; }
+    
+    int indexOf(char c, unsigned int from = 0) const { return find(_s.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return find(_s.find(str._s, from)); }
+    int lastIndexOf(char c) const { return find(_s.rfind(c)); }
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return _s.size() >= suffix._s.size() &&
+               _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+    }
+    
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= _s.size()) return String();
+        return String(_s.substr(from, to - from));
+    }
+    
+    void remove(unsigned int index) { if (index < _s.size()) _s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < _s.size()) _s.erase(index, count); }
+    void replace(const String& from, const String& to);
+    void trim();
+    void toUpperCase();
+    void toLowerCase();
+    
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return (float)atof(_s.c_str()); }
+    double toDouble() const { return atof(_s.c_str()); }
+
+private:
+    std::string _s;
+    
+    static int find(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+    void setFloat(double value, unsigned int decimals);
+    
+    friend String operator+(const String& lhs, const String& rhs);
+};
+
+inline String operator+(const String& lhs, const String& rhs) { return String(lhs._s + rhs._s); }
+inline String operator+(const String& lhs, const char* rhs) { return lhs + String(rhs); }
+inline String operator+(const char* lhs, const String& rhs) { return String(lhs) + rhs; }
+inline String operator+(const String& lhs, char rhs) { String s(lhs); s += rhs; return s; }
+
+// ==================== SERIAL ====================
+#define DEC 10
+#define HEX 16
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+    
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+    size_t println() { return write((const uint8_t*)"\n", 1); }
+    
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    operator bool() const { return true; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// ==================== SYSTEM ====================
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getFreePsram() { return 0; }
+    uint32_t getHeapSize() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    void restart();
+};
+
+extern EspClass ESP;
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,52 @@
+// FS.h
+// Host HAL file system: the subset of the ESP32 FS / File API the
+// firmware uses, over in-memory files shared by every handle.
+// HostHal::clearFiles() simulates a freshly formatted partition.
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class File {
+public:
+    File();
+    
+    size_t write(const uint8_t* buffer, size_t size);
+    size_t read(uint8_t* buffer, size_t size);
+    int available();
+    bool seek(uint32_t pos);
+    size_t position() const { return _pos; }
+    size_t size() const;
+    void close();
+    
+    operator bool() const { return _data != nullptr; }
+
+private:
+    friend class FS;
+    std::vector<uint8_t>* _data;
+    size_t _pos;
+    bool _writable;
+};
+
+class FS {
+public:
+    bool begin(bool formatOnFail = false);
+    
+    // Modes "r", "w" (truncate) and "a" (append)
+    File open(const char* path, const char* mode = "r");
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    
+    size_t totalBytes();
+    size_t usedBytes();
+    
+    // Every file (HostHal::clearFiles)
+    static std::map<std::string, std::vector<uint8_t> >& files();
+};
+
+#endif // HOST_FS_H
@@ -0,0 +1,69 @@
+// Preferences.h
+// Host HAL key-value store: the ESP32 Preferences (NVS) API over an
+// in-memory map shared by every handle, so data survives end()/begin()
+// like flash does. HostHal::clearPreferences() simulates an erased chip.
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+    Preferences();
+    ~Preferences();
+    
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+    size_t freeEntries();
+    
+    size_t putBool(const char* key, bool value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putULong(const char* key, uint32_t value);
+    size_t putFloat(const char* key, float value);
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+    
+    bool getBool(const char* key, bool defaultValue = false);
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = NAN);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLen);
+
+private:
+    typedef std::vector<uint8_t> Blob;
+    typedef std::map<std::string, Blob> Namespace;
+    
+    Namespace* _ns;
+    bool _readOnly;
+    
+    size_t put(const char* key, const void* value, size_t len);
+    const Blob* get(const char* key);
+    
+    template <typename T>
+    T getValue(const char* key, T defaultValue) {
+        const Blob* blob = get(key);
+        if (!blob || blob->size() != sizeof(T)) return defaultValue;
+        T value;
+        memcpy(&value, blob->data(), sizeof(T));
+        return value;
+    }
+    
+    friend class HostHal;
+    static std::map<std::string, Namespace>& store();
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,10 @@
+// SPIFFS.h
+// Host HAL: SPIFFS is the in-memory file system from FS.h
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+
+#include "FS.h"
+
+extern FS SPIFFS;
+
+#endif // HOST_SPIFFS_H
@@ -0,0 +1,57 @@
+// Wire.h
+// Host HAL I2C bus: transactions and bytes (including the address byte)
+// are counted so display traffic can be measured (see --bench-display in
+// host_main.cpp). A device model can be attached to one address; it gets
+// each completed write transaction (see Ssd1306Panel).
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+#define I2C_BUFFER_LENGTH 128     // As in the ESP32 core
+
+class HostI2cDevice {
+public:
+    virtual ~HostI2cDevice() {}
+    virtual void receive(const uint8_t* data, size_t length) = 0;
+};
+
+class TwoWire {
+public:
+    TwoWire();
+    
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void setClock(uint32_t frequency);
+    uint32_t getClock() const { return _clock; }
+    
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t size);
+    
+    // Device model for address (host only; nullptr = detach)
+    void attach(uint8_t address, HostI2cDevice* device);
+    
+    // Statistics (host only)
+    uint32_t getTransactions() const { return _transactions; }
+    uint32_t getBytes() const { return _bytes; }
+    uint32_t getOverflows() const { return _overflows; }    // Writes past I2C_BUFFER_LENGTH
+    double getBusMs() const { return _busMs; }               // At the clock of each transaction
+    void resetCounters();
+
+private:
+    uint32_t _clock;
+    size_t _pending;              // Bytes in the open transaction
+    uint8_t _address;
+    uint8_t _buffer[I2C_BUFFER_LENGTH];
+    HostI2cDevice* _device;
+    uint8_t _deviceAddress;
+    uint32_t _transactions;
+    uint32_t _bytes;
+    uint32_t _overflows;
+    double _busMs;
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,95 @@
+// analytics_bench.h
+// WaterTracker's usage analytics against synthetic traces with a known
+// answer, on the host HAL's simulated clock.
+//
+// Draw segmentation: household draws of every DrawCategory, with known
+// start, volume and rate, are played into DrawEventSegmenter as the
+// per-reading outflow WaterTracker feeds it, and the events it logs are
+// matched against them (missed, merged, spurious, volume error, category).
+//
+// Demand profile: hourly usage drawn from a known weekday x hour pattern
+// (Poisson count of exponential draws, so each slot's true mean and
+// spread are known) is fed to DemandProfile week after week; the profile
+// is compared with the pattern, and with itself after a save and reload.
+#ifndef ANALYTICS_BENCH_H
+#define ANALYTICS_BENCH_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include "demand_profile.h"
+#include "draw_event_segmenter.h"
+
+struct SegmenterCase {
+    std::string name;
+    int draws;                    // Synthetic draws played
+    int events;                   // Events the segmenter logged
+    int matched;                  // Draws found as an event of their own
+    int merged;                   // Draws folded into a neighbour's event
+    int missed;                   // Draws with no event
+    int spurious;                 // Events with no draw
+    float volumeErrorPct;         // Mean |error| of matched events
+    float categoryPct;            // Matched events classified as their draw
+    double nsPerSample;
+};
+
+struct ProfileRun {
+    double nsPerUsage;            // addUsage()
+    double nsPerLoop;             // loop() within an hour
+    double nsPerFold;             // loop() at the hour change, saves included
+    std::vector<float> weekErrorPct;   // Mean |expected - true| / true mean, after each week
+    float floorErrorPct;          // The same error expected from the EWMA's own noise
+    float stdErrorPct;            // Mean |std - true std| / true std, last week
+    int shiftWeeks;               // Weeks for a moved peak to reach 80 % (-1 = never)
+    float restoreErrorL;          // Largest slot difference after save() + begin()
+    size_t storedBytes;
+};
+
+class AnalyticsBench {
+public:
+    AnalyticsBench(int draws, uint32_t seed = 1);
+    
+    // Exact per-reading flow, flow booked in deadband-sized lumps as the
+    // idle tracker does, sensor noise between draws, and draws that pause
+    // for less than DRAW_EVENT_GAP_MS
+    std::vector<SegmenterCase> segmenter();
+    
+    // Weeks of a steady pattern, then the weekday morning peak moves an
+    // hour earlier
+    ProfileRun profile(int weeks);
+
+private:
+    enum TraceKind {
+        TRACE_EXACT,
+        TRACE_LUMPS,
+        TRACE_NOISE,
+        TRACE_PAUSES
+    };
+    
+    // A draw at a steady rate, optionally paused once in the middle
+    struct Draw {
+        uint64_t startMs;
+        uint64_t pauseMs;         // == resumeMs when there is no pause
+        uint64_t resumeMs;
+        uint64_t endMs;
+        float rateLpm;
+        float liters;
+        DrawCategory category;
+    };
+    
+    int _draws;
+    uint32_t _seed;
+    std::mt19937 _rng;
+    
+    float uniform(float low, float high);
+    std::vector<Draw> makeDraws(int count, bool pauses);
+    static float drawnBetween(const Draw& draw, uint64_t fromMs, uint64_t toMs);
+    SegmenterCase playSegmenter(const char* name, TraceKind kind);
+    float hourLiters(float mean);
+    static float patternMean(int slot, bool shifted);
+    static float patternStdDev(int slot, bool shifted);
+    float profileErrorPct(const DemandProfile& profile, bool shifted);
+    float stdDevErrorPct(const DemandProfile& profile);
+};
+
+#endif // ANALYTICS_BENCH_H
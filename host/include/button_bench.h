@@ -0,0 +1,90 @@
+// button_bench.h
+// Synthetic button input for ButtonHandler on the host HAL. Presses with
+// contact bounce on both edges are played into the pins (the interrupt
+// handler runs on every edge, as on the ESP32) while loop() runs every
+// few milliseconds, or stalls while several presses happen. Each press
+// lists the events it should produce and from when they are knowable
+// (e.g. the first release edge for a click); the events getEvent()
+// returns are matched against them for loss, spurious events and
+// input-to-event latency.
+#ifndef BUTTON_BENCH_H
+#define BUTTON_BENCH_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include "button_handler.h"
+
+struct ButtonBenchCase {
+    std::string name;
+    int expected;
+    int received;
+    int lost;                     // Expected, never delivered
+    int spurious;                 // Delivered, not expected (or too early)
+    float latencyP50Ms;
+    float latencyP99Ms;
+    float latencyMaxMs;
+};
+
+struct ButtonBenchReport {
+    std::vector<ButtonBenchCase> cases;
+    uint32_t droppedEdges;        // Edge ring overflows, all cases
+    uint32_t droppedEvents;
+    int lost;
+    int spurious;
+};
+
+class ButtonBench {
+public:
+    // presses per case (long presses: a tenth of that)
+    ButtonBench(int presses, uint32_t seed = 1);
+    
+    ButtonBenchReport run();
+
+private:
+    struct PinChange {
+        uint64_t timeUs;
+        uint8_t pin;
+        uint8_t level;
+    };
+    
+    struct Expected {
+        ButtonEvent event;
+        uint64_t readyUs;         // Earliest the event can be known
+        bool optional;            // Neither lost nor spurious (repeat at the release)
+        bool matched;
+    };
+    
+    // Edges of one press (each transition bounces)
+    struct Press {
+        uint64_t firstDown;
+        uint64_t lastDown;
+        uint64_t firstUp;
+        uint64_t lastUp;
+    };
+    
+    int _presses;
+    uint32_t _seed;
+    
+    std::vector<PinChange> _changes;
+    std::vector<Expected> _expected;
+    std::vector<std::pair<uint64_t, uint64_t> > _stalls;    // loop() not run in [first, second)
+    std::mt19937 _rng;
+    
+    void clear();
+    uint32_t random(uint32_t low, uint32_t high);
+    uint64_t bounce(uint64_t at, uint8_t pin, uint8_t level);
+    Press press(uint64_t at, uint8_t pin, uint64_t holdUs);
+    void expect(ButtonEvent event, uint64_t readyUs, bool optional = false);
+    
+    void buildClicks(uint8_t pin, ButtonEvent event);
+    void buildStalledClicks();
+    void buildDoubleClicks();
+    void buildLongPresses();
+    void buildRepeats();
+    void buildGlitches();
+    
+    ButtonBenchCase play(const char* name, ButtonBenchReport& report);
+};
+
+#endif // BUTTON_BENCH_H
@@ -0,0 +1,10 @@
+// esp_timer.h
+// Host HAL: the ESP-IDF microsecond clock, on the simulated clock
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,62 @@
+// event_bus_bench.h
+// EventBus cost, and the refreshes it saves in a simulated run.
+//
+// Cost: the firmware's subscriber layout (level: pump control, tracker,
+// snapshot/display, trend; pump: tracker, snapshot/display, telemetry)
+// with empty handlers, timed on the host clock for one event published
+// and dispatched, a full ring, and a pass with nothing queued.
+//
+// Updates: a scenario runs through TankSimulator with main.cpp's
+// snapshot/display subscribers attached. Before the bus, every loop pass
+// called WaterTracker::updateState() and rebuilt the web snapshot, and
+// every display tick rebuilt DisplayData; now each runs per event, and
+// the display only on ticks where an event marked it dirty.
+#ifndef EVENT_BUS_BENCH_H
+#define EVENT_BUS_BENCH_H
+
+#include <stdint.h>
+#include "event_bus.h"
+#include "sim_scenario.h"
+
+struct EventBusCost {
+    double nsPerLevelEvent;       // publish() + dispatch() to four subscribers
+    double nsPerPumpEvent;        // publish() + dispatch() to three subscribers
+    double nsPerDelivery;         // Level event cost per subscriber
+    double nsPerBurstEvent;       // Per event, ring filled then dispatched once
+    double nsPerIdleDispatch;
+};
+
+struct EventBusUpdates {
+    unsigned long passes;
+    uint32_t levelEvents;
+    uint32_t pumpEvents;
+    uint64_t trackerBefore;       // updateState() on every pass
+    uint64_t trackerAfter;        // Tracker handler per level or pump event
+    uint64_t snapshotBefore;
+    uint64_t snapshotAfter;
+    uint64_t displayBefore;       // Every DISPLAY_UPDATE_INTERVAL_MS tick
+    uint64_t displayAfter;        // Ticks with the dirty flag set
+    uint64_t eliminated;
+};
+
+class EventBusBench {
+public:
+    EventBusCost cost();
+    EventBusUpdates updates(const SimScenario& scenario);
+
+private:
+    struct Counters {
+        uint32_t level;
+        uint32_t pump;
+        uint32_t snapshots;
+        uint32_t displayRefreshes;
+        unsigned long lastDirtyTick;
+    };
+    
+    static void onLevel(const LevelEvent& evt, void* context);
+    static void onPump(const PumpEvent& evt, void* context);
+    static void markChanged(Counters* counters);
+    static void subscribe(EventBus& bus, void* context);
+};
+
+#endif // EVENT_BUS_BENCH_H
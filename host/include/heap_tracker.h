@@ -0,0 +1,52 @@
+// heap_tracker.h
+// Tracking allocator for the native build.
+//
+// Global operator new/delete are replaced (host/src/heap_tracker.cpp);
+// while tracking is on, every allocation is counted and also placed in a
+// model of the device heap: a first-fit arena of HOST_HEAP_ARENA_BYTES
+// with the ESP32 allocator's per-block overhead. The model only tracks
+// offsets (the memory itself comes from the host's malloc), so its
+// largest free block and fragmentation follow the firmware's allocation
+// pattern the way the device heap would, not glibc's.
+//
+// The HAL's in-memory NVS and SPIFFS stand in for flash and are not
+// counted. Host String is std::string, whose short-string buffer avoids
+// allocations the ESP32 String would make; rates here are a lower bound.
+#ifndef HEAP_TRACKER_H
+#define HEAP_TRACKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOST_HEAP_ARENA_BYTES (256 * 1024)     // Free DRAM after boot, roughly
+#define HOST_HEAP_BLOCK_OVERHEAD 8             // Allocator header per block
+#define HOST_HEAP_MAX_FREE_RANGES 8192
+
+struct HeapStats {
+    uint64_t allocations;         // Since start()
+    uint64_t frees;
+    uint64_t bytesAllocated;      // Requested, cumulative
+    size_t liveBytes;             // Requested, outstanding
+    size_t liveBlocks;
+    size_t peakBytes;
+    size_t arenaFree;             // Model: free bytes
+    size_t largestFree;           // Model: largest free block
+    float fragmentationPct;       // Model: 100 * (1 - largest / free)
+    uint32_t outOfMemory;         // Model: allocations that did not fit
+};
+
+class HeapTracker {
+public:
+    // Count allocations from now on (resets statistics and the model)
+    static void start();
+    static void stop();
+    
+    // Suspend while the harness itself allocates (nests; blocks freed
+    // meanwhile are still returned to the model)
+    static void pause();
+    static void resume();
+    
+    static HeapStats getStats();
+};
+
+#endif // HEAP_TRACKER_H
@@ -0,0 +1,44 @@
+// host_cloud_link.h
+// Host HAL network client: records what SyncManager sends instead of
+// talking to a server. Tests flip setOnline() and feed replies through
+// SyncManager::onCloudConfigReceived() / onPushComplete().
+#ifndef HOST_CLOUD_LINK_H
+#define HOST_CLOUD_LINK_H
+
+#include "cloud_link.h"
+
+class HostCloudLink : public CloudLink {
+public:
+    HostCloudLink() : _online(false), _accept(true), _pushCount(0), _pullCount(0) {}
+    
+    bool isOnline() override { return _online; }
+    
+    bool sendConfig(const TankConfig& config) override {
+        if (!_accept) return false;
+        _lastPushed = config;
+        _pushCount++;
+        return true;
+    }
+    
+    bool requestConfig() override {
+        if (!_accept) return false;
+        _pullCount++;
+        return true;
+    }
+    
+    void setOnline(bool online) { _online = online; }
+    void setAcceptRequests(bool accept) { _accept = accept; }   // false = outbox full
+    
+    int getPushCount() const { return _pushCount; }
+    int getPullCount() const { return _pullCount; }
+    const TankConfig& getLastPushed() const { return _lastPushed; }
+
+private:
+    bool _online;
+    bool _accept;
+    int _pushCount;
+    int _pullCount;
+    TankConfig _lastPushed;
+};
+
+#endif // HOST_CLOUD_LINK_H
@@ -0,0 +1,74 @@
+// host_hal.h
+// Native build HAL.
+//
+// On the ESP32 the firmware core talks to hardware through the Arduino
+// core (clock, GPIO, pulse timing), Preferences (key-value store), SPIFFS
+// (files) and CloudLink (network client, implemented by NetworkWorker).
+// The native env swaps in host/include for the first three and
+// HostCloudLink for the last, so PumpController, TankCalculator,
+// WaterTracker, StorageManager, SyncManager and TraceRecorder compile
+// unchanged on Linux.
+//
+// Time is simulated: millis()/micros() start at 0 and advance only
+// through delay() or advanceMillis(); time() is linked to the same clock
+// (-Wl,--wrap=time) so calendar rollovers follow simulated days. Both
+// return unsigned long, so on an ILP32 build (env:soak) they wrap at
+// 2^32 exactly like the ESP32's; uptimeMs() never wraps and is what a
+// harness should schedule on.
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+
+class HostHal {
+public:
+    typedef unsigned long (*PulseSource)(uint8_t pin, void* context);
+    
+    // Clock
+    static void advanceMillis(unsigned long ms);
+    static void advanceMicros(uint64_t us);
+    static void setEpoch(time_t epoch);     // Wall clock at the current millis()
+    static uint64_t uptimeMs();             // Since reset(), never wraps
+    
+    // GPIO (level last written by the firmware, or set by the test; a change
+    // runs the pin's attachInterruptArg() handler)
+    static int getPinLevel(uint8_t pin);
+    static void setPinLevel(uint8_t pin, int level);
+    static uint8_t getPinMode(uint8_t pin);
+    
+    // pulseIn() result for a pin (us, 0 = timeout)
+    static void setPulseWidth(uint8_t pin, unsigned long us);
+    
+    // Called for every pulseIn() instead, e.g. by a plant model (nullptr = off)
+    static void setPulseSource(PulseSource source, void* context);
+    
+    // Key-value store and files
+    static void clearPreferences();
+    static void clearFiles();
+    
+    // Key-value lookups (get*, getBytesLength) and bytes found, since start
+    static uint32_t getNvsReads();
+    static uint32_t getNvsReadBytes();
+    
+    // Key-value writes (put*, remove, clear) that reached the store
+    static uint32_t getNvsWrites();
+    
+    // Power cut: after `writes` more writes the store ignores the rest and
+    // put*/remove fail, until the budget is set back to -1 (the default)
+    static void setNvsWriteBudget(long writes);
+    
+    // The whole key-value store, to return to a saved state or compare
+    typedef std::map<std::string, std::map<std::string, std::vector<uint8_t> > > NvsImage;
+    static NvsImage getNvs();
+    static void setNvs(const NvsImage& image);
+    
+    // Serial output to stdout (on by default)
+    static void setSerialEcho(bool enabled);
+    
+    // Back to power-on state: clock 0, pins low, store and files kept
+    static void reset();
+};
+
+#endif // HOST_HAL_H
@@ -0,0 +1,74 @@
+// memory_display.h
+// Host display backend: a 128x64 monochrome panel in memory. It counts
+// the drawing calls the screens make and keeps what the windows sent so
+// far would show, which can be saved as PBM or PNG and compared with
+// reference images. Pass it to the DisplayManager constructor.
+#ifndef MEMORY_DISPLAY_H
+#define MEMORY_DISPLAY_H
+
+#include "display_backend.h"
+
+// Calls made by the display code; a call made inside another one (the
+// pixels of a line, the lines of a rectangle) is not counted again
+struct DrawStats {
+    uint32_t pixels;              // drawPixel
+    uint32_t lines;               // drawLine
+    uint32_t hlines;              // drawFastHLine
+    uint32_t vlines;              // drawFastVLine
+    uint32_t rects;               // drawRect
+    uint32_t fills;               // fillRect, fillScreen
+    uint32_t chars;               // Characters printed
+    uint32_t clears;              // clear() of the whole frame
+    uint32_t pixelsWritten;       // Every pixel set, cleared or inverted
+    uint32_t windows;             // sendWindow
+    uint32_t bytesSent;           // Frame bytes in those windows
+};
+
+class MemoryDisplay : public Adafruit_GFX, public DisplayBackend {
+public:
+    MemoryDisplay();
+    
+    // DisplayBackend
+    bool begin() override;
+    Adafruit_GFX& gfx() override { return *this; }
+    uint8_t* getBuffer() override { return _frame; }
+    void clear() override;
+    void sendWindow(const DirtyWindow& window) override;
+    void setContrast(uint8_t contrast) override { _contrast = contrast; }
+    
+    // Adafruit_GFX, counted
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    using Print::write;
+    size_t write(uint8_t c) override;
+    
+    const DrawStats& getStats() const { return _stats; }
+    void resetStats();
+    
+    // The panel as the windows sent so far left it
+    bool getPixel(int x, int y) const;
+    const uint8_t* getShown() const { return _shown; }
+    uint8_t getContrast() const { return _contrast; }
+    
+    // Binary PBM (P4) and 1-bit grayscale PNG, lit pixels black
+    bool writePbm(const char* path) const;
+    bool writePng(const char* path) const;
+    
+    // Pixels that differ from a PBM saved by writePbm(); -1 = unreadable
+    // or another size
+    int comparePbm(const char* path) const;
+
+private:
+    uint8_t _frame[DISPLAY_BUFFER_SIZE];
+    uint8_t _shown[DISPLAY_BUFFER_SIZE];
+    uint8_t _contrast;
+    DrawStats _stats;
+    int _depth;                   // Counted calls in progress
+};
+
+#endif // MEMORY_DISPLAY_H
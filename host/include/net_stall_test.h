@@ -0,0 +1,60 @@
+// net_stall_test.h
+// The network worker's queueing on real host threads, against a network
+// that stalls for seconds at a time.
+//
+// The control loop runs every NET_STALL_LOOP_MS of wall time, posts a
+// telemetry request each NET_STALL_POST_MS into an SpscQueue outbox of
+// NET_OUTBOX_SIZE and drains an inbox of NET_INBOX_SIZE, as NetworkWorker
+// does on the device. A worker thread takes the requests and "sends" them:
+// a few ms normally, or blocked until the network comes back when a stall
+// is in progress (a 2 s and a 5 s outage). The same schedule is then run
+// with the send inline on the loop, as before the worker existed. Every
+// request carries a sequence number, so drops, duplicates and reordering
+// through the queues are counted rather than assumed.
+#ifndef NET_STALL_TEST_H
+#define NET_STALL_TEST_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+struct NetStallRun {
+    int passes;
+    double maxLateMs;             // Loop pass start behind its schedule
+    double p99LateMs;
+    double maxPassUs;             // Post + dispatch time of one pass
+    uint32_t posted;
+    uint32_t dropped;             // Outbox full (counted, as on the device)
+    uint32_t sent;
+    uint32_t results;             // Results dispatched back on the loop
+    uint32_t orderErrors;         // Repeated or reordered items, or totals that don't add up
+};
+
+struct NetStallReport {
+    NetStallRun worker;
+    NetStallRun inline_;
+};
+
+class NetStallTest {
+public:
+    explicit NetStallTest(int seconds);
+    
+    NetStallReport run();
+
+private:
+    struct Request {
+        uint32_t seq;
+        String text;              // Owns heap memory, moved out of the slot like NetRequest
+    };
+    
+    struct Result {
+        uint32_t seq;
+        bool ok;
+    };
+    
+    int _seconds;
+    
+    NetStallRun runLoop(bool threaded);
+    static double stallRemainingMs(double atMs);
+};
+
+#endif // NET_STALL_TEST_H
@@ -0,0 +1,60 @@
+// power_cut_test.h
+// Power cuts at every NVS write of StorageManager's multi-key saves.
+//
+// Each case starts from a fixed stored state, runs one save on a
+// StorageManager that has already booted, and counts the writes it makes.
+// The save is then repeated with the power cut after 0, 1, ... of those
+// writes (HostHal::setNvsWriteBudget), and the device reboots: a new
+// StorageManager whose begin() replays or discards the journal. What the
+// rebooted device reads back must be exactly the old state or exactly the
+// new one, and no journal may be left behind. The replay itself is cut at
+// every write too, followed by a second, clean boot.
+#ifndef POWER_CUT_TEST_H
+#define POWER_CUT_TEST_H
+
+#include <string>
+#include <vector>
+#include "host_hal.h"
+#include "storage_manager.h"
+#include "utils.h"
+
+struct PowerCutCase {
+    std::string name;
+    int writes;                   // NVS writes of the uninterrupted save
+    int cuts;                     // Power cuts tried (save and replay)
+    int torn;                     // Reboots that read neither old nor new state
+    int journalsLeft;             // Clean boots that left "jrnl" behind
+    int replays;                  // Boots that found a journal to re-apply
+    int replayMaxWrites;
+    double replayMaxUs;           // begin() with a journal to re-apply (host)
+    double replayMeanUs;
+};
+
+struct PowerCutReport {
+    std::vector<PowerCutCase> cases;
+    int torn;
+    int journalsLeft;
+};
+
+class PowerCutTest {
+public:
+    PowerCutReport run();
+
+private:
+    enum Save {
+        SAVE_TANK_CONFIG,
+        SAVE_PUMP_CYCLE,
+        SAVE_USAGE,
+        SAVE_DAY_CLOSE
+    };
+    
+    HostHal::NvsImage _before;    // Stored state the save starts from
+    
+    void prepare();
+    int save(Save which, long budget);
+    std::string observe();
+    void bootAndCheck(const std::string& before, const std::string& after, PowerCutCase& c);
+    PowerCutCase runCase(const char* name, Save which);
+};
+
+#endif // POWER_CUT_TEST_H
@@ -0,0 +1,54 @@
+// profiler_bench.h
+// LoopProfiler probe cost on the host, and its percentiles against
+// latency distributions with a known answer.
+//
+// Cost: an empty PROFILE_SCOPE-style probe (two esp_timer reads and a
+// record()), and record() alone, timed on the host clock with the empty
+// loop taken out. The host's esp_timer is the HAL's clock read, so this
+// is the bookkeeping cost; the device adds its own esp_timer reads,
+// which LoopProfiler::begin() measures at boot.
+//
+// Accuracy: probes time code that takes a known number of microseconds
+// (the HAL's clock is advanced inside the scope). The reported p50/p99
+// are the upper edge of a log2 bucket, so each must lie between the
+// exact percentile v and 2v.
+#ifndef PROFILER_BENCH_H
+#define PROFILER_BENCH_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include "loop_profiler.h"
+
+struct ProfilerCase {
+    std::string name;
+    uint32_t samples;
+    uint32_t trueP50Us;
+    uint32_t trueP99Us;
+    uint32_t p50Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+    bool withinBucket;            // v <= reported <= 2v for both percentiles
+};
+
+struct ProfilerReport {
+    double nsPerProbe;
+    double nsPerRecord;
+    std::vector<ProfilerCase> cases;
+    int failures;
+};
+
+class ProfilerBench {
+public:
+    explicit ProfilerBench(uint32_t seed = 1);
+    
+    ProfilerReport run();
+
+private:
+    std::mt19937 _rng;
+    
+    ProfilerCase measure(const char* name, const std::vector<uint32_t>& latenciesUs);
+    static uint32_t exactPercentile(std::vector<uint32_t> sorted, uint8_t pct);
+};
+
+#endif // PROFILER_BENCH_H
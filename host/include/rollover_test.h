@@ -0,0 +1,73 @@
+// rollover_test.h
+// RolloverScheduler on the host HAL's virtual clock, in a DST time zone.
+//
+// Each case drives the clock through ordinary running (loop() every
+// minute), stalls (no loop() for hours or days), NTP steps forward and
+// back, and a boot before the clock is synced. The calendar boundaries
+// the clock crosses are found independently, by stepping localtime() and
+// bisecting to the first second of each new day, and the events the
+// scheduler fires are compared with them one by one: type, new period
+// start, order, and lateness when the loop was running.
+#ifndef ROLLOVER_TEST_H
+#define ROLLOVER_TEST_H
+
+#include <string>
+#include <vector>
+#include "rollover_scheduler.h"
+
+struct RolloverCase {
+    std::string name;
+    int expected;                 // Day/week/month boundaries that should fire
+    int fired;                    // Day/week/month events fired
+    int mismatched;               // Fired events that differ from the expected one
+    int late;                     // Fired more than a loop interval late while running
+    int broken;                   // closedStart not the previous period's start
+    int expectedAnchors;
+    int anchors;
+};
+
+struct RolloverReport {
+    std::vector<RolloverCase> cases;
+    double nsPerLoop;             // loop() before the deadline
+    int failures;                 // Cases with any difference
+};
+
+class RolloverTest {
+public:
+    RolloverReport run();
+
+private:
+    struct Fired {
+        RolloverEvent event;
+        time_t closedStart;
+        time_t nextStart;
+        time_t at;
+    };
+    
+    struct Boundary {
+        RolloverEvent event;
+        time_t start;
+        bool running;             // Crossed while loop() ran every interval
+    };
+    
+    RolloverScheduler _scheduler;
+    std::vector<Fired> _fired;
+    std::vector<Boundary> _expected;
+    int _expectedAnchors;
+    bool _synced;
+    time_t _wall;                 // Clock at the last loop()
+    
+    static void onRollover(RolloverEvent event, time_t closedStart, time_t nextStart, void* context);
+    
+    void start(time_t wall);
+    void runFor(long seconds);
+    void stall(long seconds);
+    void step(long seconds);
+    void tick(bool running);
+    void expectBetween(time_t from, time_t to, bool running);
+    RolloverCase finish(const char* name);
+    
+    static time_t local(int year, int month, int day, int hour, int minute);
+};
+
+#endif // ROLLOVER_TEST_H
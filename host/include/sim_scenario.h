@@ -0,0 +1,85 @@
+// sim_scenario.h
+// Scenario files for the tank simulator.
+//
+// One setting per line, '#' starts a comment. Times take an s/m/h/d
+// suffix (plain numbers are seconds). "at <time> <setting> <value>"
+// changes a setting mid-run:
+//
+//     duration 24h
+//     tank rect 120 100 150        # length width height (cm)
+//     start_level 60               # %
+//     thresholds 30 90             # lower upper (%)
+//     pump_rate 25                 # L/min into an empty tank
+//     relay_latency 200            # ms
+//     demand 2                     # draws per hour (daily average)
+//     at 3h source off             # well runs dry
+//     at 7d leak 0.1               # constant outflow (L/min), 0 stops it
+//     at 6h fault sensor_timeout 0.5 [count] [delay_ms]
+//                                  # FaultInjector point, 0 disarms
+#ifndef SIM_SCENARIO_H
+#define SIM_SCENARIO_H
+
+#include <string>
+#include <vector>
+#include "fault_injection.h"
+
+enum SimSetting {
+    SIM_SOURCE,                   // 1 = water available, 0 = dry
+    SIM_PUMP_RATE,                // L/min at zero head
+    SIM_DEMAND,                   // Mean draws per hour
+    SIM_NOISE,                    // Sensor noise, cm (1 sigma)
+    SIM_DROPOUT,                  // Probability a measurement times out
+    SIM_LEAK,                     // Constant outflow, L/min
+    SIM_FAULT                     // Arm / disarm an injection point (value = probability)
+};
+
+struct SimEvent {
+    uint64_t atMs;
+    SimSetting setting;
+    float value;
+
+    // SIM_FAULT
+    FaultPoint fault;
+    int32_t faultCount;
+    uint32_t faultDelayMs;
+};
+
+struct SimScenario {
+    std::string name;
+    uint64_t durationMs = 24ULL * 3600000ULL;
+    unsigned long seed = 1;
+
+    // Tank geometry (cm)
+    bool cylindrical = false;
+    float length = 100;
+    float width = 100;
+    float radius = 50;
+    float height = 100;
+
+    float startLevel = 50;        // %
+    float lowerThreshold = 20;    // %
+    float upperThreshold = 90;    // %
+
+    // Pump delivery falls linearly by headLoss (fraction) from empty to full
+    float pumpRate = 20;
+    float headLoss = 0.2;
+    unsigned long relayLatencyMs = 200;
+    bool sourceAvailable = true;
+
+    // Household demand: Poisson draws, shaped by a morning/evening profile
+    float demandPerHour = 2;
+    float drawLiters = 15;        // Mean volume per draw (exponential)
+    float drawRate = 8;           // L/min while a draw is open
+    float leakLpm = 0;            // Constant outflow on top (running toilet, cracked pipe)
+
+    // Sensor
+    float noiseCm = 0.3;
+    float dropoutRate = 0.0;
+
+    std::vector<SimEvent> events;  // Sorted by time
+
+    // Returns false and fills error (with the line number) on a bad file
+    bool load(const char* path, std::string& error);
+};
+
+#endif // SIM_SCENARIO_H
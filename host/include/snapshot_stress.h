@@ -0,0 +1,53 @@
+// snapshot_stress.h
+// SnapshotBuffer and MpscQueue on real host threads.
+//
+// Snapshot: one writer publishes as fast as it can, every field derived
+// from a publish counter, while reader threads read continuously. A read
+// is torn if its fields come from different publishes, or stale if its
+// counter goes backwards for that reader. Read and publish cost is timed
+// per call, sampled, for the median and the tail.
+//
+// Commands: producer threads push numbered items into an MpscQueue of
+// CONTROL_QUEUE_SIZE, retrying while it is full, and one consumer pops
+// them; each producer's items must arrive exactly once and in order.
+#ifndef SNAPSHOT_STRESS_H
+#define SNAPSHOT_STRESS_H
+
+#include <stdint.h>
+
+struct SnapshotStressReport {
+    int readers;
+    uint64_t publishes;
+    uint64_t reads;
+    uint64_t failedReads;         // Lapped on every retry (no copy returned)
+    uint64_t tornReads;
+    uint64_t staleReads;
+    double medianPublishNs;
+    double medianReadNs;
+    double p99ReadNs;
+    double maxReadNs;             // Includes being preempted mid-read
+    
+    int producers;
+    uint64_t pushed;
+    uint64_t fullRetries;         // push() found the queue full
+    uint64_t popped;
+    uint64_t lost;
+    uint64_t duplicated;          // Or out of order
+};
+
+class SnapshotStress {
+public:
+    SnapshotStress(int seconds, int readers = 3, int producers = 3);
+    
+    SnapshotStressReport run();
+
+private:
+    int _seconds;
+    int _readers;
+    int _producers;
+    
+    void runSnapshot(SnapshotStressReport& r);
+    void runCommands(SnapshotStressReport& r);
+};
+
+#endif // SNAPSHOT_STRESS_H
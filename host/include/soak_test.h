@@ -0,0 +1,75 @@
+// soak_test.h
+// Long-horizon soak run: a scenario stretched over many simulated days
+// (60 by default), sampled every hour.
+//
+// Timers: millis() wraps at 2^32 ms (day 49.7) when unsigned long is 32
+// bits, as on the ESP32, so the soak must be run from the ILP32 build
+// (env:soak). Every hourly activity count (sensor reads, pump starts, NVS
+// writes in total and per key) is compared across the wrap with the same
+// count before it: a burst in the hours after the wrap, or an activity
+// that never happens again, is reported as a timer misfire. Pump safety
+// (time on above the upper / off below the lower threshold) is checked
+// the same way. On a 64-bit build the clock never wraps and only the heap
+// is checked.
+//
+// Heap: allocations are counted by HeapTracker; end-of-day live bytes and
+// fragmentation are fitted to a trend, and live bytes that keep growing
+// after the first day are reported as unbounded growth.
+#ifndef SOAK_TEST_H
+#define SOAK_TEST_H
+
+#include <string>
+#include <vector>
+#include "sim_scenario.h"
+#include "tank_simulator.h"
+#include "heap_tracker.h"
+
+struct SoakSample {
+    unsigned long millisAt;       // millis() at the end of the hour
+    SimMetrics metrics;           // Counters so far
+    uint32_t nvsWrites;           // FlashWearMonitor, so far
+    std::vector<uint32_t> keyWrites;    // Per FlashWearMonitor key, so far
+    HeapStats heap;
+};
+
+struct SoakReport {
+    int days;
+    bool clockWraps;              // unsigned long is 32 bits
+    int wrapHour;                 // Hour in which millis() wrapped, -1 = none
+    
+    float allocationsPerHour;
+    float bytesPerHour;
+    size_t peakBytes;
+    size_t liveBytesDay1;
+    size_t liveBytesEnd;
+    float growthBytesPerDay;      // Least-squares slope, end-of-day live bytes
+    float fragmentationDay1Pct;
+    float fragmentationEndPct;
+    float fragmentationPerDay;
+    size_t minLargestFree;
+    uint32_t outOfMemory;
+    
+    SimMetrics metrics;
+    std::vector<std::string> findings;
+};
+
+class SoakTest {
+public:
+    SoakTest(const SimScenario& scenario, int days);
+    
+    SoakReport run();
+
+private:
+    SimScenario _scenario;
+    int _days;
+    std::vector<SoakSample> _samples;
+    
+    static void onHour(int hour, const SimMetrics& metrics, void* context);
+    
+    void checkTimers(SoakReport& report);
+    void checkSeries(const std::string& name, const std::vector<uint32_t>& counts, SoakReport& report);
+    void checkSafety(SoakReport& report);
+    void checkHeap(SoakReport& report);
+};
+
+#endif // SOAK_TEST_H
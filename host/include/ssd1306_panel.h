@@ -0,0 +1,48 @@
+// ssd1306_panel.h
+// Host model of the SSD1306 controller for the I2C stand-in: decodes the
+// command and data streams (horizontal addressing, COLUMNADDR/PAGEADDR
+// windows) into display RAM, so what the panel shows after partial
+// updates can be checked and saved. Attach with Wire.attach().
+#ifndef SSD1306_PANEL_H
+#define SSD1306_PANEL_H
+
+#include <Wire.h>
+#include <vector>
+
+class Ssd1306Panel : public HostI2cDevice {
+public:
+    Ssd1306Panel(int width = 128, int height = 64);
+    
+    void receive(const uint8_t* data, size_t length) override;
+    
+    bool getPixel(int x, int y) const;
+    const uint8_t* getRam() const { return _ram.data(); }
+    size_t getRamSize() const { return _ram.size(); }
+    
+    // Binary PBM (P4), lit pixels black
+    bool writePbm(const char* path) const;
+
+private:
+    int _width;
+    int _pages;
+    std::vector<uint8_t> _ram;
+    
+    // Address window and pointer
+    int _firstColumn;
+    int _lastColumn;
+    int _firstPage;
+    int _lastPage;
+    int _column;
+    int _page;
+    
+    // Command with arguments still to come (may span transactions)
+    uint8_t _command;
+    int _argsNeeded;
+    uint8_t _args[2];
+    int _argCount;
+    
+    void command(uint8_t byte);
+    void data(uint8_t byte);
+};
+
+#endif // SSD1306_PANEL_H
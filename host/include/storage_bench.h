@@ -0,0 +1,65 @@
+// storage_bench.h
+// Usage queries on the host HAL against a year of daily records, stored
+// both in the layout StorageManager uses now and as the per-day JSON keys
+// ("day<midnight>", one NVS entry per day) it replaced. The host store is
+// a map, so time per query only compares the paths with each other; the
+// key lookups and bytes read per query are what carry over to NVS.
+#ifndef STORAGE_BENCH_H
+#define STORAGE_BENCH_H
+
+#include <string>
+#include <vector>
+#include "storage_manager.h"
+#include "history_exporter.h"
+
+struct StorageQuery {
+    std::string name;
+    double nsPerQuery;
+    float readsPerQuery;          // Key lookups
+    float bytesPerQuery;          // Bytes read from the store
+    float liters;                 // Result of the last query (paths must agree)
+};
+
+struct ExportRun {
+    std::string name;
+    int days;
+    uint32_t bytes;
+    int rows;
+    int chunks;
+    double bytesPerSec;
+    size_t peakHeap;              // Exporter and everything read() allocates
+    uint64_t allocations;
+};
+
+class StorageBench {
+public:
+    StorageBench(int queries, uint32_t seed = 1);
+    
+    // Month-to-date usage: WaterTracker's running total, the daily table,
+    // and the per-day key probe getMonthlyUsage() used to do
+    std::vector<StorageQuery> monthUsage();
+    
+    // The last 30 and 365 days: the daily table with a warm and a cold
+    // cache, and the per-day key probe getLast30DaysUsage() used to do
+    std::vector<StorageQuery> history();
+    
+    // Daily exports of a month and a year, as the web server streams them
+    // (HistoryExporter on the heap, read() into chunkBytes at a time)
+    std::vector<ExportRun> exports(size_t chunkBytes);
+
+private:
+    int _queries;
+    uint32_t _seed;
+    
+    void fill(StorageManager& storage, int days);
+    float legacyMonthUsage(int year, int month);
+    float legacyHistory(int days, DailyUsage* usage, int& count);
+    bool legacyDailyUsage(unsigned long date, DailyUsage& usage);
+    
+    ExportRun exportRun(const char* name, ExportFormat format, int days, size_t chunkBytes);
+    
+    template <typename Query>
+    StorageQuery measure(const char* name, Query query);
+};
+
+#endif // STORAGE_BENCH_H
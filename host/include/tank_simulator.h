@@ -0,0 +1,124 @@
+// tank_simulator.h
+// Closed-loop tank simulation on the host HAL.
+//
+// The plant (tank geometry, pump delivery curve with relay latency,
+// stochastic household draws, a noisy ultrasonic echo that can drop
+// out) answers the firmware's pulseIn() calls, and the firmware side is
+// the real ControlLoop, PumpController and WaterTracker, stepped the way
+// normalOperation() and the scheduler step them. Time is the HAL's
+// virtual clock, so a simulated day takes about a second.
+//
+// Scenarios can arm FaultInjector points (native builds enable fault
+// injection); the latency and pump safety metrics show how the control
+// loop copes.
+#ifndef TANK_SIMULATOR_H
+#define TANK_SIMULATOR_H
+
+#include <random>
+#include "sim_scenario.h"
+#include "trace_recorder.h"
+#include "event_bus.h"
+
+struct SimMetrics {
+    double simHours;
+    float overshootPct;           // Peak level above the upper threshold
+    float undershootPct;          // Deepest level below the lower threshold
+    int pumpStarts;
+    float startsPerHour;
+    double pumpRunMin;
+    double dryRunMin;             // Motor on with no water at the source
+    float dryRunDetectMin;        // Dry running before the firmware stopped it (-1 = never)
+    double demandL;               // Water actually drawn by the household
+    double unmetDemandL;          // Requested while the tank was empty
+    float trackedUsageL;          // WaterTracker's total for the run
+    float usageErrorPct;          // (tracked - actual) / actual
+    double fillDemandL;           // Part of demandL drawn while the pump ran
+    float fillTrackedL;           // Part of trackedUsageL booked while pumping
+    double overflowL;
+    double leakL;                 // Lost to the scenario's leak (not in demandL)
+    int sensorReads;
+    int sensorDropouts;
+    
+    // Control-loop latency (simulated time spent inside one pass)
+    unsigned long passes;
+    float meanPassMs;
+    float maxPassMs;
+    
+    // Pump safety: longest stretch of the pump on the wrong side of a threshold
+    float maxOnAboveUpperSec;     // Running above the upper threshold
+    float maxOffBelowLowerMin;    // Idle below the lower threshold with water available
+    int faultsFired;              // FaultInjector, all points
+    
+    // Leak alarm: from the leak starting to WaterTracker raising it, and
+    // alarms raised while there was no leak
+    float leakDetectHours;        // -1 = not raised (or no leak)
+    int falseLeakAlarms;
+    
+    // Flash wear from the run's NVS writes (FlashWearMonitor, setup excluded)
+    int nvsWrites;
+    float flashLifeYears;         // Projected NVS lifetime at this write rate
+    double wallSeconds;
+    double speedup;               // Simulated time / wall time
+};
+
+// Called once per simulated hour with the counters so far (derived
+// fields like startsPerHour are only filled in at the end of run())
+typedef void (*SimHourHook)(int hour, const SimMetrics& metrics, void* context);
+
+// Called once before the run with the firmware's event bus, after the
+// control loop's own subscribers (main.cpp's subscribeEvents() slot)
+typedef void (*SimBusHook)(EventBus& bus, void* context);
+
+class TankSimulator {
+public:
+    explicit TankSimulator(const SimScenario& scenario);
+    
+    // Optional: record the run's inputs, as the firmware would
+    void setTrace(TraceRecorder* trace);
+    
+    // Optional: per-hour callback (soak monitors)
+    void setHourHook(SimHourHook hook, void* context);
+    
+    // Optional: extra event subscribers (benches)
+    void setBusHook(SimBusHook hook, void* context);
+    
+    SimMetrics run();
+
+private:
+    SimScenario _scenario;
+    std::mt19937 _rng;            // Sensor noise and dropouts
+    std::mt19937 _demandRng;      // Household draws, independent of how often the sensor is read
+    TraceRecorder* _trace;
+    SimHourHook _hourHook;
+    void* _hourContext;
+    SimBusHook _busHook;
+    void* _busContext;
+    
+    // Plant state
+    uint64_t _plantMs;
+    size_t _nextEvent;
+    double _heightCm;             // Double: a 10 ms step changes the volume by mL
+    float _litersPerCm;
+    float _capacityL;
+    bool _relayOn;
+    bool _motorOn;
+    uint64_t _relayChangeMs;
+    uint64_t _nextDrawMs;
+    double _openDrawL;            // Volume still to be drawn by open draws
+    unsigned long _onAboveMs;     // Current stretch for maxOnAboveUpperSec
+    unsigned long _offBelowMs;    // Current stretch for maxOffBelowLowerMin
+    uint64_t _leakStartMs;        // When the current leak started
+    
+    SimMetrics _metrics;
+    
+    void advanceTo(uint64_t nowMs);
+    void step(float dtSec);
+    void applyEvent(const SimEvent& evt);
+    void scheduleNextDraw();
+    float levelPercent();
+    unsigned long echoWidth();
+    
+    static unsigned long pulseSource(uint8_t pin, void* context);
+};
+
+#endif // TANK_SIMULATOR_H
@@ -0,0 +1,49 @@
+// trace_replay.h
+// Replays a trace downloaded from /api/trace through the real control
+// loop on the host HAL and compares the pump changes it produces with
+// the ones the unit recorded.
+//
+// Each boot in the trace is replayed from power-on state. A session that
+// starts mid-run (the ring wrapped, or a segment is missing) starts from
+// its keyframe instead: config, pump mode and motor state are restored,
+// but timers and alarms inside PumpController are not, so divergence
+// early in such a session is expected. Stored history (NVS) is never in
+// the trace; the replay starts from an empty store.
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <string>
+#include <vector>
+#include "trace_recorder.h"
+
+struct ReplayReport {
+    int sessions;
+    int records;
+    int readings;
+    int failedReadings;
+    int commands;
+    int buttons;
+    int damagedSegments;
+    int outputsRecorded;
+    int outputsReplayed;
+    int outputsMatched;
+    long firstDivergenceMs;                 // millis() of the first mismatch, -1 = none
+    std::vector<std::string> mismatches;    // First REPLAY_MAX_MISMATCHES, readable
+};
+
+class TraceReplayer {
+public:
+    bool load(const char* path, std::string& error);
+    
+    ReplayReport run();
+
+private:
+    std::vector<uint8_t> _data;
+    
+    void replaySession(const std::vector<TraceRecord>& records, size_t begin, size_t end,
+                       ReplayReport& report);
+    void compare(const std::vector<TraceRecord>& recorded, const std::vector<PumpEvent>& replayed,
+                 ReplayReport& report);
+};
+
+#endif // TRACE_REPLAY_H
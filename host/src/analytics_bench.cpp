@@ -0,0 +1,316 @@
+// analytics_bench.cpp
+#include "analytics_bench.h"
+#include "host_hal.h"
+#include "storage_manager.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    const time_t BENCH_EPOCH = 1761782400;          // 2025-10-30 00:00 UTC
+    const float BENCH_TANK_LITERS = 1000;           // As the simulator's baseline tank
+    const float BENCH_NOISE_RATE = 1.0f / 60;       // Noise readings per idle reading
+    
+    // Volume (L) and rate (L/min) ranges per category
+    const float DRAW_LITERS[DRAW_CATEGORY_COUNT][2] = { { 0.8, 4.5 }, { 6, 38 }, { 45, 140 }, { 160, 400 } };
+    const float DRAW_RATES[DRAW_CATEGORY_COUNT][2] = { { 3, 6 }, { 5, 10 }, { 8, 12 }, { 12, 20 } };
+    
+    const float PROFILE_DRAW_LITERS = 15;           // Mean draw (exponential), as the simulator's
+    const int PROFILE_SHIFT_WEEKS = 20;             // Longest wait for a moved peak
+}
+
+AnalyticsBench::AnalyticsBench(int draws, uint32_t seed)
+    : _draws(draws), _seed(seed), _rng(seed) {
+}
+
+float AnalyticsBench::uniform(float low, float high) {
+    return std::uniform_real_distribution<float>(low, high)(_rng);
+}
+
+// Draws of every category in turn, each followed by a quiet spell longer
+// than DRAW_EVENT_GAP_MS
+std::vector<AnalyticsBench::Draw> AnalyticsBench::makeDraws(int count, bool pauses) {
+    std::vector<Draw> draws;
+    uint64_t t = 60000;
+    
+    for (int i = 0; i < count; i++) {
+        Draw d;
+        d.category = (DrawCategory)(i % DRAW_CATEGORY_COUNT);
+        d.liters = uniform(DRAW_LITERS[d.category][0], DRAW_LITERS[d.category][1]);
+        d.rateLpm = uniform(DRAW_RATES[d.category][0], DRAW_RATES[d.category][1]);
+        
+        uint64_t runMs = (uint64_t)(d.liters / d.rateLpm * 60000);
+        uint64_t pauseMs = (pauses && d.category != DRAW_SMALL) ? (uint64_t)uniform(20000, 90000) : 0;
+        d.startMs = t;
+        d.pauseMs = t + runMs / 2;
+        d.resumeMs = d.pauseMs + pauseMs;
+        d.endMs = d.resumeMs + (runMs - runMs / 2);
+        draws.push_back(d);
+        
+        t = d.endMs + DRAW_EVENT_GAP_MS + (uint64_t)uniform(60000, 1800000);
+    }
+    return draws;
+}
+
+float AnalyticsBench::drawnBetween(const Draw& draw, uint64_t fromMs, uint64_t toMs) {
+    uint64_t running = 0;
+    uint64_t from = std::max(fromMs, draw.startMs);
+    uint64_t to = std::min(toMs, draw.pauseMs);
+    if (to > from) running += to - from;
+    from = std::max(fromMs, draw.resumeMs);
+    to = std::min(toMs, draw.endMs);
+    if (to > from) running += to - from;
+    return draw.rateLpm * running / 60000.0f;
+}
+
+SegmenterCase AnalyticsBench::playSegmenter(const char* name, TraceKind kind) {
+    HostHal::reset();
+    HostHal::setSerialEcho(false);
+    HostHal::setEpoch(BENCH_EPOCH);
+    _rng.seed(_seed);
+    
+    std::vector<Draw> draws = makeDraws(_draws, kind == TRACE_PAUSES);
+    DrawEventSegmenter segmenter;
+    segmenter.begin(nullptr);
+    
+    // Idle WaterTracker books a drop once it passes the noise deadband
+    const float lump = BENCH_TANK_LITERS * USAGE_DEADBAND_PCT / 100;
+    float unbooked = 0;
+    
+    std::vector<DrawEvent> events;
+    DrawEvent newest = DrawEvent();
+    size_t next = 0;
+    uint64_t endMs = draws.back().endMs + 2 * DRAW_EVENT_GAP_MS;
+    uint64_t samples = 0;
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t t = SENSOR_SAMPLE_INTERVAL_MS; t <= endMs; t += SENSOR_SAMPLE_INTERVAL_MS) {
+        HostHal::advanceMillis(SENSOR_SAMPLE_INTERVAL_MS);
+        
+        float liters = 0;
+        while (next < draws.size() && draws[next].endMs <= t - SENSOR_SAMPLE_INTERVAL_MS) next++;
+        for (size_t i = next; i < draws.size() && draws[i].startMs < t; i++) {
+            liters += drawnBetween(draws[i], t - SENSOR_SAMPLE_INTERVAL_MS, t);
+        }
+        
+        if (kind == TRACE_LUMPS) {
+            unbooked += liters;
+            liters = 0;
+            if (unbooked > lump) {
+                liters = unbooked;
+                unbooked = 0;
+            }
+        } else if (kind == TRACE_NOISE && liters == 0 && uniform(0, 1) < BENCH_NOISE_RATE) {
+            liters = uniform(0.05, DRAW_MIN_EVENT_LITERS * 0.9f);
+        }
+        
+        bool active = segmenter.isEventActive();
+        segmenter.addSample(liters, millis());
+        samples++;
+        
+        // Collect each logged event as it closes (the ring only keeps the last few)
+        if (active && !segmenter.isEventActive()) {
+            DrawEvent log[DRAW_EVENT_LOG_SIZE];
+            int count = segmenter.getEvents(log, DRAW_EVENT_LOG_SIZE);
+            if (count > 0 && memcmp(&log[count - 1], &newest, sizeof(newest)) != 0) {
+                newest = log[count - 1];
+                events.push_back(newest);
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    SegmenterCase c = SegmenterCase();
+    c.name = name;
+    c.draws = draws.size();
+    c.events = events.size();
+    c.nsPerSample = seconds * 1e9 / samples;
+    
+    // An event covers the draws that overlap it (the first reading of an
+    // event may come up to a reading after the draw started)
+    std::vector<int> covered(draws.size(), 0);
+    float errorSum = 0;
+    int categoryHits = 0;
+    for (size_t e = 0; e < events.size(); e++) {
+        uint64_t first = (uint64_t)(events[e].start - BENCH_EPOCH) * 1000 - SENSOR_SAMPLE_INTERVAL_MS;
+        uint64_t last = first + SENSOR_SAMPLE_INTERVAL_MS + events[e].durationSec * 1000ULL + 999;
+        
+        std::vector<size_t> inside;
+        for (size_t d = 0; d < draws.size(); d++) {
+            if (draws[d].startMs <= last && draws[d].endMs >= first) inside.push_back(d);
+        }
+        
+        if (inside.empty()) {
+            c.spurious++;
+        } else if (inside.size() == 1) {
+            const Draw& d = draws[inside[0]];
+            covered[inside[0]] = 1;
+            c.matched++;
+            errorSum += fabsf(events[e].volumeDl / 10.0f - d.liters) / d.liters;
+            if (events[e].category == d.category) categoryHits++;
+        } else {
+            for (size_t i = 0; i < inside.size(); i++) covered[inside[i]] = 2;
+            c.merged += inside.size();
+        }
+    }
+    c.missed = std::count(covered.begin(), covered.end(), 0);
+    c.volumeErrorPct = c.matched > 0 ? 100 * errorSum / c.matched : 0;
+    c.categoryPct = c.matched > 0 ? 100.0f * categoryHits / c.matched : 0;
+    return c;
+}
+
+std::vector<SegmenterCase> AnalyticsBench::segmenter() {
+    std::vector<SegmenterCase> cases;
+    cases.push_back(playSegmenter("exact", TRACE_EXACT));
+    cases.push_back(playSegmenter("lumps", TRACE_LUMPS));
+    cases.push_back(playSegmenter("noise", TRACE_NOISE));
+    cases.push_back(playSegmenter("pauses", TRACE_PAUSES));
+    return cases;
+}
+
+// Poisson number of exponential draws: mean liters, variance
+// 2 * PROFILE_DRAW_LITERS * mean
+float AnalyticsBench::hourLiters(float mean) {
+    int draws = std::poisson_distribution<int>(mean / PROFILE_DRAW_LITERS)(_rng);
+    float liters = 0;
+    for (int i = 0; i < draws; i++) {
+        liters += std::exponential_distribution<float>(1 / PROFILE_DRAW_LITERS)(_rng);
+    }
+    return liters;
+}
+
+// Morning and evening peaks, a later morning at weekends, quiet nights.
+// Shifted moves the weekday morning peak from 07:00 to 06:00.
+float AnalyticsBench::patternMean(int slot, bool shifted) {
+    int day = slot / 24;
+    int hour = slot % 24;
+    bool weekend = day == 0 || day == 6;
+    int morning = weekend ? 9 : (shifted ? 6 : 7);
+    
+    if (hour == morning) return 60;
+    if (hour == morning + 1) return 30;
+    if (hour == 19) return 45;
+    if (hour == 20) return 30;
+    if (hour >= 1 && hour <= 5) return 1;
+    return 8;
+}
+
+float AnalyticsBench::patternStdDev(int slot, bool shifted) {
+    return sqrtf(2 * PROFILE_DRAW_LITERS * patternMean(slot, shifted));
+}
+
+float AnalyticsBench::profileErrorPct(const DemandProfile& profile, bool shifted) {
+    float error = 0;
+    float total = 0;
+    for (int slot = 0; slot < DEMAND_PROFILE_SLOTS; slot++) {
+        error += fabsf(profile.getExpected(slot / 24, slot % 24) - patternMean(slot, shifted));
+        total += patternMean(slot, shifted);
+    }
+    return 100 * error / total;
+}
+
+float AnalyticsBench::stdDevErrorPct(const DemandProfile& profile) {
+    float error = 0;
+    float total = 0;
+    for (int slot = 0; slot < DEMAND_PROFILE_SLOTS; slot++) {
+        error += fabsf(profile.getStdDev(slot / 24, slot % 24) - patternStdDev(slot, false));
+        total += patternStdDev(slot, false);
+    }
+    return 100 * error / total;
+}
+
+ProfileRun AnalyticsBench::profile(int weeks) {
+    HostHal::reset();
+    HostHal::clearPreferences();
+    HostHal::setSerialEcho(false);
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    _rng.seed(_seed);
+    
+    ProfileRun r = ProfileRun();
+    r.shiftWeeks = -1;
+    r.storedBytes = DEMAND_PROFILE_SLOTS * sizeof(ProfileSlot);
+    
+    StorageManager storage;
+    storage.begin();
+    DemandProfile profile;
+    profile.begin(&storage);
+    
+    // The hour the profile starts in is partial and never folded
+    HostHal::setEpoch(BENCH_EPOCH - 1);
+    profile.loop();
+    HostHal::advanceMillis(1000);
+    profile.loop();
+    int slot = (time(nullptr) / 3600 + 4 * 24) % DEMAND_PROFILE_SLOTS;   // 1970-01-01 was a Thursday
+    
+    uint64_t folds = 0;
+    double foldSeconds = 0;
+    std::vector<float> draws;
+    
+    for (int week = 0; week < weeks + PROFILE_SHIFT_WEEKS && r.shiftWeeks < 0; week++) {
+        bool shifted = week >= weeks;
+        
+        for (int hour = 0; hour < DEMAND_PROFILE_SLOTS; hour++) {
+            // Split the hour into draws as WaterTracker would report them
+            float liters = hourLiters(patternMean(slot, shifted));
+            draws.clear();
+            while (liters > PROFILE_DRAW_LITERS) {
+                draws.push_back(PROFILE_DRAW_LITERS);
+                liters -= PROFILE_DRAW_LITERS;
+            }
+            draws.push_back(liters);
+            
+            for (size_t i = 0; i < draws.size(); i++) profile.addUsage(draws[i]);
+            
+            HostHal::advanceMillis(3600000);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            profile.loop();
+            foldSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            folds++;
+            slot = (slot + 1) % DEMAND_PROFILE_SLOTS;
+        }
+        
+        if (!shifted) {
+            r.weekErrorPct.push_back(profileErrorPct(profile, false));
+            if (week == weeks - 1) r.stdErrorPct = stdDevErrorPct(profile);
+            continue;
+        }
+        
+        // The moved peak: the new 06:00 slots on weekdays
+        float peak = 0;
+        for (int day = 1; day <= 5; day++) peak += profile.getExpected(day, 6) / 5;
+        if (peak >= 0.8f * patternMean(24 + 6, true)) r.shiftWeeks = week - weeks + 1;
+    }
+    r.nsPerFold = foldSeconds * 1e9 / folds;
+    
+    // The EWMA's steady spread is alpha / (2 - alpha) of the slot's
+    // variance; the mean |error| of a normal is sqrt(2 / pi) sigma
+    float floorSum = 0;
+    float meanSum = 0;
+    for (int s = 0; s < DEMAND_PROFILE_SLOTS; s++) {
+        float spread = sqrtf(DEMAND_PROFILE_ALPHA / (2 - DEMAND_PROFILE_ALPHA)) * patternStdDev(s, false);
+        floorSum += sqrtf(2 / M_PI) * spread;
+        meanSum += patternMean(s, false);
+    }
+    r.floorErrorPct = 100 * floorSum / meanSum;
+    
+    // Within the hour the clock has reached, so nothing is folded
+    const int calls = 1000000;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) profile.addUsage(i * 1e-6f);
+    r.nsPerUsage = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / calls;
+    
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls / 10; i++) profile.loop();
+    r.nsPerLoop = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / (calls / 10);
+    
+    profile.save();
+    DemandProfile restored;
+    restored.begin(&storage);
+    for (int s = 0; s < DEMAND_PROFILE_SLOTS; s++) {
+        int day = s / 24;
+        int hour = s % 24;
+        r.restoreErrorL = std::max(r.restoreErrorL, fabsf(restored.getExpected(day, hour) - profile.getExpected(day, hour)));
+        r.restoreErrorL = std::max(r.restoreErrorL, fabsf(restored.getStdDev(day, hour) - profile.getStdDev(day, hour)));
+    }
+    return r;
+}
@@ -0,0 +1,286 @@
+// button_bench.cpp
+#include "button_bench.h"
+#include "host_hal.h"
+#include "pins.h"
+#include <algorithm>
+
+namespace {
+    const uint64_t MS = 1000;
+    const uint64_t BENCH_POLL_US = 5 * MS;          // loop() pass
+    const uint64_t BENCH_START_US = 100 * MS;
+    const uint64_t BENCH_TAIL_US = 2000 * MS;       // After the last edge, for pending timers
+    const int BENCH_MAX_BOUNCES = 4;                // Extra open/close pairs per transition
+    const uint32_t BENCH_BOUNCE_MIN_US = 50;        // Between bounce edges
+    const uint32_t BENCH_BOUNCE_MAX_US = 1200;
+    
+    // As ButtonHandler: repeat interval after `repeats` repeats
+    uint64_t repeatInterval(int repeats) {
+        int ms = BUTTON_REPEAT_INTERVAL_MS - repeats * BUTTON_REPEAT_ACCEL_MS;
+        return (uint64_t)std::max(ms, BUTTON_REPEAT_MIN_MS) * MS;
+    }
+    
+    float percentile(const std::vector<float>& sorted, int pct) {
+        if (sorted.empty()) return 0;
+        return sorted[std::min(sorted.size() - 1, sorted.size() * pct / 100)];
+    }
+}
+
+ButtonBench::ButtonBench(int presses, uint32_t seed)
+    : _presses(presses), _seed(seed), _rng(seed) {
+}
+
+ButtonBenchReport ButtonBench::run() {
+    ButtonBenchReport report = ButtonBenchReport();
+    HostHal::setSerialEcho(false);
+    
+    clear();
+    buildClicks(BTN_MID, BTN_MID_PRESS);
+    report.cases.push_back(play("click", report));
+    
+    clear();
+    buildStalledClicks();
+    report.cases.push_back(play("stalled_click", report));
+    
+    clear();
+    buildDoubleClicks();
+    report.cases.push_back(play("double_click", report));
+    
+    clear();
+    buildLongPresses();
+    report.cases.push_back(play("long_press", report));
+    
+    clear();
+    buildRepeats();
+    report.cases.push_back(play("repeat", report));
+    
+    clear();
+    buildGlitches();
+    report.cases.push_back(play("glitch", report));
+    
+    HostHal::reset();                   // Detaches the handler's interrupts
+    return report;
+}
+
+void ButtonBench::clear() {
+    _changes.clear();
+    _expected.clear();
+    _stalls.clear();
+}
+
+uint32_t ButtonBench::random(uint32_t low, uint32_t high) {
+    return std::uniform_int_distribution<uint32_t>(low, high)(_rng);
+}
+
+// Transition to level at `at`, then pairs of bounce edges; returns the last edge
+uint64_t ButtonBench::bounce(uint64_t at, uint8_t pin, uint8_t level) {
+    uint64_t t = at;
+    _changes.push_back({ t, pin, level });
+    
+    int edges = random(0, BENCH_MAX_BOUNCES) * 2;
+    for (int i = 0; i < edges; i++) {
+        t += random(BENCH_BOUNCE_MIN_US, BENCH_BOUNCE_MAX_US);
+        _changes.push_back({ t, pin, (uint8_t)(i % 2 == 0 ? !level : level) });
+    }
+    return t;
+}
+
+ButtonBench::Press ButtonBench::press(uint64_t at, uint8_t pin, uint64_t holdUs) {
+    Press p;
+    p.firstDown = at;
+    p.lastDown = bounce(at, pin, LOW);
+    p.firstUp = std::max(at + holdUs, p.lastDown + MS);
+    p.lastUp = bounce(p.firstUp, pin, HIGH);
+    return p;
+}
+
+void ButtonBench::expect(ButtonEvent event, uint64_t readyUs, bool optional) {
+    _expected.push_back({ event, readyUs, optional, false });
+}
+
+// Single presses, well apart: a click is known at the first release edge
+void ButtonBench::buildClicks(uint8_t pin, ButtonEvent event) {
+    uint64_t t = BENCH_START_US;
+    for (int i = 0; i < _presses; i++) {
+        Press p = press(t, pin, random(60, 400) * MS);
+        expect(event, p.firstUp);
+        t = p.lastUp + random(150, 1000) * MS;
+    }
+}
+
+// Two quick presses while loop() is blocked (flash write, slow redraw)
+void ButtonBench::buildStalledClicks() {
+    uint64_t t = BENCH_START_US;
+    for (int i = 0; i < _presses / 2; i++) {
+        Press first = press(t + 30 * MS, BTN_RIGHT, 70 * MS);
+        Press second = press(first.lastUp + 90 * MS, BTN_RIGHT, 70 * MS);
+        expect(BTN_RIGHT_PRESS, first.firstUp);
+        expect(BTN_RIGHT_PRESS, second.firstUp);
+        
+        uint64_t resume = second.lastUp + 100 * MS;
+        _stalls.push_back(std::make_pair(t, resume));
+        t = resume + random(200, 600) * MS;
+    }
+}
+
+// LEFT: pairs (known at the second press) and singles (known when the
+// double-click window after the release closes), alternately
+void ButtonBench::buildDoubleClicks() {
+    uint64_t t = BENCH_START_US;
+    for (int i = 0; i < _presses; i++) {
+        uint64_t end;
+        if (i % 2 == 0) {
+            Press first = press(t, BTN_LEFT, 80 * MS);
+            Press second = press(first.lastUp + random(80, 150) * MS, BTN_LEFT, 80 * MS);
+            #if BUTTON_DOUBLE_CLICK_ENABLED
+            expect(BTN_LEFT_DOUBLE_CLICK, second.firstDown);
+            #else
+            expect(BTN_LEFT_PRESS, first.firstUp);
+            expect(BTN_LEFT_PRESS, second.firstUp);
+            #endif
+            end = second.lastUp;
+        } else {
+            Press p = press(t, BTN_LEFT, random(60, 300) * MS);
+            #if BUTTON_DOUBLE_CLICK_ENABLED
+            expect(BTN_LEFT_PRESS, p.firstUp + BUTTON_DOUBLE_CLICK_MS * MS);
+            #else
+            expect(BTN_LEFT_PRESS, p.firstUp);
+            #endif
+            end = p.lastUp;
+        }
+        t = end + random(600, 1200) * MS;
+    }
+}
+
+// MID and the manual switch held past the long-press time
+void ButtonBench::buildLongPresses() {
+    uint64_t t = BENCH_START_US;
+    int count = std::max(5, _presses / 10);
+    for (int i = 0; i < count; i++) {
+        bool mid = i % 2 == 0;
+        Press p = press(t, mid ? BTN_MID : MANUAL_SWITCH_PIN, (BUTTON_LONG_PRESS_MS + random(300, 2000)) * MS);
+        expect(mid ? BTN_MID_LONG_PRESS : BTN_MANUAL_SWITCH_LONG_PRESS, p.firstDown + BUTTON_LONG_PRESS_MS * MS);
+        t = p.lastUp + 500 * MS;
+    }
+}
+
+// TOP / BOTTOM held: a click at the press, then repeats on the
+// accelerating schedule; a repeat due while the release bounces may or
+// may not come
+void ButtonBench::buildRepeats() {
+    uint64_t t = BENCH_START_US;
+    for (int i = 0; i < _presses; i++) {
+        bool top = i % 2 == 0;
+        ButtonEvent event = top ? BTN_TOP_PRESS : BTN_BOTTOM_PRESS;
+        Press p = press(t, top ? BTN_TOP : BTN_BOTTOM, random(100, 3000) * MS);
+        t = p.lastUp + random(300, 800) * MS;
+        
+        #if !BUTTON_AUTO_REPEAT_ENABLED
+        expect(event, p.firstUp);
+        continue;
+        #endif
+        
+        expect(event, p.firstDown);
+        
+        // The handler's schedule starts from the debounced press; a repeat
+        // due before the contact opened comes even if loop() only sees
+        // the release edge later
+        uint64_t due = p.lastDown + BUTTON_DEBOUNCE_MS * MS + BUTTON_REPEAT_DELAY_MS * MS;
+        uint64_t ideal = p.firstDown + BUTTON_REPEAT_DELAY_MS * MS;
+        for (int n = 0; due <= p.lastUp; n++) {
+            expect(event, ideal, due > p.firstUp);
+            due += repeatInterval(n);
+            ideal += repeatInterval(n);
+        }
+    }
+}
+
+// Contact closed for less than the debounce time: nothing
+void ButtonBench::buildGlitches() {
+    uint64_t t = BENCH_START_US;
+    for (int i = 0; i < _presses; i++) {
+        uint8_t pin = i % 2 == 0 ? BTN_RIGHT : BTN_MID;
+        uint64_t closed = bounce(t, pin, LOW);
+        uint64_t open = bounce(closed + random(200, 20000), pin, HIGH);
+        t = open + random(100, 500) * MS;
+    }
+}
+
+ButtonBenchCase ButtonBench::play(const char* name, ButtonBenchReport& report) {
+    std::stable_sort(_changes.begin(), _changes.end(), [](const PinChange& a, const PinChange& b) {
+        return a.timeUs < b.timeUs;
+    });
+    
+    HostHal::reset();
+    ButtonHandler handler;
+    handler.begin();
+    
+    // Edges happen at their time (interrupt included); loop() every poll
+    // interval unless stalled
+    std::vector<std::pair<ButtonEvent, uint64_t> > received;
+    uint64_t end = (_changes.empty() ? BENCH_START_US : _changes.back().timeUs) + BENCH_TAIL_US;
+    uint64_t now = 0;
+    uint64_t nextPoll = BENCH_POLL_US;
+    size_t change = 0;
+    size_t stall = 0;
+    while (nextPoll <= end) {
+        if (change < _changes.size() && _changes[change].timeUs <= nextPoll) {
+            HostHal::advanceMicros(_changes[change].timeUs - now);
+            now = _changes[change].timeUs;
+            HostHal::setPinLevel(_changes[change].pin, _changes[change].level);
+            change++;
+            continue;
+        }
+        
+        HostHal::advanceMicros(nextPoll - now);
+        now = nextPoll;
+        nextPoll += BENCH_POLL_US;
+        
+        while (stall < _stalls.size() && _stalls[stall].second <= now) stall++;
+        if (stall < _stalls.size() && _stalls[stall].first <= now) continue;
+        
+        handler.loop();
+        ButtonEvent event;
+        while ((event = handler.getEvent()) != BTN_NONE) received.push_back(std::make_pair(event, now));
+    }
+    
+    // Each delivered event takes the earliest open expectation it can be
+    std::stable_sort(_expected.begin(), _expected.end(), [](const Expected& a, const Expected& b) {
+        return a.readyUs < b.readyUs;
+    });
+    ButtonBenchCase result = ButtonBenchCase();
+    result.name = name;
+    result.received = received.size();
+    std::vector<float> latencies;
+    for (size_t r = 0; r < received.size(); r++) {
+        Expected* match = nullptr;
+        for (size_t e = 0; e < _expected.size(); e++) {
+            Expected& candidate = _expected[e];
+            if (candidate.matched || candidate.event != received[r].first) continue;
+            if (candidate.readyUs > received[r].second) break;
+            match = &candidate;
+            break;
+        }
+        if (!match) {
+            result.spurious++;
+            continue;
+        }
+        match->matched = true;
+        latencies.push_back((received[r].second - match->readyUs) / 1000.0f);
+    }
+    for (size_t e = 0; e < _expected.size(); e++) {
+        if (_expected[e].optional) continue;
+        result.expected++;
+        if (!_expected[e].matched) result.lost++;
+    }
+    
+    std::sort(latencies.begin(), latencies.end());
+    result.latencyP50Ms = percentile(latencies, 50);
+    result.latencyP99Ms = percentile(latencies, 99);
+    result.latencyMaxMs = latencies.empty() ? 0 : latencies.back();
+    
+    report.droppedEdges += handler.getDroppedEdges();
+    report.droppedEvents += handler.getDroppedEvents();
+    report.lost += result.lost;
+    report.spurious += result.spurious;
+    return result;
+}
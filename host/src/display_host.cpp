@@ -0,0 +1,275 @@
+// display_host.cpp
+// Host HAL I2C bus, GFX drawing and SSD1306 frame buffer
+#include "Wire.h"
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1306.h"
+
+namespace {
+    const int I2C_CLOCKS_PER_BYTE = 9;      // 8 data bits + ACK
+    const int I2C_CLOCKS_PER_TRANSACTION = 2;   // START + STOP
+    const size_t WIRE_MAX = I2C_BUFFER_LENGTH;
+    
+    // Stand-in glyph: 5 columns of 7 rows, fixed per character code
+    uint8_t glyphColumn(uint8_t c, int column) {
+        if (c == ' ') return 0;
+        uint32_t h = (c + 1) * 2654435761u + column * 40503u;
+        h ^= h >> 13;
+        return (uint8_t)((h & 0x7F) | (column == 2 ? 0x01 : 0));
+    }
+}
+
+// ==================== I2C ====================
+TwoWire Wire;
+
+TwoWire::TwoWire()
+    : _clock(100000),
+      _pending(0),
+      _address(0),
+      _device(nullptr),
+      _deviceAddress(0),
+      _transactions(0),
+      _bytes(0),
+      _overflows(0),
+      _busMs(0) {
+}
+
+bool TwoWire::begin(int /*sda*/, int /*scl*/, uint32_t frequency) {
+    if (frequency > 0) _clock = frequency;
+    return true;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+    _clock = frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _address = address;
+    _pending = 1;                 // Address byte
+}
+
+uint8_t TwoWire::endTransmission(bool /*sendStop*/) {
+    if (_device && _address == _deviceAddress && _pending > 1) _device->receive(_buffer, _pending - 1);
+    
+    _transactions++;
+    _bytes += _pending;
+    _busMs += (double)(_pending * I2C_CLOCKS_PER_BYTE + I2C_CLOCKS_PER_TRANSACTION) * 1000.0 / _clock;
+    _pending = 0;
+    return 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    // The ESP32 core drops bytes that do not fit its buffer
+    if (_pending >= WIRE_MAX + 1) {
+        _overflows++;
+        return 0;
+    }
+    _buffer[_pending - 1] = data;
+    _pending++;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size) {
+    size_t n = 0;
+    for (size_t i = 0; i < size; i++) n += write(data[i]);
+    return n;
+}
+
+void TwoWire::attach(uint8_t address, HostI2cDevice* device) {
+    _deviceAddress = address;
+    _device = device;
+}
+
+void TwoWire::resetCounters() {
+    _transactions = 0;
+    _bytes = 0;
+    _overflows = 0;
+    _busMs = 0;
+}
+
+// ==================== GFX ====================
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h)
+    : _width(w),
+      _height(h),
+      _cursorX(0),
+      _cursorY(0),
+      _textSize(1),
+      _textColor(1),
+      _wrap(true) {
+}
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    // Bresenham
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+        drawPixel(x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+}
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < h; i++) drawFastHLine(x, y + i, w, color);
+}
+
+void Adafruit_GFX::fillScreen(uint16_t color) {
+    fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    for (int16_t y = -r; y <= r; y++) {
+        for (int16_t x = -r; x <= r; x++) {
+            int d = x * x + y * y;
+            if (d <= r * r && d > (r - 1) * (r - 1)) drawPixel(x0 + x, y0 + y, color);
+        }
+    }
+}
+
+void Adafruit_GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    for (int16_t y = -r; y <= r; y++) {
+        for (int16_t x = -r; x <= r; x++) {
+            if (x * x + y * y <= r * r) drawPixel(x0 + x, y0 + y, color);
+        }
+    }
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        _cursorX = 0;
+        _cursorY += 8 * _textSize;
+    } else if (c != '\r') {
+        if (_wrap && _cursorX + 6 * _textSize > _width) {
+            _cursorX = 0;
+            _cursorY += 8 * _textSize;
+        }
+        drawChar(_cursorX, _cursorY, c);
+        _cursorX += 6 * _textSize;
+    }
+    return 1;
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, uint8_t c) {
+    for (int column = 0; column < 5; column++) {
+        uint8_t bits = glyphColumn(c, column);
+        for (int row = 0; row < 8; row++) {
+            if (!(bits & (1 << row))) continue;
+            if (_textSize == 1) drawPixel(x + column, y + row, _textColor);
+            else fillRect(x + column * _textSize, y + row * _textSize, _textSize, _textSize, _textColor);
+        }
+    }
+}
+
+// ==================== SSD1306 ====================
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t /*rst*/,
+                                   uint32_t clkDuring, uint32_t clkAfter)
+    : Adafruit_GFX(w, h),
+      _wire(twi),
+      _address(0),
+      _clkDuring(clkDuring),
+      _clkAfter(clkAfter),
+      _buffer(nullptr) {
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+    free(_buffer);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t /*vcs*/, uint8_t addr, bool /*reset*/, bool periphBegin) {
+    if (!_buffer) _buffer = (uint8_t*)malloc(_width * ((_height + 7) / 8));
+    if (!_buffer) return false;
+    clearDisplay();
+    _address = addr;
+    if (periphBegin) _wire->begin();
+    
+    // Length of the library's init sequence for a 128x64 panel
+    static const uint8_t init[] = {
+        SSD1306_DISPLAYOFF, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0x8D, 0x14,
+        SSD1306_MEMORYMODE, 0x00, 0xA1, 0xC8, 0xDA, 0x12, SSD1306_SETCONTRAST, 0xCF,
+        0xD9, 0xF1, 0xDB, 0x40, 0xA4, 0xA6, 0x2E, SSD1306_DISPLAYON
+    };
+    _wire->setClock(_clkDuring);
+    sendCommands(init, sizeof(init));
+    _wire->setClock(_clkAfter);
+    return true;
+}
+
+// Same transactions as the library: address window, then the buffer in
+// chunks that fit the Wire buffer with the 0x40 control byte
+void Adafruit_SSD1306::display() {
+    static const uint8_t window[] = { SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0, 127 };
+    _wire->setClock(_clkDuring);
+    sendCommands(window, sizeof(window));
+    
+    size_t count = _width * ((_height + 7) / 8);
+    size_t bytesOut = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (bytesOut == 0) {
+            _wire->beginTransmission(_address);
+            _wire->write((uint8_t)0x40);
+            bytesOut = 1;
+        }
+        _wire->write(_buffer[i]);
+        if (++bytesOut >= WIRE_MAX) {
+            _wire->endTransmission();
+            bytesOut = 0;
+        }
+    }
+    if (bytesOut > 0) _wire->endTransmission();
+    _wire->setClock(_clkAfter);
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+    if (_buffer) memset(_buffer, 0, _width * ((_height + 7) / 8));
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (!_buffer || x < 0 || x >= _width || y < 0 || y >= _height) return;
+    
+    uint8_t& cell = _buffer[x + (y / 8) * _width];
+    uint8_t bit = 1 << (y & 7);
+    switch (color) {
+        case SSD1306_WHITE: cell |= bit; break;
+        case SSD1306_BLACK: cell &= ~bit; break;
+        case SSD1306_INVERSE: cell ^= bit; break;
+    }
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+    sendCommands(&c, 1);
+}
+
+void Adafruit_SSD1306::dim(bool dim) {
+    uint8_t commands[] = { SSD1306_SETCONTRAST, (uint8_t)(dim ? 0 : 0xCF) };
+    sendCommands(commands, sizeof(commands));
+}
+
+void Adafruit_SSD1306::invertDisplay(bool invert) {
+    ssd1306_command(invert ? 0xA7 : 0xA6);
+}
+
+void Adafruit_SSD1306::sendCommands(const uint8_t* commands, size_t count) {
+    _wire->beginTransmission(_address);
+    _wire->write((uint8_t)0x00);
+    _wire->write(commands, count);
+    _wire->endTransmission();
+}
@@ -0,0 +1,122 @@
+// event_bus_bench.cpp
+#include "event_bus_bench.h"
+#include "tank_simulator.h"
+#include "host_hal.h"
+#include <chrono>
+
+namespace {
+    const int COST_EVENTS = 1000000;
+    
+    typedef std::chrono::steady_clock Clock;
+    
+    double nsPer(Clock::time_point start, long count) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+    }
+    
+    // Stands in for every handler, so the cost is the bus's own
+    template <typename T>
+    void countEvent(const T&, void* context) {
+        (*static_cast<volatile uint32_t*>(context))++;
+    }
+}
+
+EventBusCost EventBusBench::cost() {
+    EventBusCost r = EventBusCost();
+    volatile uint32_t delivered = 0;
+    void* context = (void*)&delivered;
+    
+    EventBus* bus = new EventBus();
+    bus->subscribe<LevelEvent>(countEvent<LevelEvent>, context);   // Pump control
+    bus->subscribe<LevelEvent>(countEvent<LevelEvent>, context);   // Tracker
+    bus->subscribe<PumpEvent>(countEvent<PumpEvent>, context);     // Tracker
+    bus->subscribe<LevelEvent>(countEvent<LevelEvent>, context);   // Snapshot + display
+    bus->subscribe<PumpEvent>(countEvent<PumpEvent>, context);     // Snapshot + display
+    bus->subscribe<LevelEvent>(countEvent<LevelEvent>, context);   // Trend history
+    bus->subscribe<PumpEvent>(countEvent<PumpEvent>, context);     // Telemetry
+    
+    LevelEvent level = LevelEvent();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < COST_EVENTS; i++) {
+        level.timestamp = i;
+        bus->publish(level);
+        bus->dispatch();
+    }
+    r.nsPerLevelEvent = nsPer(start, COST_EVENTS);
+    r.nsPerDelivery = r.nsPerLevelEvent / 4;
+    
+    PumpEvent pump = PumpEvent();
+    start = Clock::now();
+    for (int i = 0; i < COST_EVENTS; i++) {
+        pump.timestamp = i;
+        bus->publish(pump);
+        bus->dispatch();
+    }
+    r.nsPerPumpEvent = nsPer(start, COST_EVENTS);
+    
+    const int bursts = COST_EVENTS / EVENT_BUS_QUEUE_SIZE;
+    start = Clock::now();
+    for (int i = 0; i < bursts; i++) {
+        for (int e = 0; e < EVENT_BUS_QUEUE_SIZE; e++) {
+            level.timestamp = e;
+            bus->publish(level);
+        }
+        bus->dispatch();
+    }
+    r.nsPerBurstEvent = nsPer(start, (long)bursts * EVENT_BUS_QUEUE_SIZE);
+    
+    start = Clock::now();
+    for (int i = 0; i < COST_EVENTS; i++) bus->dispatch();
+    r.nsPerIdleDispatch = nsPer(start, COST_EVENTS);
+    
+    delete bus;
+    return r;
+}
+
+void EventBusBench::markChanged(Counters* counters) {
+    counters->snapshots++;
+    
+    // The display task refreshes at most once per tick, if dirty
+    unsigned long tick = HostHal::uptimeMs() / DISPLAY_UPDATE_INTERVAL_MS + 1;
+    if (tick != counters->lastDirtyTick) {
+        counters->lastDirtyTick = tick;
+        counters->displayRefreshes++;
+    }
+}
+
+void EventBusBench::onLevel(const LevelEvent&, void* context) {
+    Counters* counters = static_cast<Counters*>(context);
+    counters->level++;
+    markChanged(counters);
+}
+
+void EventBusBench::onPump(const PumpEvent&, void* context) {
+    Counters* counters = static_cast<Counters*>(context);
+    counters->pump++;
+    markChanged(counters);
+}
+
+void EventBusBench::subscribe(EventBus& bus, void* context) {
+    bus.subscribe<LevelEvent>(onLevel, context);
+    bus.subscribe<PumpEvent>(onPump, context);
+}
+
+EventBusUpdates EventBusBench::updates(const SimScenario& scenario) {
+    Counters counters = Counters();
+    TankSimulator sim(scenario);
+    sim.setBusHook(subscribe, &counters);
+    SimMetrics m = sim.run();
+    
+    EventBusUpdates r = EventBusUpdates();
+    r.passes = m.passes;
+    r.levelEvents = counters.level;
+    r.pumpEvents = counters.pump;
+    r.trackerBefore = m.passes;
+    r.trackerAfter = counters.level + counters.pump;
+    r.snapshotBefore = m.passes;
+    r.snapshotAfter = counters.snapshots;
+    r.displayBefore = (uint64_t)(m.simHours * 3600000.0 + 0.5) / DISPLAY_UPDATE_INTERVAL_MS;
+    r.displayAfter = counters.displayRefreshes;
+    r.eliminated = (r.trackerBefore - r.trackerAfter) + (r.snapshotBefore - r.snapshotAfter) +
+                   (r.displayBefore - r.displayAfter);
+    return r;
+}
@@ -0,0 +1,544 @@
+// hal_host.cpp
+// Host HAL implementation (native build only)
+#include "host_hal.h"
+#include "heap_tracker.h"
+#include <esp_timer.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+FS SPIFFS;
+
+namespace {
+    const int HOST_PIN_COUNT = 64;
+    
+    uint64_t nowUs = 0;
+    time_t epochAtZero = 1704067200;      // 2024-01-01 00:00:00 UTC at millis() == 0
+    
+    uint8_t pinModes[HOST_PIN_COUNT];
+    uint8_t pinLevels[HOST_PIN_COUNT];
+    unsigned long pulseWidths[HOST_PIN_COUNT];
+    voidFuncPtrArg pinHandlers[HOST_PIN_COUNT];
+    void* pinHandlerArgs[HOST_PIN_COUNT];
+    int pinHandlerModes[HOST_PIN_COUNT];
+    HostHal::PulseSource pulseSource = nullptr;
+    void* pulseContext = nullptr;
+    
+    bool serialEcho = true;
+    
+    uint32_t nvsReads = 0;
+    uint32_t nvsReadBytes = 0;
+    uint32_t nvsWrites = 0;
+    long nvsWriteBudget = -1;
+    
+    // A write that may reach the store (false once the power is "cut")
+    bool nvsWrite() {
+        if (nvsWriteBudget == 0) return false;
+        if (nvsWriteBudget > 0) nvsWriteBudget--;
+        nvsWrites++;
+        return true;
+    }
+    
+    bool validPin(uint8_t pin) {
+        return pin < HOST_PIN_COUNT;
+    }
+}
+
+// ==================== CLOCK ====================
+
+unsigned long millis() {
+    return (unsigned long)(nowUs / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)nowUs;
+}
+
+void delay(unsigned long ms) {
+    nowUs += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+    nowUs += us;
+}
+
+void yield() {
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)nowUs;
+}
+
+// Linked with -Wl,--wrap=time: wall clock follows the simulated clock
+extern "C" time_t __wrap_time(time_t* out) {
+    time_t now = epochAtZero + (time_t)(nowUs / 1000000);
+    if (out) *out = now;
+    return now;
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2, const char* server3) {
+    (void)gmtOffsetSec; (void)daylightOffsetSec;
+    (void)server1; (void)server2; (void)server3;
+}
+
+// ==================== GPIO ====================
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (!validPin(pin)) return;
+    pinModes[pin] = mode;
+    if (mode == INPUT_PULLUP) pinLevels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (!validPin(pin)) return;
+    uint8_t previous = pinLevels[pin];
+    pinLevels[pin] = level ? HIGH : LOW;
+    if (pinLevels[pin] == previous || !pinHandlers[pin]) return;
+    
+    // Interrupt runs synchronously, at the current simulated time
+    int edge = pinLevels[pin] == HIGH ? RISING : FALLING;
+    if (pinHandlerModes[pin] & edge) pinHandlers[pin](pinHandlerArgs[pin]);
+}
+
+void attachInterruptArg(uint8_t pin, voidFuncPtrArg handler, void* arg, int mode) {
+    if (!validPin(pin)) return;
+    pinHandlers[pin] = handler;
+    pinHandlerArgs[pin] = arg;
+    pinHandlerModes[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (validPin(pin)) pinHandlers[pin] = nullptr;
+}
+
+int digitalRead(uint8_t pin) {
+    return validPin(pin) ? pinLevels[pin] : LOW;
+}
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeoutUs) {
+    (void)state;
+    unsigned long width = 0;
+    if (pulseSource) width = pulseSource(pin, pulseContext);
+    else if (validPin(pin)) width = pulseWidths[pin];
+    
+    // A measurement takes as long as the echo (or the timeout)
+    if (width == 0 || width > timeoutUs) {
+        nowUs += timeoutUs;
+        return 0;
+    }
+    nowUs += width;
+    return width;
+}
+
+// ==================== STRING ====================
+
+void String::setFloat(double value, unsigned int decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+    _s = buffer;
+}
+
+void String::replace(const String& from, const String& to) {
+    if (from._s.empty()) return;
+    size_t pos = 0;
+    while ((pos = _s.find(from._s, pos)) != std::string::npos) {
+        _s.replace(pos, from._s.size(), to._s);
+        pos += to._s.size();
+    }
+}
+
+void String::trim() {
+    size_t start = 0;
+    while (start < _s.size() && isspace((unsigned char)_s[start])) start++;
+    size_t end = _s.size();
+    while (end > start && isspace((unsigned char)_s[end - 1])) end--;
+    _s = _s.substr(start, end - start);
+}
+
+void String::toUpperCase() {
+    for (size_t i = 0; i < _s.size(); i++) _s[i] = toupper((unsigned char)_s[i]);
+}
+
+void String::toLowerCase() {
+    for (size_t i = 0; i < _s.size(); i++) _s[i] = tolower((unsigned char)_s[i]);
+}
+
+// ==================== SERIAL ====================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(long value, int base) {
+    char buffer[40];
+    if (base == HEX) snprintf(buffer, sizeof(buffer), "%lx", value);
+    else snprintf(buffer, sizeof(buffer), "%ld", value);
+    return print(buffer);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    char buffer[40];
+    if (base == HEX) snprintf(buffer, sizeof(buffer), "%lx", value);
+    else snprintf(buffer, sizeof(buffer), "%lu", value);
+    return print(buffer);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    return write((const uint8_t*)buffer, std::min((size_t)len, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (serialEcho) fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (serialEcho) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+void EspClass::restart() {
+    fprintf(stderr, "ESP.restart() called on host\n");
+    exit(1);
+}
+
+// ==================== KEY-VALUE STORE ====================
+
+std::map<std::string, Preferences::Namespace>& Preferences::store() {
+    static std::map<std::string, Namespace> namespaces;
+    return namespaces;
+}
+
+Preferences::Preferences() : _ns(nullptr), _readOnly(false) {
+}
+
+Preferences::~Preferences() {
+    end();
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    (void)partitionLabel;
+    if (_ns || !name || strlen(name) > 15) return false;
+    
+    // The store stands in for flash: not device heap
+    HeapTracker::pause();
+    _ns = &store()[name];
+    HeapTracker::resume();
+    _readOnly = readOnly;
+    return true;
+}
+
+void Preferences::end() {
+    _ns = nullptr;
+}
+
+bool Preferences::clear() {
+    if (!_ns || _readOnly || !nvsWrite()) return false;
+    _ns->clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_ns || _readOnly || !_ns->count(key) || !nvsWrite()) return false;
+    return _ns->erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return _ns && _ns->count(key) > 0;
+}
+
+size_t Preferences::freeEntries() {
+    return _ns ? 1000 : 0;
+}
+
+size_t Preferences::put(const char* key, const void* value, size_t len) {
+    // NVS keys are limited to 15 characters
+    if (!_ns || _readOnly || !key || strlen(key) > 15 || !nvsWrite()) return 0;
+    const uint8_t* bytes = (const uint8_t*)value;
+    HeapTracker::pause();
+    (*_ns)[key] = Blob(bytes, bytes + len);
+    HeapTracker::resume();
+    return len;
+}
+
+const Preferences::Blob* Preferences::get(const char* key) {
+    if (!_ns || !key) return nullptr;
+    nvsReads++;
+    Namespace::const_iterator it = _ns->find(key);
+    if (it == _ns->end()) return nullptr;
+    nvsReadBytes += it->second.size();
+    return &it->second;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    uint8_t v = value ? 1 : 0;
+    return put(key, &v, sizeof(v));
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putULong(const char* key, uint32_t value) {
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putFloat(const char* key, float value) {
+    return put(key, &value, sizeof(value));
+}
+
+// Stores the terminator but, like Arduino-ESP32, reports strlen()
+size_t Preferences::putString(const char* key, const char* value) {
+    return put(key, value, strlen(value) + 1) ? strlen(value) : 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return putString(key, value.c_str());
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    return put(key, value, len);
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    return getValue<uint8_t>(key, defaultValue ? 1 : 0) != 0;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    return getValue<uint8_t>(key, defaultValue);
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    return getValue<int32_t>(key, defaultValue);
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    return getValue<uint32_t>(key, defaultValue);
+}
+
+uint32_t Preferences::getULong(const char* key, uint32_t defaultValue) {
+    return getValue<uint32_t>(key, defaultValue);
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    return getValue<float>(key, defaultValue);
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    const Blob* blob = get(key);
+    if (!blob || blob->empty()) return defaultValue;
+    return String(std::string((const char*)blob->data(), blob->size() - 1));
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    const Blob* blob = get(key);
+    return blob ? blob->size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLen) {
+    const Blob* blob = get(key);
+    if (!blob || blob->size() > maxLen) return 0;
+    memcpy(buffer, blob->data(), blob->size());
+    return blob->size();
+}
+
+// ==================== FILE SYSTEM ====================
+
+namespace {
+    const size_t HOST_FS_BYTES = 1408 * 1024;     // Default partition table's SPIFFS
+}
+
+std::map<std::string, std::vector<uint8_t> >& FS::files() {
+    static std::map<std::string, std::vector<uint8_t> > all;
+    return all;
+}
+
+bool FS::begin(bool formatOnFail) {
+    (void)formatOnFail;
+    return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+    File file;
+    if (!path || !mode) return file;
+    
+    std::map<std::string, std::vector<uint8_t> >::iterator it = files().find(path);
+    if (mode[0] == 'r') {
+        if (it == files().end()) return file;
+        file._data = &it->second;
+        return file;
+    }
+    
+    HeapTracker::pause();
+    std::vector<uint8_t>& data = files()[path];
+    HeapTracker::resume();
+    if (mode[0] == 'w') data.clear();
+    file._data = &data;
+    file._pos = data.size();
+    file._writable = true;
+    return file;
+}
+
+bool FS::exists(const char* path) {
+    return path && files().count(path) > 0;
+}
+
+bool FS::remove(const char* path) {
+    return path && files().erase(path) > 0;
+}
+
+size_t FS::totalBytes() {
+    return HOST_FS_BYTES;
+}
+
+size_t FS::usedBytes() {
+    size_t used = 0;
+    std::map<std::string, std::vector<uint8_t> >::iterator it;
+    for (it = files().begin(); it != files().end(); ++it) used += it->second.size();
+    return used;
+}
+
+File::File() : _data(nullptr), _pos(0), _writable(false) {
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!_data || !_writable) return 0;
+    if (_pos + size > _data->size()) {
+        HeapTracker::pause();
+        _data->resize(_pos + size);
+        HeapTracker::resume();
+    }
+    memcpy(_data->data() + _pos, buffer, size);
+    _pos += size;
+    return size;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!_data || _pos >= _data->size()) return 0;
+    size_t n = std::min(size, _data->size() - _pos);
+    memcpy(buffer, _data->data() + _pos, n);
+    _pos += n;
+    return n;
+}
+
+int File::available() {
+    return _data && _pos < _data->size() ? (int)(_data->size() - _pos) : 0;
+}
+
+bool File::seek(uint32_t pos) {
+    if (!_data || pos > _data->size()) return false;
+    _pos = pos;
+    return true;
+}
+
+size_t File::size() const {
+    return _data ? _data->size() : 0;
+}
+
+void File::close() {
+    _data = nullptr;
+    _pos = 0;
+}
+
+// ==================== TEST CONTROLS ====================
+
+void HostHal::advanceMillis(unsigned long ms) {
+    nowUs += (uint64_t)ms * 1000;
+}
+
+void HostHal::advanceMicros(uint64_t us) {
+    nowUs += us;
+}
+
+uint64_t HostHal::uptimeMs() {
+    return nowUs / 1000;
+}
+
+void HostHal::setEpoch(time_t epoch) {
+    epochAtZero = epoch - (time_t)(nowUs / 1000000);
+}
+
+int HostHal::getPinLevel(uint8_t pin) {
+    return digitalRead(pin);
+}
+
+void HostHal::setPinLevel(uint8_t pin, int level) {
+    digitalWrite(pin, level);
+}
+
+uint8_t HostHal::getPinMode(uint8_t pin) {
+    return validPin(pin) ? pinModes[pin] : 0;
+}
+
+void HostHal::setPulseWidth(uint8_t pin, unsigned long us) {
+    if (validPin(pin)) pulseWidths[pin] = us;
+}
+
+void HostHal::setPulseSource(PulseSource source, void* context) {
+    pulseSource = source;
+    pulseContext = context;
+}
+
+void HostHal::clearPreferences() {
+    Preferences::store().clear();
+}
+
+void HostHal::clearFiles() {
+    FS::files().clear();
+}
+
+uint32_t HostHal::getNvsReads() {
+    return nvsReads;
+}
+
+uint32_t HostHal::getNvsReadBytes() {
+    return nvsReadBytes;
+}
+
+uint32_t HostHal::getNvsWrites() {
+    return nvsWrites;
+}
+
+void HostHal::setNvsWriteBudget(long writes) {
+    nvsWriteBudget = writes;
+}
+
+HostHal::NvsImage HostHal::getNvs() {
+    return Preferences::store();
+}
+
+void HostHal::setNvs(const NvsImage& image) {
+    Preferences::store() = image;
+}
+
+void HostHal::setSerialEcho(bool enabled) {
+    serialEcho = enabled;
+}
+
+void HostHal::reset() {
+    nowUs = 0;
+    memset(pinModes, 0, sizeof(pinModes));
+    memset(pinLevels, 0, sizeof(pinLevels));
+    memset(pulseWidths, 0, sizeof(pulseWidths));
+    memset(pinHandlers, 0, sizeof(pinHandlers));
+    pulseSource = nullptr;
+    pulseContext = nullptr;
+}
@@ -0,0 +1,198 @@
+// heap_tracker.cpp
+#include "heap_tracker.h"
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+    const uint32_t NOT_IN_ARENA = 0xFFFFFFFF;
+    
+    // In front of every block handed out; 16 bytes keeps max_align_t
+    struct BlockHeader {
+        uint32_t size;
+        uint32_t offset;          // In the model arena, NOT_IN_ARENA if untracked
+        uint32_t generation;      // start() that placed it
+        uint32_t reserved;
+    };
+    
+    struct FreeRange {
+        uint32_t offset;
+        uint32_t size;
+    };
+    
+    bool tracking = false;
+    int pauseDepth = 0;
+    uint32_t generation = 0;
+    HeapStats stats;
+    
+    // Model arena: sorted, coalesced free list
+    FreeRange freeRanges[HOST_HEAP_MAX_FREE_RANGES];
+    int freeCount = 0;
+    
+    uint32_t blockSize(size_t size) {
+        return (uint32_t)((size + 3) & ~(size_t)3) + HOST_HEAP_BLOCK_OVERHEAD;
+    }
+    
+    void resetArena() {
+        freeRanges[0].offset = 0;
+        freeRanges[0].size = HOST_HEAP_ARENA_BYTES;
+        freeCount = 1;
+    }
+    
+    // First fit, as multi_heap does within a size class
+    uint32_t arenaAlloc(uint32_t size) {
+        for (int i = 0; i < freeCount; i++) {
+            if (freeRanges[i].size < size) continue;
+            
+            uint32_t offset = freeRanges[i].offset;
+            freeRanges[i].offset += size;
+            freeRanges[i].size -= size;
+            if (freeRanges[i].size == 0) {
+                memmove(&freeRanges[i], &freeRanges[i + 1], (freeCount - i - 1) * sizeof(FreeRange));
+                freeCount--;
+            }
+            return offset;
+        }
+        return NOT_IN_ARENA;
+    }
+    
+    void arenaFree(uint32_t offset, uint32_t size) {
+        // First range after the block
+        int lo = 0;
+        int hi = freeCount;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (freeRanges[mid].offset < offset) lo = mid + 1;
+            else hi = mid;
+        }
+        
+        bool joinPrev = lo > 0 && freeRanges[lo - 1].offset + freeRanges[lo - 1].size == offset;
+        bool joinNext = lo < freeCount && offset + size == freeRanges[lo].offset;
+        
+        if (joinPrev && joinNext) {
+            freeRanges[lo - 1].size += size + freeRanges[lo].size;
+            memmove(&freeRanges[lo], &freeRanges[lo + 1], (freeCount - lo - 1) * sizeof(FreeRange));
+            freeCount--;
+        } else if (joinPrev) {
+            freeRanges[lo - 1].size += size;
+        } else if (joinNext) {
+            freeRanges[lo].offset = offset;
+            freeRanges[lo].size += size;
+        } else if (freeCount < HOST_HEAP_MAX_FREE_RANGES) {
+            memmove(&freeRanges[lo + 1], &freeRanges[lo], (freeCount - lo) * sizeof(FreeRange));
+            freeRanges[lo].offset = offset;
+            freeRanges[lo].size = size;
+            freeCount++;
+        }
+        // else: the free list is full and the range is lost (reported as fragmentation)
+    }
+    
+    void* allocate(size_t size) {
+        BlockHeader* header = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + size));
+        if (!header) throw std::bad_alloc();
+        
+        header->size = (uint32_t)size;
+        header->offset = NOT_IN_ARENA;
+        header->generation = generation;
+        
+        if (tracking && pauseDepth == 0) {
+            stats.allocations++;
+            stats.bytesAllocated += size;
+            stats.liveBytes += size;
+            stats.liveBlocks++;
+            if (stats.liveBytes > stats.peakBytes) stats.peakBytes = stats.liveBytes;
+            
+            header->offset = arenaAlloc(blockSize(size));
+            if (header->offset == NOT_IN_ARENA) stats.outOfMemory++;
+        }
+        return header + 1;
+    }
+    
+    void release(void* ptr) {
+        if (!ptr) return;
+        
+        BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+        if (header->offset != NOT_IN_ARENA && header->generation == generation) {
+            stats.frees++;
+            stats.liveBytes -= header->size;
+            stats.liveBlocks--;
+            arenaFree(header->offset, blockSize(header->size));
+        }
+        free(header);
+    }
+}
+
+void HeapTracker::start() {
+    memset(&stats, 0, sizeof(stats));
+    resetArena();
+    generation++;
+    tracking = true;
+    pauseDepth = 0;
+}
+
+void HeapTracker::stop() {
+    tracking = false;
+}
+
+void HeapTracker::pause() {
+    pauseDepth++;
+}
+
+void HeapTracker::resume() {
+    if (pauseDepth > 0) pauseDepth--;
+}
+
+HeapStats HeapTracker::getStats() {
+    HeapStats result = stats;
+    result.arenaFree = 0;
+    result.largestFree = 0;
+    for (int i = 0; i < freeCount; i++) {
+        result.arenaFree += freeRanges[i].size;
+        if (freeRanges[i].size > result.largestFree) result.largestFree = freeRanges[i].size;
+    }
+    result.fragmentationPct = result.arenaFree > 0
+        ? 100.0f * (1.0f - (float)result.largestFree / result.arenaFree) : 0;
+    return result;
+}
+
+// ==================== GLOBAL ALLOCATOR ====================
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    release(ptr);
+}
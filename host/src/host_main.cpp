@@ -0,0 +1,1159 @@
+// host_main.cpp
+// Native build entry point.
+//
+//     program [--verbose] [--record trace.bin] scenario.txt...
+//         Run simulator scenarios against the firmware core and print
+//         their metrics as "key value" lines (diff two runs for
+//         regressions). --record saves the input trace of a single
+//         scenario, in the /api/trace download format.
+//
+//     program --replay trace.bin
+//         Replay a trace through the control loop and diff the pump
+//         changes against the recorded ones (exit status 3 on divergence).
+//
+//     program --bench-trace
+//         Trace recorder throughput and size per record.
+//
+//     program --bench-display [minutes]
+//         OLED bus traffic per minute with partial updates, against a
+//         full frame on every display pass (default 60 minutes).
+//
+//     program --bench-render [frames]
+//         Display render time and heap allocations per frame for the
+//         main, status and usage screens with every value changing.
+//
+//     program --render-screens dir
+//         Every OLED screen with fixed data, drawn on the in-memory panel
+//         (MemoryDisplay) and saved as dir/<screen>.pbm and .png, with the
+//         draw calls and time of a full redraw of each.
+//
+//     program --check-screens dir
+//         The same screens compared with the images a --render-screens
+//         run saved in dir; prints the changed pixels per screen (exit
+//         status 5 when any screen changed).
+//
+//     program --bench-draw [iterations]
+//         Time per call of each GFX drawing routine on the in-memory panel,
+//         and of diffing and sending a frame.
+//
+//     program --bench-buttons [presses]
+//         Button presses with contact bounce through the pin interrupts
+//         and ButtonHandler: clicks, presses during a stalled loop(),
+//         double clicks, long presses, auto-repeat and short glitches.
+//         Lost and spurious events and input-to-event latency per case
+//         (exit status 6 on any loss or spurious event).
+//
+//     program --bench-usage [queries]
+//         Month-to-date usage from WaterTracker's running total, from the
+//         daily table, and from the per-day keys it replaced, over a year
+//         of records: time, key lookups and bytes read per query (exit
+//         status 7 when the results disagree).
+//
+//     program --bench-history [queries]
+//         The last 30 and 365 days of usage from the daily table (cached,
+//         and read afresh) and from the per-day keys it replaced: time,
+//         key lookups and bytes read per query (exit status 7 when the
+//         results disagree).
+//
+//     program --wear scenario.txt
+//         Run a scenario and print the NVS writes per key that
+//         FlashWearMonitor counted (setup excluded), per simulated day,
+//         with the projected flash lifetime at that rate.
+//
+//     program --bench-export [chunk_bytes]
+//         Daily history exports of a month and a year in CSV and NDJSON,
+//         read in chunks as the web server's chunked response does
+//         (default 1460 bytes): bytes, rows, throughput and peak heap
+//         (exit status 7 on a missing or extra row).
+//
+//     program --test-power-cut
+//         Cut the power at every NVS write of the multi-key storage saves
+//         (and of the boot replay that follows) and check that the
+//         rebooted device reads back the old or the new state, never a
+//         mix; prints the boot replay cost (exit status 7 on a torn state
+//         or a leftover journal).
+//
+//     program --test-draws [draws]
+//         Synthetic draws of every size (default 400) through the draw
+//         event segmenter, as exact per-reading flow, as the deadband
+//         lumps the idle tracker books, with sensor noise, and with
+//         pauses inside draws: matched, merged, missed and spurious
+//         events, volume error and classification (exit status 7 when
+//         the exact trace is not segmented one event per draw).
+//
+//     program --test-leak [weeks] scenario.txt
+//         Run a scenario for weeks (default 3) without a leak and with
+//         constant leaks of 0.05 to 0.5 L/min from day 7: hours from the
+//         leak starting to WaterTracker's alarm, and alarms raised with no
+//         leak (exit status 7 on a false alarm, or a leak of twice
+//         LEAK_MIN_FLOW_LPM or more that is never reported).
+//
+//     program --test-fill-draws [days] scenario.txt
+//         Run a scenario for days (default 6), then one more day at its own
+//         demand, 3x and 6x: water drawn on that day while the pump was
+//         filling against what WaterTracker booked during fills, and the
+//         day's usage error with and without that fill-time accounting
+//         (exit status 7 when it makes the error worse).
+//
+//     program --test-profile [weeks]
+//         Feed DemandProfile weeks (default 12) of hourly usage drawn from a
+//         known weekday x hour pattern, then move the weekday morning peak:
+//         cost of addUsage() and loop(), error against the pattern after
+//         each week and against the EWMA's own noise floor, weeks to follow
+//         the moved peak, and a save/reload round trip (exit status 7 when
+//         the profile ends above 1.5x the floor, never follows the peak or
+//         does not reload within the stored 0.1 L).
+//
+//     program --test-rollover
+//         Drive RolloverScheduler through DST days, a day/week/month end at
+//         the same second, stalls, NTP steps both ways, an outage past the
+//         catch-up limit and a boot before clock sync, comparing every
+//         event with the calendar boundaries crossed, plus the cost of
+//         loop() before a deadline (exit status 7 on any difference).
+//
+//     program --bench-scheduler [timers]
+//         Time TaskScheduler::run() with timers (default 400) periodic tasks
+//         against polling each of them with millis(), then soak the
+//         firmware's task set for 60 simulated days with loop stalls and
+//         check every run against its deadline grid (exit status 7 on a
+//         wrong run count, a burst, drift or lateness).
+//
+//     program --test-net-stall [seconds]
+//         Run a 20 ms control loop for seconds (default 10) of wall time
+//         against a worker thread behind the SPSC outbox/inbox while the
+//         network stalls for 2 s and 5 s, then with the sends inline on
+//         the loop, and report loop latency either way (exit status 7 if
+//         the threaded loop falls 100 ms behind or the queues lose,
+//         repeat or reorder an item).
+//
+//     program --test-snapshot [seconds]
+//         Publish SystemSnapshots from one thread while three reader
+//         threads read them, then push numbered commands from three
+//         threads through the ControlQueue's MpscQueue, each for seconds
+//         (default 3); report torn or stale reads, read and publish cost,
+//         and lost or reordered commands (exit status 7 on any).
+//
+//     program --bench-events scenario.txt
+//         Time EventBus publish + dispatch with the firmware's subscribers,
+//         then run the scenario and count the tracker, web snapshot and
+//         display refreshes the bus saved against refreshing on every
+//         pass or tick (exit status 7 if none were saved).
+//
+//     program --bench-profiler
+//         Time an empty LoopProfiler probe and record(), then profile
+//         code with known latency distributions and check each reported
+//         p50/p99 lies within its log2 bucket of the exact percentile
+//         (exit status 7 if not).
+//
+//     program --soak [days] scenario.txt
+//         Run a scenario for days (default 60) and check timers across the
+//         millis() wrap and heap growth (exit status 4 on findings). Only
+//         the env:soak build (32-bit unsigned long) wraps the clock.
+#include "host_hal.h"
+#include "tank_simulator.h"
+#include "trace_replay.h"
+#include "soak_test.h"
+#include "heap_tracker.h"
+#include "trend_history.h"
+#include "ssd1306_panel.h"
+#include "memory_display.h"
+#include "button_bench.h"
+#include "storage_bench.h"
+#include "flash_wear_monitor.h"
+#include "power_cut_test.h"
+#include "analytics_bench.h"
+#include "scheduler_bench.h"
+#include "net_stall_test.h"
+#include "snapshot_stress.h"
+#include "event_bus_bench.h"
+#include "profiler_bench.h"
+#include "rollover_test.h"
+#include "display_manager.h"
+#include "pins.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+static void printMetrics(const SimScenario& scenario, const SimMetrics& m) {
+    printf("[%s]\n", scenario.name.c_str());
+    printf("sim_hours %.2f\n", m.simHours);
+    printf("overshoot_pct %.2f\n", m.overshootPct);
+    printf("undershoot_pct %.2f\n", m.undershootPct);
+    printf("pump_starts %d\n", m.pumpStarts);
+    printf("starts_per_hour %.2f\n", m.startsPerHour);
+    printf("pump_run_min %.1f\n", m.pumpRunMin);
+    printf("dry_run_min %.1f\n", m.dryRunMin);
+    printf("dry_run_detect_min %.1f\n", m.dryRunDetectMin);
+    printf("demand_l %.1f\n", m.demandL);
+    printf("unmet_demand_l %.1f\n", m.unmetDemandL);
+    printf("tracked_usage_l %.1f\n", m.trackedUsageL);
+    printf("usage_error_pct %.2f\n", m.usageErrorPct);
+    printf("overflow_l %.1f\n", m.overflowL);
+    
+    // Only scenarios with a leak (or a leak alarm without one) report on it
+    if (m.leakL > 0 || m.falseLeakAlarms > 0) {
+        printf("leak_l %.1f\n", m.leakL);
+        printf("leak_detect_h %.1f\n", m.leakDetectHours);
+        printf("false_leak_alarms %d\n", m.falseLeakAlarms);
+    }
+    printf("sensor_reads %d\n", m.sensorReads);
+    printf("sensor_dropouts %d\n", m.sensorDropouts);
+    printf("faults_fired %d\n", m.faultsFired);
+    printf("mean_pass_ms %.2f\n", m.meanPassMs);
+    printf("max_pass_ms %.0f\n", m.maxPassMs);
+    printf("max_on_above_upper_s %.1f\n", m.maxOnAboveUpperSec);
+    printf("max_off_below_lower_min %.1f\n", m.maxOffBelowLowerMin);
+    printf("nvs_writes %d\n", m.nvsWrites);
+    printf("flash_life_years %.1f\n", m.flashLifeYears);
+    
+    // Timing goes to stderr so metric output stays identical run to run
+    fprintf(stderr, "%s: %.2f s wall, %.0fx real time\n",
+            scenario.name.c_str(), m.wallSeconds, m.speedup);
+}
+
+// Same bytes the web server streams from /api/trace
+static bool saveTrace(const char* path) {
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+    
+    TraceExporter exporter;
+    uint8_t buffer[512];
+    size_t n;
+    while ((n = exporter.read(buffer, sizeof(buffer))) > 0) fwrite(buffer, 1, n, out);
+    return fclose(out) == 0;
+}
+
+static int replay(const char* path) {
+    TraceReplayer replayer;
+    std::string error;
+    if (!replayer.load(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    
+    HostHal::setSerialEcho(false);
+    ReplayReport r = replayer.run();
+    
+    printf("sessions %d\n", r.sessions);
+    printf("records %d\n", r.records);
+    printf("readings %d\n", r.readings);
+    printf("failed_readings %d\n", r.failedReadings);
+    printf("commands %d\n", r.commands);
+    printf("buttons %d\n", r.buttons);
+    printf("damaged_segments %d\n", r.damagedSegments);
+    printf("outputs_recorded %d\n", r.outputsRecorded);
+    printf("outputs_replayed %d\n", r.outputsReplayed);
+    printf("outputs_matched %d\n", r.outputsMatched);
+    printf("first_divergence_ms %ld\n", r.firstDivergenceMs);
+    for (size_t i = 0; i < r.mismatches.size(); i++) {
+        printf("  %s\n", r.mismatches[i].c_str());
+    }
+    
+    return r.firstDivergenceMs < 0 ? 0 : 3;
+}
+
+// One reading per SENSOR_SAMPLE_INTERVAL_MS with a few mm of noise, an
+// occasional pump change, and the flash ring on the host file system
+static int benchTrace() {
+    const int readings = 1000000;
+    
+    HostHal::reset();
+    HostHal::clearFiles();
+    HostHal::setSerialEcho(false);
+    
+    TraceRecorder recorder;
+    recorder.begin();
+    TankConfig config;
+    config.tankHeight = 100;
+    recorder.recordConfig(config);
+    
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0, 0.3);
+    float distance = 60;
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < readings; i++) {
+        HostHal::advanceMillis(SENSOR_SAMPLE_INTERVAL_MS);
+        recorder.recordSensor(lroundf((distance + noise(rng)) * 10.0f) / 10.0f);
+        
+        if (i % 500 == 0) {
+            PumpEvent evt = PumpEvent();
+            evt.motorState = (i / 500) % 2;
+            recorder.recordPump(evt);
+        }
+    }
+    recorder.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    uint32_t records = recorder.getRecordCount();
+    uint32_t bytes = recorder.getByteCount();
+    float bytesPerReading = (float)bytes / readings;
+    float days = TRACE_SEGMENT_COUNT * TRACE_SEGMENT_SIZE / bytesPerReading *
+                 SENSOR_SAMPLE_INTERVAL_MS / 86400000.0;
+    
+    printf("records %u\n", records);
+    printf("bytes %u\n", bytes);
+    printf("bytes_per_record %.2f\n", (float)bytes / records);
+    printf("ns_per_record %.1f\n", seconds * 1e9 / records);
+    printf("flushes %u\n", recorder.getFlushCount());
+    printf("ring_days %.2f\n", days);
+    return 0;
+}
+
+// The display task fed what updateDisplay() reports for a tank that is
+// filled for 20 minutes of every hour and drawn down slowly otherwise;
+// mostly the main screen, with a look at status and usage every 10 min
+static int benchDisplay(int minutes) {
+    HostHal::reset();
+    HostHal::setSerialEcho(false);
+    
+    // What every pass used to cost: a whole frame, as display() sends it
+    Adafruit_SSD1306 panel(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1, DISPLAY_I2C_CLOCK_HZ, DISPLAY_I2C_CLOCK_HZ);
+    panel.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS);
+    Wire.resetCounters();
+    panel.display();
+    uint32_t frameBytes = Wire.getBytes();
+    double frameMs = Wire.getBusMs();
+    
+    // The SSD1306 backend, with the panel model on the bus
+    Ssd1306Panel model(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    Wire.attach(SCREEN_ADDRESS, &model);
+    Ssd1306Backend oled;
+    DisplayManager display(&oled);
+    display.begin();
+    Wire.resetCounters();
+    
+    DisplayData data = DisplayData();
+    data.waterLevel = 40;
+    data.maxInflow = 14.2;
+    data.dailyUsage = 310;
+    data.monthlyUsage = 5120;
+    data.wifiConnected = true;
+    data.iotOnline = true;
+    
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0, 0.15);
+    
+    const int passesPerMinute = 60000 / DISPLAY_UPDATE_INTERVAL_MS;
+    const int passes = minutes * passesPerMinute;
+    DisplayScreen screen = SCREEN_MAIN;
+    
+    for (int i = 0; i < passes; i++) {
+        HostHal::advanceMillis(DISPLAY_UPDATE_INTERVAL_MS);
+        int minute = i / passesPerMinute;
+        
+        data.motorState = minute % 60 < 20;
+        if (data.motorState) {
+            data.currentInflow = roundf((12.5f + noise(rng)) * 10) / 10;
+            data.waterLevel += 0.045f;
+        } else {
+            data.currentInflow = 0;
+            data.waterLevel -= 0.015f;
+            data.dailyUsage += 0.12f;
+            data.monthlyUsage += 0.12f;
+        }
+        
+        DisplayScreen wanted = minute % 10 == 8 ? SCREEN_STATUS : (minute % 10 == 9 ? SCREEN_USAGE : SCREEN_MAIN);
+        if (wanted != screen) {
+            screen = wanted;
+            display.setScreen(screen);
+        }
+        
+        display.updateData(data);
+        display.loop();
+    }
+    
+    double beforeBytes = (double)frameBytes * passes / minutes;
+    double afterBytes = (double)Wire.getBytes() / minutes;
+    
+    printf("passes %d\n", passes);
+    printf("frame_bytes %u\n", frameBytes);
+    printf("frame_bus_ms %.2f\n", frameMs);
+    printf("before_bytes_per_min %.0f\n", beforeBytes);
+    printf("after_bytes_per_min %.0f\n", afterBytes);
+    printf("before_bus_ms_per_min %.1f\n", frameMs * passes / minutes);
+    printf("after_bus_ms_per_min %.1f\n", Wire.getBusMs() / minutes);
+    printf("after_transactions_per_min %.1f\n", (double)Wire.getTransactions() / minutes);
+    printf("reduction_pct %.1f\n", 100.0 * (1.0 - afterBytes / beforeBytes));
+    printf("i2c_overflows %u\n", Wire.getOverflows());
+    
+    // Partial updates left the panel showing the last frame
+    bool matches = memcmp(model.getRam(), oled.getBuffer(), DISPLAY_BUFFER_SIZE) == 0;
+    printf("panel_matches_frame %d\n", matches);
+    Wire.attach(SCREEN_ADDRESS, nullptr);
+    return Wire.getOverflows() == 0 && matches ? 0 : 1;
+}
+
+// Worst case for the layout: level, flow and usage change every frame
+// (status and usage redraw one or two fields, main up to four)
+static int benchRender(int frames) {
+    HostHal::reset();
+    HostHal::setSerialEcho(false);
+    
+    DisplayManager display;
+    display.begin();
+    
+    DisplayData data = DisplayData();
+    data.wifiConnected = false;
+    data.iotOnline = false;
+    
+    const DisplayScreen screens[] = { SCREEN_MAIN, SCREEN_STATUS, SCREEN_USAGE };
+    const char* names[] = { "main", "status", "usage" };
+    
+    for (int s = 0; s < 3; s++) {
+        display.setScreen(screens[s]);
+        display.loop();
+        
+        HeapTracker::start();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++) {
+            HostHal::advanceMillis(DISPLAY_UPDATE_INTERVAL_MS);
+            data.waterLevel = 40 + (i % 600) * 0.1f;
+            data.currentInflow = 12 + (i % 7) * 0.1f;
+            data.maxInflow = 14 + (i % 5) * 0.1f;
+            data.dailyUsage = 300 + i * 0.01f;
+            data.monthlyUsage = 5000 + i * 0.01f;
+            display.updateData(data);
+            display.loop();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        HeapStats heap = HeapTracker::getStats();
+        HeapTracker::stop();
+        
+        printf("%s_ns_per_frame %.0f\n", names[s], seconds * 1e9 / frames);
+        printf("%s_allocations_per_frame %.3f\n", names[s], (double)heap.allocations / frames);
+    }
+    return 0;
+}
+
+// Screens saved by --render-screens, with fixed data: six hours of a
+// tank filled to 90 % every 90 minutes, a week of usage, and a fixed
+// clock and time zone so the images are reproducible
+static const DisplayScreen IMAGE_SCREENS[] = {
+    SCREEN_MAIN, SCREEN_STATUS, SCREEN_USAGE, SCREEN_LEVEL_TREND, SCREEN_FLOW_TREND, SCREEN_WEEK_USAGE
+};
+static const char* IMAGE_NAMES[] = { "main", "status", "usage", "level_trend", "flow_trend", "week_usage" };
+static const int IMAGE_COUNT = sizeof(IMAGE_SCREENS) / sizeof(IMAGE_SCREENS[0]);
+
+static void imageFixture(TrendHistory& history, DisplayData& data) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    HostHal::reset();
+    HostHal::setSerialEcho(false);
+    HostHal::setEpoch(1760000000);
+    
+    float level = 50;
+    float inflow = 0;
+    for (int i = 0; i < TREND_HOURS * 360; i++) {
+        HostHal::advanceMillis(10000);
+        int minute = (i / 6) % 90;
+        inflow = minute < 25 ? 13.5f + 0.5f * sinf(i * 0.3f) : 0;
+        level += inflow > 0 ? 0.16f : -0.0615f;
+        history.addSample(level, inflow);
+    }
+    const float days[] = { 412, 388, 455, 0, 367, 421 };
+    history.setDays(days, 6);
+    
+    data = DisplayData();
+    data.waterLevel = level;
+    data.currentInflow = inflow;
+    data.maxInflow = 14.2;
+    data.motorState = inflow > 0;
+    data.dailyUsage = 236.5;
+    data.monthlyUsage = 5120.25;
+    data.wifiConnected = true;
+    data.iotOnline = false;
+    data.leakAlarm = true;
+}
+
+// Saves every screen (or compares it with the saved image) and reports
+// the draw calls and time of a full redraw of each
+static int renderScreens(const char* dir, bool check) {
+    const int redraws = 2000;
+    
+    TrendHistory history;
+    DisplayData data;
+    imageFixture(history, data);
+    
+    MemoryDisplay panel;
+    DisplayManager display(&panel);
+    display.begin();
+    display.setHistory(&history);
+    display.updateData(data);
+    
+    int changed = 0;
+    for (int s = 0; s < IMAGE_COUNT; s++) {
+        // Full redraw: background, every field, whole frame to the panel
+        display.setScreen(IMAGE_SCREENS[s]);
+        display.refresh();
+        panel.resetStats();
+        display.loop();
+        DrawStats calls = panel.getStats();
+        
+        std::string path = std::string(dir) + "/" + IMAGE_NAMES[s];
+        if (check) {
+            int differences = panel.comparePbm((path + ".pbm").c_str());
+            if (differences < 0) {
+                fprintf(stderr, "cannot read %s.pbm\n", path.c_str());
+                return 1;
+            }
+            printf("%s_pixels_changed %d\n", IMAGE_NAMES[s], differences);
+            if (differences > 0) changed++;
+            continue;
+        }
+        
+        if (!panel.writePbm((path + ".pbm").c_str()) || !panel.writePng((path + ".png").c_str())) {
+            fprintf(stderr, "cannot write %s\n", path.c_str());
+            return 1;
+        }
+        
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < redraws; i++) {
+            display.refresh();
+            display.loop();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%s_render_us %.2f\n", IMAGE_NAMES[s], seconds * 1e6 / redraws);
+        printf("%s_draw_calls pixel=%u line=%u hline=%u vline=%u rect=%u fill=%u char=%u clear=%u\n",
+               IMAGE_NAMES[s], calls.pixels, calls.lines, calls.hlines, calls.vlines, calls.rects,
+               calls.fills, calls.chars, calls.clears);
+        printf("%s_pixels_written %u\n", IMAGE_NAMES[s], calls.pixelsWritten);
+        printf("%s_bytes_sent %u\n", IMAGE_NAMES[s], calls.bytesSent);
+    }
+    return changed == 0 ? 0 : 5;
+}
+
+// Time per call of each drawing routine the screens use, on the memory
+// panel (host GFX, so only useful to compare routines and changes to them)
+static int benchDraw(int iterations) {
+    MemoryDisplay panel;
+    panel.begin();
+    Adafruit_GFX& gfx = panel;
+    gfx.setTextSize(1);
+    gfx.setTextColor(SSD1306_WHITE);
+    
+    struct Routine {
+        const char* name;
+        void (*draw)(Adafruit_GFX& gfx, int i);
+    };
+    const Routine routines[] = {
+        { "pixel", [](Adafruit_GFX& gfx, int i) { gfx.drawPixel(i & 127, (i >> 7) & 63, SSD1306_INVERSE); } },
+        { "hline_128", [](Adafruit_GFX& gfx, int i) { gfx.drawFastHLine(0, i & 63, 128, SSD1306_INVERSE); } },
+        { "vline_64", [](Adafruit_GFX& gfx, int i) { gfx.drawFastVLine(i & 127, 0, 64, SSD1306_INVERSE); } },
+        { "line_diagonal", [](Adafruit_GFX& gfx, int) { gfx.drawLine(0, 0, 127, 63, SSD1306_INVERSE); } },
+        { "rect_tank", [](Adafruit_GFX& gfx, int) { gfx.drawRect(10, 12, 30, 48, SSD1306_INVERSE); } },
+        { "fill_tank", [](Adafruit_GFX& gfx, int) { gfx.fillRect(11, 13, 28, 46, SSD1306_INVERSE); } },
+        { "fill_screen", [](Adafruit_GFX& gfx, int i) { gfx.fillScreen(i & 1 ? SSD1306_WHITE : SSD1306_BLACK); } },
+        { "text_line", [](Adafruit_GFX& gfx, int i) {
+            gfx.setCursor(0, (i & 7) * 8);
+            gfx.print("Water Level:  62.5 %");
+        } }
+    };
+    
+    for (size_t r = 0; r < sizeof(routines) / sizeof(routines[0]); r++) {
+        panel.resetStats();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) routines[r].draw(gfx, i);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        printf("%s_ns %.1f\n", routines[r].name, seconds * 1e9 / iterations);
+        printf("%s_pixels_per_call %.1f\n", routines[r].name, (double)panel.getStats().pixelsWritten / iterations);
+    }
+    
+    // Frame handling around the drawing
+    DirtyWindow windows[DISPLAY_PAGES];
+    FrameDiff diff;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        panel.clear();
+        gfx.fillRect(11, 13 + (i & 31), 28, 8, SSD1306_WHITE);
+        int count = diff.compute(panel.getBuffer(), windows, DISPLAY_PAGES);
+        for (int w = 0; w < count; w++) panel.sendWindow(windows[w]);
+        diff.commit(panel.getBuffer());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("frame_diff_send_ns %.1f\n", seconds * 1e9 / iterations);
+    printf("frame_shown_matches %d\n", memcmp(panel.getShown(), panel.getBuffer(), DISPLAY_BUFFER_SIZE) == 0);
+    return 0;
+}
+
+static int benchButtons(int presses) {
+    ButtonBench bench(presses);
+    ButtonBenchReport r = bench.run();
+    
+    for (size_t i = 0; i < r.cases.size(); i++) {
+        const ButtonBenchCase& c = r.cases[i];
+        printf("%s_expected %d\n", c.name.c_str(), c.expected);
+        printf("%s_received %d\n", c.name.c_str(), c.received);
+        printf("%s_lost %d\n", c.name.c_str(), c.lost);
+        printf("%s_spurious %d\n", c.name.c_str(), c.spurious);
+        printf("%s_latency_p50_ms %.1f\n", c.name.c_str(), c.latencyP50Ms);
+        printf("%s_latency_p99_ms %.1f\n", c.name.c_str(), c.latencyP99Ms);
+        printf("%s_latency_max_ms %.1f\n", c.name.c_str(), c.latencyMaxMs);
+    }
+    printf("dropped_edges %u\n", r.droppedEdges);
+    printf("dropped_events %u\n", r.droppedEvents);
+    return r.lost == 0 && r.spurious == 0 ? 0 : 6;
+}
+
+// Queries come in groups of `group` paths that must return the same liters
+static int printStorageQueries(const std::vector<StorageQuery>& r, size_t group) {
+    bool agree = true;
+    for (size_t i = 0; i < r.size(); i++) {
+        const StorageQuery& q = r[i];
+        printf("%s_ns_per_query %.1f\n", q.name.c_str(), q.nsPerQuery);
+        printf("%s_reads_per_query %.1f\n", q.name.c_str(), q.readsPerQuery);
+        printf("%s_bytes_per_query %.0f\n", q.name.c_str(), q.bytesPerQuery);
+        printf("%s_liters %.1f\n", q.name.c_str(), q.liters);
+        if (fabsf(q.liters - r[i - i % group].liters) > 0.05f * (1 + q.liters / 1000)) agree = false;
+    }
+    return agree ? 0 : 7;
+}
+
+static int benchUsage(int queries) {
+    StorageBench bench(queries);
+    return printStorageQueries(bench.monthUsage(), 3);
+}
+
+static int benchHistory(int queries) {
+    StorageBench bench(queries);
+    return printStorageQueries(bench.history(), 3);
+}
+
+static int wear(const char* path) {
+    SimScenario scenario;
+    std::string error;
+    if (!scenario.load(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    
+    HostHal::setSerialEcho(false);
+    TankSimulator simulator(scenario);
+    SimMetrics m = simulator.run();
+    float days = m.simHours / 24;
+    
+    printf("[%s wear]\n", scenario.name.c_str());
+    printf("%-10s %-12s %10s %10s %10s %12s\n", "namespace", "key", "writes", "bytes", "entries", "writes_day");
+    for (int i = 0; i < FlashWearMonitor::getKeyCount(); i++) {
+        const KeyWearStats& k = FlashWearMonitor::getKeyStats(i);
+        printf("%-10s %-12s %10u %10u %10u %12.1f\n", k.ns, k.key, k.writes, k.bytes, k.entries, k.writes / days);
+    }
+    printf("writes_per_day %.1f\n", FlashWearMonitor::getTotalWrites() / days);
+    printf("bytes_per_day %.0f\n", FlashWearMonitor::getTotalBytes() / days);
+    printf("entries_per_day %.1f\n", FlashWearMonitor::getTotalEntries() / days);
+    printf("erases_per_sector_per_day %.3f\n", FlashWearMonitor::getErasesPerSectorPerDay());
+    printf("flash_life_years %.1f\n", FlashWearMonitor::getProjectedLifetimeYears());
+    return 0;
+}
+
+static int benchExport(int chunkBytes) {
+    StorageBench bench(200);
+    std::vector<ExportRun> r = bench.exports(chunkBytes);
+    
+    bool complete = true;
+    for (size_t i = 0; i < r.size(); i++) {
+        const ExportRun& e = r[i];
+        printf("%s_bytes %u\n", e.name.c_str(), e.bytes);
+        printf("%s_rows %d\n", e.name.c_str(), e.rows);
+        printf("%s_chunks %d\n", e.name.c_str(), e.chunks);
+        printf("%s_bytes_per_sec %.0f\n", e.name.c_str(), e.bytesPerSec);
+        printf("%s_peak_heap %zu\n", e.name.c_str(), e.peakHeap);
+        printf("%s_allocations %llu\n", e.name.c_str(), (unsigned long long)e.allocations);
+        
+        // One row per day, plus the CSV header
+        int header = e.name.compare(0, 4, "csv_") == 0 ? 1 : 0;
+        if (e.rows != e.days + header) complete = false;
+    }
+    return complete ? 0 : 7;
+}
+
+static int testPowerCut() {
+    PowerCutTest test;
+    PowerCutReport r = test.run();
+    
+    for (size_t i = 0; i < r.cases.size(); i++) {
+        const PowerCutCase& c = r.cases[i];
+        printf("%s_writes %d\n", c.name.c_str(), c.writes);
+        printf("%s_cuts %d\n", c.name.c_str(), c.cuts);
+        printf("%s_torn %d\n", c.name.c_str(), c.torn);
+        printf("%s_journals_left %d\n", c.name.c_str(), c.journalsLeft);
+        printf("%s_replays %d\n", c.name.c_str(), c.replays);
+        printf("%s_replay_max_writes %d\n", c.name.c_str(), c.replayMaxWrites);
+        printf("%s_replay_mean_us %.1f\n", c.name.c_str(), c.replayMeanUs);
+        printf("%s_replay_max_us %.1f\n", c.name.c_str(), c.replayMaxUs);
+    }
+    return r.torn == 0 && r.journalsLeft == 0 ? 0 : 7;
+}
+
+static int testDraws(int draws) {
+    AnalyticsBench bench(draws);
+    std::vector<SegmenterCase> r = bench.segmenter();
+    
+    for (size_t i = 0; i < r.size(); i++) {
+        const SegmenterCase& c = r[i];
+        printf("%s_draws %d\n", c.name.c_str(), c.draws);
+        printf("%s_events %d\n", c.name.c_str(), c.events);
+        printf("%s_matched %d\n", c.name.c_str(), c.matched);
+        printf("%s_merged %d\n", c.name.c_str(), c.merged);
+        printf("%s_missed %d\n", c.name.c_str(), c.missed);
+        printf("%s_spurious %d\n", c.name.c_str(), c.spurious);
+        printf("%s_volume_error_pct %.2f\n", c.name.c_str(), c.volumeErrorPct);
+        printf("%s_category_pct %.1f\n", c.name.c_str(), c.categoryPct);
+        printf("%s_ns_per_sample %.1f\n", c.name.c_str(), c.nsPerSample);
+    }
+    printf("segmenter_bytes %zu\n", sizeof(DrawEventSegmenter));
+    
+    // Exact flow must segment exactly. Noise and pauses may miss or merge
+    // one draw in fifty and add one spurious event per twenty draws (two
+    // noise readings in a row look like a tiny draw). Lumps are reported
+    // only: draws under the tracker's deadband arrive folded into later ones.
+    bool ok = true;
+    for (size_t i = 0; i < r.size(); i++) {
+        const SegmenterCase& c = r[i];
+        if (c.name == "exact") {
+            if (c.matched != c.draws || c.events != c.draws) ok = false;
+        } else if (c.name == "noise" || c.name == "pauses") {
+            if (c.missed * 50 > c.draws || c.merged * 50 > c.draws || c.spurious * 20 > c.draws) ok = false;
+        }
+    }
+    return ok ? 0 : 7;
+}
+
+static int testLeak(int weeks, const char* path) {
+    SimScenario base;
+    std::string error;
+    if (!base.load(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    base.durationMs = weeks * 7 * 86400000ULL;
+    
+    const float leaks[] = { 0, 0.05, 0.1, 0.25, 0.5 };
+    bool ok = true;
+    HostHal::setSerialEcho(false);
+    
+    for (size_t i = 0; i < sizeof(leaks) / sizeof(leaks[0]); i++) {
+        SimScenario scenario = base;
+        if (leaks[i] > 0) {
+            SimEvent evt = SimEvent();
+            evt.atMs = 7 * 86400000ULL;
+            evt.setting = SIM_LEAK;
+            evt.value = leaks[i];
+            scenario.events.push_back(evt);
+            std::stable_sort(scenario.events.begin(), scenario.events.end(), [](const SimEvent& a, const SimEvent& b) {
+                return a.atMs < b.atMs;
+            });
+        }
+        
+        TankSimulator simulator(scenario);
+        SimMetrics m = simulator.run();
+        
+        printf("[leak %.2f L/min]\n", leaks[i]);
+        printf("leak_l %.1f\n", m.leakL);
+        printf("leak_detect_h %.1f\n", m.leakDetectHours);
+        printf("false_leak_alarms %d\n", m.falseLeakAlarms);
+        printf("usage_error_pct %.2f\n", m.usageErrorPct);
+        
+        if (m.falseLeakAlarms > 0) ok = false;
+        if (leaks[i] >= 2 * LEAK_MIN_FLOW_LPM && m.leakDetectHours < 0) ok = false;
+    }
+    return ok ? 0 : 7;
+}
+
+static int testFillDraws(int days, const char* path) {
+    SimScenario base;
+    std::string error;
+    if (!base.load(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    
+    // Ordinary days first, so the pump rate is learned as it would be in
+    // service. Runs share the seed, so the busy day is the difference.
+    base.durationMs = days * 86400000ULL;
+    HostHal::setSerialEcho(false);
+    SimMetrics warm = TankSimulator(base).run();
+    
+    const float demandScales[] = { 1, 3, 6 };
+    bool ok = true;
+    
+    for (size_t i = 0; i < sizeof(demandScales) / sizeof(demandScales[0]); i++) {
+        SimScenario scenario = base;
+        scenario.durationMs += 86400000ULL;
+        SimEvent evt = SimEvent();
+        evt.atMs = base.durationMs;
+        evt.setting = SIM_DEMAND;
+        evt.value = base.demandPerHour * demandScales[i];
+        scenario.events.push_back(evt);
+        
+        SimMetrics m = TankSimulator(scenario).run();
+        double demandL = m.demandL - warm.demandL;
+        double fillDemandL = m.fillDemandL - warm.fillDemandL;
+        double trackedL = m.trackedUsageL - warm.trackedUsageL;
+        double fillTrackedL = m.fillTrackedL - warm.fillTrackedL;
+        
+        // Without fill-time accounting the tracker books only idle draws
+        printf("[demand %.1f/h]\n", evt.value);
+        printf("demand_l %.1f\n", demandL);
+        printf("fill_demand_l %.1f\n", fillDemandL);
+        printf("fill_tracked_l %.1f\n", fillTrackedL);
+        printf("usage_error_before_pct %.2f\n", (trackedL - fillTrackedL - demandL) * 100.0 / demandL);
+        printf("usage_error_pct %.2f\n", (trackedL - demandL) * 100.0 / demandL);
+        
+        if (fabs(trackedL - demandL) > fabs(trackedL - fillTrackedL - demandL)) ok = false;
+    }
+    return ok ? 0 : 7;
+}
+
+static int testProfile(int weeks) {
+    AnalyticsBench bench(0);
+    ProfileRun r = bench.profile(weeks);
+    
+    printf("ns_per_usage %.1f\n", r.nsPerUsage);
+    printf("ns_per_loop %.1f\n", r.nsPerLoop);
+    printf("ns_per_fold %.1f\n", r.nsPerFold);
+    for (size_t i = 0; i < r.weekErrorPct.size(); i++) {
+        printf("week_%zu_error_pct %.1f\n", i + 1, r.weekErrorPct[i]);
+    }
+    printf("floor_error_pct %.1f\n", r.floorErrorPct);
+    printf("std_error_pct %.1f\n", r.stdErrorPct);
+    printf("shift_weeks %d\n", r.shiftWeeks);
+    printf("restore_error_l %.3f\n", r.restoreErrorL);
+    printf("stored_bytes %zu\n", r.storedBytes);
+    
+    bool converged = !r.weekErrorPct.empty() && r.weekErrorPct.back() <= 1.5f * r.floorErrorPct;
+    return converged && r.shiftWeeks > 0 && r.restoreErrorL <= 0.051f ? 0 : 7;
+}
+
+static int testRollover() {
+    RolloverTest test;
+    RolloverReport r = test.run();
+    
+    for (size_t i = 0; i < r.cases.size(); i++) {
+        const RolloverCase& c = r.cases[i];
+        printf("%s_expected %d\n", c.name.c_str(), c.expected);
+        printf("%s_fired %d\n", c.name.c_str(), c.fired);
+        printf("%s_mismatched %d\n", c.name.c_str(), c.mismatched);
+        printf("%s_late %d\n", c.name.c_str(), c.late);
+        printf("%s_broken %d\n", c.name.c_str(), c.broken);
+        printf("%s_anchors %d/%d\n", c.name.c_str(), c.anchors, c.expectedAnchors);
+    }
+    printf("ns_per_loop %.1f\n", r.nsPerLoop);
+    printf("failures %d\n", r.failures);
+    return r.failures == 0 ? 0 : 7;
+}
+
+static int benchScheduler(int timers) {
+    SchedulerBench bench(timers);
+    SchedulerOverhead o = bench.overhead(600);
+    
+    printf("timers %d\n", o.timers);
+    printf("dispatches %llu\n", (unsigned long long)o.dispatches);
+    printf("ns_per_idle_run %.1f\n", o.nsPerIdleRun);
+    printf("ns_per_run %.1f\n", o.nsPerRun);
+    printf("ns_per_dispatch %.1f\n", o.nsPerDispatch);
+    printf("ns_per_poll_pass %.1f\n", o.nsPerPollPass);
+    printf("count_errors %d\n", o.countErrors);
+    
+    SchedulerSoak s = bench.soak(60);
+    printf("soak_days %d\n", s.days);
+    printf("soak_stalls %d\n", s.stalls);
+    for (size_t i = 0; i < s.tasks.size(); i++) {
+        const SchedulerSoakTask& t = s.tasks[i];
+        printf("%s_runs %u\n", t.name.c_str(), t.runs);
+        printf("%s_coalesced %u\n", t.name.c_str(), t.coalesced);
+        printf("%s_bursts %u\n", t.name.c_str(), t.bursts);
+        printf("%s_max_late_ms %u\n", t.name.c_str(), t.maxLateMs);
+        printf("%s_count %s\n", t.name.c_str(), t.countOk ? "ok" : "wrong");
+    }
+    printf("soak_wall_s %.1f\n", s.wallSeconds);
+    printf("findings %d\n", s.findings);
+    return o.countErrors == 0 && s.findings == 0 ? 0 : 7;
+}
+
+static void printNetStallRun(const char* name, const NetStallRun& r) {
+    printf("%s_passes %d\n", name, r.passes);
+    printf("%s_max_late_ms %.2f\n", name, r.maxLateMs);
+    printf("%s_p99_late_ms %.2f\n", name, r.p99LateMs);
+    printf("%s_max_pass_us %.1f\n", name, r.maxPassUs);
+    printf("%s_posted %u\n", name, r.posted);
+    printf("%s_dropped %u\n", name, r.dropped);
+    printf("%s_sent %u\n", name, r.sent);
+    printf("%s_results %u\n", name, r.results);
+    printf("%s_order_errors %u\n", name, r.orderErrors);
+}
+
+static int testNetStall(int seconds) {
+    NetStallTest test(seconds);
+    NetStallReport r = test.run();
+    
+    printNetStallRun("worker", r.worker);
+    printNetStallRun("inline", r.inline_);
+    
+    bool ok = r.worker.maxLateMs < 100 && r.worker.orderErrors == 0 && r.inline_.orderErrors == 0;
+    return ok ? 0 : 7;
+}
+
+static int testSnapshot(int seconds) {
+    SnapshotStress test(seconds);
+    SnapshotStressReport r = test.run();
+    
+    printf("readers %d\n", r.readers);
+    printf("publishes %llu\n", (unsigned long long)r.publishes);
+    printf("reads %llu\n", (unsigned long long)r.reads);
+    printf("failed_reads %llu\n", (unsigned long long)r.failedReads);
+    printf("torn_reads %llu\n", (unsigned long long)r.tornReads);
+    printf("stale_reads %llu\n", (unsigned long long)r.staleReads);
+    printf("median_publish_ns %.1f\n", r.medianPublishNs);
+    printf("median_read_ns %.1f\n", r.medianReadNs);
+    printf("p99_read_ns %.1f\n", r.p99ReadNs);
+    printf("max_read_ns %.1f\n", r.maxReadNs);
+    printf("producers %d\n", r.producers);
+    printf("pushed %llu\n", (unsigned long long)r.pushed);
+    printf("full_retries %llu\n", (unsigned long long)r.fullRetries);
+    printf("popped %llu\n", (unsigned long long)r.popped);
+    printf("lost %llu\n", (unsigned long long)r.lost);
+    printf("duplicated %llu\n", (unsigned long long)r.duplicated);
+    
+    bool ok = r.tornReads == 0 && r.staleReads == 0 && r.lost == 0 && r.duplicated == 0 &&
+              r.popped == r.pushed;
+    return ok ? 0 : 7;
+}
+
+static int benchEvents(const char* path) {
+    SimScenario scenario;
+    std::string error;
+    if (!scenario.load(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    
+    EventBusBench bench;
+    EventBusCost c = bench.cost();
+    printf("ns_per_level_event %.1f\n", c.nsPerLevelEvent);
+    printf("ns_per_pump_event %.1f\n", c.nsPerPumpEvent);
+    printf("ns_per_delivery %.1f\n", c.nsPerDelivery);
+    printf("ns_per_burst_event %.1f\n", c.nsPerBurstEvent);
+    printf("ns_per_idle_dispatch %.1f\n", c.nsPerIdleDispatch);
+    
+    HostHal::setSerialEcho(false);
+    EventBusUpdates u = bench.updates(scenario);
+    printf("[%s]\n", scenario.name.c_str());
+    printf("passes %lu\n", u.passes);
+    printf("level_events %u\n", u.levelEvents);
+    printf("pump_events %u\n", u.pumpEvents);
+    printf("tracker_updates %llu -> %llu\n", (unsigned long long)u.trackerBefore, (unsigned long long)u.trackerAfter);
+    printf("snapshot_updates %llu -> %llu\n", (unsigned long long)u.snapshotBefore, (unsigned long long)u.snapshotAfter);
+    printf("display_refreshes %llu -> %llu\n", (unsigned long long)u.displayBefore, (unsigned long long)u.displayAfter);
+    printf("updates_eliminated %llu\n", (unsigned long long)u.eliminated);
+    return u.eliminated > 0 ? 0 : 7;
+}
+
+static int benchProfiler() {
+    ProfilerBench bench;
+    ProfilerReport r = bench.run();
+    
+    printf("ns_per_probe %.1f\n", r.nsPerProbe);
+    printf("ns_per_record %.1f\n", r.nsPerRecord);
+    for (size_t i = 0; i < r.cases.size(); i++) {
+        const ProfilerCase& c = r.cases[i];
+        printf("%s_p50_us %u (exact %u)\n", c.name.c_str(), c.p50Us, c.trueP50Us);
+        printf("%s_p99_us %u (exact %u)\n", c.name.c_str(), c.p99Us, c.trueP99Us);
+        printf("%s_max_us %u\n", c.name.c_str(), c.maxUs);
+        printf("%s_within_bucket %s\n", c.name.c_str(), c.withinBucket ? "yes" : "no");
+    }
+    printf("failures %d\n", r.failures);
+    return r.failures == 0 ? 0 : 7;
+}
+
+static int soak(int days, const char* path) {
+    SimScenario scenario;
+    std::string error;
+    if (!scenario.load(path, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    
+    HostHal::setSerialEcho(false);
+    SoakTest test(scenario, days);
+    SoakReport r = test.run();
+    
+    if (!r.clockWraps) {
+        fprintf(stderr, "unsigned long is %zu bytes: millis() does not wrap in this build, "
+                        "timers not checked (use env:soak)\n", sizeof(unsigned long));
+    }
+    
+    printf("[%s soak]\n", scenario.name.c_str());
+    printf("days %d\n", r.days);
+    printf("wrap_hour %d\n", r.wrapHour);
+    printf("pump_starts %d\n", r.metrics.pumpStarts);
+    printf("overshoot_pct %.2f\n", r.metrics.overshootPct);
+    printf("undershoot_pct %.2f\n", r.metrics.undershootPct);
+    printf("allocations_per_hour %.1f\n", r.allocationsPerHour);
+    printf("bytes_per_hour %.0f\n", r.bytesPerHour);
+    printf("peak_bytes %zu\n", r.peakBytes);
+    printf("live_bytes_day1 %zu\n", r.liveBytesDay1);
+    printf("live_bytes_end %zu\n", r.liveBytesEnd);
+    printf("growth_bytes_per_day %.1f\n", r.growthBytesPerDay);
+    printf("fragmentation_day1_pct %.2f\n", r.fragmentationDay1Pct);
+    printf("fragmentation_end_pct %.2f\n", r.fragmentationEndPct);
+    printf("fragmentation_per_day %.3f\n", r.fragmentationPerDay);
+    printf("min_largest_free %zu\n", r.minLargestFree);
+    printf("out_of_memory %u\n", r.outOfMemory);
+    printf("findings %zu\n", r.findings.size());
+    for (size_t i = 0; i < r.findings.size(); i++) {
+        printf("  %s\n", r.findings[i].c_str());
+    }
+    
+    fprintf(stderr, "%s: %.2f s wall, %.0fx real time\n",
+            scenario.name.c_str(), r.metrics.wallSeconds, r.metrics.speedup);
+    return r.findings.empty() ? 0 : 4;
+}
+
+int main(int argc, char** argv) {
+    bool verbose = false;
+    const char* recordPath = nullptr;
+    std::vector<const char*> scenarioPaths;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            return replay(argv[i + 1]);
+        } else if (strcmp(argv[i], "--bench-trace") == 0) {
+            return benchTrace();
+        } else if (strcmp(argv[i], "--bench-display") == 0) {
+            int minutes = 60;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) minutes = atoi(argv[++i]);
+            return benchDisplay(minutes);
+        } else if (strcmp(argv[i], "--bench-render") == 0) {
+            int frames = 100000;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) frames = atoi(argv[++i]);
+            return benchRender(frames);
+        } else if (strcmp(argv[i], "--render-screens") == 0 && i + 1 < argc) {
+            return renderScreens(argv[i + 1], false);
+        } else if (strcmp(argv[i], "--check-screens") == 0 && i + 1 < argc) {
+            return renderScreens(argv[i + 1], true);
+        } else if (strcmp(argv[i], "--bench-draw") == 0) {
+            int iterations = 1000000;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) iterations = atoi(argv[++i]);
+            return benchDraw(iterations);
+        } else if (strcmp(argv[i], "--bench-buttons") == 0) {
+            int presses = 200;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) presses = atoi(argv[++i]);
+            return benchButtons(presses);
+        } else if (strcmp(argv[i], "--bench-usage") == 0) {
+            int queries = 10000;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) queries = atoi(argv[++i]);
+            return benchUsage(queries);
+        } else if (strcmp(argv[i], "--bench-history") == 0) {
+            int queries = 1000;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) queries = atoi(argv[++i]);
+            return benchHistory(queries);
+        } else if (strcmp(argv[i], "--wear") == 0 && i + 1 < argc) {
+            return wear(argv[i + 1]);
+        } else if (strcmp(argv[i], "--bench-export") == 0) {
+            int chunk = 1460;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) chunk = atoi(argv[++i]);
+            return benchExport(chunk);
+        } else if (strcmp(argv[i], "--test-power-cut") == 0) {
+            return testPowerCut();
+        } else if (strcmp(argv[i], "--test-draws") == 0) {
+            int draws = 400;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) draws = atoi(argv[++i]);
+            return testDraws(draws);
+        } else if (strcmp(argv[i], "--test-leak") == 0 && i + 1 < argc) {
+            int weeks = 3;
+            if (i + 2 < argc && isdigit((unsigned char)argv[i + 1][0])) weeks = atoi(argv[++i]);
+            return testLeak(weeks, argv[i + 1]);
+        } else if (strcmp(argv[i], "--test-fill-draws") == 0 && i + 1 < argc) {
+            int days = 6;
+            if (i + 2 < argc && isdigit((unsigned char)argv[i + 1][0])) days = atoi(argv[++i]);
+            return testFillDraws(days, argv[i + 1]);
+        } else if (strcmp(argv[i], "--test-profile") == 0) {
+            int weeks = 12;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) weeks = atoi(argv[++i]);
+            return testProfile(weeks);
+        } else if (strcmp(argv[i], "--test-rollover") == 0) {
+            return testRollover();
+        } else if (strcmp(argv[i], "--bench-scheduler") == 0) {
+            int timers = 400;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) timers = atoi(argv[++i]);
+            return benchScheduler(timers);
+        } else if (strcmp(argv[i], "--test-net-stall") == 0) {
+            int seconds = 10;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) seconds = atoi(argv[++i]);
+            return testNetStall(seconds);
+        } else if (strcmp(argv[i], "--test-snapshot") == 0) {
+            int seconds = 3;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) seconds = atoi(argv[++i]);
+            return testSnapshot(seconds);
+        } else if (strcmp(argv[i], "--bench-events") == 0 && i + 1 < argc) {
+            return benchEvents(argv[i + 1]);
+        } else if (strcmp(argv[i], "--bench-profiler") == 0) {
+            return benchProfiler();
+        } else if (strcmp(argv[i], "--soak") == 0 && i + 1 < argc) {
+            int days = 60;
+            if (i + 2 < argc && isdigit((unsigned char)argv[i + 1][0])) days = atoi(argv[++i]);
+            return soak(days, argv[i + 1]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else {
+            scenarioPaths.push_back(argv[i]);
+        }
+    }
+    
+    if (scenarioPaths.empty() || (recordPath && scenarioPaths.size() > 1)) {
+        fprintf(stderr, "usage: %s [--verbose] [--record trace.bin] scenario.txt...\n"
+                        "       %s --replay trace.bin\n"
+                        "       %s --bench-trace\n"
+                        "       %s --bench-display [minutes]\n"
+                        "       %s --bench-render [frames]\n"
+                        "       %s --render-screens dir\n"
+                        "       %s --check-screens dir\n"
+                        "       %s --bench-draw [iterations]\n"
+                        "       %s --bench-buttons [presses]\n"
+                        "       %s --bench-usage [queries]\n"
+                        "       %s --bench-history [queries]\n"
+                        "       %s --wear scenario.txt\n"
+                        "       %s --bench-export [chunk_bytes]\n"
+                        "       %s --test-power-cut\n"
+                        "       %s --test-draws [draws]\n"
+                        "       %s --test-leak [weeks] scenario.txt\n"
+                        "       %s --test-fill-draws [days] scenario.txt\n"
+                        "       %s --test-profile [weeks]\n"
+                        "       %s --test-rollover\n"
+                        "       %s --bench-scheduler [timers]\n"
+                        "       %s --test-net-stall [seconds]\n"
+                        "       %s --test-snapshot [seconds]\n"
+                        "       %s --bench-events scenario.txt\n"
+                        "       %s --bench-profiler\n"
+                        "       %s --soak [days] scenario.txt\n",
+                argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 2;
+    }
+    
+    for (size_t i = 0; i < scenarioPaths.size(); i++) {
+        SimScenario scenario;
+        std::string error;
+        if (!scenario.load(scenarioPaths[i], error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        
+        // Firmware debug output is noise at thousands of passes per second
+        HostHal::setSerialEcho(verbose);
+        
+        TraceRecorder recorder;
+        TankSimulator simulator(scenario);
+        if (recordPath) simulator.setTrace(&recorder);
+        printMetrics(scenario, simulator.run());
+        
+        if (recordPath && !saveTrace(recordPath)) {
+            fprintf(stderr, "cannot write %s\n", recordPath);
+            return 1;
+        }
+    }
+    return 0;
+}
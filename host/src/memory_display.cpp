@@ -0,0 +1,218 @@
+// memory_display.cpp
+#include "memory_display.h"
+#include <vector>
+
+namespace {
+    const size_t PBM_ROW_BYTES = (DISPLAY_WIDTH + 7) / 8;
+    
+    uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+        return ~crc;
+    }
+    
+    uint32_t adler32(const uint8_t* data, size_t length) {
+        uint32_t a = 1;
+        uint32_t b = 0;
+        for (size_t i = 0; i < length; i++) {
+            a = (a + data[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+    
+    void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) out.push_back((uint8_t)(value >> shift));
+    }
+    
+    void putChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+        putBigEndian(png, data.size());
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        putBigEndian(png, crc32(&png[start], png.size() - start));
+    }
+}
+
+MemoryDisplay::MemoryDisplay()
+    : Adafruit_GFX(DISPLAY_WIDTH, DISPLAY_HEIGHT),
+      _contrast(0xCF),
+      _stats(),
+      _depth(0) {
+    memset(_frame, 0, sizeof(_frame));
+    memset(_shown, 0, sizeof(_shown));
+}
+
+bool MemoryDisplay::begin() {
+    memset(_frame, 0, sizeof(_frame));
+    memset(_shown, 0, sizeof(_shown));
+    return true;
+}
+
+void MemoryDisplay::clear() {
+    _stats.clears++;
+    memset(_frame, 0, sizeof(_frame));
+}
+
+void MemoryDisplay::sendWindow(const DirtyWindow& window) {
+    _stats.windows++;
+    _stats.bytesSent += FrameDiff::windowBytes(window);
+    for (int page = window.firstPage; page <= window.lastPage; page++) {
+        int offset = page * DISPLAY_WIDTH;
+        memcpy(_shown + offset + window.firstColumn, _frame + offset + window.firstColumn,
+               window.lastColumn - window.firstColumn + 1);
+    }
+}
+
+void MemoryDisplay::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (_depth == 0) _stats.pixels++;
+    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) return;
+    
+    _stats.pixelsWritten++;
+    uint8_t& cell = _frame[x + (y / 8) * DISPLAY_WIDTH];
+    uint8_t bit = 1 << (y & 7);
+    switch (color) {
+        case SSD1306_WHITE: cell |= bit; break;
+        case SSD1306_BLACK: cell &= ~bit; break;
+        case SSD1306_INVERSE: cell ^= bit; break;
+    }
+}
+
+void MemoryDisplay::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (_depth++ == 0) _stats.lines++;
+    Adafruit_GFX::drawLine(x0, y0, x1, y1, color);
+    _depth--;
+}
+
+void MemoryDisplay::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    if (_depth++ == 0) _stats.hlines++;
+    Adafruit_GFX::drawFastHLine(x, y, w, color);
+    _depth--;
+}
+
+void MemoryDisplay::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    if (_depth++ == 0) _stats.vlines++;
+    Adafruit_GFX::drawFastVLine(x, y, h, color);
+    _depth--;
+}
+
+void MemoryDisplay::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (_depth++ == 0) _stats.rects++;
+    Adafruit_GFX::drawRect(x, y, w, h, color);
+    _depth--;
+}
+
+void MemoryDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (_depth++ == 0) _stats.fills++;
+    Adafruit_GFX::fillRect(x, y, w, h, color);
+    _depth--;
+}
+
+void MemoryDisplay::fillScreen(uint16_t color) {
+    if (_depth++ == 0) _stats.fills++;
+    Adafruit_GFX::fillScreen(color);
+    _depth--;
+}
+
+size_t MemoryDisplay::write(uint8_t c) {
+    if (_depth++ == 0 && c != '\n' && c != '\r') _stats.chars++;
+    size_t n = Adafruit_GFX::write(c);
+    _depth--;
+    return n;
+}
+
+void MemoryDisplay::resetStats() {
+    _stats = DrawStats();
+}
+
+bool MemoryDisplay::getPixel(int x, int y) const {
+    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) return false;
+    return _shown[(y / 8) * DISPLAY_WIDTH + x] & (1 << (y & 7));
+}
+
+bool MemoryDisplay::writePbm(const char* path) const {
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+    
+    fprintf(out, "P4\n%d %d\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    uint8_t row[PBM_ROW_BYTES];
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        memset(row, 0, sizeof(row));
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (getPixel(x, y)) row[x / 8] |= 0x80 >> (x % 8);
+        }
+        fwrite(row, 1, sizeof(row), out);
+    }
+    return fclose(out) == 0;
+}
+
+// Uncompressed: the image data goes into a single stored deflate block
+// (1 KB for this size), so no zlib is needed
+bool MemoryDisplay::writePng(const char* path) const {
+    // Scanlines, each with filter type 0; grayscale 1 = white
+    std::vector<uint8_t> raw;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        raw.push_back(0);
+        for (size_t i = 0; i < PBM_ROW_BYTES; i++) {
+            uint8_t bits = 0;
+            for (int x = i * 8; x < (int)(i * 8 + 8); x++) {
+                bits = (bits << 1) | (getPixel(x, y) ? 0 : 1);
+            }
+            raw.push_back(bits);
+        }
+    }
+    
+    std::vector<uint8_t> header;
+    putBigEndian(header, DISPLAY_WIDTH);
+    putBigEndian(header, DISPLAY_HEIGHT);
+    const uint8_t format[] = { 1, 0, 0, 0, 0 };  // Bit depth, grayscale, deflate, filter, no interlace
+    header.insert(header.end(), format, format + sizeof(format));
+    
+    std::vector<uint8_t> zlib = { 0x78, 0x01, 0x01 };  // zlib header, final stored block
+    uint16_t length = raw.size();
+    zlib.push_back(length & 0xFF);
+    zlib.push_back(length >> 8);
+    zlib.push_back(~length & 0xFF);
+    zlib.push_back((~length >> 8) & 0xFF);
+    zlib.insert(zlib.end(), raw.begin(), raw.end());
+    putBigEndian(zlib, adler32(raw.data(), raw.size()));
+    
+    static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> png(signature, signature + sizeof(signature));
+    putChunk(png, "IHDR", header);
+    putChunk(png, "IDAT", zlib);
+    putChunk(png, "IEND", std::vector<uint8_t>());
+    
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+    fwrite(png.data(), 1, png.size(), out);
+    return fclose(out) == 0;
+}
+
+int MemoryDisplay::comparePbm(const char* path) const {
+    FILE* in = fopen(path, "rb");
+    if (!in) return -1;
+    
+    int width = 0;
+    int height = 0;
+    bool valid = fscanf(in, "P4 %d %d", &width, &height) == 2 && fgetc(in) != EOF &&
+                 width == DISPLAY_WIDTH && height == DISPLAY_HEIGHT;
+    
+    int differences = 0;
+    uint8_t row[PBM_ROW_BYTES];
+    for (int y = 0; valid && y < DISPLAY_HEIGHT; y++) {
+        if (fread(row, 1, sizeof(row), in) != sizeof(row)) {
+            valid = false;
+            break;
+        }
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            bool expected = row[x / 8] & (0x80 >> (x % 8));
+            if (expected != getPixel(x, y)) differences++;
+        }
+    }
+    fclose(in);
+    return valid ? differences : -1;
+}
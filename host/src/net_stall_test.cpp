@@ -0,0 +1,144 @@
+// net_stall_test.cpp
+#include "net_stall_test.h"
+#include "config.h"
+#include "spsc_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+    const int NET_STALL_LOOP_MS = 20;            // Control loop period
+    const int NET_STALL_POST_MS = 100;           // Telemetry request period
+    const double NET_SEND_MS = 5;                // A send while the network is up
+    const int NET_DRAIN_TIMEOUT_MS = 10000;      // Longer than any outage
+    
+    // Outages as [start, end) in ms from the start of the run
+    const double STALLS[][2] = {
+        { 1000, 3000 },
+        { 4000, 9000 }
+    };
+    
+    typedef std::chrono::steady_clock Clock;
+    
+    double msBetween(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
+
+NetStallTest::NetStallTest(int seconds)
+    : _seconds(seconds) {
+}
+
+NetStallReport NetStallTest::run() {
+    NetStallReport r;
+    r.worker = runLoop(true);
+    r.inline_ = runLoop(false);
+    return r;
+}
+
+// A send started during an outage blocks until it ends, like a connect or
+// HTTP timeout
+double NetStallTest::stallRemainingMs(double atMs) {
+    for (size_t i = 0; i < sizeof(STALLS) / sizeof(STALLS[0]); i++) {
+        if (atMs >= STALLS[i][0] && atMs < STALLS[i][1]) return STALLS[i][1] - atMs;
+    }
+    return 0;
+}
+
+NetStallRun NetStallTest::runLoop(bool threaded) {
+    NetStallRun r = NetStallRun();
+    SpscQueue<Request, NET_OUTBOX_SIZE> outbox;
+    SpscQueue<Result, NET_INBOX_SIZE> inbox;
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> sent(0);
+    std::atomic<uint32_t> workerOrderErrors(0);
+    std::vector<double> late;
+    
+    const Clock::time_point start = Clock::now();
+    
+    auto send = [&](const Request& req) {
+        double blockedMs = stallRemainingMs(msBetween(start, Clock::now()));
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(blockedMs + NET_SEND_MS));
+        sent++;
+        return req.text.length() > 0;
+    };
+    
+    std::thread worker;
+    if (threaded) {
+        worker = std::thread([&]() {
+            uint32_t lastSeq = 0;
+            Request req;
+            while (!stop) {
+                while (outbox.pop(req)) {
+                    if (req.seq <= lastSeq) workerOrderErrors++;
+                    lastSeq = req.seq;
+                    Result result = { req.seq, send(req) };
+                    // The loop drains every pass, so this only spins when it is stalled
+                    while (!inbox.push(result) && !stop) std::this_thread::yield();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+    
+    uint32_t seq = 0;
+    uint32_t lastResult = 0;
+    const int passes = _seconds * 1000 / NET_STALL_LOOP_MS;
+    for (int pass = 0; pass < passes; pass++) {
+        Clock::time_point due = start + std::chrono::milliseconds(pass * NET_STALL_LOOP_MS);
+        std::this_thread::sleep_until(due);
+        Clock::time_point begin = Clock::now();
+        late.push_back(msBetween(due, begin));
+        
+        Result result;
+        while (inbox.pop(result)) {
+            if (result.seq <= lastResult) r.orderErrors++;
+            lastResult = result.seq;
+            r.results++;
+        }
+        
+        if (pass % (NET_STALL_POST_MS / NET_STALL_LOOP_MS) == 0) {
+            Request req;
+            req.seq = ++seq;
+            req.text = "{\"level\":" + String(pass) + "}";
+            r.posted++;
+            if (threaded) {
+                if (!outbox.push(req)) r.dropped++;
+            } else {
+                send(req);
+                r.results++;
+            }
+        }
+        
+        r.maxPassUs = std::max(r.maxPassUs, msBetween(begin, Clock::now()) * 1000);
+        r.passes++;
+    }
+    
+    if (threaded) {
+        // Collect a result for every request that was queued, including
+        // one the worker is still sending (a lost one ends at the timeout)
+        Result result;
+        Clock::time_point giveUp = Clock::now() + std::chrono::milliseconds(NET_DRAIN_TIMEOUT_MS);
+        while (r.results + r.dropped < r.posted && Clock::now() < giveUp) {
+            while (inbox.pop(result)) {
+                if (result.seq <= lastResult) r.orderErrors++;
+                lastResult = result.seq;
+                r.results++;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        stop = true;
+        worker.join();
+    }
+    
+    r.sent = sent;
+    r.orderErrors += workerOrderErrors;
+    if (r.sent + r.dropped != r.posted || r.results != r.sent) r.orderErrors++;
+    
+    std::sort(late.begin(), late.end());
+    r.maxLateMs = late.empty() ? 0 : late.back();
+    r.p99LateMs = late.empty() ? 0 : late[late.size() * 99 / 100];
+    return r;
+}
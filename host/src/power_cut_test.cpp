@@ -0,0 +1,244 @@
+// power_cut_test.cpp
+#include "power_cut_test.h"
+#include <chrono>
+
+namespace {
+    const time_t CUT_NOW = 1761818400;              // 2025-10-30 10:00 UTC
+    const int CUT_HISTORY_DAYS = 10;
+    const char* CUT_NAMESPACE = "waterpump";
+    
+    TankConfig tankConfig(float height) {
+        TankConfig config;
+        config.firstTimeSetup = false;
+        config.tankHeight = height;
+        config.tankLength = height * 0.8f;
+        config.tankWidth = height * 0.6f;
+        config.tankRadius = height * 0.4f;
+        config.shape = height > 160 ? CYLINDRICAL : RECTANGULAR;
+        config.upperThreshold = 90 + height / 100;
+        config.lowerThreshold = 20 + height / 100;
+        config.maxInflow = height / 10;
+        config.deviceToken = "token" + String((int)height);
+        config.configVersion = (unsigned long)height;
+        config.lastModifiedSource = height > 160 ? "cloud" : "device";
+        config.needsSync = height > 160;
+        config.syncMode = height > 160 ? CLOUD_PRIORITY : DEVICE_PRIORITY;
+        return config;
+    }
+    
+    PumpCycle pumpCycle(int n) {
+        PumpCycle cycle;
+        cycle.timestamp = CUT_NOW - 3600 * (10 - n);
+        cycle.motorState = n % 2 == 0;
+        cycle.waterLevel = 20 + n;
+        cycle.inflow = 10 + n * 0.5f;
+        return cycle;
+    }
+    
+    DailyUsage dailyUsage(long day, float liters) {
+        DailyUsage usage;
+        usage.date = TimeUtils::dayNumberToTimestamp(day);
+        usage.totalUsageLiters = liters;
+        usage.pumpCycles = (int)liters / 50;
+        usage.pumpMinutes = (int)liters / 10;
+        usage.peakInflow = liters / 20;
+        return usage;
+    }
+    
+    UsageTotals usageTotals(long day, float month, float week) {
+        UsageTotals totals;
+        totals.year = 2025;
+        totals.month = 10;
+        totals.monthUsageLiters = month;
+        totals.yearUsageLiters = month + 60000;
+        totals.weekStartDay = day - day % 7;
+        totals.weekUsageLiters = week;
+        return totals;
+    }
+    
+    bool hasJournal() {
+        HostHal::NvsImage image = HostHal::getNvs();
+        return image[CUT_NAMESPACE].count("jrnl") > 0;
+    }
+}
+
+// Config, a few pump cycles and ten days of usage, as a device would hold
+void PowerCutTest::prepare() {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    HostHal::reset();
+    HostHal::clearPreferences();
+    HostHal::setSerialEcho(false);
+    HostHal::setEpoch(CUT_NOW);
+    
+    StorageManager storage;
+    storage.begin();
+    storage.saveTankConfig(tankConfig(150));
+    for (int i = 0; i < 5; i++) {
+        storage.savePumpCycle(pumpCycle(i));
+    }
+    
+    long today = TimeUtils::localDayNumber(CUT_NOW);
+    float month = 0;
+    for (long day = today - CUT_HISTORY_DAYS + 1; day <= today; day++) {
+        float liters = 200 + (day % 13) * 10;
+        month += liters;
+        storage.saveDailyUsage(dailyUsage(day, liters), usageTotals(day, month, month / 4));
+    }
+    _before = HostHal::getNvs();
+}
+
+// One save on a booted StorageManager, with the power cut after `budget`
+// writes (-1 = never); returns the writes that reached the store
+int PowerCutTest::save(Save which, long budget) {
+    StorageManager storage;
+    storage.begin();
+    
+    long today = TimeUtils::localDayNumber(CUT_NOW);
+    uint32_t writes = HostHal::getNvsWrites();
+    HostHal::setNvsWriteBudget(budget);
+    
+    switch (which) {
+        case SAVE_TANK_CONFIG:
+            storage.saveTankConfig(tankConfig(180));
+            break;
+        case SAVE_PUMP_CYCLE:
+            storage.savePumpCycle(pumpCycle(7));
+            break;
+        case SAVE_USAGE:
+            storage.saveDailyUsage(dailyUsage(today, 412.5), usageTotals(today, 3100, 900));
+            break;
+        case SAVE_DAY_CLOSE:
+            storage.saveDailyUsage(dailyUsage(today + 1, 12.5), usageTotals(today + 1, 3112.5, 912.5));
+            break;
+    }
+    
+    HostHal::setNvsWriteBudget(-1);
+    return HostHal::getNvsWrites() - writes;
+}
+
+// Everything the firmware would read back: config, usage history and
+// totals through StorageManager, and the pump-cycle ring as stored
+std::string PowerCutTest::observe() {
+    StorageManager storage;
+    char line[160];
+    std::string state;
+    
+    TankConfig c = storage.loadTankConfig();
+    snprintf(line, sizeof(line), "config %d %g %g %g %g %d %g %g %g %s %lu %s %d %d\n",
+             c.firstTimeSetup, c.tankHeight, c.tankLength, c.tankWidth, c.tankRadius, c.shape,
+             c.upperThreshold, c.lowerThreshold, c.maxInflow, c.deviceToken.c_str(), c.configVersion,
+             c.lastModifiedSource.c_str(), c.needsSync, c.syncMode);
+    state += line;
+    
+    DailyUsage days[CUT_HISTORY_DAYS + 1];
+    int count = 0;
+    storage.getUsageHistory(CUT_NOW + 86400, CUT_HISTORY_DAYS + 1, days, count);
+    for (int i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "day %lu %g %d %d %g\n", days[i].date, days[i].totalUsageLiters,
+                 days[i].pumpCycles, days[i].pumpMinutes, days[i].peakInflow);
+        state += line;
+    }
+    
+    UsageTotals t;
+    if (storage.loadUsageTotals(t)) {
+        snprintf(line, sizeof(line), "totals %d %d %g %g %ld %g\n", t.year, t.month,
+                 t.monthUsageLiters, t.yearUsageLiters, t.weekStartDay, t.weekUsageLiters);
+        state += line;
+    }
+    
+    HostHal::NvsImage image = HostHal::getNvs();
+    const std::map<std::string, std::vector<uint8_t> >& keys = image[CUT_NAMESPACE];
+    for (std::map<std::string, std::vector<uint8_t> >::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+        if (it->first.compare(0, 5, "cycle") != 0) continue;
+        state += it->first;
+        for (size_t i = 0; i < it->second.size(); i++) {
+            snprintf(line, sizeof(line), " %02x", it->second[i]);
+            state += line;
+        }
+        state += "\n";
+    }
+    return state;
+}
+
+// Reboots from the store as the cut left it, then again with the replay
+// itself cut at every write. Counts torn states and leftover journals.
+void PowerCutTest::bootAndCheck(const std::string& before, const std::string& after, PowerCutCase& c) {
+    HostHal::NvsImage cut = HostHal::getNvs();
+    bool journal = hasJournal();
+    
+    uint32_t writes = HostHal::getNvsWrites();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        StorageManager storage;
+        storage.begin();
+    }
+    double us = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6;
+    int replayWrites = HostHal::getNvsWrites() - writes;
+    
+    if (journal) {
+        c.replays++;
+        c.replayMeanUs += us;
+        c.replayMaxUs = std::max(c.replayMaxUs, us);
+        c.replayMaxWrites = std::max(c.replayMaxWrites, replayWrites);
+    }
+    
+    std::string state = observe();
+    c.cuts++;
+    if (state != before && state != after) c.torn++;
+    if (hasJournal()) c.journalsLeft++;
+    
+    for (int j = 0; j < replayWrites; j++) {
+        HostHal::setNvs(cut);
+        HostHal::setNvsWriteBudget(j);
+        {
+            StorageManager storage;
+            storage.begin();
+        }
+        HostHal::setNvsWriteBudget(-1);
+        {
+            StorageManager storage;
+            storage.begin();
+        }
+        
+        state = observe();
+        c.cuts++;
+        if (state != before && state != after) c.torn++;
+        if (hasJournal()) c.journalsLeft++;
+    }
+}
+
+PowerCutCase PowerCutTest::runCase(const char* name, Save which) {
+    PowerCutCase c = PowerCutCase();
+    c.name = name;
+    
+    HostHal::setNvs(_before);
+    std::string before = observe();
+    c.writes = save(which, -1);
+    std::string after = observe();
+    
+    for (int k = 0; k < c.writes; k++) {
+        HostHal::setNvs(_before);
+        save(which, k);
+        bootAndCheck(before, after, c);
+    }
+    
+    if (c.replays > 0) c.replayMeanUs /= c.replays;
+    return c;
+}
+
+PowerCutReport PowerCutTest::run() {
+    prepare();
+    
+    PowerCutReport report = PowerCutReport();
+    report.cases.push_back(runCase("tank_config", SAVE_TANK_CONFIG));
+    report.cases.push_back(runCase("pump_cycle", SAVE_PUMP_CYCLE));
+    report.cases.push_back(runCase("usage", SAVE_USAGE));
+    report.cases.push_back(runCase("day_close", SAVE_DAY_CLOSE));
+    
+    for (size_t i = 0; i < report.cases.size(); i++) {
+        report.torn += report.cases[i].torn;
+        report.journalsLeft += report.cases[i].journalsLeft;
+    }
+    return report;
+}
@@ -0,0 +1,112 @@
+// profiler_bench.cpp
+#include "profiler_bench.h"
+#include "host_hal.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    const int COST_PROBES = 10000000;
+    const int CASE_SAMPLES = 100000;
+    
+    typedef std::chrono::steady_clock Clock;
+    
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+ProfilerBench::ProfilerBench(uint32_t seed)
+    : _rng(seed) {
+}
+
+ProfilerReport ProfilerBench::run() {
+    ProfilerReport r = ProfilerReport();
+    HostHal::reset();
+    
+    LoopProfiler* profiler = new LoopProfiler();
+    int8_t id = profiler->registerProbe("bench");
+    
+    // Empty loop with the same counter, taken out of both
+    volatile int sink = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < COST_PROBES; i++) sink = i;
+    double emptySeconds = secondsSince(start);
+    
+    start = Clock::now();
+    for (int i = 0; i < COST_PROBES; i++) {
+        ProfileScope scope(*profiler, id);
+        sink = i;
+    }
+    r.nsPerProbe = (secondsSince(start) - emptySeconds) * 1e9 / COST_PROBES;
+    
+    start = Clock::now();
+    for (int i = 0; i < COST_PROBES; i++) {
+        profiler->record(id, (uint32_t)i & 0xFFFF);
+        sink = i;
+    }
+    r.nsPerRecord = (secondsSince(start) - emptySeconds) * 1e9 / COST_PROBES;
+    (void)sink;
+    delete profiler;
+    
+    std::vector<uint32_t> latencies(CASE_SAMPLES);
+    
+    std::fill(latencies.begin(), latencies.end(), 120);
+    r.cases.push_back(measure("constant_120us", latencies));
+    
+    std::uniform_int_distribution<uint32_t> uniform(10, 1000);
+    for (int i = 0; i < CASE_SAMPLES; i++) latencies[i] = uniform(_rng);
+    r.cases.push_back(measure("uniform_10_1000us", latencies));
+    
+    // Typical subsystem: median ~300 us with a long right tail
+    std::lognormal_distribution<double> lognormal(log(300.0), 1.0);
+    for (int i = 0; i < CASE_SAMPLES; i++) latencies[i] = (uint32_t)lognormal(_rng) + 1;
+    r.cases.push_back(measure("lognormal_300us", latencies));
+    
+    // Mostly fast, 2% blocked for ~20 ms (a flash write, a network stall)
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::normal_distribution<double> fast(50, 5);
+    std::normal_distribution<double> slow(20000, 2000);
+    for (int i = 0; i < CASE_SAMPLES; i++) {
+        latencies[i] = (uint32_t)std::max(1.0, unit(_rng) < 0.02 ? slow(_rng) : fast(_rng));
+    }
+    r.cases.push_back(measure("bimodal_50us_20ms", latencies));
+    
+    for (size_t i = 0; i < r.cases.size(); i++) {
+        if (!r.cases[i].withinBucket) r.failures++;
+    }
+    return r;
+}
+
+ProfilerCase ProfilerBench::measure(const char* name, const std::vector<uint32_t>& latenciesUs) {
+    LoopProfiler* profiler = new LoopProfiler();
+    int8_t id = profiler->registerProbe(name);
+    
+    for (size_t i = 0; i < latenciesUs.size(); i++) {
+        ProfileScope scope(*profiler, id);
+        HostHal::advanceMicros(latenciesUs[i]);
+    }
+    
+    ProbeSummary summary;
+    profiler->getSummary(id, summary);
+    delete profiler;
+    
+    ProfilerCase c;
+    c.name = name;
+    c.samples = summary.count;
+    c.trueP50Us = exactPercentile(latenciesUs, 50);
+    c.trueP99Us = exactPercentile(latenciesUs, 99);
+    c.p50Us = summary.p50Us;
+    c.p99Us = summary.p99Us;
+    c.maxUs = summary.maxUs;
+    c.withinBucket = c.samples == latenciesUs.size() &&
+                     c.p50Us >= c.trueP50Us && c.p50Us <= 2 * c.trueP50Us &&
+                     c.p99Us >= c.trueP99Us && c.p99Us <= 2 * c.trueP99Us;
+    return c;
+}
+
+// The sample at rank ceil(n * pct / 100), as LoopProfiler counts it
+uint32_t ProfilerBench::exactPercentile(std::vector<uint32_t> sorted, uint8_t pct) {
+    std::sort(sorted.begin(), sorted.end());
+    size_t rank = (sorted.size() * pct + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
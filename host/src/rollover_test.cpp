@@ -0,0 +1,242 @@
+// rollover_test.cpp
+#include "rollover_test.h"
+#include "host_hal.h"
+#include "config.h"
+#include "utils.h"
+#include <chrono>
+
+namespace {
+    const char* TEST_TZ = "CET-1CEST,M3.5.0,M10.5.0/3";   // Central Europe, DST
+    const long LOOP_INTERVAL_S = 60;                      // WaterTracker's loop, roughly
+    const long HOUR_S = 3600;
+    const long DAY_S = 86400;
+}
+
+void RolloverTest::onRollover(RolloverEvent event, time_t closedStart, time_t nextStart, void* context) {
+    RolloverTest* test = (RolloverTest*)context;
+    Fired f;
+    f.event = event;
+    f.closedStart = closedStart;
+    f.nextStart = nextStart;
+    f.at = time(nullptr);
+    test->_fired.push_back(f);
+}
+
+time_t RolloverTest::local(int year, int month, int day, int hour, int minute) {
+    struct tm timeinfo = {};
+    timeinfo.tm_year = year - 1900;
+    timeinfo.tm_mon = month - 1;
+    timeinfo.tm_mday = day;
+    timeinfo.tm_hour = hour;
+    timeinfo.tm_min = minute;
+    timeinfo.tm_isdst = -1;
+    return mktime(&timeinfo);
+}
+
+void RolloverTest::start(time_t wall) {
+    HostHal::reset();
+    HostHal::setEpoch(wall);
+    _scheduler = RolloverScheduler();
+    _scheduler.begin(onRollover, this);
+    _fired.clear();
+    _expected.clear();
+    _expectedAnchors = 0;
+    _synced = false;
+    _wall = wall;
+    tick(true);
+}
+
+void RolloverTest::runFor(long seconds) {
+    for (long s = LOOP_INTERVAL_S; s <= seconds; s += LOOP_INTERVAL_S) {
+        HostHal::advanceMillis(LOOP_INTERVAL_S * 1000);
+        tick(true);
+    }
+}
+
+// The loop is blocked (WiFi connect, OTA) and runs once at the end
+void RolloverTest::stall(long seconds) {
+    HostHal::advanceMillis(seconds * 1000);
+    tick(false);
+}
+
+// The wall clock jumps (NTP) while uptime does not
+void RolloverTest::step(long seconds) {
+    HostHal::setEpoch(time(nullptr) + seconds);
+    tick(false);
+}
+
+void RolloverTest::tick(bool running) {
+    time_t now = time(nullptr);
+    
+    if (!TimeUtils::isTimeSynced()) {
+        // Nothing may fire before the clock is valid
+    } else if (!_synced) {
+        _synced = true;
+        _expectedAnchors++;
+    } else if (now > _wall) {
+        expectBetween(_wall, now, running);
+    } else if (TimeUtils::localDayNumber(now) < TimeUtils::localDayNumber(_wall)) {
+        _expectedAnchors++;       // Stepped back into an earlier day
+    }
+    
+    _scheduler.loop();
+    _wall = now;
+}
+
+// Boundaries in (from, to], found with localtime() alone: step an hour at a
+// time until the date changes, then bisect to its first second
+void RolloverTest::expectBetween(time_t from, time_t to, bool running) {
+    std::vector<Boundary> crossed;
+    time_t t = from;
+    
+    while (t < to) {
+        time_t next = std::min(t + HOUR_S, to);
+        if (TimeUtils::localDayNumber(next) != TimeUtils::localDayNumber(t)) {
+            time_t low = t;
+            time_t high = next;
+            while (high - low > 1) {
+                time_t mid = low + (high - low) / 2;
+                if (TimeUtils::localDayNumber(mid) == TimeUtils::localDayNumber(t)) low = mid;
+                else high = mid;
+            }
+            
+            struct tm timeinfo;
+            localtime_r(&high, &timeinfo);
+            Boundary b;
+            b.start = high;
+            b.running = running;
+            b.event = ROLLOVER_DAY;
+            crossed.push_back(b);
+            if (timeinfo.tm_wday == ROLLOVER_WEEK_START_DAY) {
+                b.event = ROLLOVER_WEEK;
+                crossed.push_back(b);
+            }
+            if (timeinfo.tm_mday == 1) {
+                b.event = ROLLOVER_MONTH;
+                crossed.push_back(b);
+            }
+        }
+        t = next;
+    }
+    
+    // Past the catch-up limit the scheduler re-anchors instead
+    if (crossed.size() > ROLLOVER_MAX_CATCHUP) {
+        crossed.resize(ROLLOVER_MAX_CATCHUP);
+        _expectedAnchors++;
+    }
+    _expected.insert(_expected.end(), crossed.begin(), crossed.end());
+}
+
+RolloverCase RolloverTest::finish(const char* name) {
+    RolloverCase c = RolloverCase();
+    c.name = name;
+    c.expected = _expected.size();
+    c.expectedAnchors = _expectedAnchors;
+    
+    // closedStart must be where the previous event of the same period
+    // left off (unknown again after an anchor)
+    time_t lastStart[ROLLOVER_MONTH + 1] = {};
+    size_t next = 0;
+    for (size_t i = 0; i < _fired.size(); i++) {
+        const Fired& f = _fired[i];
+        if (f.event == ROLLOVER_ANCHOR) {
+            c.anchors++;
+            for (int p = 0; p <= ROLLOVER_MONTH; p++) lastStart[p] = 0;
+            continue;
+        }
+        
+        c.fired++;
+        if (lastStart[f.event] != 0 && f.closedStart != lastStart[f.event]) c.broken++;
+        lastStart[f.event] = f.nextStart;
+        
+        if (next >= _expected.size()) {
+            c.mismatched++;
+            continue;
+        }
+        const Boundary& b = _expected[next++];
+        if (f.event != b.event || f.nextStart != b.start) c.mismatched++;
+        if (b.running && f.at - b.start >= LOOP_INTERVAL_S) c.late++;
+    }
+    return c;
+}
+
+RolloverReport RolloverTest::run() {
+    setenv("TZ", TEST_TZ, 1);
+    tzset();
+    HostHal::setSerialEcho(false);
+    RolloverReport r = RolloverReport();
+    
+    // 23 h and 25 h days
+    start(local(2025, 3, 29, 12, 0));
+    runFor(3 * DAY_S);
+    r.cases.push_back(finish("dst_spring"));
+    
+    start(local(2025, 10, 25, 12, 0));
+    runFor(3 * DAY_S);
+    r.cases.push_back(finish("dst_autumn"));
+    
+    // 2025-12-01 is a Monday: day, week and month end at the same second
+    start(local(2025, 11, 29, 12, 0));
+    runFor(3 * DAY_S);
+    r.cases.push_back(finish("month_and_week"));
+    
+    start(local(2025, 6, 10, 20, 0));
+    runFor(150 * 60);
+    stall(3 * HOUR_S);
+    runFor(2 * HOUR_S);
+    r.cases.push_back(finish("stall_3h"));
+    
+    start(local(2025, 6, 10, 20, 0));
+    runFor(HOUR_S);
+    stall(40 * HOUR_S);
+    runFor(HOUR_S);
+    r.cases.push_back(finish("stall_40h"));
+    
+    // The 25 h day inside a stall
+    start(local(2025, 10, 25, 22, 0));
+    runFor(HOUR_S);
+    stall(26 * HOUR_S);
+    runFor(HOUR_S);
+    r.cases.push_back(finish("stall_dst"));
+    
+    start(local(2025, 6, 29, 18, 0));
+    runFor(HOUR_S);
+    step(2 * DAY_S + 5 * HOUR_S);
+    runFor(HOUR_S);
+    r.cases.push_back(finish("ntp_forward"));
+    
+    // Back across midnight: re-anchored, and that midnight fires again
+    start(local(2025, 6, 10, 23, 40));
+    runFor(40 * 60);
+    step(-30 * 60);
+    runFor(HOUR_S);
+    r.cases.push_back(finish("ntp_backward"));
+    
+    // Longer than ROLLOVER_MAX_CATCHUP days
+    start(local(2025, 1, 10, 12, 0));
+    runFor(HOUR_S);
+    stall(45 * DAY_S);
+    runFor(HOUR_S);
+    r.cases.push_back(finish("outage_45d"));
+    
+    // Booted without a clock, synced five minutes before midnight
+    start(1000);
+    runFor(10 * 60);
+    step(local(2025, 6, 10, 23, 55) - time(nullptr));
+    runFor(10 * 60);
+    r.cases.push_back(finish("unsynced_boot"));
+    
+    for (size_t i = 0; i < r.cases.size(); i++) {
+        const RolloverCase& c = r.cases[i];
+        if (c.fired != c.expected || c.mismatched || c.late || c.broken || c.anchors != c.expectedAnchors) {
+            r.failures++;
+        }
+    }
+    
+    // Fast path: anchored, before the next deadline
+    const int loops = 1000000;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; i++) _scheduler.loop();
+    r.nsPerLoop = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e9 / loops;
+    return r;
+}
@@ -0,0 +1,212 @@
+// scheduler_bench.cpp
+#include "scheduler_bench.h"
+#include "host_hal.h"
+#include <chrono>
+#include <math.h>
+
+namespace {
+    const uint32_t BENCH_MIN_PERIOD_MS = 10;
+    const uint32_t BENCH_MAX_PERIOD_MS = 600000;
+    const int IDLE_RUNS = 1000000;
+    
+    const uint64_t DAY_MS = 86400000ULL;
+    const unsigned long SOAK_LOOP_MS = 20;           // Loop pass while not stalled
+    const uint64_t SOAK_STALL_EVERY_MS = 6 * 3600000ULL;
+    const unsigned long SOAK_STALL_MS = 2500;
+    const unsigned long SOAK_LONG_STALL_MS = 600000;
+    const int SOAK_LONG_STALL = 120;                 // Index of the long stall (day 30)
+    
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+SchedulerBench::SchedulerBench(int timers, uint32_t seed)
+    : _timers(timers), _seed(seed), _rng(seed), _stallEnding(false) {
+}
+
+void SchedulerBench::onCount(void* context) {
+    ((Timer*)context)->runs++;
+}
+
+// Runs are checked against the deadline grid origin + k * period: two runs
+// for one deadline are a burst, deadlines passed without a run were
+// coalesced, and the offset into the period is the lateness
+void SchedulerBench::onTimer(void* context) {
+    Timer* t = (Timer*)context;
+    uint64_t now = HostHal::uptimeMs();
+    uint64_t late = now - t->originMs;
+    
+    if (t->periodMs > 0) {
+        uint64_t deadline = late / t->periodMs;
+        late %= t->periodMs;
+        if (t->runs > 0) {
+            uint64_t previous = (t->lastRunMs - t->originMs) / t->periodMs;
+            if (deadline == previous) t->bursts++;
+            else t->coalesced += deadline - previous - 1;
+        } else {
+            t->coalesced += deadline;
+        }
+    }
+    
+    if (!t->bench->_stallEnding && late > t->maxLateMs) t->maxLateMs = late;
+    t->runs++;
+    t->lastRunMs = now;
+}
+
+// As TaskScheduler rounds it: whole ticks, at least one
+uint64_t SchedulerBench::firstDeadline(uint32_t delayMs) {
+    uint64_t ticks = (delayMs + SCHEDULER_TICK_MS - 1) / SCHEDULER_TICK_MS;
+    return (ticks > 0 ? ticks : 1) * SCHEDULER_TICK_MS;
+}
+
+SchedulerOverhead SchedulerBench::overhead(int simSeconds) {
+    HostHal::reset();
+    _rng.seed(_seed);
+    
+    SchedulerOverhead r = SchedulerOverhead();
+    r.timers = _timers;
+    std::vector<Timer> timers(_timers, Timer());
+    TaskScheduler* scheduler = new TaskScheduler();
+    
+    std::uniform_real_distribution<double> logPeriod(log(BENCH_MIN_PERIOD_MS), log(BENCH_MAX_PERIOD_MS));
+    for (int i = 0; i < _timers; i++) {
+        Timer& t = timers[i];
+        t.bench = this;
+        t.periodMs = (uint32_t)(exp(logPeriod(_rng)) / SCHEDULER_TICK_MS + 0.5) * SCHEDULER_TICK_MS;
+        t.originMs = firstDeadline(0);
+        if (scheduler->addPeriodic("bench", t.periodMs, onCount, &t) < 0) r.countErrors++;
+    }
+    
+    const uint64_t steps = (uint64_t)simSeconds * 1000;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t s = 0; s < steps; s++) {
+        HostHal::advanceMillis(1);
+        scheduler->run();
+    }
+    double runSeconds = secondsSince(start);
+    
+    for (int i = 0; i < _timers; i++) {
+        const Timer& t = timers[i];
+        long expected = (long)((steps - t.originMs) / t.periodMs) + 1;
+        r.dispatches += t.runs;
+        if (labs((long)t.runs - expected) > 1) r.countErrors++;
+    }
+    
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < IDLE_RUNS; i++) scheduler->run();
+    r.nsPerIdleRun = secondsSince(start) * 1e9 / IDLE_RUNS;
+    delete scheduler;
+    
+    // What the scheduler replaced: every timer polled on every pass
+    for (int i = 0; i < _timers; i++) timers[i].polledAt = millis();
+    uint64_t polls = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t s = 0; s < steps; s++) {
+        HostHal::advanceMillis(1);
+        for (int i = 0; i < _timers; i++) {
+            Timer& t = timers[i];
+            if (millis() - t.polledAt >= t.periodMs) {
+                t.polledAt += t.periodMs;
+                polls++;
+            }
+        }
+    }
+    double pollSeconds = secondsSince(start);
+    
+    // The simulated clock's own cost, taken out of both
+    start = std::chrono::steady_clock::now();
+    for (uint64_t s = 0; s < steps; s++) HostHal::advanceMillis(1);
+    double clockSeconds = secondsSince(start);
+    
+    r.nsPerRun = (runSeconds - clockSeconds) * 1e9 / steps;
+    r.nsPerDispatch = r.dispatches > 0 ? (runSeconds - clockSeconds) * 1e9 / r.dispatches : 0;
+    r.nsPerPollPass = (pollSeconds - clockSeconds) * 1e9 / steps;
+    if (polls == 0) r.countErrors++;
+    return r;
+}
+
+SchedulerSoak SchedulerBench::soak(int days) {
+    HostHal::reset();
+    _stallEnding = false;
+    
+    // main.cpp's tasks, a weekly task, and a one-shot past the wheel's range
+    struct Spec {
+        const char* name;
+        uint32_t periodMs;
+        uint32_t delayMs;
+        TaskPriority priority;
+    };
+    const Spec specs[] = {
+        { "sensor", SENSOR_SAMPLE_INTERVAL_MS, SENSOR_SAMPLE_INTERVAL_MS, TASK_PRIORITY_HIGH },
+        { "tracker", TRACKER_UPDATE_INTERVAL_MS, 0, TASK_PRIORITY_NORMAL },
+        { "display", DISPLAY_UPDATE_INTERVAL_MS, 0, TASK_PRIORITY_NORMAL },
+        { "trace", TRACE_FLUSH_INTERVAL_MS, TRACE_FLUSH_INTERVAL_MS, TASK_PRIORITY_LOW },
+        { "telemetry", TELEMETRY_SEND_INTERVAL_MS, 0, TASK_PRIORITY_NORMAL },
+        { "sync", CONFIG_SYNC_INTERVAL_MS, CONFIG_SYNC_INTERVAL_MS, TASK_PRIORITY_LOW },
+        { "iotPoll", IOT_POLL_INTERVAL_MS, IOT_POLL_INTERVAL_MS, TASK_PRIORITY_LOW },
+        { "ota", OTA_CHECK_INTERVAL_MS, OTA_CHECK_INTERVAL_MS, TASK_PRIORITY_LOW },
+        { "ml", ML_UPDATE_CHECK_INTERVAL_MS, ML_UPDATE_CHECK_INTERVAL_MS, TASK_PRIORITY_LOW },
+        { "weekly", 7 * DAY_MS, 7 * DAY_MS, TASK_PRIORITY_LOW },
+        { "oneshot_3d", 0, 3 * DAY_MS, TASK_PRIORITY_NORMAL }
+    };
+    const int count = sizeof(specs) / sizeof(specs[0]);
+    
+    SchedulerSoak r = SchedulerSoak();
+    r.days = days;
+    std::vector<Timer> timers(count, Timer());
+    TaskScheduler* scheduler = new TaskScheduler();
+    
+    for (int i = 0; i < count; i++) {
+        Timer& t = timers[i];
+        t.bench = this;
+        t.name = specs[i].name;
+        t.periodMs = specs[i].periodMs;
+        t.originMs = firstDeadline(specs[i].delayMs);
+        if (t.periodMs > 0) {
+            scheduler->addPeriodic(t.name, t.periodMs, onTimer, &t, specs[i].priority, specs[i].delayMs);
+        } else {
+            scheduler->addOneShot(t.name, specs[i].delayMs, onTimer, &t, specs[i].priority);
+        }
+    }
+    
+    const uint64_t endMs = days * DAY_MS;
+    uint64_t nextStall = SOAK_STALL_EVERY_MS + 1234;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    while (HostHal::uptimeMs() < endMs) {
+        if (HostHal::uptimeMs() >= nextStall) {
+            HostHal::advanceMillis(r.stalls == SOAK_LONG_STALL ? SOAK_LONG_STALL_MS : SOAK_STALL_MS);
+            nextStall += SOAK_STALL_EVERY_MS;
+            r.stalls++;
+            _stallEnding = true;
+            scheduler->run();
+            _stallEnding = false;
+            continue;
+        }
+        HostHal::advanceMillis(SOAK_LOOP_MS);
+        scheduler->run();
+    }
+    r.wallSeconds = secondsSince(start);
+    delete scheduler;
+    
+    uint64_t endedMs = HostHal::uptimeMs();
+    for (int i = 0; i < count; i++) {
+        const Timer& t = timers[i];
+        SchedulerSoakTask task;
+        task.name = t.name;
+        task.periodMs = t.periodMs;
+        task.runs = t.runs;
+        task.coalesced = t.coalesced;
+        task.bursts = t.bursts;
+        task.maxLateMs = t.maxLateMs;
+        
+        uint64_t deadlines = endedMs < t.originMs ? 0
+            : t.periodMs > 0 ? (endedMs - t.originMs) / t.periodMs + 1 : 1;
+        task.countOk = t.runs + t.coalesced == deadlines;
+        
+        if (task.bursts > 0 || !task.countOk || task.maxLateMs > SOAK_LOOP_MS) r.findings++;
+        r.tasks.push_back(task);
+    }
+    return r;
+}
@@ -0,0 +1,165 @@
+// sim_scenario.cpp
+#include "sim_scenario.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+    bool parseTime(const std::string& text, uint64_t& ms) {
+        char* end = nullptr;
+        double value = strtod(text.c_str(), &end);
+        if (end == text.c_str() || value < 0) return false;
+
+        double scale = 1000;
+        if (*end == 'm') scale = 60000;
+        else if (*end == 'h') scale = 3600000;
+        else if (*end == 'd') scale = 86400000;
+        else if (*end != 's' && *end != '\0') return false;
+
+        ms = (uint64_t)(value * scale);
+        return true;
+    }
+
+    bool parseFloat(const std::string& text, float& value) {
+        char* end = nullptr;
+        value = strtof(text.c_str(), &end);
+        return end != text.c_str() && *end == '\0';
+    }
+
+    bool parseSwitch(const std::string& text, float& value) {
+        if (text == "on") value = 1;
+        else if (text == "off") value = 0;
+        else return false;
+        return true;
+    }
+
+    // Settings that may also change mid-run
+    bool parseSetting(const std::string& key, const std::string& arg, SimSetting& setting, float& value) {
+        if (key == "source") {
+            setting = SIM_SOURCE;
+            return parseSwitch(arg, value);
+        }
+
+        if (key == "pump_rate") setting = SIM_PUMP_RATE;
+        else if (key == "demand") setting = SIM_DEMAND;
+        else if (key == "noise") setting = SIM_NOISE;
+        else if (key == "dropout") setting = SIM_DROPOUT;
+        else if (key == "leak") setting = SIM_LEAK;
+        else return false;
+        return parseFloat(arg, value);
+    }
+
+    // fault <point> <probability> [count] [delay_ms], from words[first]
+    bool parseFault(const std::vector<std::string>& words, size_t first, SimEvent& evt) {
+        if (words.size() < first + 3 || words.size() > first + 5 || words[first] != "fault") return false;
+
+        evt.setting = SIM_FAULT;
+        evt.faultCount = -1;
+        evt.faultDelayMs = 0;
+        if (!FaultInjector::pointFromName(words[first + 1].c_str(), evt.fault)) return false;
+        if (!parseFloat(words[first + 2], evt.value)) return false;
+
+        float number;
+        if (words.size() > first + 3) {
+            if (!parseFloat(words[first + 3], number)) return false;
+            evt.faultCount = (int32_t)number;
+        }
+        if (words.size() > first + 4) {
+            if (!parseFloat(words[first + 4], number) || number < 0) return false;
+            evt.faultDelayMs = (uint32_t)number;
+        }
+        return true;
+    }
+}
+
+bool SimScenario::load(const char* path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    name = path;
+    const char* slash = strrchr(path, '/');
+    if (slash) name = slash + 1;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream in(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (in >> word) words.push_back(word);
+        if (words.empty()) continue;
+
+        const std::string& key = words[0];
+        bool ok = true;
+        SimSetting setting;
+        float value;
+
+        if (key == "at" && words.size() > 2 && words[2] == "fault") {
+            SimEvent evt;
+            ok = parseTime(words[1], evt.atMs) && parseFault(words, 2, evt);
+            if (ok) events.push_back(evt);
+        } else if (key == "fault") {
+            // Armed once the firmware is up (the first plant step)
+            SimEvent evt;
+            evt.atMs = 0;
+            ok = parseFault(words, 0, evt);
+            if (ok) events.push_back(evt);
+        } else if (key == "at" && words.size() == 4) {
+            SimEvent evt;
+            ok = parseTime(words[1], evt.atMs) && parseSetting(words[2], words[3], evt.setting, evt.value);
+            if (ok) events.push_back(evt);
+        } else if (key == "duration" && words.size() == 2) {
+            ok = parseTime(words[1], durationMs);
+        } else if (key == "seed" && words.size() == 2) {
+            seed = strtoul(words[1].c_str(), nullptr, 10);
+        } else if (key == "tank" && words.size() == 5 && words[1] == "rect") {
+            cylindrical = false;
+            ok = parseFloat(words[2], length) && parseFloat(words[3], width) && parseFloat(words[4], height);
+        } else if (key == "tank" && words.size() == 4 && words[1] == "cyl") {
+            cylindrical = true;
+            ok = parseFloat(words[2], radius) && parseFloat(words[3], height);
+        } else if (key == "start_level" && words.size() == 2) {
+            ok = parseFloat(words[1], startLevel);
+        } else if (key == "thresholds" && words.size() == 3) {
+            ok = parseFloat(words[1], lowerThreshold) && parseFloat(words[2], upperThreshold);
+        } else if (key == "head_loss" && words.size() == 2) {
+            ok = parseFloat(words[1], headLoss);
+        } else if (key == "relay_latency" && words.size() == 2) {
+            float latencyMs;
+            ok = parseFloat(words[1], latencyMs) && latencyMs >= 0;
+            if (ok) relayLatencyMs = (unsigned long)latencyMs;
+        } else if (key == "draw" && words.size() == 3) {
+            ok = parseFloat(words[1], drawLiters) && parseFloat(words[2], drawRate);
+        } else if (words.size() == 2 && parseSetting(key, words[1], setting, value)) {
+            switch (setting) {
+                case SIM_SOURCE:    sourceAvailable = value > 0; break;
+                case SIM_PUMP_RATE: pumpRate = value; break;
+                case SIM_DEMAND:    demandPerHour = value; break;
+                case SIM_NOISE:     noiseCm = value; break;
+                case SIM_DROPOUT:   dropoutRate = value; break;
+                case SIM_LEAK:      leakLpm = value; break;
+                case SIM_FAULT:     break;
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = name + ":" + std::to_string(lineNumber) + ": cannot parse \"" + line + "\"";
+            return false;
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const SimEvent& a, const SimEvent& b) {
+        return a.atMs < b.atMs;
+    });
+    return true;
+}
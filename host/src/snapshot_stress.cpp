@@ -0,0 +1,211 @@
+// snapshot_stress.cpp
+#include "snapshot_stress.h"
+#include "system_snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+    const int TIMING_SAMPLE_EVERY = 64;          // Calls between timed calls
+    
+    typedef std::chrono::steady_clock Clock;
+    
+    double nsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+    
+    // What timing an empty call costs, taken out of every timed call
+    double clockNs() {
+        const int calls = 10000;
+        double total = 0;
+        for (int i = 0; i < calls; i++) {
+            Clock::time_point start = Clock::now();
+            total += nsSince(start);
+        }
+        return total / calls;
+    }
+    
+    // Every field a function of n, so a mix of two publishes shows
+    SystemSnapshot numbered(uint32_t n) {
+        SystemSnapshot s;
+        s.timestamp = n;
+        s.waterLevel = (float)(n % 100000);
+        s.currentInflow = (float)(n % 1000);
+        s.maxInflow = (float)(n % 777);
+        s.motorState = n & 1;
+        s.mode = n % 3;
+        s.dryRunAlarm = (n >> 1) & 1;
+        s.overflowAlarm = (n >> 2) & 1;
+        s.leakAlarm = (n >> 3) & 1;
+        s.dailyUsage = (float)(n % 4096);
+        s.weeklyUsage = (float)(n % 8191);
+        s.monthlyUsage = (float)(n % 65521);
+        s.todayCycles = (int)n;
+        s.pumpRate = (float)(n % 97);
+        return s;
+    }
+    
+    bool consistent(const SystemSnapshot& s) {
+        SystemSnapshot expected = numbered((uint32_t)s.timestamp);
+        return s.waterLevel == expected.waterLevel && s.currentInflow == expected.currentInflow &&
+               s.maxInflow == expected.maxInflow && s.motorState == expected.motorState &&
+               s.mode == expected.mode && s.dryRunAlarm == expected.dryRunAlarm &&
+               s.overflowAlarm == expected.overflowAlarm && s.leakAlarm == expected.leakAlarm &&
+               s.dailyUsage == expected.dailyUsage && s.weeklyUsage == expected.weeklyUsage &&
+               s.monthlyUsage == expected.monthlyUsage && s.todayCycles == expected.todayCycles &&
+               s.pumpRate == expected.pumpRate;
+    }
+    
+    struct NumberedCommand {
+        uint16_t producer;
+        uint32_t seq;
+    };
+}
+
+SnapshotStress::SnapshotStress(int seconds, int readers, int producers)
+    : _seconds(seconds), _readers(readers), _producers(producers) {
+}
+
+SnapshotStressReport SnapshotStress::run() {
+    SnapshotStressReport r = SnapshotStressReport();
+    r.readers = _readers;
+    r.producers = _producers;
+    runSnapshot(r);
+    runCommands(r);
+    return r;
+}
+
+void SnapshotStress::runSnapshot(SnapshotStressReport& r) {
+    SnapshotBuffer* buffer = new SnapshotBuffer();
+    std::atomic<bool> stop(false);
+    
+    struct ReaderStats {
+        uint64_t reads;
+        uint64_t failed;
+        uint64_t torn;
+        uint64_t stale;
+        std::vector<double> ns;
+    };
+    std::vector<ReaderStats> stats(_readers, ReaderStats());
+    
+    std::vector<std::thread> readers;
+    for (int i = 0; i < _readers; i++) {
+        readers.push_back(std::thread([&, i]() {
+            ReaderStats& s = stats[i];
+            unsigned long last = 0;
+            SystemSnapshot snapshot;
+            while (!stop) {
+                bool timed = s.reads % TIMING_SAMPLE_EVERY == 0;
+                Clock::time_point start = timed ? Clock::now() : Clock::time_point();
+                bool ok = buffer->read(snapshot);
+                if (timed) s.ns.push_back(nsSince(start));
+                s.reads++;
+                
+                if (!ok) {
+                    s.failed++;
+                    continue;
+                }
+                if (!consistent(snapshot)) s.torn++;
+                else if (snapshot.timestamp < last) s.stale++;
+                else last = snapshot.timestamp;
+            }
+        }));
+    }
+    
+    // Writer on this thread
+    uint32_t n = 0;
+    std::vector<double> publishNs;
+    Clock::time_point end = Clock::now() + std::chrono::seconds(_seconds);
+    while (Clock::now() < end) {
+        for (int i = 0; i < TIMING_SAMPLE_EVERY; i++) {
+            SystemSnapshot snapshot = numbered(++n);
+            if (i == 0) {
+                Clock::time_point start = Clock::now();
+                buffer->publish(snapshot);
+                publishNs.push_back(nsSince(start));
+            } else {
+                buffer->publish(snapshot);
+            }
+        }
+    }
+    stop = true;
+    for (size_t i = 0; i < readers.size(); i++) readers[i].join();
+    delete buffer;
+    
+    std::vector<double> ns;
+    for (int i = 0; i < _readers; i++) {
+        r.reads += stats[i].reads;
+        r.failedReads += stats[i].failed;
+        r.tornReads += stats[i].torn;
+        r.staleReads += stats[i].stale;
+        ns.insert(ns.end(), stats[i].ns.begin(), stats[i].ns.end());
+    }
+    double overhead = clockNs();
+    r.publishes = n;
+    if (!publishNs.empty()) {
+        std::sort(publishNs.begin(), publishNs.end());
+        r.medianPublishNs = publishNs[publishNs.size() / 2] - overhead;
+    }
+    if (!ns.empty()) {
+        std::sort(ns.begin(), ns.end());
+        r.medianReadNs = ns[ns.size() / 2] - overhead;
+        r.p99ReadNs = ns[ns.size() * 99 / 100] - overhead;
+        r.maxReadNs = ns.back() - overhead;
+    }
+}
+
+void SnapshotStress::runCommands(SnapshotStressReport& r) {
+    MpscQueue<NumberedCommand, CONTROL_QUEUE_SIZE>* queue = new MpscQueue<NumberedCommand, CONTROL_QUEUE_SIZE>();
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> fullRetries(0);
+    std::vector<uint32_t> pushed(_producers, 0);
+    
+    std::vector<std::thread> producers;
+    for (int p = 0; p < _producers; p++) {
+        producers.push_back(std::thread([&, p]() {
+            NumberedCommand command;
+            command.producer = p;
+            command.seq = 0;
+            while (!stop) {
+                command.seq++;
+                bool queued;
+                while (!(queued = queue->push(command)) && !stop) {
+                    fullRetries++;
+                    std::this_thread::yield();
+                }
+                if (!queued) break;
+                pushed[p] = command.seq;
+            }
+        }));
+    }
+    
+    // Consumer on this thread, as the control loop
+    std::vector<uint32_t> next(_producers, 1);
+    NumberedCommand command;
+    Clock::time_point end = Clock::now() + std::chrono::seconds(_seconds);
+    auto take = [&]() {
+        r.popped++;
+        uint32_t& expected = next[command.producer];
+        if (command.seq > expected) r.lost += command.seq - expected;
+        if (command.seq < expected) r.duplicated++;
+        else expected = command.seq + 1;
+    };
+    while (Clock::now() < end) {
+        for (int i = 0; i < 1000; i++) {
+            if (queue->pop(command)) take();
+            else std::this_thread::yield();
+        }
+    }
+    stop = true;
+    for (size_t i = 0; i < producers.size(); i++) producers[i].join();
+    while (queue->pop(command)) take();
+    delete queue;
+    
+    for (int p = 0; p < _producers; p++) {
+        r.pushed += pushed[p];
+        if (pushed[p] + 1 > next[p]) r.lost += pushed[p] + 1 - next[p];
+    }
+    r.fullRetries = fullRetries;
+}
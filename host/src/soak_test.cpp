@@ -0,0 +1,221 @@
+// soak_test.cpp
+#include "soak_test.h"
+#include "host_hal.h"
+#include "flash_wear_monitor.h"
+#include <algorithm>
+#include <stdarg.h>
+
+namespace {
+    const int SOAK_WARMUP_HOURS = 24;             // Boot-time allocations and first saves
+    const int SOAK_WRAP_WINDOW_HOURS = 3;         // Hours from the wrap checked for bursts
+    const float SOAK_BURST_FACTOR = 2.0;          // x the busiest hour before the wrap
+    const float SOAK_GROWTH_LIMIT = 64.0;         // Live bytes per day still counted as flat
+    
+    std::string format(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+    
+    std::string format(const char* fmt, ...) {
+        char text[256];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(text, sizeof(text), fmt, args);
+        va_end(args);
+        return text;
+    }
+    
+    // Least-squares slope of y over x = 0, 1, 2 ...
+    float slope(const std::vector<float>& y) {
+        size_t n = y.size();
+        if (n < 2) return 0;
+        
+        double sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+        for (size_t i = 0; i < n; i++) {
+            sumX += i;
+            sumY += y[i];
+            sumXY += i * y[i];
+            sumXX += (double)i * i;
+        }
+        double denominator = n * sumXX - sumX * sumX;
+        return denominator != 0 ? (n * sumXY - sumX * sumY) / denominator : 0;
+    }
+}
+
+SoakTest::SoakTest(const SimScenario& scenario, int days)
+    : _scenario(scenario), _days(days) {
+    _scenario.durationMs = (uint64_t)days * 86400000ULL;
+}
+
+SoakReport SoakTest::run() {
+    SoakReport report = SoakReport();
+    report.days = _days;
+    report.clockWraps = sizeof(unsigned long) == 4;
+    report.wrapHour = -1;
+    
+    _samples.clear();
+    _samples.reserve(_days * 24);
+    FlashWearMonitor::reset();
+    
+    TankSimulator simulator(_scenario);
+    simulator.setHourHook(onHour, this);
+    
+    HeapTracker::start();
+    report.metrics = simulator.run();
+    HeapTracker::stop();
+    
+    for (size_t h = 1; h < _samples.size(); h++) {
+        if (_samples[h].millisAt < _samples[h - 1].millisAt) {
+            report.wrapHour = h;
+            break;
+        }
+    }
+    
+    checkTimers(report);
+    checkSafety(report);
+    checkHeap(report);
+    return report;
+}
+
+void SoakTest::onHour(int /*hour*/, const SimMetrics& metrics, void* context) {
+    SoakTest* self = static_cast<SoakTest*>(context);
+    HeapTracker::pause();
+    
+    SoakSample sample;
+    sample.millisAt = millis();
+    sample.metrics = metrics;
+    sample.nvsWrites = 0;
+    for (int i = 0; i < FlashWearMonitor::getKeyCount(); i++) {
+        const KeyWearStats& stats = FlashWearMonitor::getKeyStats(i);
+        sample.keyWrites.push_back(stats.writes);
+        sample.nvsWrites += stats.writes;
+    }
+    sample.heap = HeapTracker::getStats();
+    self->_samples.push_back(sample);
+    
+    HeapTracker::resume();
+}
+
+// ==================== TIMERS ====================
+
+void SoakTest::checkTimers(SoakReport& report) {
+    if (report.wrapHour < 0) return;
+    
+    // Hourly counts from the cumulative samples
+    size_t hours = _samples.size();
+    std::vector<uint32_t> reads(hours), starts(hours), writes(hours);
+    for (size_t h = 1; h < hours; h++) {
+        reads[h] = _samples[h].metrics.sensorReads - _samples[h - 1].metrics.sensorReads;
+        starts[h] = _samples[h].metrics.pumpStarts - _samples[h - 1].metrics.pumpStarts;
+        writes[h] = _samples[h].nvsWrites - _samples[h - 1].nvsWrites;
+    }
+    checkSeries("sensor reads", reads, report);
+    checkSeries("pump starts", starts, report);
+    checkSeries("NVS writes", writes, report);
+    
+    // Per key, so one misfiring save timer is not hidden in the total
+    int keys = FlashWearMonitor::getKeyCount();
+    for (int k = 0; k < keys; k++) {
+        std::vector<uint32_t> counts(hours);
+        for (size_t h = 1; h < hours; h++) {
+            uint32_t now = k < (int)_samples[h].keyWrites.size() ? _samples[h].keyWrites[k] : 0;
+            uint32_t before = k < (int)_samples[h - 1].keyWrites.size() ? _samples[h - 1].keyWrites[k] : 0;
+            counts[h] = now - before;
+        }
+        const KeyWearStats& stats = FlashWearMonitor::getKeyStats(k);
+        checkSeries(std::string("NVS writes to ") + stats.ns + "/" + stats.key, counts, report);
+    }
+}
+
+void SoakTest::checkSeries(const std::string& name, const std::vector<uint32_t>& counts, SoakReport& report) {
+    int wrap = report.wrapHour;
+    if (wrap - SOAK_WARMUP_HOURS < SOAK_WARMUP_HOURS) return;   // Too little history before the wrap
+    
+    std::vector<uint32_t> before(counts.begin() + SOAK_WARMUP_HOURS, counts.begin() + wrap - 1);
+    uint32_t busiest = *std::max_element(before.begin(), before.end());
+    std::nth_element(before.begin(), before.begin() + before.size() / 2, before.end());
+    uint32_t median = before[before.size() / 2];
+    
+    // Burst: a deadline (last + interval) that wrapped ahead of millis(), or
+    // an elapsed time that came out huge, fires on every pass. The first
+    // shows in the hour before the wrap.
+    int windowEnd = std::min((int)counts.size(), wrap + SOAK_WRAP_WINDOW_HOURS);
+    for (int h = wrap - 1; h < windowEnd; h++) {
+        if (counts[h] > SOAK_BURST_FACTOR * busiest + 2) {
+            report.findings.push_back(format("timer burst: %s %u in hour %+d from the wrap (at most %u per hour before)",
+                                             name.c_str(), counts[h], h - wrap, busiest));
+            return;
+        }
+    }
+    
+    // Stall: a deadline computed past the wrap never comes round again
+    uint32_t after = 0;
+    for (size_t h = wrap; h < counts.size(); h++) after += counts[h];
+    if (median > 0 && after == 0) {
+        report.findings.push_back(format("timer stalled: no %s after the wrap (median %u per hour before)",
+                                         name.c_str(), median));
+    }
+}
+
+void SoakTest::checkSafety(SoakReport& report) {
+    int wrap = report.wrapHour;
+    if (wrap < 1) return;
+    
+    // Longest stretches before the wrap against the rest of the run
+    const SimMetrics& before = _samples[wrap - 1].metrics;
+    const SimMetrics& after = _samples.back().metrics;
+    
+    if (after.maxOnAboveUpperSec > SOAK_BURST_FACTOR * before.maxOnAboveUpperSec + 5) {
+        report.findings.push_back(format("pump safety: ran %.0f s above the upper threshold after the wrap "
+                                         "(at most %.0f s before)", after.maxOnAboveUpperSec, before.maxOnAboveUpperSec));
+    }
+    if (after.maxOffBelowLowerMin > SOAK_BURST_FACTOR * before.maxOffBelowLowerMin + 1) {
+        report.findings.push_back(format("pump safety: idle %.1f min below the lower threshold after the wrap "
+                                         "(at most %.1f min before)", after.maxOffBelowLowerMin, before.maxOffBelowLowerMin));
+    }
+}
+
+// ==================== HEAP ====================
+
+void SoakTest::checkHeap(SoakReport& report) {
+    if (_samples.empty()) return;
+    
+    const HeapStats& last = _samples.back().heap;
+    float hours = _samples.size();
+    report.allocationsPerHour = last.allocations / hours;
+    report.bytesPerHour = last.bytesAllocated / hours;
+    report.peakBytes = last.peakBytes;
+    report.outOfMemory = last.outOfMemory;
+    
+    // End-of-day points after the first day
+    std::vector<float> live, fragmentation;
+    report.minLargestFree = HOST_HEAP_ARENA_BYTES;
+    for (size_t h = SOAK_WARMUP_HOURS - 1; h < _samples.size(); h += 24) {
+        live.push_back(_samples[h].heap.liveBytes);
+        fragmentation.push_back(_samples[h].heap.fragmentationPct);
+    }
+    for (size_t h = 0; h < _samples.size(); h++) {
+        report.minLargestFree = std::min(report.minLargestFree, _samples[h].heap.largestFree);
+    }
+    if (live.empty()) return;
+    
+    report.liveBytesDay1 = live.front();
+    report.liveBytesEnd = live.back();
+    report.growthBytesPerDay = slope(live);
+    report.fragmentationDay1Pct = fragmentation.front();
+    report.fragmentationEndPct = fragmentation.back();
+    report.fragmentationPerDay = slope(fragmentation);
+    
+    // Growth that is still going on in the last week, not just a buffer filling up
+    size_t week = std::min<size_t>(7, live.size() / 2);
+    if (report.growthBytesPerDay > SOAK_GROWTH_LIMIT && week > 0) {
+        float firstWeekMax = *std::max_element(live.begin(), live.begin() + week);
+        float lastWeekMin = *std::min_element(live.end() - week, live.end());
+        if (lastWeekMin > firstWeekMax) {
+            report.findings.push_back(format("heap growth: live bytes %zu -> %zu (%.0f bytes/day)",
+                                             report.liveBytesDay1, report.liveBytesEnd, report.growthBytesPerDay));
+        }
+    }
+    
+    if (report.outOfMemory > 0) {
+        report.findings.push_back(format("heap: %u allocations did not fit the %d KB model arena",
+                                         report.outOfMemory, HOST_HEAP_ARENA_BYTES / 1024));
+    }
+}
@@ -0,0 +1,101 @@
+// ssd1306_panel.cpp
+#include "ssd1306_panel.h"
+
+namespace {
+    const uint8_t CONTROL_DATA = 0x40;          // D/C# bit of the control byte
+    
+    // Argument bytes of the commands the driver sends (others take none)
+    int argumentCount(uint8_t command) {
+        switch (command) {
+            case 0x21:                          // COLUMNADDR
+            case 0x22:                          // PAGEADDR
+                return 2;
+            case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+            case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+}
+
+Ssd1306Panel::Ssd1306Panel(int width, int height)
+    : _width(width),
+      _pages(height / 8),
+      _ram(width * (height / 8), 0),
+      _firstColumn(0),
+      _lastColumn(width - 1),
+      _firstPage(0),
+      _lastPage(height / 8 - 1),
+      _column(0),
+      _page(0),
+      _command(0),
+      _argsNeeded(0),
+      _argCount(0) {
+}
+
+// One write transaction: control byte, then a command or data stream
+void Ssd1306Panel::receive(const uint8_t* bytes, size_t length) {
+    bool isData = bytes[0] & CONTROL_DATA;
+    for (size_t i = 1; i < length; i++) {
+        if (isData) data(bytes[i]);
+        else command(bytes[i]);
+    }
+}
+
+void Ssd1306Panel::command(uint8_t byte) {
+    if (_argsNeeded == 0) {
+        _command = byte;
+        _argsNeeded = argumentCount(byte);
+        _argCount = 0;
+        return;
+    }
+    
+    if (_argCount < 2) _args[_argCount] = byte;
+    _argCount++;
+    if (_argCount < _argsNeeded) return;
+    _argsNeeded = 0;
+    
+    // Ends are limited to the RAM (the driver sends 0xFF for "last page")
+    if (_command == 0x21) {
+        _firstColumn = min(_args[0] & 0x7F, _width - 1);
+        _lastColumn = min(_args[1] & 0x7F, _width - 1);
+        _column = _firstColumn;
+    } else if (_command == 0x22) {
+        _firstPage = min(_args[0] & 0x07, _pages - 1);
+        _lastPage = min(_args[1] & 0x07, _pages - 1);
+        _page = _firstPage;
+    }
+}
+
+void Ssd1306Panel::data(uint8_t byte) {
+    _ram[_page * _width + _column] = byte;
+    
+    // Horizontal addressing: across the window, then down, then wrap
+    if (++_column > _lastColumn) {
+        _column = _firstColumn;
+        if (++_page > _lastPage) _page = _firstPage;
+    }
+}
+
+bool Ssd1306Panel::getPixel(int x, int y) const {
+    if (x < 0 || x >= _width || y < 0 || y >= _pages * 8) return false;
+    return _ram[(y / 8) * _width + x] & (1 << (y & 7));
+}
+
+bool Ssd1306Panel::writePbm(const char* path) const {
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+    
+    int height = _pages * 8;
+    fprintf(out, "P4\n%d %d\n", _width, height);
+    std::vector<uint8_t> row((_width + 7) / 8);
+    for (int y = 0; y < height; y++) {
+        std::fill(row.begin(), row.end(), 0);
+        for (int x = 0; x < _width; x++) {
+            if (getPixel(x, y)) row[x / 8] |= 0x80 >> (x % 8);
+        }
+        fwrite(row.data(), 1, row.size(), out);
+    }
+    return fclose(out) == 0;
+}
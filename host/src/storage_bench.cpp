@@ -0,0 +1,243 @@
+// storage_bench.cpp
+#include "storage_bench.h"
+#include "host_hal.h"
+#include "heap_tracker.h"
+#include "tank_calculator.h"
+#include "water_tracker.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+
+namespace {
+    const time_t BENCH_NOW = 1761818400;            // 2025-10-30 10:00 UTC
+    const int BENCH_DAYS = 365;
+    const char* LEGACY_NAMESPACE = "legacyday";
+    
+    String legacyKey(unsigned long date) {
+        return "day" + String((date / 86400) * 86400);
+    }
+    
+    float sumLiters(const DailyUsage* usage, int count) {
+        float total = 0;
+        for (int i = 0; i < count; i++) total += usage[i].totalUsageLiters;
+        return total;
+    }
+}
+
+StorageBench::StorageBench(int queries, uint32_t seed)
+    : _queries(queries), _seed(seed) {
+}
+
+// A year of days up to today, in the daily table and as legacy keys
+void StorageBench::fill(StorageManager& storage, int days) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    HostHal::reset();
+    HostHal::clearPreferences();
+    HostHal::setSerialEcho(false);
+    HostHal::setEpoch(BENCH_NOW);
+    
+    storage.begin();
+    
+    std::mt19937 rng(_seed);
+    std::uniform_real_distribution<float> liters(150, 450);
+    Preferences legacy;
+    legacy.begin(LEGACY_NAMESPACE, false);
+    
+    long today = TimeUtils::localDayNumber(BENCH_NOW);
+    for (long day = today - days + 1; day <= today; day++) {
+        DailyUsage usage;
+        usage.date = TimeUtils::dayNumberToTimestamp(day);
+        usage.totalUsageLiters = roundf(liters(rng) * 10) / 10;
+        usage.pumpCycles = 4;
+        usage.pumpMinutes = 60;
+        storage.saveDailyUsage(usage);
+        
+        // The JSON the old saveDailyUsage() wrote
+        char json[64];
+        snprintf(json, sizeof(json), "{\"date\":%lu,\"usage\":%g,\"cycles\":%d}",
+                 usage.date, usage.totalUsageLiters, usage.pumpCycles);
+        legacy.putString(legacyKey(usage.date).c_str(), json);
+    }
+    legacy.end();
+}
+
+// The old StorageManager::getDailyUsage(): one key and a JSON parse per day.
+// The fixed layout is parsed with sscanf() instead of ArduinoJson, so the
+// time per query understates the old path a little.
+bool StorageBench::legacyDailyUsage(unsigned long date, DailyUsage& usage) {
+    Preferences legacy;
+    legacy.begin(LEGACY_NAMESPACE, true);
+    String json = legacy.getString(legacyKey(date).c_str(), "");
+    legacy.end();
+    
+    if (json.isEmpty()) return false;
+    
+    return sscanf(json.c_str(), "{\"date\":%lu,\"usage\":%f,\"cycles\":%d}",
+                  &usage.date, &usage.totalUsageLiters, &usage.pumpCycles) == 3;
+}
+
+// The old StorageManager::getMonthlyUsage(), which getMonthUsage() called
+float StorageBench::legacyMonthUsage(int year, int month) {
+    struct tm timeinfo = {};
+    timeinfo.tm_year = year - 1900;
+    timeinfo.tm_mon = month - 1;
+    timeinfo.tm_mday = 1;
+    unsigned long startDate = mktime(&timeinfo);
+    
+    timeinfo.tm_mon = month;
+    timeinfo.tm_mday = 0;
+    int daysInMonth = mktime(&timeinfo) / 86400 - startDate / 86400;
+    
+    float total = 0;
+    for (int day = 0; day < daysInMonth; day++) {
+        DailyUsage usage;
+        if (legacyDailyUsage(startDate + day * 86400, usage)) {
+            total += usage.totalUsageLiters;
+        }
+    }
+    return total;
+}
+
+// The old StorageManager::getLast30DaysUsage(), for any number of days
+float StorageBench::legacyHistory(int days, DailyUsage* usage, int& count) {
+    unsigned long now = time(nullptr);
+    count = 0;
+    for (int i = 0; i < days; i++) {
+        if (legacyDailyUsage(now - (unsigned long)i * 86400, usage[count])) count++;
+    }
+    return sumLiters(usage, count);
+}
+
+template <typename Query>
+StorageQuery StorageBench::measure(const char* name, Query query) {
+    uint32_t reads = HostHal::getNvsReads();
+    uint32_t bytes = HostHal::getNvsReadBytes();
+    volatile float result = 0;
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < _queries; i++) {
+        result = query();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    StorageQuery q;
+    q.name = name;
+    q.nsPerQuery = seconds * 1e9 / _queries;
+    q.readsPerQuery = (float)(HostHal::getNvsReads() - reads) / _queries;
+    q.bytesPerQuery = (float)(HostHal::getNvsReadBytes() - bytes) / _queries;
+    q.liters = result;
+    return q;
+}
+
+std::vector<StorageQuery> StorageBench::monthUsage() {
+    StorageManager storage;
+    fill(storage, BENCH_DAYS);
+    
+    // The clock is valid, so the totals are seeded from the records
+    TankCalculator calculator;
+    WaterTracker tracker;
+    tracker.begin(&storage, &calculator);
+    tracker.loop();
+    
+    int year, month, day;
+    TimeUtils::getCurrentDate(year, month, day);
+    
+    std::vector<StorageQuery> queries;
+    queries.push_back(measure("tracker", [&]() {
+        return tracker.getMonthUsage();
+    }));
+    queries.push_back(measure("table", [&]() {
+        float total = 0;
+        storage.getMonthlyUsage(year, month, total);
+        return total;
+    }));
+    queries.push_back(measure("legacy_keys", [&]() {
+        return legacyMonthUsage(year, month);
+    }));
+    return queries;
+}
+
+std::vector<StorageQuery> StorageBench::history() {
+    StorageManager storage;
+    fill(storage, BENCH_DAYS);
+    
+    std::vector<DailyUsage> usage(BENCH_DAYS);
+    std::vector<StorageQuery> queries;
+    const int spans[] = { 30, 365 };
+    
+    for (int s = 0; s < 2; s++) {
+        int days = spans[s];
+        std::string suffix = "_" + std::to_string(days);
+        
+        queries.push_back(measure(("table" + suffix).c_str(), [&]() {
+            int count = 0;
+            storage.getUsageHistory(time(nullptr), days, usage.data(), count);
+            return sumLiters(usage.data(), count);
+        }));
+        
+        // A fresh StorageManager reads the whole table blob again
+        queries.push_back(measure(("table_cold" + suffix).c_str(), [&]() {
+            StorageManager cold;
+            int count = 0;
+            cold.getUsageHistory(time(nullptr), days, usage.data(), count);
+            return sumLiters(usage.data(), count);
+        }));
+        
+        queries.push_back(measure(("legacy_keys" + suffix).c_str(), [&]() {
+            int count = 0;
+            return legacyHistory(days, usage.data(), count);
+        }));
+    }
+    return queries;
+}
+
+// One export, timed over _queries runs, then once more with the heap tracked
+ExportRun StorageBench::exportRun(const char* name, ExportFormat format, int days, size_t chunkBytes) {
+    std::vector<uint8_t> buffer(chunkBytes);
+    unsigned long from = time(nullptr) - (unsigned long)(days - 1) * 86400;
+    
+    ExportRun run = ExportRun();
+    run.name = name;
+    run.days = days;
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t total = 0;
+    for (int i = 0; i < _queries; i++) {
+        HistoryExporter exporter(EXPORT_DAILY, format, from, 0);
+        size_t n;
+        while ((n = exporter.read(buffer.data(), chunkBytes)) > 0) total += n;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.bytesPerSec = total / seconds;
+    
+    HeapTracker::start();
+    std::shared_ptr<HistoryExporter> exporter = std::make_shared<HistoryExporter>(EXPORT_DAILY, format, from, 0);
+    size_t n;
+    while ((n = exporter->read(buffer.data(), chunkBytes)) > 0) {
+        run.bytes += n;
+        run.chunks++;
+        run.rows += std::count(buffer.begin(), buffer.begin() + n, '\n');
+    }
+    exporter.reset();
+    HeapStats heap = HeapTracker::getStats();
+    HeapTracker::stop();
+    
+    run.peakHeap = heap.peakBytes;
+    run.allocations = heap.allocations;
+    return run;
+}
+
+std::vector<ExportRun> StorageBench::exports(size_t chunkBytes) {
+    StorageManager storage;
+    fill(storage, BENCH_DAYS);
+    
+    std::vector<ExportRun> runs;
+    runs.push_back(exportRun("csv_30", EXPORT_CSV, 30, chunkBytes));
+    runs.push_back(exportRun("ndjson_30", EXPORT_NDJSON, 30, chunkBytes));
+    runs.push_back(exportRun("csv_365", EXPORT_CSV, 365, chunkBytes));
+    runs.push_back(exportRun("ndjson_365", EXPORT_NDJSON, 365, chunkBytes));
+    return runs;
+}
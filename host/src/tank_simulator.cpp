@@ -0,0 +1,344 @@
+// tank_simulator.cpp
+#include "tank_simulator.h"
+#include "host_hal.h"
+#include "config.h"
+#include "pins.h"
+#include "sensor.h"
+#include "tank_calculator.h"
+#include "pump_controller.h"
+#include "water_tracker.h"
+#include "storage_manager.h"
+#include "event_bus.h"
+#include "control_loop.h"
+#include <chrono>
+
+namespace {
+    const unsigned long SIM_LOOP_MS = 10;         // One loop() pass
+    const uint64_t SIM_MAX_STEP_MS = 100;         // Plant integration step
+    
+    // Relative household demand by hour of day (mean 1 after scaling)
+    const float DEMAND_PROFILE[24] = {
+        0.2, 0.1, 0.1, 0.1, 0.2, 0.6, 1.8, 2.4, 1.8, 1.0, 0.8, 0.8,
+        1.0, 0.9, 0.8, 0.8, 1.0, 1.4, 1.9, 2.0, 1.6, 1.0, 0.6, 0.3
+    };
+    
+    float demandProfileAt(time_t now) {
+        static float scale = 0;
+        if (scale == 0) {
+            float sum = 0;
+            for (int h = 0; h < 24; h++) sum += DEMAND_PROFILE[h];
+            scale = 24.0 / sum;
+        }
+        
+        struct tm local;
+        localtime_r(&now, &local);
+        return DEMAND_PROFILE[local.tm_hour] * scale;
+    }
+}
+
+TankSimulator::TankSimulator(const SimScenario& scenario)
+    : _scenario(scenario),
+      _rng(scenario.seed),
+      _demandRng(scenario.seed + 1),
+      _trace(nullptr),
+      _hourHook(nullptr),
+      _hourContext(nullptr),
+      _busHook(nullptr),
+      _busContext(nullptr),
+      _plantMs(0),
+      _nextEvent(0),
+      _heightCm(0),
+      _litersPerCm(0),
+      _capacityL(0),
+      _relayOn(false),
+      _motorOn(false),
+      _relayChangeMs(0),
+      _nextDrawMs(0),
+      _openDrawL(0),
+      _onAboveMs(0),
+      _offBelowMs(0),
+      _leakStartMs(0),
+      _metrics() {
+}
+
+void TankSimulator::setTrace(TraceRecorder* trace) {
+    _trace = trace;
+}
+
+void TankSimulator::setHourHook(SimHourHook hook, void* context) {
+    _hourHook = hook;
+    _hourContext = context;
+}
+
+void TankSimulator::setBusHook(SimBusHook hook, void* context) {
+    _busHook = hook;
+    _busContext = context;
+}
+
+SimMetrics TankSimulator::run() {
+    HostHal::reset();
+    HostHal::clearPreferences();
+    HostHal::clearFiles();
+    HostHal::setPulseSource(pulseSource, this);
+    FaultInjector::reset();
+    FaultInjector::seed(_scenario.seed);
+    
+    // Plant
+    float area = _scenario.cylindrical
+        ? 3.14159265f * _scenario.radius * _scenario.radius
+        : _scenario.length * _scenario.width;
+    _litersPerCm = area / 1000.0;
+    _capacityL = _litersPerCm * _scenario.height;
+    _heightCm = _scenario.height * _scenario.startLevel / 100.0;
+    _metrics = SimMetrics();
+    _metrics.dryRunDetectMin = -1;
+    _metrics.leakDetectHours = -1;
+    scheduleNextDraw();
+    
+    // Firmware, wired as in setup() / initializeSystem()
+    StorageManager storage;
+    TankCalculator calculator;
+    PumpController pump(PUMP_RELAY_PIN);
+    UltrasonicSensor sensor(SENSOR_TRIG_PIN, SENSOR_ECHO_PIN);
+    WaterTracker tracker;
+    EventBus bus;
+    ControlLoop control(&sensor, &calculator, &pump, &tracker, &storage, &bus);
+    
+    storage.begin();
+    TankConfig config = storage.loadTankConfig();
+    config.firstTimeSetup = false;
+    config.shape = _scenario.cylindrical ? CYLINDRICAL : RECTANGULAR;
+    config.tankHeight = _scenario.height;
+    config.tankLength = _scenario.length;
+    config.tankWidth = _scenario.width;
+    config.tankRadius = _scenario.radius;
+    config.lowerThreshold = _scenario.lowerThreshold;
+    config.upperThreshold = _scenario.upperThreshold;
+    storage.saveTankConfig(config);
+    
+    pump.begin();
+    sensor.begin();
+    calculator.setTankConfig(config);
+    tracker.begin(&storage, &calculator);
+    if (_trace && _trace->begin()) control.setTrace(_trace);
+    control.begin(config);
+    if (_busHook) _busHook(bus, _busContext);
+    control.readSensor();
+    FlashWearMonitor::reset();
+    
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+    
+    // Scheduler deadlines (sensor and tracker tasks), on the uptime: millis() may wrap
+    uint64_t nextSample = HostHal::uptimeMs() + SENSOR_SAMPLE_INTERVAL_MS;
+    uint64_t nextTrackerRun = HostHal::uptimeMs() + TRACKER_UPDATE_INTERVAL_MS;
+    
+    uint64_t nextHour = HostHal::uptimeMs() + 3600000ULL;
+    int hour = 0;
+    unsigned long passes = 0;
+    double passTotalMs = 0;
+    bool leakAlarm = tracker.isLeakAlarm();
+    
+    while (HostHal::uptimeMs() < _scenario.durationMs) {
+        uint64_t passStart = HostHal::uptimeMs();
+        
+        bool pumping = pump.isOn();
+        float trackedBefore = tracker.getYearUsage();
+        
+        if (HostHal::uptimeMs() >= nextSample) {
+            nextSample += SENSOR_SAMPLE_INTERVAL_MS;
+            control.readSensor();
+        }
+        if (HostHal::uptimeMs() >= nextTrackerRun) {
+            nextTrackerRun += TRACKER_UPDATE_INTERVAL_MS;
+            tracker.loop();
+        }
+        
+        control.loop();
+        
+        // Usage booked in a pass that started or stopped with the pump on
+        // (the stop pass accounts the fill's last partial window)
+        float trackedL = tracker.getYearUsage() - trackedBefore;
+        if ((pumping || pump.isOn()) && trackedL > 0) _metrics.fillTrackedL += trackedL;
+        
+        unsigned long passMs = HostHal::uptimeMs() - passStart;
+        passTotalMs += passMs;
+        passes++;
+        _metrics.maxPassMs = std::max(_metrics.maxPassMs, (float)passMs);
+        
+        if (_metrics.dryRunDetectMin < 0 && pump.isDryRunDetected()) {
+            _metrics.dryRunDetectMin = _metrics.dryRunMin;
+        }
+        
+        if (tracker.isLeakAlarm() != leakAlarm) {
+            leakAlarm = !leakAlarm;
+            if (leakAlarm && _scenario.leakLpm <= 0) {
+                _metrics.falseLeakAlarms++;
+            } else if (leakAlarm && _metrics.leakDetectHours < 0) {
+                _metrics.leakDetectHours = (_plantMs - _leakStartMs) / 3600000.0;
+            }
+        }
+        
+        HostHal::advanceMillis(SIM_LOOP_MS);
+        advanceTo(HostHal::uptimeMs());
+        
+        if (_hourHook && HostHal::uptimeMs() >= nextHour) {
+            nextHour += 3600000ULL;
+            _hourHook(hour++, _metrics, _hourContext);
+        }
+    }
+    
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (_trace) _trace->flush();
+    HostHal::setPulseSource(nullptr, nullptr);
+    
+    SimMetrics& m = _metrics;
+    m.simHours = HostHal::uptimeMs() / 3600000.0;
+    m.startsPerHour = m.simHours > 0 ? m.pumpStarts / m.simHours : 0;
+    m.trackedUsageL = tracker.getYearUsage();
+    m.usageErrorPct = m.demandL + m.leakL > 0
+        ? (m.trackedUsageL - m.demandL - m.leakL) * 100.0 / (m.demandL + m.leakL) : 0;
+    m.passes = passes;
+    m.meanPassMs = passes > 0 ? passTotalMs / passes : 0;
+    for (int i = 0; i < FAULT_POINT_COUNT; i++) m.faultsFired += FaultInjector::getFiredCount((FaultPoint)i);
+    FaultInjector::reset();
+    m.nvsWrites = FlashWearMonitor::getTotalWrites();
+    m.flashLifeYears = FlashWearMonitor::getProjectedLifetimeYears();
+    m.wallSeconds = wallSeconds;
+    m.speedup = wallSeconds > 0 ? m.simHours * 3600.0 / wallSeconds : 0;
+    return m;
+}
+
+void TankSimulator::advanceTo(uint64_t nowMs) {
+    while (_plantMs < nowMs) {
+        uint64_t stepMs = std::min(nowMs - _plantMs, SIM_MAX_STEP_MS);
+        
+        while (_nextEvent < _scenario.events.size() && _scenario.events[_nextEvent].atMs <= _plantMs) {
+            applyEvent(_scenario.events[_nextEvent++]);
+        }
+        
+        _plantMs += stepMs;
+        step(stepMs / 1000.0);
+    }
+}
+
+void TankSimulator::step(float dtSec) {
+    // Relay -> motor, after the contactor's latency
+    bool relay = HostHal::getPinLevel(PUMP_RELAY_PIN) == HIGH;
+    if (relay != _relayOn) {
+        _relayOn = relay;
+        _relayChangeMs = _plantMs;
+    }
+    if (_motorOn != _relayOn && _plantMs - _relayChangeMs >= _scenario.relayLatencyMs) {
+        _motorOn = _relayOn;
+        if (_motorOn) _metrics.pumpStarts++;
+    }
+    
+    // New household draws
+    while (_plantMs >= _nextDrawMs) {
+        std::exponential_distribution<float> volume(1.0 / _scenario.drawLiters);
+        _openDrawL += volume(_demandRng);
+        scheduleNextDraw();
+    }
+    
+    double volumeL = _heightCm * _litersPerCm;
+    
+    // Pump delivery falls off with head
+    double inL = 0;
+    if (_motorOn && _scenario.sourceAvailable) {
+        float head = _heightCm / _scenario.height;
+        inL = _scenario.pumpRate * (1.0 - _scenario.headLoss * head) / 60.0 * dtSec;
+    }
+    
+    double wantL = std::min(_openDrawL, _scenario.drawRate / 60.0 * dtSec);
+    double outL = std::min(wantL, volumeL + inL);
+    _openDrawL -= wantL;
+    _metrics.demandL += outL;
+    if (_motorOn) _metrics.fillDemandL += outL;
+    _metrics.unmetDemandL += wantL - outL;
+    
+    double leakL = std::min(_scenario.leakLpm / 60.0 * dtSec, volumeL + inL - outL);
+    _metrics.leakL += leakL;
+    
+    volumeL += inL - outL - leakL;
+    if (volumeL > _capacityL) {
+        _metrics.overflowL += volumeL - _capacityL;
+        volumeL = _capacityL;
+    }
+    _heightCm = volumeL / _litersPerCm;
+    
+    // Metrics
+    float level = levelPercent();
+    _metrics.overshootPct = std::max(_metrics.overshootPct, level - _scenario.upperThreshold);
+    _metrics.undershootPct = std::max(_metrics.undershootPct, _scenario.lowerThreshold - level);
+    unsigned long stepMs = lroundf(dtSec * 1000);
+    _onAboveMs = _motorOn && level > _scenario.upperThreshold ? _onAboveMs + stepMs : 0;
+    _offBelowMs = !_motorOn && _scenario.sourceAvailable && level < _scenario.lowerThreshold
+        ? _offBelowMs + stepMs : 0;
+    _metrics.maxOnAboveUpperSec = std::max(_metrics.maxOnAboveUpperSec, _onAboveMs / 1000.0f);
+    _metrics.maxOffBelowLowerMin = std::max(_metrics.maxOffBelowLowerMin, _offBelowMs / 60000.0f);
+    if (_motorOn) {
+        _metrics.pumpRunMin += dtSec / 60.0;
+        if (!_scenario.sourceAvailable) _metrics.dryRunMin += dtSec / 60.0;
+    }
+}
+
+void TankSimulator::applyEvent(const SimEvent& evt) {
+    switch (evt.setting) {
+        case SIM_SOURCE:    _scenario.sourceAvailable = evt.value > 0; break;
+        case SIM_PUMP_RATE: _scenario.pumpRate = evt.value; break;
+        case SIM_NOISE:     _scenario.noiseCm = evt.value; break;
+        case SIM_DROPOUT:   _scenario.dropoutRate = evt.value; break;
+        case SIM_LEAK:
+            if (_scenario.leakLpm <= 0 && evt.value > 0) _leakStartMs = _plantMs;
+            _scenario.leakLpm = evt.value;
+            break;
+        case SIM_DEMAND:
+            _scenario.demandPerHour = evt.value;
+            scheduleNextDraw();
+            break;
+        case SIM_FAULT:
+            if (evt.value > 0) FaultInjector::arm(evt.fault, evt.value, evt.faultCount, evt.faultDelayMs);
+            else FaultInjector::disarm(evt.fault);
+            break;
+    }
+}
+
+void TankSimulator::scheduleNextDraw() {
+    // Rate for the current hour (piecewise constant is close enough)
+    float perHour = _scenario.demandPerHour * demandProfileAt(time(nullptr));
+    if (perHour <= 0) {
+        _nextDrawMs = _plantMs + 3600000UL;   // Re-evaluate in an hour
+        return;
+    }
+    
+    std::exponential_distribution<float> gap(perHour / 3600000.0);
+    _nextDrawMs = _plantMs + (uint64_t)gap(_demandRng) + 1;
+}
+
+float TankSimulator::levelPercent() {
+    return _heightCm * 100.0 / _scenario.height;
+}
+
+unsigned long TankSimulator::echoWidth() {
+    _metrics.sensorReads++;
+    
+    std::uniform_real_distribution<float> chance(0, 1);
+    if (chance(_rng) < _scenario.dropoutRate) {
+        _metrics.sensorDropouts++;
+        return 0;
+    }
+    
+    std::normal_distribution<float> noise(0, _scenario.noiseCm > 0 ? _scenario.noiseCm : 1e-6);
+    float distance = SENSOR_DEAD_ZONE_CM + (_scenario.height - _heightCm) + noise(_rng);
+    if (distance < 2) distance = 2;
+    return (unsigned long)(distance * 2.0 / 0.0343);
+}
+
+// pulseIn() on the echo pin: bring the plant up to "now" first
+unsigned long TankSimulator::pulseSource(uint8_t pin, void* context) {
+    TankSimulator* self = static_cast<TankSimulator*>(context);
+    if (pin != SENSOR_ECHO_PIN) return 0;
+    
+    self->advanceTo(HostHal::uptimeMs());
+    return self->echoWidth();
+}
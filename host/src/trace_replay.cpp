@@ -0,0 +1,243 @@
+// trace_replay.cpp
+#include "trace_replay.h"
+#include "host_hal.h"
+#include "config.h"
+#include "pins.h"
+#include "sensor.h"
+#include "tank_calculator.h"
+#include "pump_controller.h"
+#include "water_tracker.h"
+#include "storage_manager.h"
+#include "event_bus.h"
+#include "control_loop.h"
+#include <fstream>
+#include <iterator>
+
+namespace {
+    const unsigned long REPLAY_LOOP_MS = 10;            // loop() pass between inputs
+    const unsigned long REPLAY_TOLERANCE_MS = 1000;     // Timer-driven changes may land a pass apart
+    const size_t REPLAY_MAX_MISMATCHES = 20;
+    
+    void onPumpEvent(const PumpEvent& evt, void* context) {
+        static_cast<std::vector<PumpEvent>*>(context)->push_back(evt);
+    }
+    
+    bool samePumpState(const TraceRecord& recorded, const PumpEvent& replayed) {
+        return recorded.motorState == replayed.motorState && recorded.mode == replayed.mode &&
+               recorded.dryRunAlarm == replayed.dryRunAlarm &&
+               recorded.overflowAlarm == replayed.overflowAlarm;
+    }
+    
+    std::string describe(unsigned long timestamp, bool motorState, uint8_t mode, bool dryRun, bool overflow) {
+        char text[96];
+        snprintf(text, sizeof(text), "t=%lu motor=%s mode=%u dryRun=%d overflow=%d",
+                 timestamp, motorState ? "on" : "off", mode, dryRun, overflow);
+        return text;
+    }
+    
+    void applyConfig(TankConfig& config, const TraceConfig& trace) {
+        config.shape = (TankShape)trace.shape;
+        config.tankHeight = trace.tankHeight;
+        config.tankLength = trace.tankLength;
+        config.tankWidth = trace.tankWidth;
+        config.tankRadius = trace.tankRadius;
+        config.upperThreshold = trace.upperThreshold;
+        config.lowerThreshold = trace.lowerThreshold;
+    }
+}
+
+bool TraceReplayer::load(const char* path, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+    
+    _data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+ReplayReport TraceReplayer::run() {
+    ReplayReport report = ReplayReport();
+    report.firstDivergenceMs = -1;
+    
+    std::vector<TraceRecord> records;
+    TraceReader reader(_data.data(), _data.size());
+    TraceRecord record;
+    while (reader.next(record)) records.push_back(record);
+    report.records = records.size();
+    report.damagedSegments = reader.getDamagedSegments();
+    
+    // Sessions break at every boot and wherever the segment chain has a gap
+    size_t begin = 0;
+    uint32_t lastSequence = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].type != TRACE_SYNC) continue;
+        
+        bool chained = i > 0 && !records[i].boot && records[i].sequence == lastSequence + 1;
+        lastSequence = records[i].sequence;
+        if (chained) continue;
+        
+        if (i > begin) replaySession(records, begin, i, report);
+        begin = i;
+    }
+    if (records.size() > begin) replaySession(records, begin, records.size(), report);
+    
+    return report;
+}
+
+void TraceReplayer::replaySession(const std::vector<TraceRecord>& records, size_t begin, size_t end,
+                                  ReplayReport& report) {
+    const TraceRecord& sync = records[begin];
+    if (sync.type != TRACE_SYNC) return;
+    
+    // The keyframe is followed by the config whenever one was known
+    size_t first = begin + 1;
+    if (first >= end || records[first].type != TRACE_CONFIG) return;
+    report.sessions++;
+    
+    HostHal::reset();
+    HostHal::clearPreferences();
+    HostHal::advanceMillis(sync.timestamp);
+    HostHal::setEpoch(sync.epoch);
+    
+    // Firmware, wired as in setup() / initializeSystem()
+    StorageManager storage;
+    TankCalculator calculator;
+    PumpController pump(PUMP_RELAY_PIN);
+    UltrasonicSensor sensor(SENSOR_TRIG_PIN, SENSOR_ECHO_PIN);
+    WaterTracker tracker;
+    EventBus bus;
+    ControlLoop control(&sensor, &calculator, &pump, &tracker, &storage, &bus);
+    
+    storage.begin();
+    TankConfig config = storage.loadTankConfig();
+    config.firstTimeSetup = false;
+    applyConfig(config, records[first].config);
+    storage.saveTankConfig(config);
+    
+    pump.begin();
+    calculator.setTankConfig(config);
+    tracker.begin(&storage, &calculator);
+    control.begin(config);
+    
+    std::vector<PumpEvent> replayed;
+    bus.subscribe<PumpEvent>(onPumpEvent, &replayed);
+    
+    // Mid-run keyframe: restore what the trace knows about the pump
+    if (!sync.boot) {
+        if (sync.mode == MANUAL_MODE) control.command(PUMP_CMD_MANUAL, SOURCE_BUTTON);
+        if (sync.mode == OVERRIDE_MODE) control.command(PUMP_CMD_OVERRIDE, SOURCE_BUTTON);
+        if (sync.motorState) control.command(PUMP_CMD_ON, SOURCE_BUTTON);
+        control.loop();
+        replayed.clear();               // Already running before the segment began
+    }
+    
+    std::vector<TraceRecord> recorded;
+    unsigned long nextTrackerRun = millis() + TRACKER_UPDATE_INTERVAL_MS;
+    
+    for (size_t i = first + 1; i < end; i++) {
+        const TraceRecord& rec = records[i];
+        
+        // loop() passes up to the input, then the pass that handled it
+        while (millis() + REPLAY_LOOP_MS <= rec.timestamp) {
+            HostHal::advanceMillis(REPLAY_LOOP_MS);
+            if (millis() >= nextTrackerRun) {
+                nextTrackerRun += TRACKER_UPDATE_INTERVAL_MS;
+                tracker.loop();
+            }
+            control.loop();
+        }
+        if (rec.timestamp > millis()) HostHal::advanceMillis(rec.timestamp - millis());
+        
+        switch (rec.type) {
+            case TRACE_SENSOR:
+            case TRACE_SENSOR_FAIL:
+                if (rec.type == TRACE_SENSOR) report.readings++;
+                else report.failedReadings++;
+                control.applyReading(rec.distance);
+                control.loop();
+                break;
+            
+            case TRACE_COMMAND:
+                report.commands++;
+                control.command((PumpCommand)rec.command, (CommandSource)rec.source);
+                control.loop();
+                break;
+            
+            case TRACE_CONFIG:
+                applyConfig(config, rec.config);
+                calculator.setTankConfig(config);
+                control.setConfig(config);
+                break;
+            
+            case TRACE_BUTTON:
+                report.buttons++;
+                break;
+            
+            case TRACE_PUMP:
+                recorded.push_back(rec);
+                break;
+            
+            default:
+                break;
+        }
+    }
+    
+    // Let changes caused by the last input come through
+    control.loop();
+    compare(recorded, replayed, report);
+}
+
+// Walks both output sequences in time order; an extra or missing change
+// is reported once and the walk continues from the next one
+void TraceReplayer::compare(const std::vector<TraceRecord>& recorded, const std::vector<PumpEvent>& replayed,
+                            ReplayReport& report) {
+    report.outputsRecorded += recorded.size();
+    report.outputsReplayed += replayed.size();
+    
+    size_t i = 0;
+    size_t j = 0;
+    while (i < recorded.size() || j < replayed.size()) {
+        std::string mismatch;
+        unsigned long at;
+        
+        if (i < recorded.size() && j < replayed.size()) {
+            const TraceRecord& rec = recorded[i];
+            const PumpEvent& evt = replayed[j];
+            long dt = (long)evt.timestamp - (long)rec.timestamp;
+            
+            if (samePumpState(rec, evt) && labs(dt) <= (long)REPLAY_TOLERANCE_MS) {
+                report.outputsMatched++;
+                i++;
+                j++;
+                continue;
+            }
+            
+            if (evt.timestamp < rec.timestamp) {
+                at = evt.timestamp;
+                mismatch = "extra    " + describe(evt.timestamp, evt.motorState, evt.mode,
+                                                  evt.dryRunAlarm, evt.overflowAlarm);
+                j++;
+            } else {
+                at = rec.timestamp;
+                mismatch = "missing  " + describe(rec.timestamp, rec.motorState, rec.mode,
+                                                  rec.dryRunAlarm, rec.overflowAlarm);
+                i++;
+            }
+        } else if (i < recorded.size()) {
+            const TraceRecord& rec = recorded[i++];
+            at = rec.timestamp;
+            mismatch = "missing  " + describe(rec.timestamp, rec.motorState, rec.mode,
+                                              rec.dryRunAlarm, rec.overflowAlarm);
+        } else {
+            const PumpEvent& evt = replayed[j++];
+            at = evt.timestamp;
+            mismatch = "extra    " + describe(evt.timestamp, evt.motorState, evt.mode,
+                                              evt.dryRunAlarm, evt.overflowAlarm);
+        }
+        
+        if (report.firstDivergenceMs < 0) report.firstDivergenceMs = at;
+        if (report.mismatches.size() < REPLAY_MAX_MISMATCHES) report.mismatches.push_back(mismatch);
+    }
+}
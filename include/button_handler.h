@@ -3,19 +3,40 @@
 #define BUTTON_HANDLER_H
 
 #include <Arduino.h>
+#include <atomic>
+#include "spsc_queue.h"
+#include "config.h"
 
+// Values are recorded in the input trace: append only
 enum ButtonEvent {
     BTN_NONE,
-    BTN_TOP_PRESS,
+    BTN_TOP_PRESS,                // Also auto-repeats while held
     BTN_MID_PRESS,
-    BTN_BOTTOM_PRESS,
+    BTN_BOTTOM_PRESS,             // Also auto-repeats while held
     BTN_LEFT_PRESS,
     BTN_RIGHT_PRESS,
     BTN_MID_LONG_PRESS,
     BTN_MANUAL_SWITCH_TOGGLE,
-    BTN_MANUAL_SWITCH_LONG_PRESS
+    BTN_MANUAL_SWITCH_LONG_PRESS,
+    BTN_LEFT_DOUBLE_CLICK
 };
 
+#define BUTTON_COUNT 6
+
+// Pin change interrupts time-stamp every edge into a lock-free ring
+// (the GPIO ISR is the only producer, loop() the only consumer), so
+// presses are not lost while loop() is busy. loop() debounces the edges
+// by their timestamps (a level counts once it has been stable for
+// BUTTON_DEBOUNCE_MS) and recognises the gestures:
+//   click         on release, shorter than a long press
+//   double click  second press within BUTTON_DOUBLE_CLICK_MS of the
+//                 first release (LEFT only; its click waits that long;
+//                 BUTTON_DOUBLE_CLICK_ENABLED)
+//   long press    while held for BUTTON_LONG_PRESS_MS (MID, switch)
+//   auto-repeat   TOP / BOTTOM click on press, then repeat while held,
+//                 faster with every repeat (value entry;
+//                 BUTTON_AUTO_REPEAT_ENABLED, else click on release)
+// Recognised events queue up until getEvent() takes them.
 class ButtonHandler {
 public:
     ButtonHandler();
@@ -23,7 +44,7 @@ public:
     void begin();
     void loop();
     
-    // Get the last button event (consumes the event)
+    // Oldest recognised event (consumes it); BTN_NONE when none
     ButtonEvent getEvent();
     
     // Check if a specific button is currently pressed
@@ -32,31 +53,56 @@ public:
     // Check manual switch state
     bool getManualSwitchState();
     
-    // Reset long press timer
+    // Held buttons start timing a new long press
     void resetLongPress();
     
+    // Edges the ring had no room for (pins are re-read), and events
+    // getEvent() was not called for in time
+    uint32_t getDroppedEdges() const { return _droppedEdges.load(std::memory_order_relaxed); }
+    uint32_t getDroppedEvents() const { return _droppedEvents; }
+
 private:
-    // Button states
+    struct ButtonEdge {
+        uint32_t timeUs;
+        uint8_t button;
+        bool pressed;
+    };
+    
+    // Interrupt argument, one per button (in DRAM, unlike the flash
+    // BUTTONS table, so the ISR can read it while flash is busy)
+    struct ButtonPin {
+        ButtonHandler* handler;
+        uint8_t button;
+        uint8_t pin;
+    };
+    
     struct ButtonState {
-        bool currentState;
-        bool lastState;
-        unsigned long lastDebounceTime;
-        unsigned long pressStartTime;
-        bool longPressTriggered;
+        bool raw;                 // Level after the last edge
+        uint32_t rawSinceUs;      // Time of the last edge
+        bool pressed;             // Debounced
+        uint32_t pressedUs;       // Debounced press began
+        bool handled;             // Press already produced its event (long, double, repeat)
+        bool clickPending;        // Released, waiting for a second click
+        uint32_t releasedUs;
+        uint16_t repeats;
+        uint32_t nextRepeatUs;
     };
     
-    ButtonState _btnTop;
-    ButtonState _btnMid;
-    ButtonState _btnBottom;
-    ButtonState _btnLeft;
-    ButtonState _btnRight;
-    ButtonState _btnManual;
+    ButtonPin _pins[BUTTON_COUNT];
+    ButtonState _buttons[BUTTON_COUNT];
+    SpscQueue<ButtonEdge, BUTTON_EDGE_QUEUE_SIZE> _edges;
+    SpscQueue<ButtonEvent, BUTTON_EVENT_QUEUE_SIZE> _events;
+    std::atomic<uint32_t> _droppedEdges;    // Written by the ISR only
+    uint32_t _seenDroppedEdges;
+    uint32_t _droppedEvents;
     
-    ButtonEvent _lastEvent;
-    bool _eventAvailable;
+    static void onEdge(void* arg);
     
-    void updateButton(ButtonState& btn, uint8_t pin, ButtonEvent shortEvent, ButtonEvent longEvent = BTN_NONE);
-    bool readDebounced(ButtonState& btn, uint8_t pin);
+    void applyEdge(int button, bool pressed, uint32_t timeUs);
+    void settle(int button, uint32_t nowUs);
+    void change(int button, uint32_t timeUs);
+    void runTimers(int button, uint32_t nowUs);
+    void emit(ButtonEvent event);
 };
 
 #endif // BUTTON_HANDLER_H
@@ -0,0 +1,22 @@
+// cloud_link.h
+#ifndef CLOUD_LINK_H
+#define CLOUD_LINK_H
+
+#include "storage_manager.h"
+
+// Network client used by SyncManager. On the device NetworkWorker
+// implements it (requests are queued for the worker task); the native
+// build substitutes HostCloudLink.
+class CloudLink {
+public:
+    virtual ~CloudLink() {}
+    
+    // Cloud reachable (as of the last check)
+    virtual bool isOnline() = 0;
+    
+    // Non-blocking; outcome arrives later (false if it could not be queued)
+    virtual bool sendConfig(const TankConfig& config) = 0;
+    virtual bool requestConfig() = 0;
+};
+
+#endif // CLOUD_LINK_H
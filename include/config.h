@@ -39,6 +39,34 @@
 #define DEFAULT_LOWER_THRESHOLD 20.0        // Default lower threshold (%)
 #define MANUAL_OVERRIDE_MAX_LEVEL 95.0      // Max level for manual override
 
+// ==================== USAGE ANALYTICS ====================
+#define DRAW_EVENT_GAP_MS 120000            // Outflow pause that ends a draw event
+#define DRAW_MIN_EVENT_LITERS 0.5           // Smaller events are treated as sensor noise
+#define DRAW_SMALL_MAX_LITERS 5.0           // Tap / hand wash
+#define DRAW_MEDIUM_MAX_LITERS 40.0         // Dishes, toilet, short shower
+#define DRAW_LARGE_MAX_LITERS 150.0         // Shower, laundry (above = bulk)
+#define DRAW_EVENT_LOG_SIZE 64              // Recent draw events kept (ring)
+#define DRAW_EVENT_FLUSH_COUNT 8            // Persist after this many new events
+#define PUMP_ACCOUNT_INTERVAL_MS 60000      // Level-change window while pumping
+#define PUMP_SETTLE_MS 30000                // Ignore the first window after pump start
+#define PUMP_RATE_TOLERANCE 0.05            // Fill within 5% of the rate = no draw
+#define PUMP_RATE_ALPHA 0.1                 // EWMA weight for clean fills
+#define PUMP_RATE_ALPHA_UP 0.3              // EWMA weight when a fill beats the rate
+#define USAGE_DEADBAND_PCT 1.0              // Level drop (%) before it counts as a draw (noise)
+#define ROLLOVER_WEEK_START_DAY 1           // Weekly totals start on Monday (0 = Sunday)
+#define ROLLOVER_MAX_CATCHUP 31             // Missed periods closed one by one before re-anchoring
+#define DEMAND_PROFILE_ALPHA 0.2            // EWMA weight per weekly observation of a slot
+#define DEMAND_PROFILE_SAVE_HOURS 6         // Persist the 7x24 profile every N folded hours
+#define LEAK_QUIET_START_HOUR 1             // Quiet hours used for the night baseline
+#define LEAK_QUIET_END_HOUR 5               // (local time, end exclusive)
+#define LEAK_WINDOW_MS 900000               // Net outflow window (15 min)
+#define LEAK_MIN_WINDOWS 8                  // Clean windows needed to judge a night
+#define LEAK_BASELINE_PERCENTILE 25         // Night baseline = this percentile of window flow
+#define LEAK_MIN_FLOW_LPM 0.05              // Baseline at/above this is suspicious (~72 L/day)
+#define LEAK_CONFIRM_NIGHTS 3               // Consecutive suspicious nights to raise the alarm
+#define LEAK_HIST_BUCKETS 20                // Log-spaced flow histogram buckets
+#define LEAK_HIST_MIN_LPM 0.01              // Upper edge of the zero bucket
+
 // ==================== NETWORK CONFIGURATION ====================
 #define AP_SSID "SmartWaterPump"            // Access Point name
 #define AP_PASSWORD "pump12345"             // Access Point password (min 8 chars)
@@ -61,12 +89,23 @@
 #define IOT_API_ENDPOINT "/api/v1/devices"          // REST API endpoint
 #define IOT_CONNECTION_TIMEOUT_MS 10000             // Timeout for IoT attempts
 #define IOT_RETRY_AFTER_FAIL_MS 300000              // Retry after 5 minutes
+#define IOT_POLL_INTERVAL_MS 30000                  // REST API command/config poll
+
+// ==================== NETWORK WORKER ====================
+// All blocking network I/O runs in its own task; loop() (core 1) only queues
+#define NET_WORKER_CORE 0                   // Runs beside the WiFi stack
+#define NET_WORKER_PRIORITY 1               // Same as loop()
+#define NET_WORKER_STACK_SIZE 8192          // HTTPClient + JSON + OTA stream
+#define NET_WORKER_IDLE_MS 20               // Wake-up period while queues are empty
+#define NET_OUTBOX_SIZE 8                   // loop() -> worker requests (power of two)
+#define NET_INBOX_SIZE 8                    // Worker -> loop() events (power of two)
 
 // ==================== UPDATE & SYNC CONFIGURATION ====================
 // OTA and sync are OPTIONAL - system works standalone
 #define AUTO_OTA_ENABLED false              // Disable until server ready
 #define OTA_CHECK_AT_STARTUP false          // Don't check at boot
 #define OTA_CHECK_DAILY false               // Don't check daily
+#define OTA_CHECK_INTERVAL_MS 86400000      // Auto-update check period (24 h)
 #define CONFIG_SYNC_INTERVAL_MS 300000      // Sync every 5 minutes (if connected)
 #define TELEMETRY_SEND_INTERVAL_MS 10000    // Send telemetry every 10s (if connected)
 #define GRACEFUL_IOT_FAILURE true           // Continue if IoT fails ✅
@@ -80,32 +119,86 @@
 #define ML_MODEL_UPDATE_INTERVAL_DAYS 7     // Download new model every N days
 #define ML_MODEL_PATH "/model.tflite"       // Model file path in SPIFFS
 #define ML_PREDICTION_INTERVAL_MS 60000     // Run prediction every minute
+#define ML_UPDATE_CHECK_INTERVAL_MS 86400000 // Model update check period (24 h)
 #define ML_FALLBACK_TO_AUTO true            // Use AUTO mode if ML not available ✅
 
 // ==================== DISPLAY CONFIGURATION ====================
 #define DISPLAY_UPDATE_INTERVAL_MS 1000     // Update display every second
 #define DISPLAY_TIMEOUT_SECONDS 300         // Dim display after 5 min inactivity
 #define SCREEN_ROTATION_DELAY_MS 5000       // Auto-rotate screens every 5 sec
+#define DISPLAY_I2C_CLOCK_HZ 400000         // SSD1306 fast mode (during and between frames)
+#define DISPLAY_WINDOW_OVERHEAD 10          // I2C bytes to open an update window (for merging)
+#define TREND_HOURS 6                       // Level / flow sparkline span
+#define TREND_POINTS 96                     // Sparkline samples kept (one per plot column)
+#define TREND_DAYS 7                        // Usage bar chart, today included
 
 // ==================== STORAGE CONFIGURATION ====================
 #define PREFERENCES_NAMESPACE "waterpump"   // Preferences namespace
 #define MAX_DAILY_RECORDS 30                // Store 30 days of history
+#define DAILY_TABLE_DAYS 370                // Days kept in the binary daily table (ring)
+#define LEGACY_DAY_KEYS_SINCE 1577836800UL  // Oldest possible "day<epoch>" key (2020-01-01)
 #define MAX_PUMP_CYCLE_LOGS 100             // Store last 100 pump cycles
+#define USAGE_SAVE_INTERVAL_MS 600000       // Coalesce usage saves (most lost on a power cut)
+#define JOURNAL_MAX_ENTRIES 20              // Updates per atomic storage transaction
+#define JOURNAL_MAX_BYTES 512               // Journal blob size limit (bounds boot replay)
+#define FLASH_WEAR_MAX_KEYS 40              // NVS keys tracked by the wear monitor
+#define NVS_PARTITION_PAGES 5               // 4 KB pages in the NVS partition (0x5000)
+#define FLASH_ERASE_ENDURANCE 100000        // Rated erase cycles per flash sector
 
 // ==================== WEB DASHBOARD CONFIGURATION ====================
 #define WEB_UPDATE_INTERVAL_MS 2000         // Update web dashboard every 2s
 #define WEB_ENABLE_AUTH false               // ✅ Disabled for easier testing
 #define WEB_DEFAULT_USERNAME "admin"        // Default username
 #define WEB_DEFAULT_PASSWORD "admin"        // Default password
+#define EXPORT_LINE_SIZE 128                // Max bytes per exported CSV/NDJSON row
+#define EXPORT_BATCH_DAYS 8                 // Daily records read per storage access
+#define EXPORT_DEFAULT_DAYS 30              // Daily export range when none is given
 
 // ==================== BUTTON CONFIGURATION ====================
 #define BUTTON_DEBOUNCE_MS 50               // Button debounce time
 #define BUTTON_LONG_PRESS_MS 5000           // Long press duration for override
+#define BUTTON_DOUBLE_CLICK_ENABLED true     // LEFT double click = home screen (LEFT clicks wait for it)
+#define BUTTON_DOUBLE_CLICK_MS 300          // Second press after a release (LEFT: home screen)
+#define BUTTON_AUTO_REPEAT_ENABLED true     // TOP/BOTTOM click on press, repeat while held (false = on release)
+#define BUTTON_REPEAT_DELAY_MS 500          // TOP/BOTTOM held: first repeat after
+#define BUTTON_REPEAT_INTERVAL_MS 200       // then repeats this far apart,
+#define BUTTON_REPEAT_ACCEL_MS 20           // shorter by this with each repeat,
+#define BUTTON_REPEAT_MIN_MS 40             // down to this
+#define BUTTON_EDGE_QUEUE_SIZE 64           // Pin edges from the ISR not yet debounced (power of two)
+#define BUTTON_EVENT_QUEUE_SIZE 16          // Recognised button events not yet taken (power of two)
 #define CONFIG_MODE_TIMEOUT_MS 300000       // Exit config mode after 5 min
 
+// ==================== TASK SCHEDULER ====================
+#define SCHEDULER_TICK_MS 10                // Timer wheel resolution
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 16              // Registered periodic + one-shot tasks (host bench: more)
+#endif
+#define TRACKER_UPDATE_INTERVAL_MS 1000     // Rollover / demand profile housekeeping
+
+// ==================== SHARED STATE ====================
+#define CONTROL_QUEUE_SIZE 8                // Pending actuations from other tasks (power of two)
+#define SNAPSHOT_READ_RETRIES 4             // Reader retries when the writer laps it
+
+// ==================== EVENT BUS ====================
+#define EVENT_BUS_QUEUE_SIZE 16             // Pending events (delivered per loop pass)
+#define EVENT_BUS_MAX_SUBSCRIBERS 8         // Handlers across all topics
+
+// ==================== INPUT TRACE ====================
+#define TRACE_ENABLED true                  // Record external inputs to SPIFFS for host replay
+#define TRACE_SEGMENT_COUNT 8               // Segment files in the trace ring
+#define TRACE_SEGMENT_SIZE 16384            // Bytes per segment (~4 bytes per sensor reading)
+#define TRACE_BUFFER_SIZE 256               // RAM buffer between flushes
+#define TRACE_FLUSH_INTERVAL_MS 60000       // Max age of records not yet in flash
+
 // ==================== DEBUG CONFIGURATION ====================
 #define ENABLE_SERIAL_DEBUG true            // Enable serial debugging ✅
 #define SERIAL_BAUD_RATE 115200             // Serial baud rate
+#define ENABLE_LOOP_PROFILER true           // Timing probes around loop() subsystems
+#define PROFILER_MAX_PROBES 16              // Named probes (fixed memory)
+#define PROFILER_BUCKETS 24                 // log2(us) latency buckets; last one is >= 4.2 s
+#ifndef ENABLE_FAULT_INJECTION
+#define ENABLE_FAULT_INJECTION false        // Test builds only: injection points + /api/debug/faults
+#endif
 
 // ==================== FIRMWARE VERSION ====================
 #define FIRMWARE_VERSION "1.0.0"            // Current firmware version
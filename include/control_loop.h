@@ -0,0 +1,101 @@
+// control_loop.h
+#ifndef CONTROL_LOOP_H
+#define CONTROL_LOOP_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensor.h"
+#include "tank_calculator.h"
+#include "pump_controller.h"
+#include "water_tracker.h"
+#include "storage_manager.h"
+#include "event_bus.h"
+#include "trace_recorder.h"
+
+// Pump requests from buttons, the web server and the cloud. They all go
+// through ControlLoop::command(), so a trace records (and the host
+// replays) them the same way.
+enum PumpCommand : uint8_t {
+    PUMP_CMD_ON,
+    PUMP_CMD_OFF,
+    PUMP_CMD_AUTO,
+    PUMP_CMD_MANUAL,
+    PUMP_CMD_TOGGLE_MANUAL,       // Manual switch (switches to MANUAL first if needed)
+    PUMP_CMD_OVERRIDE,            // Manual switch long press: enter / exit override
+    PUMP_CMD_RESET_SAFETY
+};
+
+enum CommandSource : uint8_t {
+    SOURCE_BUTTON,
+    SOURCE_WEB,
+    SOURCE_CLOUD
+};
+
+// Sensor -> level -> pump control -> usage tracking.
+//
+// The part of normalOperation() that closes the loop around the tank,
+// kept free of display/network code so the host simulator runs exactly
+// what the firmware runs. readSensor() publishes a LevelEvent; pump
+// control and the tracker react to it from the event bus, and pump
+// changes come back as PumpEvents.
+class ControlLoop {
+public:
+    ControlLoop(UltrasonicSensor* sensor, TankCalculator* calculator, PumpController* pump,
+                WaterTracker* tracker, StorageManager* storage, EventBus* bus);
+    
+    // Subscribes pump control and the tracker; call before other subscribers
+    void begin(const TankConfig& config);
+    
+    // Optional: record inputs and pump changes
+    void setTrace(TraceRecorder* trace);
+    
+    // Thresholds changed (setup, cloud sync)
+    void setConfig(const TankConfig& config);
+    
+    // Scheduled every SENSOR_SAMPLE_INTERVAL_MS; false on a failed reading
+    bool readSensor();
+    
+    // The part of readSensor() after the measurement (trace replay entry)
+    bool applyReading(float distance);
+    
+    void command(PumpCommand cmd, CommandSource source);
+    
+    // Every pass: pump housekeeping, pump change events, event delivery
+    void loop();
+    
+    // Publish a PumpEvent if motor, mode or alarms changed since the last one
+    void publishPumpState();
+    
+    float getWaterLevel();
+    float getInflow();            // cm³/sec between the last two readings
+    float getMaxInflow();
+
+private:
+    UltrasonicSensor* _sensor;
+    TankCalculator* _calculator;
+    PumpController* _pump;
+    WaterTracker* _tracker;
+    StorageManager* _storage;
+    EventBus* _bus;
+    TraceRecorder* _trace;
+    
+    TankConfig _config;
+    
+    float _level;
+    float _previousLevel;
+    float _inflow;
+    float _maxInflow;
+    unsigned long _lastSensorRead;    // 0 = no reading yet
+    
+    unsigned long _lastSavedChange;   // Pump state change already logged
+    PumpEvent _lastPumpEvent;
+    bool _pumpPublished;
+    
+    void updatePumpControl(const LevelEvent& evt);
+    
+    static void onLevelControl(const LevelEvent& evt, void* context);
+    static void onLevelTracker(const LevelEvent& evt, void* context);
+    static void onPumpTracker(const PumpEvent& evt, void* context);
+};
+
+#endif // CONTROL_LOOP_H
@@ -0,0 +1,53 @@
+// demand_profile.h
+#ifndef DEMAND_PROFILE_H
+#define DEMAND_PROFILE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "storage_manager.h"
+
+#define DEMAND_PROFILE_SLOTS (7 * 24)
+
+// Weekday x hour demand profile.
+// Usage is summed for the current hour (O(1) per usage event); when the
+// hour ends the sum is folded into its slot as an EWMA of liters plus an
+// EWMA variance. Hours the device was off are not folded.
+class DemandProfile {
+public:
+    DemandProfile();
+    
+    void begin(StorageManager* storage);
+    
+    // Call periodically; folds the finished hour when the hour changes
+    void loop();
+    
+    void addUsage(float liters);
+    
+    // Expected liters and standard deviation for a slot (dayOfWeek 0 = Sunday)
+    float getExpected(int dayOfWeek, int hour) const;
+    float getStdDev(int dayOfWeek, int hour) const;
+    int getWeeks(int dayOfWeek, int hour) const;
+    
+    // Expected liters for the current hour (0 if the clock isn't synced)
+    float getExpectedNow() const;
+    
+    void save();
+    void buildReport(JsonDocument& doc);
+    
+private:
+    StorageManager* _storage;
+    
+    float _mean[DEMAND_PROFILE_SLOTS];
+    float _variance[DEMAND_PROFILE_SLOTS];
+    uint8_t _weeks[DEMAND_PROFILE_SLOTS];
+    
+    int _currentSlot;             // -1 until the clock is synced
+    bool _partialHour;            // Current hour not observed from its start
+    float _hourLiters;
+    int _foldsSinceSave;
+    
+    void fold(int slot, float liters);
+    static int slotNow();
+};
+
+#endif // DEMAND_PROFILE_H
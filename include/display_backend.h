@@ -0,0 +1,48 @@
+// display_backend.h
+#ifndef DISPLAY_BACKEND_H
+#define DISPLAY_BACKEND_H
+
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include "frame_diff.h"
+
+// Where DisplayManager draws and what it sends frames to. Screens draw
+// through gfx() into getBuffer(), a frame in the SSD1306 page layout
+// (see FrameDiff); sendWindow() then shows one changed region of it.
+// The firmware uses Ssd1306Backend; the host build adds an in-memory
+// panel that saves images and counts draw calls (host/memory_display.h).
+class DisplayBackend {
+public:
+    virtual ~DisplayBackend() {}
+    
+    virtual bool begin() = 0;
+    virtual Adafruit_GFX& gfx() = 0;
+    virtual uint8_t* getBuffer() = 0;
+    
+    // Blank the frame (not the panel)
+    virtual void clear() = 0;
+    
+    // Show window of the frame
+    virtual void sendWindow(const DirtyWindow& window) = 0;
+    
+    virtual void setContrast(uint8_t contrast) = 0;
+};
+
+// SSD1306 on the display I2C pins
+class Ssd1306Backend : public DisplayBackend {
+public:
+    Ssd1306Backend();
+    
+    bool begin() override;
+    Adafruit_GFX& gfx() override { return _display; }
+    uint8_t* getBuffer() override { return _display.getBuffer(); }
+    void clear() override;
+    void sendWindow(const DirtyWindow& window) override;
+    void setContrast(uint8_t contrast) override;
+
+private:
+    Adafruit_SSD1306 _display;
+};
+
+#endif // DISPLAY_BACKEND_H
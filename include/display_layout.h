@@ -0,0 +1,86 @@
+// display_layout.h
+#ifndef DISPLAY_LAYOUT_H
+#define DISPLAY_LAYOUT_H
+
+#include <Arduino.h>
+#include "display_backend.h"
+#include "frame_diff.h"
+
+#define LAYOUT_MAX_FIELDS 8
+#define LAYOUT_TEXT_SIZE 22           // One 128 px line of 6 px characters + NUL
+
+// Static text, drawn once when the screen is switched to
+struct LayoutLabel {
+    int16_t x;
+    int16_t y;
+    const char* text;
+};
+
+// Static outline
+struct LayoutBox {
+    int16_t x;
+    int16_t y;
+    int16_t width;
+    int16_t height;
+};
+
+enum LayoutFieldType : uint8_t {
+    FIELD_NUMBER,                 // value.number with `decimals` places, then `suffix`
+    FIELD_TEXT,                   // value.text, a string constant (nullptr = blank)
+    FIELD_BAR                     // value.number 0-100 fills the area from the bottom
+};
+
+struct LayoutField {
+    LayoutFieldType type;
+    int16_t x;
+    int16_t y;
+    uint8_t width;                // Characters (NUMBER, TEXT) or pixels (BAR)
+    uint8_t height;               // Pixels (BAR)
+    uint8_t decimals;             // NUMBER
+    const char* suffix;           // NUMBER, nullptr = none
+};
+
+union LayoutValue {
+    float number;
+    const char* text;
+};
+
+struct ScreenLayout {
+    const LayoutLabel* labels;
+    uint8_t labelCount;
+    const LayoutBox* boxes;
+    uint8_t boxCount;
+    const LayoutField* fields;
+    uint8_t fieldCount;
+};
+
+// Renders a ScreenLayout into the display buffer without heap allocation.
+// Labels and boxes are drawn once per screen switch and kept in a
+// background copy; after that a field is re-rendered only when its
+// formatted text (or bar height) changes, by restoring its area from the
+// background and drawing the new value.
+class LayoutRenderer {
+public:
+    LayoutRenderer();
+    
+    // values[i] belongs to layout.fields[i]; false = frame unchanged
+    bool render(DisplayBackend& backend, const ScreenLayout& layout, const LayoutValue* values);
+    
+    // Something else was drawn: the next render starts from the background
+    void invalidate();
+    
+    // Fixed-point formatting into out (always terminated); returns the length
+    static size_t formatNumber(char* out, size_t size, float value, uint8_t decimals);
+
+private:
+    const ScreenLayout* _layout;
+    uint8_t _background[DISPLAY_BUFFER_SIZE];
+    char _text[LAYOUT_MAX_FIELDS][LAYOUT_TEXT_SIZE];   // As drawn
+    int16_t _fill[LAYOUT_MAX_FIELDS];                  // Bar pixels as drawn
+    
+    void drawBackground(DisplayBackend& backend, const ScreenLayout& layout);
+    bool renderField(DisplayBackend& backend, int index, const LayoutField& field, const LayoutValue& value);
+    void restore(uint8_t* frame, int16_t x, int16_t y, int16_t width, int16_t height);
+};
+
+#endif // DISPLAY_LAYOUT_H
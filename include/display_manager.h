@@ -2,16 +2,22 @@
 #ifndef DISPLAY_MANAGER_H
 #define DISPLAY_MANAGER_H
 
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
+#include "display_backend.h"
+#include "frame_diff.h"
+#include "display_layout.h"
+
+class TrendHistory;
 
 enum DisplayScreen {
     SCREEN_MAIN,
     SCREEN_STATUS,
     SCREEN_USAGE,
+    SCREEN_LEVEL_TREND,    // Level sparkline (TrendHistory)
+    SCREEN_FLOW_TREND,     // Inflow sparkline
+    SCREEN_WEEK_USAGE,     // Daily usage bars
     SCREEN_CONFIG_MENU,
-    SCREEN_SETUP
+    SCREEN_SETUP,
+    SCREEN_PERF            // Loop profiler (ENABLE_LOOP_PROFILER)
 };
 
 struct DisplayData {
@@ -23,22 +29,32 @@ struct DisplayData {
     bool overrideMode;
     float dailyUsage;
     float monthlyUsage;
-    String wifiStatus;
-    String iotStatus;
+    bool wifiConnected;
+    bool iotOnline;
     bool dryRunAlarm;
     bool overflowAlarm;
+    bool leakAlarm;
 };
 
 class DisplayManager {
 public:
-    DisplayManager();
+    // nullptr = the SSD1306 on the display pins
+    DisplayManager(DisplayBackend* backend = nullptr);
     
     bool begin();
+    
+    // Scheduled every DISPLAY_UPDATE_INTERVAL_MS: dimming, message expiry, redraw
     void loop();
     
     // Update display data
     void updateData(const DisplayData& data);
     
+    // Source of the trend screens (not owned)
+    void setHistory(const TrendHistory* history);
+    
+    // Redraw and resend everything on the next loop()
+    void refresh();
+    
     // Screen management
     void setScreen(DisplayScreen screen);
     DisplayScreen getCurrentScreen();
@@ -58,12 +74,18 @@ public:
     void setBrightness(uint8_t brightness);
     void dimDisplay();
     void wakeDisplay();
-    
+
 private:
-    Adafruit_SSD1306 _display;
+    Ssd1306Backend _oled;
+    DisplayBackend* _backend;
+    Adafruit_GFX& _display;       // _backend->gfx()
+    FrameDiff _frame;             // What the panel shows, for partial updates
+    LayoutRenderer _layout;       // Main, status and usage screens
     DisplayData _data;
     DisplayScreen _currentScreen;
-    unsigned long _lastUpdate;
+    bool _redraw;                 // Data or screen changed since the last render
+    const TrendHistory* _history;
+    uint32_t _historyVersion;     // History drawn on the trend screen
     unsigned long _lastActivity;
     bool _isDimmed;
     unsigned long _messageEndTime;
@@ -76,10 +98,19 @@ private:
     void drawUsageScreen();
     void drawConfigMenuScreen(int selectedItem);
     void drawSetupScreen(const String& prompt);
+    void drawPerfScreen();
+    void drawTrendScreen(bool inflow);
+    void drawWeekUsageScreen();
+    
+    void renderLayout(const ScreenLayout& layout, const LayoutValue* values);
+    void clearScreen();
+    
+    // Transfer the changed parts of the frame buffer (instead of display())
+    void flush();
+    static bool sameData(const DisplayData& a, const DisplayData& b);
     
-    void drawTankLevel(int x, int y, int width, int height, float level);
     void drawStatusIcon(int x, int y, bool state);
-    String formatFloat(float value, int decimals = 1);
+    static void formatMicros(uint32_t us, char* out, size_t size);
 };
 
 #endif // DISPLAY_MANAGER_H
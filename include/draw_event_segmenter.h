@@ -0,0 +1,72 @@
+// draw_event_segmenter.h
+#ifndef DRAW_EVENT_SEGMENTER_H
+#define DRAW_EVENT_SEGMENTER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "storage_manager.h"
+
+enum DrawCategory {
+    DRAW_SMALL = 0,     // Tap, hand wash
+    DRAW_MEDIUM,        // Dishes, toilet, short shower
+    DRAW_LARGE,         // Shower, laundry
+    DRAW_BULK,          // Garden, tank drain, leak
+    DRAW_CATEGORY_COUNT
+};
+
+// Groups consecutive outflow samples into discrete draw events.
+// O(1) per sample; finished events go into a fixed ring that is persisted
+// every DRAW_EVENT_FLUSH_COUNT events (and on request).
+class DrawEventSegmenter {
+public:
+    DrawEventSegmenter();
+    
+    void begin(StorageManager* storage);
+    
+    // Feed one sample. liters = outflow since the previous sample (0 if none).
+    void addSample(float liters, unsigned long nowMs);
+    
+    // Close any open event (pump started, day rollover)
+    void closeEvent();
+    
+    // Write unsaved events to storage
+    void flush();
+    
+    // Copy of the event log, oldest first
+    int getEvents(DrawEvent* events, int maxCount);
+    bool isEventActive() const { return _active; }
+    
+    void buildReport(JsonDocument& doc);
+    
+    static const char* getCategoryName(uint8_t category);
+    static DrawCategory classify(float liters);
+    
+private:
+    StorageManager* _storage;
+    
+    // Open event
+    bool _active;
+    unsigned long _startMs;
+    unsigned long _lastFlowMs;
+    uint32_t _startTime;
+    float _volume;
+    float _peakRate;              // L/min
+    
+    // A lone drop under DRAW_MIN_EVENT_LITERS, held until the next reading
+    bool _lastFlowing;
+    float _heldLiters;
+    unsigned long _heldMs;
+    uint32_t _heldTime;
+    
+    // Finished events (ring)
+    DrawEvent _events[DRAW_EVENT_LOG_SIZE];
+    int _head;                    // Next slot to write
+    int _count;
+    int _unsaved;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    
+    void addFlow(float liters, unsigned long nowMs, uint32_t nowTime);
+    void appendEvent(const DrawEvent& event);
+};
+
+#endif // DRAW_EVENT_SEGMENTER_H
@@ -0,0 +1,124 @@
+// event_bus.h
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <string.h>
+#include <type_traits>
+#include "config.h"
+
+enum EventTopic : uint8_t {
+    TOPIC_LEVEL,                  // New sensor reading
+    TOPIC_PUMP,                   // Motor, mode or safety alarm changed
+    TOPIC_COUNT
+};
+
+struct LevelEvent {
+    unsigned long timestamp;
+    float waterLevel;             // %
+    float previousLevel;
+    float currentInflow;
+    float maxInflow;
+};
+
+struct PumpEvent {
+    unsigned long timestamp;
+    bool motorState;
+    uint8_t mode;                 // PumpMode
+    bool dryRunAlarm;
+    bool overflowAlarm;
+};
+
+// Compile-time topic of each payload type
+template <typename T> struct EventTopicOf;
+template <> struct EventTopicOf<LevelEvent> { static const EventTopic id = TOPIC_LEVEL; };
+template <> struct EventTopicOf<PumpEvent> { static const EventTopic id = TOPIC_PUMP; };
+
+// Publish/subscribe between control-loop subsystems.
+//
+// publish() copies the payload into a fixed ring (no allocation) and
+// dispatch() hands queued events to the topic's subscribers in
+// subscription order. Events published from a handler are delivered in
+// the same dispatch(), up to EVENT_BUS_QUEUE_SIZE per call. Publish and
+// dispatch on the control loop only; buildReport() may run elsewhere and
+// read slightly stale counters.
+class EventBus {
+public:
+    template <typename T>
+    using Handler = void (*)(const T& event, void* context);
+    
+    EventBus();
+    
+    // False when EVENT_BUS_MAX_SUBSCRIBERS are in use
+    template <typename T>
+    bool subscribe(Handler<T> handler, void* context = nullptr) {
+        return addSubscriber(EventTopicOf<T>::id, reinterpret_cast<GenericHandler>(handler),
+                             &invoke<T>, context);
+    }
+    
+    // False (and counted as dropped) when the ring is full
+    template <typename T>
+    bool publish(const T& event) {
+        static_assert(sizeof(T) <= sizeof(Payload), "Event payload larger than EventBus::Payload");
+        static_assert(std::is_trivially_copyable<T>::value, "Event payloads are copied as bytes");
+        
+        Event* slot = claimSlot(EventTopicOf<T>::id);
+        if (!slot) return false;
+        memcpy(&slot->payload, &event, sizeof(T));
+        return true;
+    }
+    
+    // Deliver pending events; returns how many were dispatched
+    int dispatch();
+    
+    uint32_t getDroppedCount();
+    void buildReport(JsonDocument& doc);
+
+private:
+    typedef void (*GenericHandler)();
+    typedef void (*Invoker)(GenericHandler handler, const void* payload, void* context);
+    
+    union Payload {
+        LevelEvent level;
+        PumpEvent pump;
+    };
+    
+    struct Event {
+        EventTopic topic;
+        Payload payload;
+    };
+    
+    struct Subscriber {
+        EventTopic topic;
+        GenericHandler handler;
+        Invoker invoker;
+        void* context;
+    };
+    
+    Event _queue[EVENT_BUS_QUEUE_SIZE];
+    uint8_t _head;
+    uint8_t _count;
+    
+    Subscriber _subscribers[EVENT_BUS_MAX_SUBSCRIBERS];
+    uint8_t _subscriberCount;
+    
+    // Statistics
+    uint32_t _published[TOPIC_COUNT];
+    uint32_t _delivered[TOPIC_COUNT];
+    uint32_t _dropped;
+    uint32_t _dispatchCalls;
+    uint32_t _idleDispatches;     // Passes with nothing to deliver
+    
+    bool addSubscriber(EventTopic topic, GenericHandler handler, Invoker invoker, void* context);
+    Event* claimSlot(EventTopic topic);
+    
+    template <typename T>
+    static void invoke(GenericHandler handler, const void* payload, void* context) {
+        reinterpret_cast<Handler<T>>(handler)(*static_cast<const T*>(payload), context);
+    }
+    
+    static const char* topicName(EventTopic topic);
+};
+
+#endif // EVENT_BUS_H
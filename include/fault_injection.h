@@ -0,0 +1,86 @@
+// fault_injection.h
+#ifndef FAULT_INJECTION_H
+#define FAULT_INJECTION_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ==================== FAULT INJECTION ====================
+// Named points in the sensor, storage and network paths where a test
+// build can make the operation time out, return garbage, stall or only
+// half-complete, to exercise the graceful-degradation paths. Points are
+// armed from the host simulator ("fault" lines in a scenario) or from
+// POST /api/debug/faults.
+//
+// With ENABLE_FAULT_INJECTION false the FAULT_* macros expand to
+// constants and FaultInjector is not compiled, so release builds carry
+// no trace of it.
+
+enum FaultPoint : uint8_t {
+    FAULT_SENSOR_TIMEOUT = 0,     // Echo never arrives (full pulseIn timeout)
+    FAULT_SENSOR_CORRUPT,         // Plausible but wrong distance
+    FAULT_SENSOR_SLOW,            // Measurement stalls for the armed delay
+    FAULT_STORAGE_WRITE_FAIL,     // NVS put* writes nothing
+    FAULT_STORAGE_PARTIAL_WRITE,  // Blob/string put* stores half the data
+    FAULT_STORAGE_READ_CORRUPT,   // getBytes flips a bit, getFloat returns NaN
+    FAULT_STORAGE_SLOW,           // NVS write stalls (page GC)
+    FAULT_MQTT_PUBLISH_FAIL,      // Publish dropped
+    FAULT_MQTT_SLOW,              // Publish stalls
+    FAULT_REST_TIMEOUT,           // Request times out
+    FAULT_REST_SLOW,              // Response stalls
+    FAULT_REST_CORRUPT,           // Response body truncated
+    FAULT_WIFI_CONNECT_FAIL,      // Association times out
+    FAULT_WIFI_DROP,              // Link reported down
+    FAULT_POINT_COUNT
+};
+
+#if ENABLE_FAULT_INJECTION
+
+#include <ArduinoJson.h>
+
+class FaultInjector {
+public:
+    // Fire with the given probability per hit, at most count times
+    // (-1 = no limit). delayMs is the stall for the *_SLOW points and the
+    // extra latency of the timeout points.
+    static void arm(FaultPoint point, float probability, int32_t count = -1, uint32_t delayMs = 0);
+    static void disarm(FaultPoint point);
+    static void reset();                        // Disarm everything, clear counters
+    static void seed(uint32_t value);
+    
+    // At an injection point: true if the fault happens this time
+    static bool fire(FaultPoint point);
+    
+    // Stall for the armed delay if the point fires
+    static void stall(FaultPoint point);
+    
+    // Armed delay (0 = the point's natural timeout)
+    static uint32_t getDelay(FaultPoint point);
+    
+    // Uniform in [0, 1), for corrupted values
+    static float random();
+    
+    static const char* getName(FaultPoint point);
+    static bool pointFromName(const char* name, FaultPoint& point);
+    static uint32_t getHitCount(FaultPoint point);
+    static uint32_t getFiredCount(FaultPoint point);
+    
+    // Armed points and counters for /api/debug/faults
+    static void buildReport(JsonDocument& doc);
+};
+
+#define FAULT_FIRES(point) FaultInjector::fire(point)
+#define FAULT_STALL(point) FaultInjector::stall(point)
+#define FAULT_DELAY(point, fallback) (FaultInjector::getDelay(point) ? FaultInjector::getDelay(point) : (fallback))
+#define FAULT_RANDOM() FaultInjector::random()
+
+#else
+
+#define FAULT_FIRES(point) (false)
+#define FAULT_STALL(point) do {} while (0)
+#define FAULT_DELAY(point, fallback) (fallback)
+#define FAULT_RANDOM() (0.0f)
+
+#endif // ENABLE_FAULT_INJECTION
+
+#endif // FAULT_INJECTION_H
@@ -0,0 +1,71 @@
+// flash_wear_monitor.h
+#ifndef FLASH_WEAR_MONITOR_H
+#define FLASH_WEAR_MONITOR_H
+
+#include <Preferences.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+// Write statistics for one NVS key (indexed keys like cycle0..cycle99 share "cycle#")
+struct KeyWearStats {
+    char ns[16];
+    char key[16];
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t entries;             // Estimated 32-byte NVS entries consumed
+};
+
+// ==================== FLASH WEAR MONITOR ====================
+// Counts NVS writes per namespace/key since boot and projects flash lifetime
+// from the observed write rate. Counts are put*() calls, so they are an upper
+// bound: NVS skips rewriting an identical value.
+
+class FlashWearMonitor {
+public:
+    static void recordWrite(const char* ns, const char* key, size_t valueBytes, bool variableLength);
+    
+    static uint32_t getTotalWrites();
+    static uint32_t getTotalBytes();
+    static uint32_t getTotalEntries();
+    
+    // Estimated page erases so far and per-sector erase rate
+    static float getEstimatedPageErases();
+    static float getErasesPerSectorPerDay();
+    
+    // Years until the NVS sectors reach their rated erase endurance
+    static float getProjectedLifetimeYears();
+    
+    static int getKeyCount();
+    static const KeyWearStats& getKeyStats(int index);
+    
+    // Fill a JSON report (used by the diagnostics endpoint)
+    static void buildReport(JsonDocument& doc);
+    
+    static void reset();
+};
+
+// Preferences with every put*() reported to FlashWearMonitor.
+// StorageManager uses this in place of Preferences.
+class TrackedPreferences : public Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false);
+    
+    size_t putBool(const char* key, bool value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putULong(const char* key, uint32_t value);
+    size_t putFloat(const char* key, float value);
+    size_t putString(const char* key, const String& value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+    
+    #if ENABLE_FAULT_INJECTION
+    // Read side of FAULT_STORAGE_READ_CORRUPT
+    float getFloat(const char* key, float defaultValue = NAN);
+    size_t getBytes(const char* key, void* buffer, size_t maxLen);
+    #endif
+
+private:
+    char _namespace[16];
+};
+
+#endif // FLASH_WEAR_MONITOR_H
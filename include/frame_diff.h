@@ -0,0 +1,45 @@
+// frame_diff.h
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <Arduino.h>
+#include "pins.h"
+
+#define DISPLAY_PAGES (DISPLAY_HEIGHT / 8)
+#define DISPLAY_BUFFER_SIZE (DISPLAY_WIDTH * DISPLAY_PAGES)
+
+// Rectangle of SSD1306 RAM to rewrite: pages (8-pixel rows) x columns
+struct DirtyWindow {
+    uint8_t firstPage;
+    uint8_t lastPage;
+    uint8_t firstColumn;
+    uint8_t lastColumn;
+};
+
+// Keeps the last frame sent to the panel and reports which parts of a new
+// one differ. Frames are in the SSD1306 / Adafruit layout: one byte per
+// column per page, page-major. Changed columns are found per page, then
+// adjacent pages are merged into one window when sending the union costs
+// less than opening a second window (DISPLAY_WINDOW_OVERHEAD).
+class FrameDiff {
+public:
+    FrameDiff();
+    
+    // Windows covering every change since the last commit(); 0 = identical.
+    // Before the first commit (or after invalidate) the whole frame.
+    int compute(const uint8_t* frame, DirtyWindow* windows, int maxWindows);
+    
+    // The frame has reached the panel
+    void commit(const uint8_t* frame);
+    
+    // Panel contents unknown (reset, another writer): next compute() sends all
+    void invalidate();
+    
+    static size_t windowBytes(const DirtyWindow& window);
+
+private:
+    uint8_t _previous[DISPLAY_BUFFER_SIZE];
+    bool _valid;
+};
+
+#endif // FRAME_DIFF_H
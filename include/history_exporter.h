@@ -0,0 +1,66 @@
+// history_exporter.h
+#ifndef HISTORY_EXPORTER_H
+#define HISTORY_EXPORTER_H
+
+#include <Arduino.h>
+#include "storage_manager.h"
+#include "config.h"
+
+enum ExportKind {
+    EXPORT_DAILY,
+    EXPORT_CYCLES
+};
+
+enum ExportFormat {
+    EXPORT_CSV,
+    EXPORT_NDJSON
+};
+
+// Streams stored history row by row into caller-provided buffers, so a
+// chunked HTTP response never holds more than one row plus a small batch
+// (and, for daily exports, one copy of the daily table read at the start).
+class HistoryExporter {
+public:
+    // Range is [from, to] in seconds for daily records and in the stored
+    // timestamp units for pump cycles; 0 means unbounded.
+    HistoryExporter(ExportKind kind, ExportFormat format, unsigned long from, unsigned long to);
+    
+    // Copy as many bytes as fit into buffer; returns 0 when the export is done
+    size_t read(uint8_t* buffer, size_t maxLen);
+    
+    static const char* getContentType(ExportFormat format);
+    
+private:
+    StorageManager _storage;   // Own NVS handle; read() runs on the web server task
+    ExportKind _kind;
+    ExportFormat _format;
+    unsigned long _from;
+    unsigned long _to;
+    
+    // Pending row (may span several read() calls)
+    char _line[EXPORT_LINE_SIZE];
+    size_t _lineLength;
+    size_t _linePos;
+    bool _headerSent;
+    bool _done;
+    
+    // Daily cursor
+    long _nextDay;
+    long _lastDay;
+    DailyUsage _batch[EXPORT_BATCH_DAYS];
+    int _batchCount;
+    int _batchPos;
+    
+    // Pump cycle cursor (counts down from oldest to newest). The ring
+    // position is taken at the start so cycles logged meanwhile don't
+    // shift the walk.
+    int _cycleIndex;
+    int _cycleAge;
+    
+    bool formatNextRow();
+    bool formatHeader();
+    bool formatDailyRow(const DailyUsage& usage);
+    bool formatCycleRow(const PumpCycle& cycle);
+};
+
+#endif // HISTORY_EXPORTER_H
@@ -44,9 +44,13 @@ public:
     // Initialize with device token from storage
     bool begin();
     
-    // Must be called in loop()
+    // Client methods block on the network - call them from the
+    // NetworkWorker task, not from loop()
     void loop();
     
+    // Pull pending commands/config (REST API only; scheduled every IOT_POLL_INTERVAL_MS)
+    void poll();
+    
     // Connection status
     bool isConnected();
     
@@ -69,7 +73,6 @@ private:
     IoTProtocol _protocol;
     StorageManager _storage;
     String _deviceToken;
-    unsigned long _lastTelemetrySend;
     bool _initialized;
 };
 
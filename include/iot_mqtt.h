@@ -67,6 +67,7 @@ private:
     static IoTMQTT* _instance; // For static callback
     
     void handleMessage(String topic, String payload);
+    bool publish(const char* topic, const char* payload, bool retained = false);
     unsigned long _lastReconnectAttempt;
 };
 
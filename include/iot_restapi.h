@@ -52,15 +52,13 @@ public:
     // Set callback for received config
     void setConfigCallback(void (*callback)(const String& configJson));
     
-    // Manual polling (called periodically in loop)
+    // Fetch pending commands and config (scheduled via IoTClient::poll)
     void pollServer();
     
 private:
     HTTPClient _http;
     String _serverUrl;
     String _deviceToken;
-    unsigned long _lastPollTime;
-    unsigned long _pollInterval;
     
     void (*_commandCallback)(const CommandData& cmd);
     void (*_configCallback)(const String& configJson);
@@ -0,0 +1,64 @@
+// leak_detector.h
+#ifndef LEAK_DETECTOR_H
+#define LEAK_DETECTOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "storage_manager.h"
+
+// Night-time minimum flow leak detection.
+//
+// During quiet hours the net tank outflow is measured over fixed windows
+// (pump off only) as the least-squares slope of every volume sample in the
+// window - two end readings alone carry the full sensor noise - and binned into a log-spaced histogram. When the quiet
+// period ends, a low percentile of that histogram is the night's baseline
+// flow - occasional night-time draws sit above it, a leak lifts it. The
+// alarm is raised after LEAK_CONFIRM_NIGHTS suspicious nights in a row and
+// cleared by the first clean night.
+class LeakDetector {
+public:
+    LeakDetector();
+    
+    void begin(StorageManager* storage);
+    
+    // Feed the current tank volume; cheap when outside quiet hours
+    void addSample(float volumeLiters, bool pumpOn, unsigned long nowMs);
+    
+    bool isAlarmActive() const { return _state.alarm != 0; }
+    float getBaselineFlow() const { return _state.baselineLpm; }   // L/min, last night
+    int getSuspectNights() const { return _state.suspectNights; }
+    
+    void buildReport(JsonDocument& doc);
+
+private:
+    StorageManager* _storage;
+    LeakState _state;
+    
+    // Current window
+    bool _windowOpen;
+    bool _windowPumped;
+    unsigned long _windowStartMs;
+    float _windowStartVolume;
+    
+    // Least-squares sums, t in minutes and v in litres from the window start
+    uint16_t _windowSamples;
+    float _sumT;
+    float _sumV;
+    float _sumTT;
+    float _sumTV;
+    
+    // Current night
+    bool _inQuietHours;
+    uint16_t _histogram[LEAK_HIST_BUCKETS];
+    uint16_t _windowCount;
+    
+    bool isQuietHour();
+    void openWindow(float volumeLiters, bool pumpOn, unsigned long nowMs);
+    void closeWindow();
+    void evaluateNight();
+    float percentile(int pct);
+    static int bucketFor(float lpm);
+    static float bucketLowerEdge(int bucket);
+};
+
+#endif // LEAK_DETECTOR_H
@@ -0,0 +1,96 @@
+// loop_profiler.h
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include "config.h"
+
+struct ProbeSummary {
+    const char* name;
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t p50Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+    uint32_t avgUs;
+};
+
+// Latency histograms for the subsystems called from loop().
+//
+// Each named probe keeps a call count, min/max/total and a log2 bucket
+// histogram (bucket b holds [2^(b-1), 2^b) us) in fixed memory, so
+// recording is a clz and a few adds. Percentiles are read back as the
+// upper edge of the bucket that holds them, clamped to min/max.
+// Recording happens on the loop() task only; readers on other tasks may
+// see a sample half-applied, which is harmless for diagnostics.
+class LoopProfiler {
+public:
+    LoopProfiler();
+    
+    // Measure the cost of one probe (reported as probeOverheadNs)
+    void begin();
+    
+    // Returns -1 when PROFILER_MAX_PROBES are in use
+    int8_t registerProbe(const char* name);
+    void record(int8_t id, uint32_t us);
+    void reset();
+    
+    int getProbeCount();
+    bool getSummary(int8_t id, ProbeSummary& summary);
+    uint32_t getOverheadNs();
+    
+    void buildReport(JsonDocument& doc);
+
+private:
+    struct Probe {
+        const char* name;
+        uint32_t count;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        uint32_t buckets[PROFILER_BUCKETS];
+    };
+    
+    Probe _probes[PROFILER_MAX_PROBES];
+    int _probeCount;
+    uint32_t _overheadNs;
+    
+    static uint8_t bucketOf(uint32_t us);
+    static uint32_t percentile(const Probe& probe, uint8_t pct);
+};
+
+extern LoopProfiler loopProfiler;
+
+// Times the enclosing scope into a probe
+class ProfileScope {
+public:
+    ProfileScope(LoopProfiler& profiler, int8_t id)
+        : _profiler(profiler), _id(id), _start(esp_timer_get_time()) {
+    }
+    
+    ~ProfileScope() {
+        _profiler.record(_id, (uint32_t)(esp_timer_get_time() - _start));
+    }
+
+private:
+    LoopProfiler& _profiler;
+    int8_t _id;
+    int64_t _start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// PROFILE_SCOPE("name"); times the rest of the enclosing block.
+// The probe is registered once, on first use.
+#if ENABLE_LOOP_PROFILER
+#define PROFILE_SCOPE(name) \
+    static const int8_t PROFILE_CONCAT(_probeId, __LINE__) = loopProfiler.registerProbe(name); \
+    ProfileScope PROFILE_CONCAT(_probeScope, __LINE__)(loopProfiler, PROFILE_CONCAT(_probeId, __LINE__))
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#endif
+
+#endif // LOOP_PROFILER_H
@@ -7,6 +7,7 @@
 #include <SPIFFS.h>
 // #include <TensorFlowLite_ESP32.h>  // Uncomment when TFLite library is added
 #include "storage_manager.h"
+#include "demand_profile.h"
 
 struct MLInput {
     float hourOfDay;           // 0-23
@@ -34,8 +35,11 @@ public:
     // Check if ML model is loaded and ready
     bool isReady();
     
+    // Source for MLInput::avgUsageSameHour (optional)
+    void setDemandProfile(const DemandProfile* profile);
+    
     // Make prediction based on current state
-    MLPrediction predict(const MLInput& input);
+    MLPrediction predict(const MLInput& rawInput);
     
     // Download model from server
     bool downloadModel();
@@ -51,11 +55,12 @@ public:
     String getModelVersion();
     unsigned long getModelTimestamp();
     
-    // Should be called in loop() for periodic model updates
-    void loop();
+    // Scheduled every ML_UPDATE_CHECK_INTERVAL_MS for model updates
+    void periodicCheck();
     
 private:
     StorageManager* _storage;
+    const DemandProfile* _profile;
     String _serverUrl;
     String _deviceToken;
     HTTPClient _http;
@@ -64,7 +69,6 @@ private:
     bool _enabled;
     unsigned long _modelTimestamp;
     String _modelVersion;
-    unsigned long _lastUpdateCheck;
     
     // TensorFlow Lite objects (uncomment when library added)
     // tflite::MicroInterpreter* _interpreter;
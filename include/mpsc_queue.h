@@ -0,0 +1,77 @@
+// mpsc_queue.h
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+// Bounded multi-producer / single-consumer ring buffer.
+//
+// Lock-free: any number of tasks may push() concurrently, exactly one
+// task calls pop(). Every cell carries a sequence number: producers claim
+// a position with a CAS on the tail and hand the cell over by bumping
+// its sequence, so the consumer never sees a half-written item and a
+// full queue fails fast instead of blocking.
+template <typename T, size_t N>
+class MpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscQueue size must be a power of two");
+
+public:
+    MpscQueue() : _tail(0), _head(0) {
+        for (size_t i = 0; i < N; i++) {
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    // Any task; false when full (item is not queued)
+    bool push(const T& item) {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        
+        for (;;) {
+            cell = &_cells[pos & (N - 1)];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        
+        cell->data = item;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer task only; false when empty
+    bool pop(T& item) {
+        Cell* cell = &_cells[_head & (N - 1)];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(_head + 1) < 0) {
+            return false;
+        }
+        
+        item = std::move(cell->data);
+        cell->seq.store(_head + N, std::memory_order_release);
+        _head++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+    
+    Cell _cells[N];
+    std::atomic<size_t> _tail;    // Next position to claim (producers)
+    size_t _head;                 // Next position to read (consumer only)
+};
+
+#endif // MPSC_QUEUE_H
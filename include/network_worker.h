@@ -0,0 +1,122 @@
+// network_worker.h
+#ifndef NETWORK_WORKER_H
+#define NETWORK_WORKER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+#include "spsc_queue.h"
+#include "wifi_manager.h"
+#include "iot_client.h"
+#include "ota_updater.h"
+#include "ml_predictor.h"
+#include "cloud_link.h"
+
+// Requests from the control loop (outbox)
+enum NetRequestType : uint8_t {
+    NET_REQ_TELEMETRY,
+    NET_REQ_STATUS,
+    NET_REQ_CONFIG_PUSH,
+    NET_REQ_CONFIG_PULL,
+    NET_REQ_POLL,
+    NET_REQ_OTA_CHECK,          // Check only; result ok = update available
+    NET_REQ_OTA_AUTO_UPDATE,    // Check and install
+    NET_REQ_ML_UPDATE
+};
+
+struct NetRequest {
+    NetRequestType type;
+    TelemetryData telemetry;    // NET_REQ_TELEMETRY
+    TankConfig config;          // NET_REQ_CONFIG_PUSH
+    String text;                // NET_REQ_STATUS
+};
+
+// Events for the control loop (inbox)
+enum NetEventType : uint8_t {
+    NET_EVT_LINK,               // Boot connect finished; ok = cloud client ready
+    NET_EVT_COMMAND,            // Cloud command
+    NET_EVT_CONFIG,             // Cloud config JSON in text
+    NET_EVT_RESULT              // Outcome of a status/config/OTA request
+};
+
+struct NetEvent {
+    NetEventType type;
+    NetRequestType request;     // NET_EVT_RESULT
+    bool ok;
+    CommandData command;        // NET_EVT_COMMAND
+    String text;                // Config JSON, or the status that was sent
+};
+
+typedef void (*NetEventCallback)(const NetEvent& event);
+
+// Owns every blocking network client (WiFi connect, MQTT/REST/WebSocket,
+// OTA and ML HTTP) on a FreeRTOS task pinned to NET_WORKER_CORE.
+// loop() never waits on the network: it posts requests into a bounded
+// SPSC outbox and drains results and cloud messages from an SPSC inbox
+// with dispatch(). When a queue is full the newest item is dropped.
+class NetworkWorker : public CloudLink {
+public:
+    NetworkWorker();
+    
+    // Start the worker task (clients must outlive it)
+    bool begin(WiFiManager* wifi, IoTClient* iot, OTAUpdater* ota, MLPredictor* ml);
+    
+    // Connect saved WiFi + cloud in the background; reports NET_EVT_LINK
+    void connect();
+    
+    // Control loop side (non-blocking, false if the outbox is full)
+    bool sendTelemetry(const TelemetryData& data);
+    bool sendStatus(const String& status);
+    bool sendConfig(const TankConfig& config) override;
+    bool requestConfig() override;
+    bool poll();
+    bool checkForUpdate();
+    bool autoUpdate();
+    bool updateModel();
+    
+    // Deliver queued events to the callback; call every loop pass
+    void dispatch();
+    void setEventCallback(NetEventCallback callback);
+    
+    // WiFi up and cloud client connected (as of the worker's last pass)
+    bool isOnline() override;
+    
+    uint32_t getDroppedCount();
+
+private:
+    WiFiManager* _wifi;
+    IoTClient* _iot;
+    OTAUpdater* _ota;
+    MLPredictor* _ml;
+    TaskHandle_t _task;
+    NetEventCallback _eventCallback;
+    
+    SpscQueue<NetRequest, NET_OUTBOX_SIZE> _outbox;
+    SpscQueue<NetEvent, NET_INBOX_SIZE> _inbox;
+    
+    std::atomic<bool> _connectRequested;
+    std::atomic<bool> _online;
+    std::atomic<uint32_t> _dropped;
+    
+    // Worker task state
+    bool _linkStarted;
+    bool _iotReady;
+    unsigned long _lastIoTAttempt;
+    
+    static NetworkWorker* _instance; // For static client callbacks
+    
+    static void taskEntry(void* param);
+    void service();
+    void connectLink();
+    bool startIoT();
+    bool cloudReady();
+    void handleRequest(const NetRequest& req);
+    bool post(NetRequest& req);
+    void postEvent(NetEvent& evt);
+    void postResult(NetRequestType request, bool ok, const String& text = "");
+    
+    static void onCommand(const CommandData& cmd);
+    static void onConfig(const String& configJson);
+};
+
+#endif // NETWORK_WORKER_H
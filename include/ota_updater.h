@@ -30,7 +30,7 @@ class OTAUpdater {
 public:
     OTAUpdater();
     
-    // Initialize (returns false if WiFi not available)
+    // Initialize (WiFi is checked per request, not here)
     bool begin(StorageManager* storage, const String& serverUrl, const String& deviceToken);
     
     // Check for updates (returns true if update available)
@@ -53,8 +53,8 @@ public:
     void setAutoUpdate(bool enabled);
     bool isAutoUpdateEnabled();
     
-    // Should be called in loop() for automatic updates
-    void loop();
+    // Scheduled every OTA_CHECK_INTERVAL_MS for automatic updates
+    void periodicCheck();
     
 private:
     StorageManager* _storage;
@@ -66,7 +66,6 @@ private:
     int _progress;
     FirmwareInfo _latestFirmware;
     bool _autoUpdateEnabled;
-    unsigned long _lastCheckTime;
     bool _updateAvailable;
     
     // Helper functions
@@ -0,0 +1,55 @@
+// rollover_scheduler.h
+#ifndef ROLLOVER_SCHEDULER_H
+#define ROLLOVER_SCHEDULER_H
+
+#include <Arduino.h>
+#include <time.h>
+
+enum RolloverEvent {
+    ROLLOVER_ANCHOR = 0,    // Clock became valid or stepped backwards; periods re-based on now
+    ROLLOVER_DAY,
+    ROLLOVER_WEEK,
+    ROLLOVER_MONTH
+};
+
+// Fires day/week/month rollovers from absolute local-time deadlines.
+//
+// Each period keeps its start and the next deadline (local midnight via
+// mktime, so DST days are 23/25 h long). loop() costs one time() call and
+// two compares until the earliest deadline passes. After a stall or a
+// forward NTP step every missed period is closed in chronological order
+// (up to ROLLOVER_MAX_CATCHUP, then re-anchored); a backward step
+// re-anchors without firing.
+class RolloverScheduler {
+public:
+    // closedStart: start of the period that ended; nextStart: start of the new one
+    typedef void (*Callback)(RolloverEvent event, time_t closedStart, time_t nextStart, void* context);
+    
+    RolloverScheduler();
+    
+    void begin(Callback callback, void* context);
+    void loop();
+    
+    bool isAnchored() const { return _anchored; }
+    time_t getDeadline(RolloverEvent event) const;
+    
+    // Local start of the day / week / month containing t
+    static time_t periodStart(RolloverEvent event, time_t t);
+    
+private:
+    static const int PERIOD_COUNT = 3;   // Day, week, month
+    
+    Callback _callback;
+    void* _context;
+    bool _anchored;
+    
+    time_t _start[PERIOD_COUNT];
+    time_t _deadline[PERIOD_COUNT];
+    time_t _nextDeadline;         // Earliest of _deadline
+    
+    void anchor(time_t now);
+    void updateNextDeadline();
+    static time_t nextPeriodStart(RolloverEvent event, time_t start);
+};
+
+#endif // ROLLOVER_SCHEDULER_H
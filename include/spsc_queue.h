@@ -0,0 +1,69 @@
+// spsc_queue.h
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+// Bounded single-producer / single-consumer ring buffer.
+//
+// Lock-free: exactly one task calls push() and exactly one other task
+// calls pop(). Each index is written by one side only and published with
+// release/acquire ordering, so a slot is never touched by both sides at
+// once. Slots are reused in place, which lets T own heap memory (String):
+// the producer assigns into a free slot and the consumer moves it out.
+// Only std::atomic is used, so the header also builds for host threads.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+    
+    // Producer side; false when full (item is not queued). Always inlined,
+    // so an IRAM interrupt handler can push without calling into flash.
+    __attribute__((always_inline)) bool push(const T& item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        
+        _slots[tail & (N - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side; false when empty
+    bool pop(T& item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        
+        item = std::move(_slots[head & (N - 1)]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Approximate when called from a third task
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+    
+    bool empty() const {
+        return size() == 0;
+    }
+    
+    static size_t capacity() {
+        return N;
+    }
+
+private:
+    T _slots[N];
+    std::atomic<size_t> _head;    // Next slot to read (written by consumer)
+    std::atomic<size_t> _tail;    // Next slot to write (written by producer)
+};
+
+#endif // SPSC_QUEUE_H
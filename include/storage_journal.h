@@ -0,0 +1,78 @@
+// storage_journal.h
+#ifndef STORAGE_JOURNAL_H
+#define STORAGE_JOURNAL_H
+
+#include <Arduino.h>
+#include "flash_wear_monitor.h"
+#include "config.h"
+
+// ==================== STORAGE JOURNAL ====================
+// Small write-ahead journal that makes a group of NVS writes atomic.
+//
+// commit() first writes every staged update as one CRC-protected "jrnl"
+// blob, then applies the updates to their real keys and removes the blob
+// only once every put succeeded. A power cut before the blob is complete
+// leaves the old values (the transaction is discarded). A power cut or a
+// failed put after it leaves a journal that replay() re-applies on the next
+// boot (or the next commit). Replay is bounded by
+// JOURNAL_MAX_ENTRIES / JOURNAL_MAX_BYTES.
+
+class StorageJournal {
+public:
+    StorageJournal();
+    
+    // Stage updates (returns false if the journal is full)
+    bool stageBool(const char* key, bool value);
+    bool stageUChar(const char* key, uint8_t value);
+    bool stageInt(const char* key, int32_t value);
+    bool stageULong(const char* key, uint32_t value);
+    bool stageFloat(const char* key, float value);
+    bool stageString(const char* key, const String& value);
+    bool stageBytes(const char* key, const void* value, size_t len);
+    
+    // Write the journal, apply it and clear it. Returns false if the
+    // journal couldn't be written or an update failed to apply (the journal
+    // is then kept). The caller owns the preferences session (opened
+    // read-write).
+    bool commit(TrackedPreferences& prefs);
+    
+    static const int REPLAY_DAMAGED = -1;   // Damaged journal discarded
+    static const int REPLAY_FAILED = -2;    // Apply failed, journal kept
+    
+    // Re-apply a committed journal left by a power cut or a failed apply.
+    // Returns the number of updates applied, 0 if there was nothing to do,
+    // or one of the REPLAY_* codes above.
+    static int replay(TrackedPreferences& prefs);
+    
+    int getEntryCount() const { return _count; }
+    
+private:
+    enum EntryType : uint8_t {
+        ENTRY_BOOL = 1,
+        ENTRY_UCHAR,
+        ENTRY_INT,
+        ENTRY_ULONG,
+        ENTRY_FLOAT,
+        ENTRY_STRING,
+        ENTRY_BYTES
+    };
+    
+    struct __attribute__((packed)) Header {
+        uint16_t magic;
+        uint8_t count;
+        uint8_t reserved;
+        uint16_t length;          // Bytes of entry data following the header
+        uint16_t crc;             // CRC16 over the entry data
+    };
+    
+    uint8_t _buffer[JOURNAL_MAX_BYTES];
+    size_t _length;
+    uint8_t _count;
+    bool _overflow;
+    
+    bool stage(EntryType type, const char* key, const void* value, size_t len);
+    static bool apply(TrackedPreferences& prefs, const uint8_t* data, size_t length, int& applied);
+    static uint16_t crc16(const uint8_t* data, size_t length);
+};
+
+#endif // STORAGE_JOURNAL_H
@@ -4,6 +4,9 @@
 
 #include <Preferences.h>
 #include <ArduinoJson.h>
+#include "config.h"
+#include "flash_wear_monitor.h"
+#include "storage_journal.h"
 
 enum TankShape {
     RECTANGULAR,
@@ -40,9 +43,55 @@ struct PumpCycle {
 };
 
 struct DailyUsage {
-    unsigned long date;           // Unix timestamp (midnight)
-    float totalUsageLiters;
-    int pumpCycles;
+    unsigned long date = 0;       // Unix timestamp (local midnight)
+    float totalUsageLiters = 0.0;
+    int pumpCycles = 0;
+    int pumpMinutes = 0;
+    float peakInflow = 0.0;       // cm³/sec
+};
+
+// Packed on-flash form of DailyUsage (one slot per day in the daily table)
+struct __attribute__((packed)) DailyRecord {
+    uint16_t day;                 // Local day number since 1970-01-01 (0 = empty/unsynced clock)
+    uint16_t pumpCycles;
+    uint16_t pumpMinutes;
+    uint16_t peakInflow;          // cm³/sec
+    float usageLiters;
+};
+
+// One segmented draw (outflow) event, packed for the event log blob
+struct __attribute__((packed)) DrawEvent {
+    uint32_t start;               // Unix time the draw started
+    uint16_t durationSec;
+    uint16_t volumeDl;            // Deciliters
+    uint16_t peakRateDl;          // Peak outflow, deciliters/minute
+    uint8_t category;             // DrawCategory
+    uint8_t reserved;
+};
+
+// One weekday x hour slot of the demand profile, packed for flash
+struct __attribute__((packed)) ProfileSlot {
+    uint16_t meanDl;              // EWMA liters in this hour, deciliters
+    uint16_t stdDl;               // EWMA standard deviation, deciliters
+    uint8_t weeks;                // Observations so far (saturates at 255)
+};
+
+// Leak detector state, persisted once per night
+struct __attribute__((packed)) LeakState {
+    uint8_t suspectNights = 0;    // Consecutive nights with baseline flow
+    uint8_t alarm = 0;
+    uint16_t reserved = 0;
+    float baselineLpm = 0.0;      // Last night's baseline outflow (L/min)
+};
+
+// Running month-to-date / year-to-date totals, kept next to the daily record
+struct UsageTotals {
+    int year = 0;                 // Calendar year the totals belong to
+    int month = 0;                // 1-12
+    float monthUsageLiters = 0.0;
+    float yearUsageLiters = 0.0;
+    long weekStartDay = 0;        // Local day number the current week started
+    float weekUsageLiters = 0.0;
 };
 
 class StorageManager {
@@ -72,12 +121,34 @@ public:
     // Pump Cycle Logs
     bool savePumpCycle(const PumpCycle& cycle);
     bool getPumpCycles(PumpCycle* cycles, int maxCount, int& actualCount);
+    int getPumpCycleIndex();                        // Ring write position ("cycleIdx")
+    bool getPumpCycle(int cycleIdx, int age, PumpCycle& cycle);   // age 0 = newest before cycleIdx
     
     // Daily Usage
     bool saveDailyUsage(const DailyUsage& usage);
+    bool saveDailyUsage(const DailyUsage& usage, const UsageTotals& totals);
+    bool loadUsageTotals(UsageTotals& totals);
     bool getDailyUsage(unsigned long date, DailyUsage& usage);
     bool getMonthlyUsage(int year, int month, float& totalLiters);
     bool getLast30DaysUsage(DailyUsage* usageArray, int& count);
+    bool getUsageHistory(unsigned long endDate, int days, DailyUsage* usageArray, int& count);
+    bool getUsageDays(long firstDay, int days, DailyUsage* usageArray, int& count);
+    
+    // Draw Event Log (oldest first)
+    bool saveDrawEvents(const DrawEvent* events, int count);
+    bool loadDrawEvents(DrawEvent* events, int maxCount, int& count);
+    
+    // Learned pump delivery rate (L/min, 0 = not learned yet)
+    bool savePumpRate(float litersPerMinute);
+    float loadPumpRate();
+    
+    // Demand Profile (7 x 24 slots, Sunday 00:00 first)
+    bool saveDemandProfile(const ProfileSlot* slots, int count);
+    bool loadDemandProfile(ProfileSlot* slots, int count);
+    
+    // Leak Detector
+    bool saveLeakState(const LeakState& state);
+    bool loadLeakState(LeakState& state);
     
     // Web Authentication
     bool saveWebCredentials(const String& username, const String& password);
@@ -93,16 +164,31 @@ public:
     
     // Factory Reset
     void factoryReset();
-    
+
 private:
-    Preferences preferences;
+    TrackedPreferences preferences;
     static constexpr const char* NAMESPACE = "waterpump";
     
     // Helper functions
     String generateCycleKey(int index);
     String generateDailyKey(unsigned long date);
-    int getCurrentCycleIndex();
-    void incrementCycleIndex();
+    
+    // Daily table ("dayTbl" ring blob + "dayCur" record for the open day).
+    // The table is cached after the first read; it only changes once a day.
+    uint16_t _currentDay;
+    bool _tableMigrated;
+    bool _tableCached;
+    DailyRecord _table[DAILY_TABLE_DAYS];
+    void putDailyRecord(const DailyUsage& usage, StorageJournal& journal);
+    void foldIntoTable(const DailyRecord& record);
+    bool readDailyTable();
+    const DailyRecord* loadDailyTable();
+    bool loadCurrentRecord(DailyRecord& record);
+    void ensureDailyTable();
+    void migrateDailyRecords();
+    void sweepLegacyDailyKeys(unsigned long before);
+    static DailyRecord packDailyUsage(const DailyUsage& usage);
+    static DailyUsage unpackDailyRecord(const DailyRecord& record);
 };
 
 #endif // STORAGE_MANAGER_H
\ No newline at end of file
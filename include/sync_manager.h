@@ -3,7 +3,7 @@
 #define SYNC_MANAGER_H
 
 #include "storage_manager.h"
-#include "iot_client.h"
+#include "cloud_link.h"
 #include <ArduinoJson.h>
 
 enum SyncStatus {
@@ -19,8 +19,10 @@ class SyncManager {
 public:
     SyncManager();
     
-    void begin(StorageManager* storage, IoTClient* iotClient);
-    void loop();
+    void begin(StorageManager* storage, CloudLink* network);
+    
+    // Scheduled every CONFIG_SYNC_INTERVAL_MS
+    void periodicSync();
     
     // Trigger sync operations
     bool syncConfig();
@@ -33,6 +35,9 @@ public:
     // Handle config updates from cloud
     void onCloudConfigReceived(const String& configJson);
     
+    // Outcome of a queued pushConfig() (from NetworkWorker::dispatch on the device)
+    void onPushComplete(bool success);
+    
     // Get sync status
     SyncStatus getStatus();
     String getStatusString();
@@ -48,11 +53,10 @@ public:
     
 private:
     StorageManager* _storage;
-    IoTClient* _iotClient;
+    CloudLink* _network;
     
     SyncStatus _status;
     unsigned long _lastSyncTime;
-    unsigned long _lastSyncAttempt;
     
     TankConfig _localConfig;
     TankConfig _cloudConfig;
@@ -0,0 +1,73 @@
+// system_snapshot.h
+#ifndef SYSTEM_SNAPSHOT_H
+#define SYSTEM_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+#include "mpsc_queue.h"
+
+// Control-loop state as seen by other tasks (web server)
+struct SystemSnapshot {
+    unsigned long timestamp;      // millis() at publish
+    float waterLevel;
+    float currentInflow;
+    float maxInflow;
+    bool motorState;
+    uint8_t mode;                 // PumpMode
+    bool dryRunAlarm;
+    bool overflowAlarm;
+    bool leakAlarm;
+    float dailyUsage;
+    float weeklyUsage;
+    float monthlyUsage;
+    int todayCycles;
+    float pumpRate;               // L/min while filling
+};
+
+// Single-writer, many-reader snapshot (double-buffered seqlock).
+//
+// publish() fills the slot readers are not pointed at, then flips the
+// index, so a reader never waits on a write in progress - even when it
+// preempts the writer on the same core. Each slot also has a sequence
+// (odd while being written); a reader that is lapped by two publishes
+// sees it change and retries, so a torn copy is never returned. The slot
+// is held as 32-bit atomic words (release stores, acquire loads) rather
+// than a plain struct, so a racing copy is defined behaviour and the
+// ordering needs no fences; on the ESP32 these are plain loads and
+// stores with a barrier.
+class SnapshotBuffer {
+public:
+    SnapshotBuffer();
+    
+    // Control loop only
+    void publish(const SystemSnapshot& snapshot);
+    
+    // Any task; false before the first publish or if lapped on every retry
+    bool read(SystemSnapshot& snapshot) const;
+
+private:
+    static const size_t WORDS = (sizeof(SystemSnapshot) + 3) / 4;
+    
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        std::atomic<uint32_t> words[WORDS];
+    };
+    
+    Slot _slots[2];
+    std::atomic<uint8_t> _current;    // Slot readers use
+};
+
+// Actuations requested from other tasks; applied by the control loop
+enum ControlCommandType : uint8_t {
+    CMD_PUMP_ON,
+    CMD_PUMP_OFF
+};
+
+struct ControlCommand {
+    ControlCommandType type;
+};
+
+typedef MpscQueue<ControlCommand, CONTROL_QUEUE_SIZE> ControlQueue;
+
+#endif // SYSTEM_SNAPSHOT_H
@@ -0,0 +1,93 @@
+// task_scheduler.h
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+typedef void (*TaskCallback)(void* context);
+#if SCHEDULER_MAX_TASKS > 127
+typedef int16_t TaskId;           // -1 = invalid
+#else
+typedef int8_t TaskId;            // -1 = invalid
+#endif
+
+enum TaskPriority : uint8_t {
+    TASK_PRIORITY_LOW = 0,
+    TASK_PRIORITY_NORMAL = 1,
+    TASK_PRIORITY_HIGH = 2
+};
+
+// Cooperative scheduler on a hierarchical timer wheel.
+//
+// Four levels of 64 slots at SCHEDULER_TICK_MS resolution cover ~46 h;
+// longer delays park in the top level and are re-cascaded. Time is the
+// 64-bit esp_timer clock, so nothing wraps. run() is a single clock read
+// and compare while no tick has elapsed. Tasks due in the same pass run
+// highest priority first; periodic tasks are re-armed from their previous
+// deadline (no drift) and coalesce runs missed during a stall.
+class TaskScheduler {
+public:
+    TaskScheduler();
+    
+    TaskId addPeriodic(const char* name, uint32_t periodMs, TaskCallback callback, void* context = nullptr,
+                       TaskPriority priority = TASK_PRIORITY_NORMAL, uint32_t initialDelayMs = 0);
+    TaskId addOneShot(const char* name, uint32_t delayMs, TaskCallback callback, void* context = nullptr,
+                      TaskPriority priority = TASK_PRIORITY_NORMAL);
+    bool cancel(TaskId id);
+    bool reschedule(TaskId id, uint32_t delayMs);
+    
+    // Call from loop()
+    void run();
+    
+    // Monotonic milliseconds since boot (64-bit, no wrap)
+    static uint64_t nowMs();
+    
+    int getTaskCount();
+    void buildReport(JsonDocument& doc);
+    
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int SLOT_MASK = SLOTS - 1;
+    
+    struct Task {
+        TaskCallback callback;
+        void* context;
+        const char* name;
+        uint64_t expiry;          // Absolute tick
+        uint32_t periodTicks;     // 0 = one-shot
+        TaskPriority priority;
+        bool active;
+        int8_t level;             // Wheel level while linked, -1 otherwise
+        int8_t slot;
+        TaskId next;
+        TaskId prev;
+        
+        // Runtime accounting
+        uint32_t runs;
+        uint32_t skipped;         // Periodic runs coalesced after a stall
+        uint64_t totalUs;
+        uint32_t maxUs;
+        uint32_t maxLateMs;
+    };
+    
+    Task _tasks[SCHEDULER_MAX_TASKS];
+    TaskId _wheel[LEVELS][SLOTS];
+    int _levelCount[LEVELS];
+    uint64_t _currentTick;
+    int _pending;                 // Tasks linked into the wheel
+    
+    TaskId addTask(const char* name, uint32_t delayMs, uint32_t periodMs, TaskCallback callback,
+                   void* context, TaskPriority priority);
+    void link(TaskId id);
+    void unlink(TaskId id);
+    void cascade(int level);
+    void collect(TaskId* ready, int& readyCount);
+    void execute(TaskId id);
+    static uint64_t msToTicks(uint32_t ms);
+};
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,188 @@
+// trace_recorder.h
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include "storage_manager.h"
+#include "event_bus.h"
+#include "config.h"
+
+// ==================== INPUT TRACE ====================
+// Compact record of everything the control loop is fed from outside
+// (sensor readings, pump commands, button presses, config changes) plus
+// the pump state it produced, so a field problem can be replayed on the
+// host (see host/src/trace_replay.cpp) and the outputs compared.
+//
+// Record: varint ms since the previous record, type byte, payload.
+// A sensor reading is a zigzag varint of the change in mm, so a steady
+// tank costs about 4 bytes per reading. Records go to a RAM buffer and
+// are appended to SPIFFS segment files (/trace0.bin ...) on flush();
+// every segment starts with a SYNC keyframe, so each one decodes on its
+// own and the oldest can simply be overwritten.
+//
+// Export / download format: per segment, oldest first, a frame of
+// "SWPT" + uint32 length + the segment's records.
+
+enum TraceRecordType : uint8_t {
+    TRACE_END = 0,                // Padding / end of segment
+    TRACE_SYNC,                   // Keyframe: absolute millis, epoch, sequence, pump mode
+    TRACE_CONFIG,                 // Tank geometry and thresholds
+    TRACE_SENSOR,                 // Distance reading
+    TRACE_SENSOR_FAIL,            // Reading failed (timeout / out of range)
+    TRACE_COMMAND,                // Pump command (PumpCommand, CommandSource)
+    TRACE_BUTTON,                 // Raw ButtonEvent
+    TRACE_PUMP                    // Output: motor, mode and alarms after a change
+};
+
+struct TraceConfig {
+    uint8_t shape;
+    float tankHeight;
+    float tankLength;
+    float tankWidth;
+    float tankRadius;
+    float upperThreshold;
+    float lowerThreshold;
+};
+
+struct TraceRecord {
+    TraceRecordType type;
+    unsigned long timestamp;      // millis() when recorded
+    
+    // SYNC
+    uint32_t sequence;
+    uint32_t epoch;
+    bool boot;                    // First segment after a reset (millis restarted)
+    
+    uint8_t mode;                 // SYNC, PUMP
+    bool motorState;              // SYNC, PUMP
+    bool dryRunAlarm;             // PUMP
+    bool overflowAlarm;           // PUMP
+    
+    float distance;               // SENSOR, cm
+    uint8_t command;              // COMMAND
+    uint8_t source;               // COMMAND
+    uint8_t button;               // BUTTON
+    TraceConfig config;           // CONFIG
+};
+
+// Decodes an export stream (or a single segment with framed = false)
+class TraceReader {
+public:
+    TraceReader(const uint8_t* data, size_t length, bool framed = true);
+    
+    // False at the end of the data
+    bool next(TraceRecord& record);
+    
+    int getDamagedSegments() const { return _damaged; }
+
+private:
+    const uint8_t* _data;
+    size_t _length;
+    size_t _pos;
+    size_t _segmentEnd;
+    bool _framed;
+    bool _inSegment;
+    int _damaged;
+    
+    unsigned long _time;
+    int32_t _distanceMm;
+    
+    bool readVarint(uint32_t& value);
+    bool readBytes(void* out, size_t len);
+    bool decode(TraceRecord& record);
+};
+
+class TraceRecorder {
+public:
+    TraceRecorder();
+    
+    // Mounts SPIFFS and starts a new segment after the newest one
+    bool begin();
+    
+    // Inputs
+    void recordConfig(const TankConfig& config);
+    void recordSensor(float distance);          // < 0 = failed reading
+    void recordCommand(uint8_t command, uint8_t source);
+    void recordButton(uint8_t event);
+    
+    // Output
+    void recordPump(const PumpEvent& evt);
+    
+    // Append the buffer to the current segment (scheduled, and when full)
+    void flush();
+    
+    bool isEnabled() const { return _enabled; }
+    uint32_t getRecordCount() const { return _records; }
+    uint32_t getByteCount() const { return _bytes + _length; }
+    uint32_t getFlushCount() const { return _flushes; }
+    
+    // Counters for /api/diagnostics/trace
+    void buildReport(JsonDocument& doc);
+
+private:
+    bool _enabled;
+    uint8_t _buffer[TRACE_BUFFER_SIZE];
+    size_t _length;
+    
+    int _segment;
+    uint32_t _sequence;
+    size_t _segmentBytes;         // Flushed to the current segment
+    bool _bootSegment;
+    
+    // Delta bases (reset at every keyframe)
+    unsigned long _lastTime;
+    int32_t _lastDistanceMm;
+    
+    // Keyframe state
+    TraceConfig _config;
+    bool _haveConfig;
+    uint8_t _mode;
+    bool _motorState;
+    
+    // Statistics
+    uint32_t _records;
+    uint32_t _bytes;
+    uint32_t _flushes;
+    uint32_t _flushErrors;
+    uint32_t _maxFlushUs;
+    
+    void startSegment();
+    void writeSync();
+    void writeConfig();
+    bool reserve(size_t recordBytes);
+    void beginRecord(TraceRecordType type);
+    void putVarint(uint32_t value);
+    void putBytes(const void* data, size_t len);
+    
+    static uint32_t readSequence(int segment, bool& valid);
+    
+    friend class TraceExporter;
+    static void segmentPath(int segment, char* path, size_t size);
+};
+
+// Streams the segments oldest first for the download endpoint (same
+// pattern as HistoryExporter). Records still in the RAM buffer are not
+// included; they reach flash within TRACE_FLUSH_INTERVAL_MS.
+class TraceExporter {
+public:
+    TraceExporter();
+    
+    // Copy as many bytes as fit into buffer; returns 0 when done
+    size_t read(uint8_t* buffer, size_t maxLen);
+
+private:
+    int _order[TRACE_SEGMENT_COUNT];
+    int _count;
+    int _next;
+    
+    File _file;
+    uint8_t _header[8];
+    size_t _headerPos;
+    size_t _remaining;            // Bytes of the current frame still to send
+    
+    bool openNext();
+};
+
+#endif // TRACE_RECORDER_H
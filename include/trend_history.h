@@ -0,0 +1,66 @@
+// trend_history.h
+#ifndef TREND_HISTORY_H
+#define TREND_HISTORY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "event_bus.h"
+
+class WaterTracker;
+
+#define TREND_INTERVAL_MS ((unsigned long)TREND_HOURS * 3600000UL / TREND_POINTS)
+
+// Fixed-size history for the OLED trend screens. Level and inflow are
+// averaged over TREND_INTERVAL_MS and kept in a ring of TREND_POINTS
+// (0.1 resolution), so plotting cost does not depend on the reading
+// rate. Intervals without a reading (sensor failures) repeat the previous
+// point. The usage chart keeps the closed days before today, re-read from
+// the tracker when the local day changes.
+class TrendHistory {
+public:
+    TrendHistory();
+    
+    // EventBus subscriber (context = TrendHistory*)
+    static void onLevel(const LevelEvent& evt, void* context);
+    void addSample(float level, float inflow);
+    
+    // Scheduled with the tracker: reloads closed days on a new local day
+    void updateDays(WaterTracker* tracker);
+    
+    // Closed days, oldest first, ending yesterday (up to TREND_DAYS - 1)
+    void setDays(const float* liters, int count);
+    
+    // Points, oldest first
+    int getPointCount() const { return _count; }
+    float getLevel(int index) const;
+    float getInflow(int index) const;
+    
+    // Closed day i of TREND_DAYS - 1, oldest first (0 = no record)
+    float getDay(int index) const;
+    
+    // Changes whenever a point or a day is added
+    uint32_t getVersion() const { return _version; }
+
+private:
+    int16_t _level[TREND_POINTS];       // % x 10
+    int16_t _inflow[TREND_POINTS];      // x 10
+    int _head;                          // Next slot
+    int _count;
+    
+    // Interval being averaged
+    unsigned long _intervalStart;
+    float _levelSum;
+    float _inflowSum;
+    int _samples;
+    bool _started;
+    
+    float _days[TREND_DAYS - 1];
+    long _dayNumber;                    // Local day the days were loaded for
+    
+    uint32_t _version;
+    
+    void closeInterval();
+    void push(int16_t level, int16_t inflow);
+};
+
+#endif // TREND_HISTORY_H
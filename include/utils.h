@@ -26,6 +26,11 @@ public:
     // Get midnight timestamp for today
     static unsigned long getTodayMidnight();
     
+    // Local calendar day number (days since 1970-01-01 in local time)
+    static long localDayNumber(unsigned long timestamp);
+    static long daysFromCivil(int year, int month, int day);
+    static unsigned long dayNumberToTimestamp(long dayNumber);
+    
     // Time synchronization (NTP)
     static bool syncTimeNTP(const char* ntpServer = "pool.ntp.org");
     static bool isTimeSynced();
@@ -4,6 +4,10 @@
 
 #include "storage_manager.h"
 #include "tank_calculator.h"
+#include "draw_event_segmenter.h"
+#include "leak_detector.h"
+#include "demand_profile.h"
+#include "rollover_scheduler.h"
 #include <time.h>
 
 struct UsageSnapshot {
@@ -18,6 +22,8 @@ public:
     WaterTracker();
     
     void begin(StorageManager* storage, TankCalculator* calculator);
+    
+    // Scheduled every TRACKER_UPDATE_INTERVAL_MS: rollovers, demand profile
     void loop();
     
     // Update current state
@@ -25,15 +31,32 @@ public:
     
     // Get usage statistics
     float getTodayUsage();        // Liters used today
+    float getWeekUsage();         // Liters used this week
     float getMonthUsage();        // Liters used this month
+    float getYearUsage();         // Liters used this year
     int getTodayCycles();         // Pump on/off cycles today
+    float getPumpRate();          // Learned pump delivery (L/min, 0 = unknown)
     
     // Get historical data
     bool getLast30Days(DailyUsage* usageArray, int& count);
     
-    // Reset daily counter (called at midnight)
+    // Per-event consumption (segmented draws)
+    void buildDrawEventReport(JsonDocument& doc);
+    
+    // Weekday x hour demand profile
+    const DemandProfile* getDemandProfile();
+    void buildProfileReport(JsonDocument& doc);
+    
+    // Leak detection (night-time baseline flow)
+    bool isLeakAlarm();
+    void buildLeakReport(JsonDocument& doc);
+    
+    // Close today now (rollovers normally do this at the day deadline)
     void resetDaily();
     
+    // Save usage counted since the last coalesced save (before a restart)
+    void flush();
+    
     // Manual reset
     void resetAll();
     
@@ -47,20 +70,57 @@ private:
     bool _currentPumpState;
     bool _previousPumpState;
     unsigned long _lastUpdateTime;
-    unsigned long _lastMidnightCheck;
     
     // Daily accumulation
     float _todayUsageLiters;
     int _todayCycles;
+    unsigned long _todayPumpMs;
+    float _todayPeakInflow;
     unsigned long _todayStartTimestamp;
+    bool _usageDirty;             // Usage not saved yet (saves are coalesced)
+    unsigned long _lastUsageSaveMs;
+    bool _todayPending;           // Booted before clock sync, stored day not loaded yet
+    
+    // Pump delivery model (consumption while pumping)
+    float _pumpRate;              // Learned delivery rate, L/min
+    float _savedPumpRate;
+    bool _pumpRateProvisional;    // First fill still running, rate is its mean so far
+    unsigned long _pumpStartMs;
+    unsigned long _pumpRefMs;     // Start of the current accounting window
+    float _pumpRefVolume;
+    float _pumpShortfall;         // Expected minus observed rise not yet booked, L
+    unsigned long _fillRefMs;     // End of the spin-up window (rate learning)
+    float _fillRefVolume;
+    float _fillDrawn;             // Booked since _fillRefMs
+    
+    // Idle draw detection reference (level %, moves outside the deadband)
+    float _idleRefLevel;
+    bool _idleRefValid;
+    
+    // Week/month/year-to-date totals (updated incrementally)
+    UsageTotals _totals;
+    RolloverScheduler _rollover;
+    
+    // Draw event segmentation
+    DrawEventSegmenter _draws;
+    LeakDetector _leak;
+    DemandProfile _profile;
     
     // Snapshot for change detection
     UsageSnapshot _lastSnapshot;
     
     // Helper functions
+    void addUsage(float liters);
+    float accountPumping(float volume, unsigned long now, bool pumpStopped);
+    void learnPumpRate(float observedRate);
+    void savePumpRate();
     void detectUsage();
     void saveDailyData();
-    bool isMidnight();
+    static void onRollover(RolloverEvent event, time_t closedStart, time_t nextStart, void* context);
+    void rebaseToday(unsigned long dayStart);
+    void closeDay(unsigned long nextDayStart);
+    void seedTotals();
+    void rollTotals();
     unsigned long getMidnightTimestamp();
     unsigned long getCurrentTimestamp();
 };
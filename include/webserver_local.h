@@ -10,17 +10,32 @@
 #include "tank_calculator.h"
 #include "pump_controller.h"
 #include "water_tracker.h"
+#include "history_exporter.h"
+#include "task_scheduler.h"
+#include "event_bus.h"
+#include "loop_profiler.h"
+#include "system_snapshot.h"
+#include "trace_recorder.h"
 
 class WebServerLocal {
 public:
     WebServerLocal();
     
-    // Initialize web server (returns false if WiFi not available)
-    bool begin(StorageManager* storage, TankCalculator* calculator, 
-               PumpController* pump, WaterTracker* tracker);
+    // Initialize web server (returns false if WiFi not available).
+    // Live values come from the snapshot; pump requests go through the
+    // command queue and are applied by the control loop.
+    bool begin(TankCalculator* calculator, WaterTracker* tracker,
+               const SnapshotBuffer* snapshot, ControlQueue* commands);
     
-    // Update with current system data
-    void updateData(float waterLevel, float currentInflow, float maxInflow);
+    // Optional: expose scheduler statistics at /api/diagnostics/tasks
+    void setScheduler(TaskScheduler* scheduler);
+    
+    // Optional: expose event bus counters at /api/diagnostics/events
+    void setEventBus(EventBus* bus);
+    
+    // Optional: expose the input trace at /api/trace and its counters at
+    // /api/diagnostics/trace
+    void setTraceRecorder(TraceRecorder* trace);
     
     // Check if server is running
     bool isRunning();
@@ -30,18 +45,17 @@ public:
     
 private:
     AsyncWebServer* _server;
-    StorageManager* _storage;
+    StorageManager _storage;   // Own NVS handle; handlers run on the AsyncTCP task
     TankCalculator* _calculator;
-    PumpController* _pump;
     WaterTracker* _tracker;
+    const SnapshotBuffer* _snapshot;
+    ControlQueue* _commands;
+    TaskScheduler* _scheduler;
+    EventBus* _eventBus;
+    TraceRecorder* _trace;
     
     bool _isRunning;
     
-    // Current data
-    float _waterLevel;
-    float _currentInflow;
-    float _maxInflow;
-    
     // Route handlers
     void setupRoutes();
     void handleRoot(AsyncWebServerRequest* request);
@@ -56,6 +70,19 @@ private:
     void handleWiFiConnect(AsyncWebServerRequest* request);
     void handleSetup(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
     void handleUsageStats(AsyncWebServerRequest* request);
+    void handleUsageEvents(AsyncWebServerRequest* request);
+    void handleUsageProfile(AsyncWebServerRequest* request);
+    void handleStorageDiagnostics(AsyncWebServerRequest* request);
+    void handleTaskDiagnostics(AsyncWebServerRequest* request);
+    void handlePerfDiagnostics(AsyncWebServerRequest* request);
+    void handleEventDiagnostics(AsyncWebServerRequest* request);
+    void handleTraceDiagnostics(AsyncWebServerRequest* request);
+    void handleTraceDownload(AsyncWebServerRequest* request);
+    #if ENABLE_FAULT_INJECTION
+    void handleFaults(AsyncWebServerRequest* request);
+    #endif
+    void handleExport(AsyncWebServerRequest* request, ExportKind kind);
+    void queuePumpCommand(AsyncWebServerRequest* request, ControlCommandType type);
     
     // Authentication
     bool checkAuth(AsyncWebServerRequest* request);
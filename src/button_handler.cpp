@@ -1,51 +1,126 @@
 // button_handler.cpp
 #include "button_handler.h"
-#include "config.h"
 #include "pins.h"
 
+// What each button produces
+struct ButtonConfig {
+    uint8_t pin;
+    ButtonEvent click;
+    ButtonEvent longPress;        // BTN_NONE = none
+    ButtonEvent doubleClick;      // BTN_NONE = click without waiting
+    bool repeat;                  // Click on press, repeat while held
+};
+
+#if BUTTON_DOUBLE_CLICK_ENABLED
+#define LEFT_DOUBLE_CLICK BTN_LEFT_DOUBLE_CLICK
+#else
+#define LEFT_DOUBLE_CLICK BTN_NONE
+#endif
+
+// Flash (read from loop() only; the interrupt gets its pin from ButtonPin)
+static const ButtonConfig BUTTONS[BUTTON_COUNT] = {
+    { BTN_TOP, BTN_TOP_PRESS, BTN_NONE, BTN_NONE, BUTTON_AUTO_REPEAT_ENABLED },
+    { BTN_MID, BTN_MID_PRESS, BTN_MID_LONG_PRESS, BTN_NONE, false },
+    { BTN_BOTTOM, BTN_BOTTOM_PRESS, BTN_NONE, BTN_NONE, BUTTON_AUTO_REPEAT_ENABLED },
+    { BTN_LEFT, BTN_LEFT_PRESS, BTN_NONE, LEFT_DOUBLE_CLICK, false },
+    { BTN_RIGHT, BTN_RIGHT_PRESS, BTN_NONE, BTN_NONE, false },
+    { MANUAL_SWITCH_PIN, BTN_MANUAL_SWITCH_TOGGLE, BTN_MANUAL_SWITCH_LONG_PRESS, BTN_NONE, false }
+};
+
+static const int MANUAL_BUTTON = 5;          // Index of the manual switch in BUTTONS
+
+static const uint32_t DEBOUNCE_US = BUTTON_DEBOUNCE_MS * 1000UL;
+static const uint32_t LONG_PRESS_US = BUTTON_LONG_PRESS_MS * 1000UL;
+static const uint32_t DOUBLE_CLICK_US = BUTTON_DOUBLE_CLICK_MS * 1000UL;
+
+// Wrap-safe "a is at or after b" for micros() timestamps
+static bool reached(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) >= 0;
+}
+
+// Repeat interval after `repeats` repeats, in us
+static uint32_t repeatInterval(uint16_t repeats) {
+    int32_t ms = BUTTON_REPEAT_INTERVAL_MS - (int32_t)repeats * BUTTON_REPEAT_ACCEL_MS;
+    return (uint32_t)max(ms, (int32_t)BUTTON_REPEAT_MIN_MS) * 1000UL;
+}
+
 ButtonHandler::ButtonHandler() 
-    : _lastEvent(BTN_NONE), _eventAvailable(false) {
+    : _droppedEdges(0), _seenDroppedEdges(0), _droppedEvents(0) {
+    memset(_buttons, 0, sizeof(_buttons));
 }
 
 void ButtonHandler::begin() {
-    // Initialize all button pins with internal pull-up
-    pinMode(BTN_TOP, INPUT_PULLUP);
-    pinMode(BTN_MID, INPUT_PULLUP);
-    pinMode(BTN_BOTTOM, INPUT_PULLUP);
-    pinMode(BTN_LEFT, INPUT_PULLUP);
-    pinMode(BTN_RIGHT, INPUT_PULLUP);
-    pinMode(MANUAL_SWITCH_PIN, INPUT_PULLUP);
-    
-    // Initialize button states
-    _btnTop = {false, false, 0, 0, false};
-    _btnMid = {false, false, 0, 0, false};
-    _btnBottom = {false, false, 0, 0, false};
-    _btnLeft = {false, false, 0, 0, false};
-    _btnRight = {false, false, 0, 0, false};
-    _btnManual = {false, false, 0, 0, false};
+    uint32_t now = micros();
+    
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        // Internal pull-up, active low
+        pinMode(BUTTONS[i].pin, INPUT_PULLUP);
+        
+        // A button held at boot counts as pressed, without an event
+        ButtonState& btn = _buttons[i];
+        memset(&btn, 0, sizeof(btn));
+        btn.raw = isPressed(BUTTONS[i].pin);
+        btn.rawSinceUs = now;
+        btn.pressed = btn.raw;
+        btn.pressedUs = now;
+        btn.handled = btn.raw;
+        
+        _pins[i].handler = this;
+        _pins[i].button = i;
+        _pins[i].pin = BUTTONS[i].pin;
+        attachInterruptArg(digitalPinToInterrupt(BUTTONS[i].pin), onEdge, &_pins[i], CHANGE);
+    }
     
     #if ENABLE_SERIAL_DEBUG
     Serial.println("Button handler initialized");
     #endif
 }
 
+// GPIO interrupt, any edge; bounce produces bursts of these. Runs from
+// IRAM while flash may be busy (NVS writes), so it only touches DRAM
+// (this object, the ButtonPin argument) and inlined code: SpscQueue::push
+// is always_inline, micros() and digitalRead() are IRAM functions.
+void IRAM_ATTR ButtonHandler::onEdge(void* arg) {
+    ButtonPin* pin = static_cast<ButtonPin*>(arg);
+    ButtonHandler* handler = pin->handler;
+    
+    ButtonEdge edge;
+    edge.timeUs = micros();
+    edge.button = pin->button;
+    edge.pressed = digitalRead(pin->pin) == LOW;
+    if (!handler->_edges.push(edge)) {
+        handler->_droppedEdges.store(handler->_droppedEdges.load(std::memory_order_relaxed) + 1,
+                                     std::memory_order_relaxed);
+    }
+}
+
 void ButtonHandler::loop() {
-    // Update all buttons
-    updateButton(_btnTop, BTN_TOP, BTN_TOP_PRESS);
-    updateButton(_btnMid, BTN_MID, BTN_MID_PRESS, BTN_MID_LONG_PRESS);
-    updateButton(_btnBottom, BTN_BOTTOM, BTN_BOTTOM_PRESS);
-    updateButton(_btnLeft, BTN_LEFT, BTN_LEFT_PRESS);
-    updateButton(_btnRight, BTN_RIGHT, BTN_RIGHT_PRESS);
-    updateButton(_btnManual, MANUAL_SWITCH_PIN, BTN_MANUAL_SWITCH_TOGGLE, BTN_MANUAL_SWITCH_LONG_PRESS);
+    // Edges in the order they happened
+    ButtonEdge edge;
+    while (_edges.pop(edge)) {
+        applyEdge(edge.button, edge.pressed, edge.timeUs);
+    }
+    
+    uint32_t now = micros();
+    
+    // The ring overflowed: whatever came after is only known from the pins
+    uint32_t dropped = getDroppedEdges();
+    if (dropped != _seenDroppedEdges) {
+        _seenDroppedEdges = dropped;
+        for (int i = 0; i < BUTTON_COUNT; i++) {
+            applyEdge(i, isPressed(BUTTONS[i].pin), now);
+        }
+    }
+    
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        settle(i, now);
+        runTimers(i, now);
+    }
 }
 
 ButtonEvent ButtonHandler::getEvent() {
-    if (_eventAvailable) {
-        _eventAvailable = false;
-        ButtonEvent event = _lastEvent;
-        _lastEvent = BTN_NONE;
-        return event;
-    }
+    ButtonEvent event;
+    if (_events.pop(event)) return event;
     return BTN_NONE;
 }
 
@@ -54,73 +129,108 @@ bool ButtonHandler::isPressed(uint8_t pin) {
 }
 
 bool ButtonHandler::getManualSwitchState() {
-    return _btnManual.currentState;
+    return _buttons[MANUAL_BUTTON].pressed;
 }
 
 void ButtonHandler::resetLongPress() {
-    _btnMid.longPressTriggered = false;
-    _btnManual.longPressTriggered = false;
+    uint32_t now = micros();
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        if (!_buttons[i].pressed || BUTTONS[i].longPress == BTN_NONE) continue;
+        _buttons[i].pressedUs = now;
+        _buttons[i].handled = false;
+    }
 }
 
-void ButtonHandler::updateButton(ButtonState& btn, uint8_t pin, ButtonEvent shortEvent, ButtonEvent longEvent) {
-    bool reading = readDebounced(btn, pin);
+void ButtonHandler::applyEdge(int button, bool pressed, uint32_t timeUs) {
+    ButtonState& btn = _buttons[button];
     
-    // Detect press (transition from released to pressed)
-    if (reading && !btn.lastState) {
-        btn.pressStartTime = millis();
-        btn.longPressTriggered = false;
-    }
+    // The level before this edge may have lasted long enough to count
+    settle(button, timeUs);
+    runTimers(button, timeUs);
     
-    // Detect release (transition from pressed to released)
-    if (!reading && btn.lastState) {
-        unsigned long pressDuration = millis() - btn.pressStartTime;
-        
-        // Only trigger short press if long press wasn't already triggered
-        if (!btn.longPressTriggered && pressDuration < BUTTON_LONG_PRESS_MS) {
-            _lastEvent = shortEvent;
-            _eventAvailable = true;
-            
-            #if ENABLE_SERIAL_DEBUG
-            Serial.print("Button event: ");
-            Serial.println(shortEvent);
-            #endif
-        }
-        
-        btn.longPressTriggered = false;
-    }
+    if (pressed == btn.raw) return;   // Missed the edge in between, or a repeat
+    btn.raw = pressed;
+    btn.rawSinceUs = timeUs;
+}
+
+// Accepts the raw level once it has been stable for the debounce time
+void ButtonHandler::settle(int button, uint32_t nowUs) {
+    ButtonState& btn = _buttons[button];
+    if (btn.raw == btn.pressed || !reached(nowUs, btn.rawSinceUs + DEBOUNCE_US)) return;
     
-    // Check for long press while button is held
-    if (reading && !btn.longPressTriggered && longEvent != BTN_NONE) {
-        unsigned long pressDuration = millis() - btn.pressStartTime;
+    uint32_t at = btn.rawSinceUs + DEBOUNCE_US;
+    runTimers(button, at);
+    change(button, at);
+}
+
+// Debounced press or release at timeUs
+void ButtonHandler::change(int button, uint32_t timeUs) {
+    const ButtonConfig& config = BUTTONS[button];
+    ButtonState& btn = _buttons[button];
+    btn.pressed = btn.raw;
+    
+    if (btn.pressed) {
+        btn.pressedUs = timeUs;
+        btn.handled = false;
         
-        if (pressDuration >= BUTTON_LONG_PRESS_MS) {
-            btn.longPressTriggered = true;
-            _lastEvent = longEvent;
-            _eventAvailable = true;
-            
-            #if ENABLE_SERIAL_DEBUG
-            Serial.print("Long press event: ");
-            Serial.println(longEvent);
-            #endif
+        if (btn.clickPending) {
+            // Second press inside the window (runTimers closed expired ones)
+            btn.clickPending = false;
+            btn.handled = true;
+            emit(config.doubleClick);
+        } else if (config.repeat) {
+            btn.handled = true;
+            btn.repeats = 0;
+            btn.nextRepeatUs = timeUs + BUTTON_REPEAT_DELAY_MS * 1000UL;
+            emit(config.click);
         }
+        return;
     }
     
-    btn.lastState = reading;
-    btn.currentState = reading;
+    // Release: a click unless the press already counted or was too long
+    if (btn.handled || reached(timeUs, btn.pressedUs + LONG_PRESS_US)) return;
+    
+    if (config.doubleClick != BTN_NONE) {
+        btn.clickPending = true;
+        btn.releasedUs = timeUs;
+    } else {
+        emit(config.click);
+    }
 }
 
-bool ButtonHandler::readDebounced(ButtonState& btn, uint8_t pin) {
-    bool reading = isPressed(pin);
+// Time-driven gestures up to nowUs: double-click window, long press, repeat
+void ButtonHandler::runTimers(int button, uint32_t nowUs) {
+    const ButtonConfig& config = BUTTONS[button];
+    ButtonState& btn = _buttons[button];
     
-    // If the reading has changed, reset debounce timer
-    if (reading != btn.lastState) {
-        btn.lastDebounceTime = millis();
+    if (btn.clickPending && reached(nowUs, btn.releasedUs + DOUBLE_CLICK_US)) {
+        btn.clickPending = false;
+        emit(config.click);
     }
     
-    // Only return stable reading after debounce time
-    if ((millis() - btn.lastDebounceTime) > BUTTON_DEBOUNCE_MS) {
-        return reading;
+    if (!btn.pressed) return;
+    
+    if (!btn.handled && config.longPress != BTN_NONE && reached(nowUs, btn.pressedUs + LONG_PRESS_US)) {
+        btn.handled = true;
+        emit(config.longPress);
     }
     
-    return btn.currentState; // Return previous stable state
-}
\ No newline at end of file
+    // Not after the contact opened (the release is still being debounced);
+    // one repeat per pass at most, so a stalled loop() skips repeats
+    // rather than delivering a burst
+    if (config.repeat && btn.raw && reached(nowUs, btn.nextRepeatUs)) {
+        emit(config.click);
+        btn.nextRepeatUs += repeatInterval(btn.repeats);
+        if (btn.repeats < UINT16_MAX) btn.repeats++;
+        if (reached(nowUs, btn.nextRepeatUs)) btn.nextRepeatUs = nowUs + repeatInterval(btn.repeats);
+    }
+}
+
+void ButtonHandler::emit(ButtonEvent event) {
+    if (!_events.push(event)) _droppedEvents++;
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Button event: ");
+    Serial.println(event);
+    #endif
+}
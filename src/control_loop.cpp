@@ -0,0 +1,217 @@
+// control_loop.cpp
+#include "control_loop.h"
+
+ControlLoop::ControlLoop(UltrasonicSensor* sensor, TankCalculator* calculator, PumpController* pump,
+                         WaterTracker* tracker, StorageManager* storage, EventBus* bus)
+    : _sensor(sensor),
+      _calculator(calculator),
+      _pump(pump),
+      _tracker(tracker),
+      _storage(storage),
+      _bus(bus),
+      _trace(nullptr),
+      _level(0),
+      _previousLevel(0),
+      _inflow(0),
+      _maxInflow(0),
+      _lastSensorRead(0),
+      _lastSavedChange(0),
+      _pumpPublished(false) {
+}
+
+void ControlLoop::begin(const TankConfig& config) {
+    _config = config;
+    if (_trace) _trace->recordConfig(config);
+    
+    // Pump control first, so the tracker sees the resulting pump change
+    // in the same dispatch
+    _bus->subscribe<LevelEvent>(onLevelControl, this);
+    _bus->subscribe<LevelEvent>(onLevelTracker, this);
+    _bus->subscribe<PumpEvent>(onPumpTracker, this);
+}
+
+void ControlLoop::setTrace(TraceRecorder* trace) {
+    _trace = trace;
+}
+
+void ControlLoop::setConfig(const TankConfig& config) {
+    _config = config;
+    if (_trace) _trace->recordConfig(config);
+}
+
+bool ControlLoop::readSensor() {
+    float distance = _sensor->getAverageDistance(3);
+    
+    // Millimetre resolution (the sensor is good to ~3 mm), so a trace
+    // holds exactly the value the loop acted on
+    if (distance >= 0) distance = lroundf(distance * 10.0f) / 10.0f;
+    if (_trace) _trace->recordSensor(distance);
+    return applyReading(distance);
+}
+
+bool ControlLoop::applyReading(float distance) {
+    if (distance < 0) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("Sensor read error");
+        #endif
+        return false;
+    }
+    
+    unsigned long now = millis();
+    
+    // Update water level
+    _previousLevel = _level;
+    _level = _calculator->distanceToLevel(distance);
+    
+    // Inflow over the interval since the previous good reading
+    _inflow = (_lastSensorRead > 0)
+        ? _calculator->calculateInflow(_level, _previousLevel, now - _lastSensorRead)
+        : 0.0;
+    _lastSensorRead = now;
+    
+    // Update max inflow
+    if (_inflow > _maxInflow) {
+        _maxInflow = _inflow;
+        _config.maxInflow = _maxInflow;
+        _storage->saveTankConfig(_config);
+    }
+    
+    LevelEvent evt;
+    evt.timestamp = now;
+    evt.waterLevel = _level;
+    evt.previousLevel = _previousLevel;
+    evt.currentInflow = _inflow;
+    evt.maxInflow = _maxInflow;
+    if (!_bus->publish(evt)) {
+        // Ring full (counted in the bus report): pump safety and usage
+        // tracking must still see this reading, so run them directly
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("Level event dropped - controlling directly");
+        #endif
+        onLevelControl(evt, this);
+        onLevelTracker(evt, this);
+    }
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Distance: ");
+    Serial.print(distance);
+    Serial.print(" cm, Level: ");
+    Serial.print(_level);
+    Serial.print(" %, Inflow: ");
+    Serial.println(_inflow);
+    #endif
+    
+    return true;
+}
+
+void ControlLoop::command(PumpCommand cmd, CommandSource source) {
+    if (_trace) _trace->recordCommand(cmd, source);
+    
+    switch (cmd) {
+        case PUMP_CMD_ON:
+            _pump->turnOn();
+            break;
+        case PUMP_CMD_OFF:
+            _pump->turnOff();
+            break;
+        case PUMP_CMD_AUTO:
+            _pump->setMode(AUTO_MODE);
+            break;
+        case PUMP_CMD_MANUAL:
+            _pump->setMode(MANUAL_MODE);
+            break;
+        case PUMP_CMD_TOGGLE_MANUAL:
+            if (_pump->getMode() == AUTO_MODE) _pump->setMode(MANUAL_MODE);
+            _pump->toggleManual();
+            break;
+        case PUMP_CMD_OVERRIDE:
+            if (_pump->getMode() == OVERRIDE_MODE) {
+                _pump->exitOverrideMode();
+            } else {
+                _pump->enterOverrideMode();
+            }
+            break;
+        case PUMP_CMD_RESET_SAFETY:
+            _pump->resetSafetyAlarms();
+            break;
+    }
+}
+
+void ControlLoop::loop() {
+    _pump->loop();
+    publishPumpState();
+    _bus->dispatch();
+}
+
+void ControlLoop::publishPumpState() {
+    PumpEvent evt;
+    evt.timestamp = millis();
+    evt.motorState = _pump->isOn();
+    evt.mode = (uint8_t)_pump->getMode();
+    evt.dryRunAlarm = _pump->isDryRunDetected();
+    evt.overflowAlarm = _pump->isOverflowRisk();
+    
+    if (_pumpPublished &&
+        evt.motorState == _lastPumpEvent.motorState && evt.mode == _lastPumpEvent.mode &&
+        evt.dryRunAlarm == _lastPumpEvent.dryRunAlarm && evt.overflowAlarm == _lastPumpEvent.overflowAlarm) {
+        return;
+    }
+    
+    if (_bus->publish(evt)) {
+        _lastPumpEvent = evt;
+        _pumpPublished = true;
+        if (_trace) _trace->recordPump(evt);
+    }
+}
+
+float ControlLoop::getWaterLevel() {
+    return _level;
+}
+
+float ControlLoop::getInflow() {
+    return _inflow;
+}
+
+float ControlLoop::getMaxInflow() {
+    return _maxInflow;
+}
+
+// Acts on the reading the event carries, not on whatever _level holds by
+// the time the bus delivers it
+void ControlLoop::updatePumpControl(const LevelEvent& evt) {
+    // Safety checks
+    _pump->updateSafetyCheck(evt.waterLevel, evt.previousLevel, SENSOR_SAMPLE_INTERVAL_MS);
+    
+    // Automatic control if in AUTO mode
+    if (_pump->getMode() == AUTO_MODE) {
+        _pump->autoControl(evt.waterLevel, _config.upperThreshold, _config.lowerThreshold);
+    }
+    
+    // Save pump cycle data once per state change
+    unsigned long stateChange = _pump->getLastStateChangeTime();
+    if (stateChange > 0 && stateChange != _lastSavedChange) {
+        _lastSavedChange = stateChange;
+        PumpCycle cycle;
+        cycle.timestamp = millis();
+        cycle.motorState = _pump->isOn();
+        cycle.waterLevel = evt.waterLevel;
+        cycle.inflow = evt.currentInflow;
+        _storage->savePumpCycle(cycle);
+    }
+}
+
+void ControlLoop::onLevelControl(const LevelEvent& evt, void* context) {
+    ControlLoop* self = static_cast<ControlLoop*>(context);
+    self->updatePumpControl(evt);
+    self->publishPumpState();
+}
+
+void ControlLoop::onLevelTracker(const LevelEvent& evt, void* context) {
+    ControlLoop* self = static_cast<ControlLoop*>(context);
+    self->_tracker->updateState(evt.waterLevel, self->_pump->isOn(), evt.currentInflow);
+}
+
+void ControlLoop::onPumpTracker(const PumpEvent& evt, void* context) {
+    ControlLoop* self = static_cast<ControlLoop*>(context);
+    self->_tracker->updateState(self->_level, evt.motorState, self->_inflow);
+}
@@ -0,0 +1,133 @@
+// demand_profile.cpp
+#include "demand_profile.h"
+#include "config.h"
+#include "utils.h"
+
+DemandProfile::DemandProfile()
+    : _storage(nullptr),
+      _currentSlot(-1),
+      _partialHour(true),
+      _hourLiters(0),
+      _foldsSinceSave(0) {
+    memset(_mean, 0, sizeof(_mean));
+    memset(_variance, 0, sizeof(_variance));
+    memset(_weeks, 0, sizeof(_weeks));
+}
+
+void DemandProfile::begin(StorageManager* storage) {
+    _storage = storage;
+    if (!_storage) return;
+    
+    ProfileSlot* slots = (ProfileSlot*)calloc(DEMAND_PROFILE_SLOTS, sizeof(ProfileSlot));
+    if (!slots) return;
+    
+    if (_storage->loadDemandProfile(slots, DEMAND_PROFILE_SLOTS)) {
+        for (int i = 0; i < DEMAND_PROFILE_SLOTS; i++) {
+            float stdDev = slots[i].stdDl / 10.0;
+            _mean[i] = slots[i].meanDl / 10.0;
+            _variance[i] = stdDev * stdDev;
+            _weeks[i] = slots[i].weeks;
+        }
+    }
+    free(slots);
+}
+
+void DemandProfile::loop() {
+    int slot = slotNow();
+    if (slot == _currentSlot) return;
+    
+    // Fold only a fully observed hour: not the partial first hour after
+    // boot/sync, and not across a clock jump
+    bool consecutive = _currentSlot >= 0 && slot == (_currentSlot + 1) % DEMAND_PROFILE_SLOTS;
+    if (consecutive && !_partialHour) {
+        fold(_currentSlot, _hourLiters);
+    }
+    
+    _partialHour = !consecutive;
+    _currentSlot = slot;
+    _hourLiters = 0;
+}
+
+void DemandProfile::addUsage(float liters) {
+    _hourLiters += liters;
+}
+
+float DemandProfile::getExpected(int dayOfWeek, int hour) const {
+    if (dayOfWeek < 0 || dayOfWeek > 6 || hour < 0 || hour > 23) return 0;
+    return _mean[dayOfWeek * 24 + hour];
+}
+
+float DemandProfile::getStdDev(int dayOfWeek, int hour) const {
+    if (dayOfWeek < 0 || dayOfWeek > 6 || hour < 0 || hour > 23) return 0;
+    return sqrt(_variance[dayOfWeek * 24 + hour]);
+}
+
+int DemandProfile::getWeeks(int dayOfWeek, int hour) const {
+    if (dayOfWeek < 0 || dayOfWeek > 6 || hour < 0 || hour > 23) return 0;
+    return _weeks[dayOfWeek * 24 + hour];
+}
+
+float DemandProfile::getExpectedNow() const {
+    int slot = slotNow();
+    return slot >= 0 ? _mean[slot] : 0;
+}
+
+void DemandProfile::save() {
+    if (!_storage) return;
+    
+    ProfileSlot* slots = (ProfileSlot*)calloc(DEMAND_PROFILE_SLOTS, sizeof(ProfileSlot));
+    if (!slots) return;
+    
+    for (int i = 0; i < DEMAND_PROFILE_SLOTS; i++) {
+        slots[i].meanDl = (uint16_t)min(_mean[i] * 10.0f + 0.5f, 65535.0f);
+        slots[i].stdDl = (uint16_t)min(sqrtf(_variance[i]) * 10.0f + 0.5f, 65535.0f);
+        slots[i].weeks = _weeks[i];
+    }
+    
+    if (_storage->saveDemandProfile(slots, DEMAND_PROFILE_SLOTS)) {
+        _foldsSinceSave = 0;
+    }
+    free(slots);
+}
+
+void DemandProfile::buildReport(JsonDocument& doc) {
+    JsonArray mean = doc["mean"].to<JsonArray>();
+    JsonArray stdDev = doc["std"].to<JsonArray>();
+    JsonArray weeks = doc["weeks"].to<JsonArray>();
+    
+    for (int day = 0; day < 7; day++) {
+        JsonArray meanRow = mean.add<JsonArray>();
+        JsonArray stdRow = stdDev.add<JsonArray>();
+        JsonArray weekRow = weeks.add<JsonArray>();
+        for (int hour = 0; hour < 24; hour++) {
+            int slot = day * 24 + hour;
+            meanRow.add(roundf(_mean[slot] * 10) / 10);
+            stdRow.add(roundf(sqrtf(_variance[slot]) * 10) / 10);
+            weekRow.add(_weeks[slot]);
+        }
+    }
+    doc["unit"] = "L/hour";
+    doc["currentSlot"] = _currentSlot;
+}
+
+void DemandProfile::fold(int slot, float liters) {
+    // Plain average for the first weeks, EWMA once enough history exists
+    float alpha = max((float)DEMAND_PROFILE_ALPHA, 1.0f / (_weeks[slot] + 1));
+    float delta = liters - _mean[slot];
+    
+    _mean[slot] += alpha * delta;
+    _variance[slot] = (1 - alpha) * (_variance[slot] + alpha * delta * delta);
+    if (_weeks[slot] < 255) _weeks[slot]++;
+    
+    if (++_foldsSinceSave >= DEMAND_PROFILE_SAVE_HOURS) {
+        save();
+    }
+}
+
+int DemandProfile::slotNow() {
+    if (!TimeUtils::isTimeSynced()) return -1;
+    
+    time_t now = time(nullptr);
+    struct tm* timeinfo = localtime(&now);
+    return timeinfo->tm_wday * 24 + timeinfo->tm_hour;
+}
@@ -0,0 +1,62 @@
+// display_backend.cpp
+#include "display_backend.h"
+#include "config.h"
+#include "pins.h"
+
+Ssd1306Backend::Ssd1306Backend()
+    : _display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, OLED_RESET, DISPLAY_I2C_CLOCK_HZ, DISPLAY_I2C_CLOCK_HZ) {
+}
+
+bool Ssd1306Backend::begin() {
+    Wire.begin(DISPLAY_SDA, DISPLAY_SCL);
+    
+    if (!_display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("SSD1306 allocation failed");
+        #endif
+        return false;
+    }
+    return true;
+}
+
+void Ssd1306Backend::clear() {
+    _display.clearDisplay();
+}
+
+void Ssd1306Backend::sendWindow(const DirtyWindow& window) {
+    const uint8_t* frame = _display.getBuffer();
+    
+    // Address window; begin() left the panel in horizontal addressing mode,
+    // so the data wraps from the window's last column to the next page
+    Wire.beginTransmission(SCREEN_ADDRESS);
+    Wire.write((uint8_t)0x00);          // Control byte: command stream
+    Wire.write((uint8_t)SSD1306_COLUMNADDR);
+    Wire.write(window.firstColumn);
+    Wire.write(window.lastColumn);
+    Wire.write((uint8_t)SSD1306_PAGEADDR);
+    Wire.write(window.firstPage);
+    Wire.write(window.lastPage);
+    Wire.endTransmission();
+    
+    // Data in transactions that fit the Wire buffer with the control byte
+    size_t chunk = 0;
+    for (int page = window.firstPage; page <= window.lastPage; page++) {
+        for (int column = window.firstColumn; column <= window.lastColumn; column++) {
+            if (chunk == 0) {
+                Wire.beginTransmission(SCREEN_ADDRESS);
+                Wire.write((uint8_t)0x40);  // Control byte: data stream
+            }
+            Wire.write(frame[page * DISPLAY_WIDTH + column]);
+            if (++chunk == I2C_BUFFER_LENGTH - 1) {
+                Wire.endTransmission();
+                chunk = 0;
+            }
+        }
+    }
+    if (chunk > 0) Wire.endTransmission();
+}
+
+void Ssd1306Backend::setContrast(uint8_t contrast) {
+    _display.ssd1306_command(SSD1306_SETCONTRAST);
+    _display.ssd1306_command(contrast);
+}
@@ -0,0 +1,150 @@
+// display_layout.cpp
+#include "display_layout.h"
+
+static const int CHAR_WIDTH = 6;              // Built-in font cell at text size 1
+static const int CHAR_HEIGHT = 8;
+
+LayoutRenderer::LayoutRenderer()
+    : _layout(nullptr) {
+    memset(_background, 0, sizeof(_background));
+    memset(_text, 0, sizeof(_text));
+    memset(_fill, 0, sizeof(_fill));
+}
+
+bool LayoutRenderer::render(DisplayBackend& backend, const ScreenLayout& layout, const LayoutValue* values) {
+    bool changed = false;
+    
+    if (_layout != &layout) {
+        drawBackground(backend, layout);
+        _layout = &layout;
+        changed = true;
+    }
+    
+    int count = min((int)layout.fieldCount, LAYOUT_MAX_FIELDS);
+    for (int i = 0; i < count; i++) {
+        if (renderField(backend, i, layout.fields[i], values[i])) changed = true;
+    }
+    
+    return changed;
+}
+
+void LayoutRenderer::invalidate() {
+    _layout = nullptr;
+}
+
+void LayoutRenderer::drawBackground(DisplayBackend& backend, const ScreenLayout& layout) {
+    Adafruit_GFX& display = backend.gfx();
+    backend.clear();
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+    
+    for (int i = 0; i < layout.labelCount; i++) {
+        display.setCursor(layout.labels[i].x, layout.labels[i].y);
+        display.print(layout.labels[i].text);
+    }
+    for (int i = 0; i < layout.boxCount; i++) {
+        const LayoutBox& box = layout.boxes[i];
+        display.drawRect(box.x, box.y, box.width, box.height, SSD1306_WHITE);
+    }
+    memcpy(_background, backend.getBuffer(), sizeof(_background));
+    
+    // Every field is blank on the background
+    memset(_text, 0, sizeof(_text));
+    memset(_fill, 0, sizeof(_fill));
+}
+
+bool LayoutRenderer::renderField(DisplayBackend& backend, int index, const LayoutField& field,
+                                 const LayoutValue& value) {
+    Adafruit_GFX& display = backend.gfx();
+    
+    if (field.type == FIELD_BAR) {
+        float level = constrain(value.number, 0.0f, 100.0f);
+        int16_t fill = (int16_t)(field.height * level / 100.0f);
+        if (fill == _fill[index]) return false;
+        
+        restore(backend.getBuffer(), field.x, field.y, field.width, field.height);
+        if (fill > 0) {
+            display.fillRect(field.x, field.y + field.height - fill, field.width, fill, SSD1306_WHITE);
+        }
+        _fill[index] = fill;
+        return true;
+    }
+    
+    // Format into a scratch line, cut to the field width
+    char text[LAYOUT_TEXT_SIZE];
+    size_t size = min((size_t)field.width + 1, sizeof(text));
+    text[0] = '\0';
+    if (field.type == FIELD_NUMBER) {
+        size_t len = formatNumber(text, size, value.number, field.decimals);
+        if (field.suffix) strncpy(text + len, field.suffix, size - len - 1);
+        text[size - 1] = '\0';
+    } else if (value.text) {
+        strncpy(text, value.text, size - 1);
+        text[size - 1] = '\0';
+    }
+    
+    if (strcmp(text, _text[index]) == 0) return false;
+    
+    restore(backend.getBuffer(), field.x, field.y, field.width * CHAR_WIDTH, CHAR_HEIGHT);
+    display.setCursor(field.x, field.y);
+    display.print(text);
+    strcpy(_text[index], text);
+    return true;
+}
+
+// Copies an area back from the background; pages are 8 pixel rows, so
+// the first and last page of the area are masked
+void LayoutRenderer::restore(uint8_t* frame, int16_t x, int16_t y, int16_t width, int16_t height) {
+    int16_t x0 = max((int16_t)0, x);
+    int16_t x1 = min((int16_t)DISPLAY_WIDTH, (int16_t)(x + width));
+    int16_t y0 = max((int16_t)0, y);
+    int16_t y1 = min((int16_t)DISPLAY_HEIGHT, (int16_t)(y + height));
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    for (int page = y0 / 8; page <= (y1 - 1) / 8; page++) {
+        int top = max(y0 - page * 8, 0);
+        int bottom = min(y1 - page * 8, 8);
+        uint8_t mask = (uint8_t)((0xFF << top) & (0xFF >> (8 - bottom)));
+        
+        int offset = page * DISPLAY_WIDTH;
+        for (int column = x0; column < x1; column++) {
+            frame[offset + column] = (frame[offset + column] & ~mask) | (_background[offset + column] & mask);
+        }
+    }
+}
+
+size_t LayoutRenderer::formatNumber(char* out, size_t size, float value, uint8_t decimals) {
+    static const uint32_t SCALE[] = { 1, 10, 100, 1000 };
+    if (size == 0) return 0;
+    if (decimals > 3) decimals = 3;
+    
+    // Out of range (or NaN): dashes rather than a wrapped integer
+    float magnitude = value < 0 ? -value : value;
+    if (!(magnitude < 4000000.0f)) {
+        strncpy(out, "----", size - 1);
+        out[size - 1] = '\0';
+        return strlen(out);
+    }
+    
+    uint32_t scaled = (uint32_t)(magnitude * SCALE[decimals] + 0.5f);
+    bool negative = value < 0 && scaled > 0;
+    
+    // Digits from the right
+    char digits[16];
+    int n = 0;
+    for (int i = 0; i < decimals; i++) {
+        digits[n++] = '0' + scaled % 10;
+        scaled /= 10;
+    }
+    if (decimals > 0) digits[n++] = '.';
+    do {
+        digits[n++] = '0' + scaled % 10;
+        scaled /= 10;
+    } while (scaled > 0);
+    if (negative) digits[n++] = '-';
+    
+    size_t len = 0;
+    while (n > 0 && len < size - 1) out[len++] = digits[--n];
+    out[len] = '\0';
+    return len;
+}
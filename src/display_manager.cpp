@@ -2,11 +2,112 @@
 #include "display_manager.h"
 #include "config.h"
 #include "pins.h"
+#include "loop_profiler.h"
+#include "display_layout.h"
+#include "trend_history.h"
+#include "utils.h"
 
-DisplayManager::DisplayManager()
-    : _display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, OLED_RESET),
+// Screens reachable with next/previous
+static const DisplayScreen ROTATION[] = {
+    SCREEN_MAIN,
+    SCREEN_STATUS,
+    SCREEN_USAGE,
+    SCREEN_LEVEL_TREND,
+    SCREEN_FLOW_TREND,
+    SCREEN_WEEK_USAGE,
+    #if ENABLE_LOOP_PROFILER
+    SCREEN_PERF,
+    #endif
+};
+static const int ROTATION_COUNT = sizeof(ROTATION) / sizeof(ROTATION[0]);
+
+// ==================== SCREEN LAYOUTS ====================
+// Labels and outlines are drawn once per screen switch; fields are
+// redrawn only when their text changes (see LayoutRenderer)
+#define LAYOUT_COUNT(items) (uint8_t)(sizeof(items) / sizeof(items[0]))
+
+static const LayoutLabel MAIN_LABELS[] = {
+    { 0, 0, "Water Level:" },
+    { 50, 12, "Pump:" },
+    { 50, 22, "Flow:" }
+};
+static const LayoutBox MAIN_BOXES[] = {
+    { 10, 12, 30, 48 }                          // Tank
+};
+enum { MAIN_LEVEL, MAIN_TANK, MAIN_PUMP, MAIN_FLOW, MAIN_MODE, MAIN_ALARM1, MAIN_ALARM2, MAIN_FIELD_COUNT };
+static const LayoutField MAIN_FIELDS[] = {
+    { FIELD_NUMBER, 78, 0, 8, 0, 1, "%" },
+    { FIELD_BAR, 11, 13, 28, 46, 0, nullptr },
+    { FIELD_TEXT, 86, 12, 3, 0, 0, nullptr },
+    { FIELD_NUMBER, 86, 22, 7, 0, 1, nullptr },
+    { FIELD_TEXT, 50, 32, 8, 0, 0, nullptr },
+    { FIELD_TEXT, 50, 42, 9, 0, 0, nullptr },   // Alarms, pump alarms first
+    { FIELD_TEXT, 50, 52, 9, 0, 0, nullptr }
+};
+static const ScreenLayout MAIN_LAYOUT = {
+    MAIN_LABELS, LAYOUT_COUNT(MAIN_LABELS),
+    MAIN_BOXES, LAYOUT_COUNT(MAIN_BOXES),
+    MAIN_FIELDS, LAYOUT_COUNT(MAIN_FIELDS)
+};
+
+static const LayoutLabel STATUS_LABELS[] = {
+    { 0, 0, "=== STATUS ===" },
+    { 0, 12, "WiFi:" },
+    { 0, 22, "Cloud:" },
+    { 0, 32, "Max Flow:" },
+    { 0, 42, "Mode:" }
+};
+enum { STATUS_WIFI, STATUS_CLOUD, STATUS_MAX_FLOW, STATUS_MODE, STATUS_FIELD_COUNT };
+static const LayoutField STATUS_FIELDS[] = {
+    { FIELD_TEXT, 36, 12, 12, 0, 0, nullptr },
+    { FIELD_TEXT, 42, 22, 12, 0, 0, nullptr },
+    { FIELD_NUMBER, 60, 32, 8, 0, 1, nullptr },
+    { FIELD_TEXT, 36, 42, 8, 0, 0, nullptr }
+};
+static const ScreenLayout STATUS_LAYOUT = {
+    STATUS_LABELS, LAYOUT_COUNT(STATUS_LABELS),
+    nullptr, 0,
+    STATUS_FIELDS, LAYOUT_COUNT(STATUS_FIELDS)
+};
+
+static const LayoutLabel USAGE_LABELS[] = {
+    { 0, 0, "=== USAGE ===" },
+    { 0, 16, "Today:" },
+    { 0, 40, "This Month:" }
+};
+enum { USAGE_TODAY, USAGE_MONTH, USAGE_FIELD_COUNT };
+static const LayoutField USAGE_FIELDS[] = {
+    { FIELD_NUMBER, 0, 26, 14, 0, 2, " L" },
+    { FIELD_NUMBER, 0, 50, 14, 0, 2, " L" }
+};
+static const ScreenLayout USAGE_LAYOUT = {
+    USAGE_LABELS, LAYOUT_COUNT(USAGE_LABELS),
+    nullptr, 0,
+    USAGE_FIELDS, LAYOUT_COUNT(USAGE_FIELDS)
+};
+
+// Trend screens: title row, then the plot below it
+static const int TREND_TOP = 12;
+static const int TREND_BOTTOM = DISPLAY_HEIGHT - 2;
+static const int TREND_LABEL_X = TREND_POINTS + 4;     // Scale labels right of the sparkline
+static const int WEEK_BAR_WIDTH = 14;
+static const int WEEK_BAR_PITCH = 18;
+static const int WEEK_BAR_BOTTOM = DISPLAY_HEIGHT - 10; // Weekday letters below
+
+static const char* modeName(const DisplayData& data) {
+    if (data.overrideMode) return "OVERRIDE";
+    if (data.manualMode) return "MANUAL";
+    return "AUTO";
+}
+
+DisplayManager::DisplayManager(DisplayBackend* backend)
+    : _backend(backend ? backend : &_oled),
+      _display(_backend->gfx()),
+      _data(),
       _currentScreen(SCREEN_MAIN),
-      _lastUpdate(0),
+      _redraw(true),
+      _history(nullptr),
+      _historyVersion(0),
       _lastActivity(0),
       _isDimmed(false),
       _messageEndTime(0),
@@ -14,22 +115,16 @@ DisplayManager::DisplayManager()
 }
 
 bool DisplayManager::begin() {
-    Wire.begin(DISPLAY_SDA, DISPLAY_SCL);
+    if (!_backend->begin()) return false;
+    _frame.invalidate();
     
-    if (!_display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
-        #if ENABLE_SERIAL_DEBUG
-        Serial.println("SSD1306 allocation failed");
-        #endif
-        return false;
-    }
-    
-    _display.clearDisplay();
+    clearScreen();
     _display.setTextSize(1);
     _display.setTextColor(SSD1306_WHITE);
     _display.setCursor(0, 0);
     _display.println("Water Pump System");
     _display.println("Initializing...");
-    _display.display();
+    flush();
     
     return true;
 }
@@ -40,45 +135,75 @@ void DisplayManager::loop() {
         dimDisplay();
     }
     
-    // Handle temporary messages
-    if (_messageEndTime > 0 && millis() > _messageEndTime) {
+    // Handle temporary messages (signed difference survives millis() wrap)
+    if (_messageEndTime > 0 && (long)(millis() - _messageEndTime) >= 0) {
         _messageEndTime = 0;
-        updateData(_data); // Refresh normal display
+        _redraw = true; // Refresh normal display
     }
     
-    // Update display at regular intervals
-    if (millis() - _lastUpdate > DISPLAY_UPDATE_INTERVAL_MS) {
-        _lastUpdate = millis();
-
-        if (_messageEndTime == 0) { // Only update if no temporary message
-            switch (_currentScreen) {
-                case SCREEN_MAIN:
-                    drawMainScreen();
-                    break;
-                case SCREEN_STATUS:
-                    drawStatusScreen();
-                    break;
-                case SCREEN_USAGE:
-                    drawUsageScreen();
-                    break;
-                case SCREEN_SETUP:
-                    drawSetupScreen(_setupPrompt);
-                    break;
-                default:
-                    break;
-            }
+    // Trend screens also follow the history
+    bool trendScreen = _currentScreen == SCREEN_LEVEL_TREND || _currentScreen == SCREEN_FLOW_TREND ||
+                       _currentScreen == SCREEN_WEEK_USAGE;
+    if (trendScreen && _history && _history->getVersion() != _historyVersion) _redraw = true;
+    
+    // Only render when something on screen can have changed; the profiler
+    // screen shows live numbers
+    if (_messageEndTime == 0 && (_redraw || _currentScreen == SCREEN_PERF)) {
+        _redraw = false;
+        switch (_currentScreen) {
+            case SCREEN_MAIN:
+                drawMainScreen();
+                break;
+            case SCREEN_STATUS:
+                drawStatusScreen();
+                break;
+            case SCREEN_USAGE:
+                drawUsageScreen();
+                break;
+            case SCREEN_LEVEL_TREND:
+                drawTrendScreen(false);
+                break;
+            case SCREEN_FLOW_TREND:
+                drawTrendScreen(true);
+                break;
+            case SCREEN_WEEK_USAGE:
+                drawWeekUsageScreen();
+                break;
+            case SCREEN_SETUP:
+                drawSetupScreen(_setupPrompt);
+                break;
+            case SCREEN_PERF:
+                drawPerfScreen();
+                break;
+            default:
+                break;
         }
     }
 }
 
 void DisplayManager::updateData(const DisplayData& data) {
-    _data = data;
+    if (!sameData(data, _data)) {
+        _data = data;
+        _redraw = true;
+    }
     _lastActivity = millis();
     if (_isDimmed) wakeDisplay();
 }
 
+void DisplayManager::setHistory(const TrendHistory* history) {
+    _history = history;
+    _redraw = true;
+}
+
+void DisplayManager::refresh() {
+    _layout.invalidate();
+    _frame.invalidate();
+    _redraw = true;
+}
+
 void DisplayManager::setScreen(DisplayScreen screen) {
     _currentScreen = screen;
+    _redraw = true;
     _lastActivity = millis();
     if (_isDimmed) wakeDisplay();
 }
@@ -88,21 +213,23 @@ DisplayScreen DisplayManager::getCurrentScreen() {
 }
 
 void DisplayManager::nextScreen() {
-    int screen = (int)_currentScreen;
-    screen = (screen + 1) % 3; // Cycle through 3 main screens
-    _currentScreen = (DisplayScreen)screen;
+    int index = 0;
+    while (index < ROTATION_COUNT && ROTATION[index] != _currentScreen) index++;
+    _currentScreen = ROTATION[(index + 1) % ROTATION_COUNT];
+    _redraw = true;
     _lastActivity = millis();
 }
 
 void DisplayManager::previousScreen() {
-    int screen = (int)_currentScreen;
-    screen = (screen - 1 + 3) % 3;
-    _currentScreen = (DisplayScreen)screen;
+    int index = 0;
+    while (index < ROTATION_COUNT && ROTATION[index] != _currentScreen) index++;
+    _currentScreen = ROTATION[(index + ROTATION_COUNT - 1) % ROTATION_COUNT];
+    _redraw = true;
     _lastActivity = millis();
 }
 
 void DisplayManager::showMessage(const String& title, const String& message, int duration) {
-    _display.clearDisplay();
+    clearScreen();
     _display.setTextSize(1);
     
     // Draw title
@@ -114,7 +241,7 @@ void DisplayManager::showMessage(const String& title, const String& message, int
     _display.setCursor(0, 16);
     _display.println(message);
     
-    _display.display();
+    flush();
     
     _messageTitle = title;
     _messageText = message;
@@ -123,7 +250,7 @@ void DisplayManager::showMessage(const String& title, const String& message, int
 }
 
 void DisplayManager::showProgress(const String& title, int percent) {
-    _display.clearDisplay();
+    clearScreen();
     _display.setTextSize(1);
     
     _display.setCursor(0, 0);
@@ -142,7 +269,7 @@ void DisplayManager::showProgress(const String& title, int percent) {
     _display.print(percent);
     _display.println("%");
     
-    _display.display();
+    flush();
     _lastActivity = millis();
 }
 
@@ -163,8 +290,7 @@ void DisplayManager::showSetupScreen(const String& prompt) {
 }
 
 void DisplayManager::setBrightness(uint8_t brightness) {
-    _display.ssd1306_command(SSD1306_SETCONTRAST);
-    _display.ssd1306_command(brightness);
+    _backend->setContrast(brightness);
 }
 
 void DisplayManager::dimDisplay() {
@@ -178,101 +304,144 @@ void DisplayManager::wakeDisplay() {
 }
 
 void DisplayManager::drawMainScreen() {
-    _display.clearDisplay();
+    LayoutValue values[MAIN_FIELD_COUNT];
+    values[MAIN_LEVEL].number = _data.waterLevel;
+    values[MAIN_TANK].number = _data.waterLevel;
+    values[MAIN_PUMP].text = _data.motorState ? "ON" : "OFF";
+    values[MAIN_FLOW].number = _data.currentInflow;
+    values[MAIN_MODE].text = modeName(_data);
+    
+    // Two alarm lines; leak is shown when a line is free
+    const char* alarms[3];
+    int count = 0;
+    if (_data.dryRunAlarm) alarms[count++] = "DRY RUN!";
+    if (_data.overflowAlarm) alarms[count++] = "OVERFLOW!";
+    if (_data.leakAlarm) alarms[count++] = "LEAK?";
+    values[MAIN_ALARM1].text = count > 0 ? alarms[0] : nullptr;
+    values[MAIN_ALARM2].text = count > 1 ? alarms[1] : nullptr;
+    
+    renderLayout(MAIN_LAYOUT, values);
+}
+
+void DisplayManager::drawStatusScreen() {
+    LayoutValue values[STATUS_FIELD_COUNT];
+    values[STATUS_WIFI].text = _data.wifiConnected ? "Connected" : "Disconnected";
+    values[STATUS_CLOUD].text = _data.iotOnline ? "Online" : "Offline";
+    values[STATUS_MAX_FLOW].number = _data.maxInflow;
+    values[STATUS_MODE].text = modeName(_data);
     
-    // Title
-    _display.setTextSize(1);
-    _display.setCursor(0, 0);
-    _display.print("Water Level: ");
-    _display.print(formatFloat(_data.waterLevel));
-    _display.println("%");
+    renderLayout(STATUS_LAYOUT, values);
+}
+
+void DisplayManager::drawUsageScreen() {
+    LayoutValue values[USAGE_FIELD_COUNT];
+    values[USAGE_TODAY].number = _data.dailyUsage;
+    values[USAGE_MONTH].number = _data.monthlyUsage;
     
-    // Tank visualization
-    drawTankLevel(10, 12, 30, 48, _data.waterLevel);
+    renderLayout(USAGE_LAYOUT, values);
+}
+
+// Last TREND_HOURS of level (0-100 %) or inflow (scaled to the highest
+// point), newest at the right edge of the plot
+void DisplayManager::drawTrendScreen(bool inflow) {
+    int count = _history ? _history->getPointCount() : 0;
+    if (_history) _historyVersion = _history->getVersion();
+    
+    float current = inflow ? _data.currentInflow : _data.waterLevel;
+    float scale = 100;
+    if (inflow) {
+        scale = max(current, 0.0f);
+        for (int i = 0; i < count; i++) scale = max(scale, _history->getInflow(i));
+        scale = max(1.0f, ceilf(scale));
+    }
     
-    // Status info
-    _display.setCursor(50, 12);
-    _display.print("Pump: ");
-    _display.println(_data.motorState ? "ON" : "OFF");
+    clearScreen();
+    _display.setTextSize(1);
     
-    _display.setCursor(50, 22);
-    _display.print("Flow: ");
-    _display.println(formatFloat(_data.currentInflow));
+    char text[LAYOUT_TEXT_SIZE];
+    snprintf(text, sizeof(text), "%s %dh", inflow ? "Flow" : "Level", TREND_HOURS);
+    _display.setCursor(0, 0);
+    _display.print(text);
     
-    _display.setCursor(50, 32);
-    if (_data.overrideMode) {
-        _display.println("OVERRIDE");
-    } else if (_data.manualMode) {
-        _display.println("MANUAL");
-    } else {
-        _display.println("AUTO");
+    size_t len = LayoutRenderer::formatNumber(text, sizeof(text) - 1, current, 1);
+    if (!inflow) {
+        text[len++] = '%';
+        text[len] = '\0';
     }
-    
-    // Alarms
-    if (_data.dryRunAlarm) {
-        _display.setCursor(50, 42);
-        _display.println("DRY RUN!");
+    _display.setCursor(DISPLAY_WIDTH - len * 6, 0);
+    _display.print(text);
+    
+    // Scale
+    LayoutRenderer::formatNumber(text, sizeof(text), scale, 0);
+    _display.setCursor(TREND_LABEL_X, TREND_TOP);
+    _display.print(text);
+    _display.setCursor(TREND_LABEL_X, TREND_BOTTOM - 7);
+    _display.print("0");
+    _display.drawFastVLine(TREND_POINTS, TREND_TOP, TREND_BOTTOM - TREND_TOP + 1, SSD1306_WHITE);
+    
+    if (count == 0) {
+        _display.setCursor(12, 32);
+        _display.print("No data yet");
+        flush();
+        return;
     }
-    if (_data.overflowAlarm) {
-        _display.setCursor(50, 52);
-        _display.println("OVERFLOW!");
+    
+    int height = TREND_BOTTOM - TREND_TOP;
+    int previousY = 0;
+    for (int i = 0; i < count; i++) {
+        float value = inflow ? _history->getInflow(i) : _history->getLevel(i);
+        int y = TREND_BOTTOM - (int)lroundf(constrain(value / scale, 0.0f, 1.0f) * height);
+        int x = TREND_POINTS - count + i;
+        if (i == 0) _display.drawPixel(x, y, SSD1306_WHITE);
+        else _display.drawLine(x - 1, previousY, x, y, SSD1306_WHITE);
+        previousY = y;
     }
     
-    _display.display();
+    flush();
 }
 
-void DisplayManager::drawStatusScreen() {
-    _display.clearDisplay();
-    _display.setTextSize(1);
+// Litres per day: the closed days from the history, then today
+void DisplayManager::drawWeekUsageScreen() {
+    float days[TREND_DAYS];
+    for (int i = 0; i < TREND_DAYS - 1; i++) days[i] = _history ? _history->getDay(i) : 0;
+    days[TREND_DAYS - 1] = _data.dailyUsage;
+    if (_history) _historyVersion = _history->getVersion();
     
-    _display.setCursor(0, 0);
-    _display.println("=== STATUS ===");
-    
-    _display.setCursor(0, 12);
-    _display.print("WiFi: ");
-    _display.println(_data.wifiStatus);
-    
-    _display.setCursor(0, 22);
-    _display.print("Cloud: ");
-    _display.println(_data.iotStatus);
-    
-    _display.setCursor(0, 32);
-    _display.print("Max Flow: ");
-    _display.println(formatFloat(_data.maxInflow));
-    
-    _display.setCursor(0, 42);
-    _display.print("Mode: ");
-    if (_data.overrideMode) _display.println("OVERRIDE");
-    else if (_data.manualMode) _display.println("MANUAL");
-    else _display.println("AUTO");
+    float highest = 0;
+    for (int i = 0; i < TREND_DAYS; i++) highest = max(highest, days[i]);
     
-    _display.display();
-}
-
-void DisplayManager::drawUsageScreen() {
-    _display.clearDisplay();
+    clearScreen();
     _display.setTextSize(1);
     
+    char text[LAYOUT_TEXT_SIZE];
+    char value[8];
+    LayoutRenderer::formatNumber(value, sizeof(value), highest, 0);
+    snprintf(text, sizeof(text), "Usage %dd max %sL", TREND_DAYS, value);
     _display.setCursor(0, 0);
-    _display.println("=== USAGE ===");
-    
-    _display.setCursor(0, 16);
-    _display.println("Today:");
-    _display.setCursor(0, 26);
-    _display.print(formatFloat(_data.dailyUsage, 2));
-    _display.println(" L");
-    
-    _display.setCursor(0, 40);
-    _display.println("This Month:");
-    _display.setCursor(0, 50);
-    _display.print(formatFloat(_data.monthlyUsage, 2));
-    _display.println(" L");
+    _display.print(text);
+    
+    // Weekday initials once the clock is set (day 0 was a Thursday)
+    long today = TimeUtils::isTimeSynced() ? TimeUtils::localDayNumber(time(nullptr)) : -1;
+    
+    int height = WEEK_BAR_BOTTOM - TREND_TOP;
+    for (int i = 0; i < TREND_DAYS; i++) {
+        int x = 1 + i * WEEK_BAR_PITCH;
+        int bar = highest > 0 ? (int)lroundf(days[i] / highest * height) : 0;
+        if (bar > 0) _display.fillRect(x, WEEK_BAR_BOTTOM - bar + 1, WEEK_BAR_WIDTH, bar, SSD1306_WHITE);
+        else _display.drawFastHLine(x, WEEK_BAR_BOTTOM, WEEK_BAR_WIDTH, SSD1306_WHITE);
+        
+        if (today >= 0) {
+            long day = today - (TREND_DAYS - 1 - i);
+            _display.setCursor(x + 4, DISPLAY_HEIGHT - 8);
+            _display.print("SMTWTFS"[(day + 4) % 7]);
+        }
+    }
     
-    _display.display();
+    flush();
 }
 
 void DisplayManager::drawConfigMenuScreen(int selectedItem) {
-    _display.clearDisplay();
+    clearScreen();
     _display.setTextSize(1);
     
     _display.setCursor(0, 0);
@@ -297,11 +466,11 @@ void DisplayManager::drawConfigMenuScreen(int selectedItem) {
         _display.println(menuItems[i]);
     }
     
-    _display.display();
+    flush();
 }
 
 void DisplayManager::drawSetupScreen(const String& prompt) {
-    _display.clearDisplay();
+    clearScreen();
     _display.setTextSize(1);
     
     _display.setCursor(0, 0);
@@ -313,21 +482,86 @@ void DisplayManager::drawSetupScreen(const String& prompt) {
     _display.setCursor(0, 50);
     _display.println("Use buttons");
     
-    _display.display();
+    flush();
 }
 
-void DisplayManager::drawTankLevel(int x, int y, int width, int height, float level) {
-    // Draw tank outline
-    _display.drawRect(x, y, width, height, SSD1306_WHITE);
+// Five slowest loop probes by p99
+void DisplayManager::drawPerfScreen() {
+    const int rows = 5;
+    ProbeSummary top[rows];
+    int shown = 0;
+    
+    for (int i = 0; i < loopProfiler.getProbeCount(); i++) {
+        ProbeSummary summary;
+        if (!loopProfiler.getSummary(i, summary) || summary.count == 0) continue;
+        
+        // Insertion into the sorted top list
+        int pos = shown;
+        while (pos > 0 && top[pos - 1].p99Us < summary.p99Us) {
+            if (pos < rows) top[pos] = top[pos - 1];
+            pos--;
+        }
+        if (pos < rows) top[pos] = summary;
+        if (shown < rows) shown++;
+    }
     
-    // Calculate fill height
-    int fillHeight = (height - 2) * level / 100.0;
-    int fillY = y + height - fillHeight - 1;
+    clearScreen();
+    _display.setTextSize(1);
     
-    // Draw water level
-    if (fillHeight > 0) {
-        _display.fillRect(x + 1, fillY, width - 2, fillHeight, SSD1306_WHITE);
+    _display.setCursor(0, 0);
+    _display.println("=== PERF p50/p99 ===");
+    
+    char line[22];
+    char p50[8];
+    char p99[8];
+    for (int i = 0; i < shown; i++) {
+        formatMicros(top[i].p50Us, p50, sizeof(p50));
+        formatMicros(top[i].p99Us, p99, sizeof(p99));
+        snprintf(line, sizeof(line), "%-8.8s %5.5s %5.5s", top[i].name, p50, p99);
+        _display.setCursor(0, 12 + i * 10);
+        _display.print(line);
+    }
+    
+    if (shown == 0) {
+        _display.setCursor(0, 20);
+        _display.println("No samples yet");
+    }
+    
+    flush();
+}
+
+// Only changed fields are redrawn, and nothing is sent if none changed
+void DisplayManager::renderLayout(const ScreenLayout& layout, const LayoutValue* values) {
+    if (_layout.render(*_backend, layout, values)) flush();
+}
+
+// Start of a free-form screen: the layout background is gone
+void DisplayManager::clearScreen() {
+    _layout.invalidate();
+    _backend->clear();
+}
+
+// Sends only the parts of the frame that differ from what the panel shows
+// (a full frame is ~1 KB, 25 ms of bus time at 400 kHz)
+void DisplayManager::flush() {
+    DirtyWindow windows[DISPLAY_PAGES];
+    uint8_t* frame = _backend->getBuffer();
+    int count = _frame.compute(frame, windows, DISPLAY_PAGES);
+    
+    for (int i = 0; i < count; i++) {
+        _backend->sendWindow(windows[i]);
     }
+    _frame.commit(frame);
+}
+
+bool DisplayManager::sameData(const DisplayData& a, const DisplayData& b) {
+    return a.waterLevel == b.waterLevel && a.currentInflow == b.currentInflow &&
+           a.maxInflow == b.maxInflow && a.motorState == b.motorState &&
+           a.manualMode == b.manualMode && a.overrideMode == b.overrideMode &&
+           a.dailyUsage == b.dailyUsage && a.monthlyUsage == b.monthlyUsage &&
+           a.wifiConnected == b.wifiConnected && a.iotOnline == b.iotOnline &&
+           a.dryRunAlarm == b.dryRunAlarm && a.overflowAlarm == b.overflowAlarm &&
+           a.leakAlarm == b.leakAlarm;
 }
 
 void DisplayManager::drawStatusIcon(int x, int y, bool state) {
@@ -338,6 +572,17 @@ void DisplayManager::drawStatusIcon(int x, int y, bool state) {
     }
 }
 
-String DisplayManager::formatFloat(float value, int decimals) {
-    return String(value, decimals);
-}
\ No newline at end of file
+// Fits a duration in 5 characters: 850u, 12.5m, 340m, 4.2s
+void DisplayManager::formatMicros(uint32_t us, char* out, size_t size) {
+    if (us < 1000) {
+        snprintf(out, size, "%uu", (unsigned)us);
+    } else if (us < 100000) {
+        size_t len = LayoutRenderer::formatNumber(out, size - 1, us / 1000.0f, 1);
+        snprintf(out + len, size - len, "m");
+    } else if (us < 1000000) {
+        snprintf(out, size, "%um", (unsigned)(us / 1000));
+    } else {
+        size_t len = LayoutRenderer::formatNumber(out, size - 1, us / 1000000.0f, 1);
+        snprintf(out + len, size - len, "s");
+    }
+}
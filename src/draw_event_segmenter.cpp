@@ -0,0 +1,185 @@
+// draw_event_segmenter.cpp
+#include "draw_event_segmenter.h"
+#include "config.h"
+
+DrawEventSegmenter::DrawEventSegmenter()
+    : _storage(nullptr),
+      _active(false),
+      _startMs(0),
+      _lastFlowMs(0),
+      _startTime(0),
+      _volume(0),
+      _peakRate(0),
+      _lastFlowing(false),
+      _heldLiters(0),
+      _heldMs(0),
+      _heldTime(0),
+      _head(0),
+      _count(0),
+      _unsaved(0) {
+}
+
+void DrawEventSegmenter::begin(StorageManager* storage) {
+    _storage = storage;
+    
+    int loaded = 0;
+    if (_storage && _storage->loadDrawEvents(_events, DRAW_EVENT_LOG_SIZE, loaded)) {
+        _count = loaded;
+        _head = loaded % DRAW_EVENT_LOG_SIZE;
+    }
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Draw events loaded: ");
+    Serial.println(_count);
+    #endif
+}
+
+void DrawEventSegmenter::addSample(float liters, unsigned long nowMs) {
+    // A held drop counts only if this reading shows flow too
+    if (_heldLiters > 0) {
+        if (liters > 0) addFlow(_heldLiters, _heldMs, _heldTime);
+        _heldLiters = 0;
+    }
+    
+    if (liters > 0 && liters < DRAW_MIN_EVENT_LITERS && !_lastFlowing) {
+        // A small drop on its own is usually sensor noise; isolated ones
+        // would otherwise add up to spurious events or bridge two draws
+        _heldLiters = liters;
+        _heldMs = nowMs;
+        _heldTime = time(nullptr);
+    } else if (liters > 0) {
+        addFlow(liters, nowMs, time(nullptr));
+    } else if (_active && nowMs - _lastFlowMs > DRAW_EVENT_GAP_MS) {
+        closeEvent();
+    }
+    _lastFlowing = liters > 0;
+}
+
+void DrawEventSegmenter::addFlow(float liters, unsigned long nowMs, uint32_t nowTime) {
+    // Rate over the time since the previous drop; tracker calls this
+    // per reading or pump change, so the interval is floored at one sample
+    unsigned long interval = SENSOR_SAMPLE_INTERVAL_MS;
+    
+    if (!_active) {
+        _active = true;
+        _startMs = nowMs;
+        _startTime = nowTime;
+        _volume = 0;
+        _peakRate = 0;
+    } else {
+        interval = constrain(nowMs - _lastFlowMs,
+                             (unsigned long)SENSOR_SAMPLE_INTERVAL_MS,
+                             (unsigned long)DRAW_EVENT_GAP_MS);
+    }
+    
+    float rate = liters * 60000.0 / interval;
+    if (rate > _peakRate) _peakRate = rate;
+    
+    _volume += liters;
+    _lastFlowMs = nowMs;
+}
+
+void DrawEventSegmenter::closeEvent() {
+    if (!_active) return;
+    _active = false;
+    
+    if (_volume < DRAW_MIN_EVENT_LITERS) return;
+    
+    DrawEvent event;
+    event.start = _startTime;
+    event.durationSec = min((_lastFlowMs - _startMs) / 1000, 65535UL);
+    event.volumeDl = (uint16_t)min(_volume * 10.0f, 65535.0f);
+    event.peakRateDl = (uint16_t)min(_peakRate * 10.0f, 65535.0f);
+    event.category = classify(_volume);
+    event.reserved = 0;
+    appendEvent(event);
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.printf("Draw event: %.1f L over %u s (%s)\n",
+                  _volume, event.durationSec, getCategoryName(event.category));
+    #endif
+    
+    if (_unsaved >= DRAW_EVENT_FLUSH_COUNT) {
+        flush();
+    }
+}
+
+void DrawEventSegmenter::flush() {
+    if (!_storage || _unsaved == 0) return;
+    
+    DrawEvent ordered[DRAW_EVENT_LOG_SIZE];
+    int count = getEvents(ordered, DRAW_EVENT_LOG_SIZE);
+    
+    if (_storage->saveDrawEvents(ordered, count)) {
+        _unsaved = 0;
+    }
+}
+
+int DrawEventSegmenter::getEvents(DrawEvent* events, int maxCount) {
+    portENTER_CRITICAL(&_mux);
+    int count = min(_count, maxCount);
+    int first = (_head - count + DRAW_EVENT_LOG_SIZE) % DRAW_EVENT_LOG_SIZE;
+    for (int i = 0; i < count; i++) {
+        events[i] = _events[(first + i) % DRAW_EVENT_LOG_SIZE];
+    }
+    portEXIT_CRITICAL(&_mux);
+    return count;
+}
+
+void DrawEventSegmenter::buildReport(JsonDocument& doc) {
+    DrawEvent events[DRAW_EVENT_LOG_SIZE];
+    int count = getEvents(events, DRAW_EVENT_LOG_SIZE);
+    
+    int categoryCount[DRAW_CATEGORY_COUNT] = {0};
+    float categoryLiters[DRAW_CATEGORY_COUNT] = {0};
+    
+    JsonArray list = doc["events"].to<JsonArray>();
+    for (int i = count - 1; i >= 0; i--) {
+        const DrawEvent& e = events[i];
+        JsonObject item = list.add<JsonObject>();
+        item["start"] = e.start;
+        item["duration"] = e.durationSec;
+        item["liters"] = e.volumeDl / 10.0;
+        item["peakRate"] = e.peakRateDl / 10.0;
+        item["category"] = getCategoryName(e.category);
+        
+        if (e.category < DRAW_CATEGORY_COUNT) {
+            categoryCount[e.category]++;
+            categoryLiters[e.category] += e.volumeDl / 10.0;
+        }
+    }
+    
+    JsonObject summary = doc["summary"].to<JsonObject>();
+    for (int c = 0; c < DRAW_CATEGORY_COUNT; c++) {
+        JsonObject entry = summary[getCategoryName(c)].to<JsonObject>();
+        entry["count"] = categoryCount[c];
+        entry["liters"] = categoryLiters[c];
+    }
+    doc["active"] = _active;
+}
+
+const char* DrawEventSegmenter::getCategoryName(uint8_t category) {
+    switch (category) {
+        case DRAW_SMALL:  return "small";
+        case DRAW_MEDIUM: return "medium";
+        case DRAW_LARGE:  return "large";
+        case DRAW_BULK:   return "bulk";
+        default:          return "unknown";
+    }
+}
+
+DrawCategory DrawEventSegmenter::classify(float liters) {
+    if (liters < DRAW_SMALL_MAX_LITERS) return DRAW_SMALL;
+    if (liters < DRAW_MEDIUM_MAX_LITERS) return DRAW_MEDIUM;
+    if (liters < DRAW_LARGE_MAX_LITERS) return DRAW_LARGE;
+    return DRAW_BULK;
+}
+
+void DrawEventSegmenter::appendEvent(const DrawEvent& event) {
+    portENTER_CRITICAL(&_mux);
+    _events[_head] = event;
+    _head = (_head + 1) % DRAW_EVENT_LOG_SIZE;
+    if (_count < DRAW_EVENT_LOG_SIZE) _count++;
+    portEXIT_CRITICAL(&_mux);
+    _unsaved++;
+}
@@ -0,0 +1,101 @@
+// event_bus.cpp
+#include "event_bus.h"
+
+EventBus::EventBus()
+    : _head(0),
+      _count(0),
+      _subscriberCount(0),
+      _dropped(0),
+      _dispatchCalls(0),
+      _idleDispatches(0) {
+    memset(_published, 0, sizeof(_published));
+    memset(_delivered, 0, sizeof(_delivered));
+}
+
+bool EventBus::addSubscriber(EventTopic topic, GenericHandler handler, Invoker invoker, void* context) {
+    if (!handler || _subscriberCount >= EVENT_BUS_MAX_SUBSCRIBERS) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("EventBus: subscriber table full");
+        #endif
+        return false;
+    }
+    
+    Subscriber& sub = _subscribers[_subscriberCount++];
+    sub.topic = topic;
+    sub.handler = handler;
+    sub.invoker = invoker;
+    sub.context = context;
+    return true;
+}
+
+EventBus::Event* EventBus::claimSlot(EventTopic topic) {
+    if (_count >= EVENT_BUS_QUEUE_SIZE) {
+        _dropped++;
+        return nullptr;
+    }
+    
+    Event* slot = &_queue[(_head + _count) % EVENT_BUS_QUEUE_SIZE];
+    slot->topic = topic;
+    _count++;
+    _published[topic]++;
+    return slot;
+}
+
+int EventBus::dispatch() {
+    _dispatchCalls++;
+    if (_count == 0) {
+        _idleDispatches++;
+        return 0;
+    }
+    
+    // Bounded so a handler that keeps publishing cannot stall the loop
+    int dispatched = 0;
+    while (_count > 0 && dispatched < EVENT_BUS_QUEUE_SIZE) {
+        // Copy out first: handlers may publish into the freed slot
+        Event event = _queue[_head];
+        _head = (_head + 1) % EVENT_BUS_QUEUE_SIZE;
+        _count--;
+        
+        for (uint8_t i = 0; i < _subscriberCount; i++) {
+            const Subscriber& sub = _subscribers[i];
+            if (sub.topic != event.topic) continue;
+            
+            sub.invoker(sub.handler, &event.payload, sub.context);
+            _delivered[event.topic]++;
+        }
+        dispatched++;
+    }
+    
+    return dispatched;
+}
+
+uint32_t EventBus::getDroppedCount() {
+    return _dropped;
+}
+
+void EventBus::buildReport(JsonDocument& doc) {
+    doc["subscribers"] = _subscriberCount;
+    doc["pending"] = _count;
+    doc["dropped"] = _dropped;
+    doc["dispatchCalls"] = _dispatchCalls;
+    
+    // Each idle pass is one where every subscriber used to refresh anyway
+    doc["idlePasses"] = _idleDispatches;
+    doc["skippedUpdates"] = (uint64_t)_idleDispatches * _subscriberCount;
+    
+    JsonArray topics = doc["topics"].to<JsonArray>();
+    for (int t = 0; t < TOPIC_COUNT; t++) {
+        JsonObject obj = topics.add<JsonObject>();
+        obj["name"] = topicName((EventTopic)t);
+        obj["published"] = _published[t];
+        obj["delivered"] = _delivered[t];
+    }
+}
+
+const char* EventBus::topicName(EventTopic topic) {
+    switch (topic) {
+        case TOPIC_LEVEL: return "level";
+        case TOPIC_PUMP:  return "pump";
+        default:          return "unknown";
+    }
+}
@@ -0,0 +1,143 @@
+// fault_injection.cpp
+#include "fault_injection.h"
+
+#if ENABLE_FAULT_INJECTION
+
+struct FaultState {
+    float probability;            // 0 = disarmed
+    int32_t remaining;            // Fires left, -1 = no limit
+    uint32_t delayMs;
+    uint32_t hits;
+    uint32_t fired;
+};
+
+static const char* const FAULT_NAMES[FAULT_POINT_COUNT] = {
+    "sensor_timeout", "sensor_corrupt", "sensor_slow",
+    "storage_write_fail", "storage_partial_write", "storage_read_corrupt", "storage_slow",
+    "mqtt_publish_fail", "mqtt_slow",
+    "rest_timeout", "rest_slow", "rest_corrupt",
+    "wifi_connect_fail", "wifi_drop"
+};
+
+static FaultState faults[FAULT_POINT_COUNT];
+static uint32_t rngState = 0x9E3779B9;
+static portMUX_TYPE faultMux = portMUX_INITIALIZER_UNLOCKED;
+
+// xorshift32: repeatable from seed(), no dependence on esp_random()
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+void FaultInjector::arm(FaultPoint point, float probability, int32_t count, uint32_t delayMs) {
+    if (point >= FAULT_POINT_COUNT) return;
+    
+    portENTER_CRITICAL(&faultMux);
+    faults[point].probability = constrain(probability, 0.0f, 1.0f);
+    faults[point].remaining = count;
+    faults[point].delayMs = delayMs;
+    portEXIT_CRITICAL(&faultMux);
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.printf("Fault armed: %s p=%.2f count=%ld delay=%lu ms\n",
+                  FAULT_NAMES[point], probability, (long)count, (unsigned long)delayMs);
+    #endif
+}
+
+void FaultInjector::disarm(FaultPoint point) {
+    if (point >= FAULT_POINT_COUNT) return;
+    
+    portENTER_CRITICAL(&faultMux);
+    faults[point].probability = 0;
+    portEXIT_CRITICAL(&faultMux);
+}
+
+void FaultInjector::reset() {
+    portENTER_CRITICAL(&faultMux);
+    memset(faults, 0, sizeof(faults));
+    portEXIT_CRITICAL(&faultMux);
+}
+
+void FaultInjector::seed(uint32_t value) {
+    portENTER_CRITICAL(&faultMux);
+    rngState = value ? value : 0x9E3779B9;
+    portEXIT_CRITICAL(&faultMux);
+}
+
+bool FaultInjector::fire(FaultPoint point) {
+    if (point >= FAULT_POINT_COUNT) return false;
+    
+    portENTER_CRITICAL(&faultMux);
+    FaultState& state = faults[point];
+    state.hits++;
+    
+    bool fired = false;
+    if (state.probability > 0 && state.remaining != 0) {
+        fired = state.probability >= 1.0f || (nextRandom() >> 8) < state.probability * 16777216.0f;
+        if (fired) {
+            state.fired++;
+            if (state.remaining > 0) state.remaining--;
+        }
+    }
+    portEXIT_CRITICAL(&faultMux);
+    
+    return fired;
+}
+
+void FaultInjector::stall(FaultPoint point) {
+    if (fire(point)) delay(getDelay(point));
+}
+
+uint32_t FaultInjector::getDelay(FaultPoint point) {
+    return point < FAULT_POINT_COUNT ? faults[point].delayMs : 0;
+}
+
+float FaultInjector::random() {
+    portENTER_CRITICAL(&faultMux);
+    uint32_t value = nextRandom();
+    portEXIT_CRITICAL(&faultMux);
+    return (value >> 8) / 16777216.0f;
+}
+
+const char* FaultInjector::getName(FaultPoint point) {
+    return point < FAULT_POINT_COUNT ? FAULT_NAMES[point] : "unknown";
+}
+
+bool FaultInjector::pointFromName(const char* name, FaultPoint& point) {
+    if (!name) return false;
+    
+    for (int i = 0; i < FAULT_POINT_COUNT; i++) {
+        if (strcmp(name, FAULT_NAMES[i]) == 0) {
+            point = (FaultPoint)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t FaultInjector::getHitCount(FaultPoint point) {
+    return point < FAULT_POINT_COUNT ? faults[point].hits : 0;
+}
+
+uint32_t FaultInjector::getFiredCount(FaultPoint point) {
+    return point < FAULT_POINT_COUNT ? faults[point].fired : 0;
+}
+
+void FaultInjector::buildReport(JsonDocument& doc) {
+    JsonArray points = doc["points"].to<JsonArray>();
+    for (int i = 0; i < FAULT_POINT_COUNT; i++) {
+        const FaultState& state = faults[i];
+        JsonObject entry = points.add<JsonObject>();
+        entry["name"] = FAULT_NAMES[i];
+        entry["armed"] = state.probability > 0 && state.remaining != 0;
+        entry["probability"] = state.probability;
+        entry["remaining"] = state.remaining;
+        entry["delayMs"] = state.delayMs;
+        entry["hits"] = state.hits;
+        entry["fired"] = state.fired;
+    }
+}
+
+#endif // ENABLE_FAULT_INJECTION
@@ -0,0 +1,241 @@
+// flash_wear_monitor.cpp
+#include "flash_wear_monitor.h"
+#include "config.h"
+#include "fault_injection.h"
+
+// NVS layout constants (ESP-IDF): 32-byte entries, 126 entries per 4 KB page
+#define NVS_ENTRY_SIZE 32
+#define NVS_ENTRIES_PER_PAGE 126
+
+static KeyWearStats keyStats[FLASH_WEAR_MAX_KEYS];
+static int keyCount = 0;
+static uint32_t totalWrites = 0;
+static uint32_t totalBytes = 0;
+static uint32_t totalEntries = 0;
+static unsigned long trackingStart = 0;
+static portMUX_TYPE wearMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ==================== FLASH WEAR MONITOR ====================
+
+// Bounded copy that always terminates (NVS names are at most 15 chars)
+static void copyName(char* dest, size_t size, const char* src) {
+    size_t len = strnlen(src, size - 1);
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+}
+
+void FlashWearMonitor::recordWrite(const char* ns, const char* key, size_t valueBytes, bool variableLength) {
+    if (!key) return;
+    
+    // Primitives fit in one entry; strings/blobs take a header entry plus data entries
+    uint32_t entries = 1;
+    if (variableLength) {
+        entries += (valueBytes + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE;
+    }
+    
+    // Fold trailing index digits so ring keys (cycle0..cycle99) share one slot
+    char folded[16];
+    size_t len = strlen(key);
+    if (len >= sizeof(folded)) len = sizeof(folded) - 1;
+    memcpy(folded, key, len);
+    folded[len] = '\0';
+    size_t end = len;
+    while (end > 0 && isDigit(folded[end - 1])) end--;
+    if (end > 0 && end < len && end + 1 < sizeof(folded)) {
+        folded[end] = '#';
+        folded[end + 1] = '\0';
+    }
+    
+    portENTER_CRITICAL(&wearMux);
+    
+    if (trackingStart == 0) trackingStart = millis();
+    totalWrites++;
+    totalBytes += valueBytes;
+    totalEntries += entries;
+    
+    int slot = -1;
+    for (int i = 0; i < keyCount; i++) {
+        if (strcmp(keyStats[i].key, folded) == 0 && strcmp(keyStats[i].ns, ns) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    
+    if (slot < 0) {
+        if (keyCount < FLASH_WEAR_MAX_KEYS - 1) {
+            slot = keyCount++;
+            copyName(keyStats[slot].ns, sizeof(keyStats[slot].ns), ns);
+            copyName(keyStats[slot].key, sizeof(keyStats[slot].key), folded);
+        } else {
+            // Last slot collects everything that didn't fit
+            slot = FLASH_WEAR_MAX_KEYS - 1;
+            if (keyCount < FLASH_WEAR_MAX_KEYS) {
+                keyCount = FLASH_WEAR_MAX_KEYS;
+                strcpy(keyStats[slot].ns, "*");
+                strcpy(keyStats[slot].key, "(other)");
+            }
+        }
+    }
+    
+    keyStats[slot].writes++;
+    keyStats[slot].bytes += valueBytes;
+    keyStats[slot].entries += entries;
+    
+    portEXIT_CRITICAL(&wearMux);
+}
+
+uint32_t FlashWearMonitor::getTotalWrites() {
+    return totalWrites;
+}
+
+uint32_t FlashWearMonitor::getTotalBytes() {
+    return totalBytes;
+}
+
+uint32_t FlashWearMonitor::getTotalEntries() {
+    return totalEntries;
+}
+
+float FlashWearMonitor::getEstimatedPageErases() {
+    // Every page filled with entries is eventually erased by NVS garbage collection
+    return (float)totalEntries / NVS_ENTRIES_PER_PAGE;
+}
+
+float FlashWearMonitor::getErasesPerSectorPerDay() {
+    if (trackingStart == 0) return 0.0;
+    
+    float elapsedDays = (millis() - trackingStart) / 86400000.0;
+    if (elapsedDays <= 0) return 0.0;
+    
+    // NVS spreads erases across its pages (one page is kept free for GC)
+    float erasesPerSector = getEstimatedPageErases() / (NVS_PARTITION_PAGES - 1);
+    return erasesPerSector / elapsedDays;
+}
+
+float FlashWearMonitor::getProjectedLifetimeYears() {
+    float rate = getErasesPerSectorPerDay();
+    if (rate <= 0) return -1.0; // Not enough data yet
+    
+    return FLASH_ERASE_ENDURANCE / rate / 365.0;
+}
+
+int FlashWearMonitor::getKeyCount() {
+    return keyCount;
+}
+
+const KeyWearStats& FlashWearMonitor::getKeyStats(int index) {
+    return keyStats[index];
+}
+
+void FlashWearMonitor::buildReport(JsonDocument& doc) {
+    doc["trackedSeconds"] = trackingStart ? (millis() - trackingStart) / 1000 : 0;
+    doc["totalWrites"] = totalWrites;
+    doc["totalBytes"] = totalBytes;
+    doc["estimatedEntries"] = totalEntries;
+    doc["estimatedPageErases"] = getEstimatedPageErases();
+    doc["erasesPerSectorPerDay"] = getErasesPerSectorPerDay();
+    doc["enduranceCycles"] = FLASH_ERASE_ENDURANCE;
+    doc["projectedLifetimeYears"] = getProjectedLifetimeYears();
+    
+    JsonArray keys = doc["keys"].to<JsonArray>();
+    for (int i = 0; i < keyCount; i++) {
+        JsonObject entry = keys.add<JsonObject>();
+        entry["ns"] = keyStats[i].ns;
+        entry["key"] = keyStats[i].key;
+        entry["writes"] = keyStats[i].writes;
+        entry["bytes"] = keyStats[i].bytes;
+        entry["entries"] = keyStats[i].entries;
+    }
+}
+
+void FlashWearMonitor::reset() {
+    portENTER_CRITICAL(&wearMux);
+    keyCount = 0;
+    totalWrites = 0;
+    totalBytes = 0;
+    totalEntries = 0;
+    trackingStart = millis();
+    portEXIT_CRITICAL(&wearMux);
+}
+
+// ==================== TRACKED PREFERENCES ====================
+
+// Injection point shared by every put*: a slow write, then maybe no write
+static bool writeFails() {
+    FAULT_STALL(FAULT_STORAGE_SLOW);
+    return FAULT_FIRES(FAULT_STORAGE_WRITE_FAIL);
+}
+
+bool TrackedPreferences::begin(const char* name, bool readOnly) {
+    copyName(_namespace, sizeof(_namespace), name);
+    return Preferences::begin(name, readOnly);
+}
+
+size_t TrackedPreferences::putBool(const char* key, bool value) {
+    if (writeFails()) return 0;
+    size_t written = Preferences::putBool(key, value);
+    if (written) FlashWearMonitor::recordWrite(_namespace, key, written, false);
+    return written;
+}
+
+size_t TrackedPreferences::putUChar(const char* key, uint8_t value) {
+    if (writeFails()) return 0;
+    size_t written = Preferences::putUChar(key, value);
+    if (written) FlashWearMonitor::recordWrite(_namespace, key, written, false);
+    return written;
+}
+
+size_t TrackedPreferences::putInt(const char* key, int32_t value) {
+    if (writeFails()) return 0;
+    size_t written = Preferences::putInt(key, value);
+    if (written) FlashWearMonitor::recordWrite(_namespace, key, written, false);
+    return written;
+}
+
+size_t TrackedPreferences::putULong(const char* key, uint32_t value) {
+    if (writeFails()) return 0;
+    size_t written = Preferences::putULong(key, value);
+    if (written) FlashWearMonitor::recordWrite(_namespace, key, written, false);
+    return written;
+}
+
+size_t TrackedPreferences::putFloat(const char* key, float value) {
+    if (writeFails()) return 0;
+    size_t written = Preferences::putFloat(key, value);
+    if (written) FlashWearMonitor::recordWrite(_namespace, key, written, false);
+    return written;
+}
+
+size_t TrackedPreferences::putString(const char* key, const String& value) {
+    if (writeFails()) return 0;
+    String stored = FAULT_FIRES(FAULT_STORAGE_PARTIAL_WRITE) ? value.substring(0, value.length() / 2) : value;
+    size_t written = Preferences::putString(key, stored);
+    // putString() reports strlen() (0 for an empty value) but NVS also
+    // stores the terminator
+    if (written == stored.length()) FlashWearMonitor::recordWrite(_namespace, key, written + 1, true);
+    return written;
+}
+
+size_t TrackedPreferences::putBytes(const char* key, const void* value, size_t len) {
+    if (writeFails()) return 0;
+    if (FAULT_FIRES(FAULT_STORAGE_PARTIAL_WRITE)) len /= 2;
+    size_t written = Preferences::putBytes(key, value, len);
+    if (written) FlashWearMonitor::recordWrite(_namespace, key, written, true);
+    return written;
+}
+
+#if ENABLE_FAULT_INJECTION
+float TrackedPreferences::getFloat(const char* key, float defaultValue) {
+    float value = Preferences::getFloat(key, defaultValue);
+    return FAULT_FIRES(FAULT_STORAGE_READ_CORRUPT) ? NAN : value;
+}
+
+size_t TrackedPreferences::getBytes(const char* key, void* buffer, size_t maxLen) {
+    size_t read = Preferences::getBytes(key, buffer, maxLen);
+    if (read > 0 && FAULT_FIRES(FAULT_STORAGE_READ_CORRUPT)) {
+        uint32_t bit = (uint32_t)(FAULT_RANDOM() * read * 8);
+        static_cast<uint8_t*>(buffer)[bit / 8] ^= 1 << (bit % 8);
+    }
+    return read;
+}
+#endif
@@ -0,0 +1,75 @@
+// frame_diff.cpp
+#include "frame_diff.h"
+#include "config.h"
+
+FrameDiff::FrameDiff()
+    : _valid(false) {
+    memset(_previous, 0, sizeof(_previous));
+}
+
+int FrameDiff::compute(const uint8_t* frame, DirtyWindow* windows, int maxWindows) {
+    if (maxWindows <= 0) return 0;
+    
+    if (!_valid) {
+        windows[0].firstPage = 0;
+        windows[0].lastPage = DISPLAY_PAGES - 1;
+        windows[0].firstColumn = 0;
+        windows[0].lastColumn = DISPLAY_WIDTH - 1;
+        return 1;
+    }
+    
+    int count = 0;
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        const uint8_t* now = frame + page * DISPLAY_WIDTH;
+        const uint8_t* before = _previous + page * DISPLAY_WIDTH;
+        
+        int first = 0;
+        while (first < DISPLAY_WIDTH && now[first] == before[first]) first++;
+        if (first == DISPLAY_WIDTH) continue;
+        
+        int last = DISPLAY_WIDTH - 1;
+        while (now[last] == before[last]) last--;
+        
+        DirtyWindow window = { (uint8_t)page, (uint8_t)page, (uint8_t)first, (uint8_t)last };
+        
+        // Grow the previous window down to this page if that is cheaper
+        if (count > 0 && windows[count - 1].lastPage == page - 1) {
+            DirtyWindow merged = windows[count - 1];
+            merged.lastPage = page;
+            if (window.firstColumn < merged.firstColumn) merged.firstColumn = window.firstColumn;
+            if (window.lastColumn > merged.lastColumn) merged.lastColumn = window.lastColumn;
+            
+            size_t separate = windowBytes(windows[count - 1]) + windowBytes(window) + DISPLAY_WINDOW_OVERHEAD;
+            if (windowBytes(merged) <= separate) {
+                windows[count - 1] = merged;
+                continue;
+            }
+        }
+        
+        // Out of slots: widen the last window over everything below it
+        if (count == maxWindows) {
+            DirtyWindow& tail = windows[count - 1];
+            tail.lastPage = page;
+            if (window.firstColumn < tail.firstColumn) tail.firstColumn = window.firstColumn;
+            if (window.lastColumn > tail.lastColumn) tail.lastColumn = window.lastColumn;
+            continue;
+        }
+        
+        windows[count++] = window;
+    }
+    
+    return count;
+}
+
+void FrameDiff::commit(const uint8_t* frame) {
+    memcpy(_previous, frame, sizeof(_previous));
+    _valid = true;
+}
+
+void FrameDiff::invalidate() {
+    _valid = false;
+}
+
+size_t FrameDiff::windowBytes(const DirtyWindow& window) {
+    return (size_t)(window.lastPage - window.firstPage + 1) * (window.lastColumn - window.firstColumn + 1);
+}
@@ -0,0 +1,153 @@
+// history_exporter.cpp
+#include "history_exporter.h"
+#include "utils.h"
+
+HistoryExporter::HistoryExporter(ExportKind kind, ExportFormat format, unsigned long from, unsigned long to)
+    : _kind(kind),
+      _format(format),
+      _from(from),
+      _to(to),
+      _lineLength(0),
+      _linePos(0),
+      _headerSent(false),
+      _done(false),
+      _nextDay(0),
+      _lastDay(0),
+      _batchCount(0),
+      _batchPos(0),
+      _cycleIndex(0),
+      _cycleAge(MAX_PUMP_CYCLE_LOGS - 1) {
+    
+    if (_kind == EXPORT_DAILY) {
+        unsigned long end = (_to > 0) ? _to : (unsigned long)time(nullptr);
+        unsigned long start = (_from > 0) ? _from : end - (EXPORT_DEFAULT_DAYS - 1) * 86400UL;
+        _nextDay = TimeUtils::localDayNumber(start);
+        _lastDay = TimeUtils::localDayNumber(end);
+        
+        // The table only holds DAILY_TABLE_DAYS, older days can't exist
+        if (_lastDay - _nextDay >= DAILY_TABLE_DAYS) {
+            _nextDay = _lastDay - DAILY_TABLE_DAYS + 1;
+        }
+    } else {
+        _cycleIndex = _storage.getPumpCycleIndex();
+    }
+}
+
+size_t HistoryExporter::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    
+    while (written < maxLen) {
+        // Refill the line buffer when the previous row has been sent
+        if (_linePos >= _lineLength) {
+            if (_done) break;
+            
+            _lineLength = 0;
+            _linePos = 0;
+            
+            bool hasRow = _headerSent ? formatNextRow() : formatHeader();
+            if (!hasRow) {
+                _done = true;
+                break;
+            }
+        }
+        
+        size_t chunk = min(_lineLength - _linePos, maxLen - written);
+        memcpy(buffer + written, _line + _linePos, chunk);
+        _linePos += chunk;
+        written += chunk;
+    }
+    
+    return written;
+}
+
+const char* HistoryExporter::getContentType(ExportFormat format) {
+    return (format == EXPORT_CSV) ? "text/csv" : "application/x-ndjson";
+}
+
+bool HistoryExporter::formatHeader() {
+    _headerSent = true;
+    
+    if (_format == EXPORT_NDJSON) {
+        // NDJSON has no header row
+        return formatNextRow();
+    }
+    
+    const char* header = (_kind == EXPORT_DAILY)
+        ? "date,usage_liters,pump_cycles,pump_minutes,peak_inflow\n"
+        : "timestamp,motor_state,water_level,inflow\n";
+    
+    _lineLength = snprintf(_line, sizeof(_line), "%s", header);
+    return true;
+}
+
+bool HistoryExporter::formatNextRow() {
+    if (_kind == EXPORT_DAILY) {
+        while (true) {
+            if (_batchPos < _batchCount) {
+                return formatDailyRow(_batch[_batchPos++]);
+            }
+            
+            if (_nextDay > _lastDay) return false;
+            
+            // Batches come from _storage's cached table, read from NVS once per export
+            int days = min((long)EXPORT_BATCH_DAYS, _lastDay - _nextDay + 1);
+            _storage.getUsageDays(_nextDay, days, _batch, _batchCount);
+            _nextDay += days;
+            _batchPos = 0;
+        }
+    }
+    
+    // Pump cycles: walk the ring from oldest to newest, one record per read
+    while (_cycleAge >= 0) {
+        PumpCycle cycle;
+        int age = _cycleAge--;
+        
+        if (!_storage.getPumpCycle(_cycleIndex, age, cycle)) continue;
+        if (_from > 0 && cycle.timestamp < _from) continue;
+        if (_to > 0 && cycle.timestamp > _to) continue;
+        
+        return formatCycleRow(cycle);
+    }
+    
+    return false;
+}
+
+bool HistoryExporter::formatDailyRow(const DailyUsage& usage) {
+    time_t rawtime = usage.date;
+    struct tm* timeinfo = localtime(&rawtime);
+    char date[11];
+    strftime(date, sizeof(date), "%Y-%m-%d", timeinfo);
+    
+    int length;
+    if (_format == EXPORT_CSV) {
+        length = snprintf(_line, sizeof(_line), "%s,%.2f,%d,%d,%.1f\n",
+                          date, usage.totalUsageLiters, usage.pumpCycles,
+                          usage.pumpMinutes, usage.peakInflow);
+    } else {
+        length = snprintf(_line, sizeof(_line),
+                          "{\"date\":\"%s\",\"usageLiters\":%.2f,\"pumpCycles\":%d,"
+                          "\"pumpMinutes\":%d,\"peakInflow\":%.1f}\n",
+                          date, usage.totalUsageLiters, usage.pumpCycles,
+                          usage.pumpMinutes, usage.peakInflow);
+    }
+    
+    _lineLength = min((size_t)max(length, 0), sizeof(_line) - 1);
+    return true;
+}
+
+bool HistoryExporter::formatCycleRow(const PumpCycle& cycle) {
+    int length;
+    if (_format == EXPORT_CSV) {
+        length = snprintf(_line, sizeof(_line), "%lu,%d,%.2f,%.2f\n",
+                          cycle.timestamp, cycle.motorState ? 1 : 0,
+                          cycle.waterLevel, cycle.inflow);
+    } else {
+        length = snprintf(_line, sizeof(_line),
+                          "{\"timestamp\":%lu,\"motorState\":%s,\"waterLevel\":%.2f,\"inflow\":%.2f}\n",
+                          cycle.timestamp, cycle.motorState ? "true" : "false",
+                          cycle.waterLevel, cycle.inflow);
+    }
+    
+    _lineLength = min((size_t)max(length, 0), sizeof(_line) - 1);
+    return true;
+}
@@ -2,7 +2,7 @@
 #include "iot_client.h"
 
 IoTClient::IoTClient() 
-    : _lastTelemetrySend(0), _initialized(false) {
+    : _initialized(false) {
 }
 
 bool IoTClient::begin() {
@@ -64,6 +64,14 @@ void IoTClient::loop() {
     _protocol.loop();
 }
 
+void IoTClient::poll() {
+    if (!_initialized) return;
+    
+    #if COMMUNICATION_PROTOCOL == PROTOCOL_RESTAPI
+    _protocol.pollServer();
+    #endif
+}
+
 bool IoTClient::isConnected() {
     if (!_initialized) return false;
     
@@ -87,11 +95,7 @@ bool IoTClient::isConnected() {
 bool IoTClient::sendTelemetry(const TelemetryData& data) {
     if (!_initialized) return false;
     
-    // Rate limiting for telemetry
-    if (millis() - _lastTelemetrySend < TELEMETRY_SEND_INTERVAL_MS) {
-        return false; // Too soon
-    }
-    
+    // Cadence is owned by the "telemetry" scheduler task
     bool success = false;
     
     #if COMMUNICATION_PROTOCOL == PROTOCOL_MQTT
@@ -102,10 +106,6 @@ bool IoTClient::sendTelemetry(const TelemetryData& data) {
         success = _protocol.sendTelemetry(data);
     #endif
     
-    if (success) {
-        _lastTelemetrySend = millis();
-    }
-    
     return success;
 }
 
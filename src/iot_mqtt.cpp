@@ -1,6 +1,7 @@
 // iot_mqtt.cpp
 #include "iot_mqtt.h"
 #include "config.h"
+#include "fault_injection.h"
 
 IoTMQTT* IoTMQTT::_instance = nullptr;
 
@@ -100,7 +101,7 @@ bool IoTMQTT::publishTelemetry(const TelemetryData& data) {
     String jsonStr;
     serializeJson(doc, jsonStr);
     
-    return _mqttClient.publish(_topicTelemetry.c_str(), jsonStr.c_str(), false);
+    return publish(_topicTelemetry.c_str(), jsonStr.c_str(), false);
 }
 
 bool IoTMQTT::publishStatus(const String& status) {
@@ -113,7 +114,7 @@ bool IoTMQTT::publishStatus(const String& status) {
     String jsonStr;
     serializeJson(doc, jsonStr);
     
-    return _mqttClient.publish(_topicStatus.c_str(), jsonStr.c_str(), true); // Retained
+    return publish(_topicStatus.c_str(), jsonStr.c_str(), true); // Retained
 }
 
 bool IoTMQTT::publishConfig(const TankConfig& config) {
@@ -135,7 +136,7 @@ bool IoTMQTT::publishConfig(const TankConfig& config) {
     String jsonStr;
     serializeJson(doc, jsonStr);
     
-    return _mqttClient.publish(_topicConfig.c_str(), jsonStr.c_str(), true); // Retained
+    return publish(_topicConfig.c_str(), jsonStr.c_str(), true); // Retained
 }
 
 bool IoTMQTT::requestConfig() {
@@ -148,7 +149,14 @@ bool IoTMQTT::requestConfig() {
     serializeJson(doc, jsonStr);
     
     String requestTopic = "devices/" + _deviceToken + "/config/request";
-    return _mqttClient.publish(requestTopic.c_str(), jsonStr.c_str());
+    return publish(requestTopic.c_str(), jsonStr.c_str());
+}
+
+bool IoTMQTT::publish(const char* topic, const char* payload, bool retained) {
+    FAULT_STALL(FAULT_MQTT_SLOW);
+    if (FAULT_FIRES(FAULT_MQTT_PUBLISH_FAIL)) return false;
+    
+    return _mqttClient.publish(topic, payload, retained);
 }
 
 void IoTMQTT::setCommandCallback(void (*callback)(const CommandData& cmd)) {
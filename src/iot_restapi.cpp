@@ -1,12 +1,11 @@
 // iot_restapi.cpp
 #include "iot_restapi.h"
 #include "config.h"
+#include "fault_injection.h"
 
 IoTRestAPI::IoTRestAPI() 
     : _commandCallback(nullptr),
-      _configCallback(nullptr),
-      _lastPollTime(0),
-      _pollInterval(30000) { // Poll every 30 seconds
+      _configCallback(nullptr) {
 }
 
 bool IoTRestAPI::begin(const String& serverUrl, const String& deviceToken) {
@@ -18,11 +17,8 @@ bool IoTRestAPI::begin(const String& serverUrl, const String& deviceToken) {
 }
 
 void IoTRestAPI::loop() {
-    // Automatically poll for commands and config updates
-    if (millis() - _lastPollTime > _pollInterval) {
-        _lastPollTime = millis();
-        pollServer();
-    }
+    // Nothing to service between requests; polling runs from
+    // IoTClient::poll() every IOT_POLL_INTERVAL_MS
 }
 
 bool IoTRestAPI::isConnected() {
@@ -166,8 +162,12 @@ bool IoTRestAPI::sendRequest(const String& method, const String& endpoint, const
     _http.addHeader("Content-Type", "application/json");
     
     int httpCode = -1;
+    FAULT_STALL(FAULT_REST_SLOW);
     
-    if (method == "GET") {
+    if (FAULT_FIRES(FAULT_REST_TIMEOUT)) {
+        delay(FAULT_DELAY(FAULT_REST_TIMEOUT, IOT_CONNECTION_TIMEOUT_MS));
+        httpCode = HTTPC_ERROR_READ_TIMEOUT;
+    } else if (method == "GET") {
         httpCode = _http.GET();
     } else if (method == "POST") {
         httpCode = _http.POST(payload);
@@ -179,6 +179,9 @@ bool IoTRestAPI::sendRequest(const String& method, const String& endpoint, const
     
     if (httpCode > 0) {
         response = _http.getString();
+        if (FAULT_FIRES(FAULT_REST_CORRUPT)) {
+            response = response.substring(0, response.length() / 2);
+        }
         
         #if ENABLE_SERIAL_DEBUG
         Serial.print("HTTP Response code: ");
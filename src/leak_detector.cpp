@@ -0,0 +1,170 @@
+// leak_detector.cpp
+#include "leak_detector.h"
+#include "config.h"
+#include "utils.h"
+
+#define LEAK_BUCKET_GROWTH 1.5
+
+LeakDetector::LeakDetector()
+    : _storage(nullptr),
+      _windowOpen(false),
+      _windowPumped(false),
+      _windowStartMs(0),
+      _windowStartVolume(0),
+      _windowSamples(0),
+      _sumT(0),
+      _sumV(0),
+      _sumTT(0),
+      _sumTV(0),
+      _inQuietHours(false),
+      _windowCount(0) {
+    memset(_histogram, 0, sizeof(_histogram));
+}
+
+void LeakDetector::begin(StorageManager* storage) {
+    _storage = storage;
+    if (_storage) {
+        _storage->loadLeakState(_state);
+    }
+    
+    #if ENABLE_SERIAL_DEBUG
+    if (_state.alarm) {
+        Serial.print("Leak alarm active - night baseline ");
+        Serial.print(_state.baselineLpm);
+        Serial.println(" L/min");
+    }
+    #endif
+}
+
+void LeakDetector::addSample(float volumeLiters, bool pumpOn, unsigned long nowMs) {
+    bool quiet = isQuietHour();
+    
+    if (!quiet) {
+        if (_inQuietHours) {
+            _inQuietHours = false;
+            _windowOpen = false;
+            evaluateNight();
+        }
+        return;
+    }
+    _inQuietHours = true;
+    
+    if (!_windowOpen) {
+        _windowOpen = true;
+        openWindow(volumeLiters, pumpOn, nowMs);
+        return;
+    }
+    
+    if (pumpOn) _windowPumped = true;
+    
+    float t = (nowMs - _windowStartMs) / 60000.0;
+    float v = volumeLiters - _windowStartVolume;
+    _windowSamples++;
+    _sumT += t;
+    _sumV += v;
+    _sumTT += t * t;
+    _sumTV += t * v;
+    
+    if (nowMs - _windowStartMs >= LEAK_WINDOW_MS) {
+        closeWindow();
+        openWindow(volumeLiters, pumpOn, nowMs);
+    }
+}
+
+void LeakDetector::buildReport(JsonDocument& doc) {
+    doc["leakAlarm"] = _state.alarm != 0;
+    doc["leakBaseline"] = _state.baselineLpm;
+    doc["leakNights"] = _state.suspectNights;
+}
+
+bool LeakDetector::isQuietHour() {
+    if (!TimeUtils::isTimeSynced()) return false;
+    
+    time_t now = time(nullptr);
+    struct tm* timeinfo = localtime(&now);
+    return timeinfo->tm_hour >= LEAK_QUIET_START_HOUR &&
+           timeinfo->tm_hour < LEAK_QUIET_END_HOUR;
+}
+
+// The window's first sample is its origin (t = 0, v = 0)
+void LeakDetector::openWindow(float volumeLiters, bool pumpOn, unsigned long nowMs) {
+    _windowPumped = pumpOn;
+    _windowStartMs = nowMs;
+    _windowStartVolume = volumeLiters;
+    _windowSamples = 1;
+    _sumT = _sumV = _sumTT = _sumTV = 0;
+}
+
+void LeakDetector::closeWindow() {
+    // Refills hide outflow, so windows with pump activity are dropped
+    float denom = _windowSamples * _sumTT - _sumT * _sumT;
+    if (_windowPumped || denom <= 0) return;
+    
+    float slope = (_windowSamples * _sumTV - _sumT * _sumV) / denom;
+    float lpm = max(0.0f, -slope);
+    
+    _histogram[bucketFor(lpm)]++;
+    _windowCount++;
+}
+
+void LeakDetector::evaluateNight() {
+    if (_windowCount >= LEAK_MIN_WINDOWS) {
+        _state.baselineLpm = percentile(LEAK_BASELINE_PERCENTILE);
+        
+        if (_state.baselineLpm >= LEAK_MIN_FLOW_LPM) {
+            if (_state.suspectNights < 255) _state.suspectNights++;
+            if (_state.suspectNights >= LEAK_CONFIRM_NIGHTS) _state.alarm = 1;
+        } else {
+            _state.suspectNights = 0;
+            _state.alarm = 0;
+        }
+        
+        if (_storage) {
+            _storage->saveLeakState(_state);
+        }
+        
+        #if ENABLE_SERIAL_DEBUG
+        Serial.printf("Night baseline flow: %.3f L/min (%d suspect nights)\n",
+                      _state.baselineLpm, _state.suspectNights);
+        #endif
+    }
+    
+    memset(_histogram, 0, sizeof(_histogram));
+    _windowCount = 0;
+}
+
+float LeakDetector::percentile(int pct) {
+    uint32_t target = ((uint32_t)_windowCount * pct + 99) / 100;
+    if (target == 0) target = 1;
+    
+    uint32_t seen = 0;
+    for (int i = 0; i < LEAK_HIST_BUCKETS; i++) {
+        seen += _histogram[i];
+        if (seen >= target) return bucketLowerEdge(i);
+    }
+    return bucketLowerEdge(LEAK_HIST_BUCKETS - 1);
+}
+
+// Bucket 0 holds [0, LEAK_HIST_MIN_LPM); bucket i >= 1 starts at
+// LEAK_HIST_MIN_LPM * 1.5^(i-1)
+int LeakDetector::bucketFor(float lpm) {
+    if (lpm < LEAK_HIST_MIN_LPM) return 0;
+    
+    int bucket = 1;
+    float edge = LEAK_HIST_MIN_LPM * LEAK_BUCKET_GROWTH;
+    while (lpm >= edge && bucket < LEAK_HIST_BUCKETS - 1) {
+        edge *= LEAK_BUCKET_GROWTH;
+        bucket++;
+    }
+    return bucket;
+}
+
+float LeakDetector::bucketLowerEdge(int bucket) {
+    if (bucket == 0) return 0.0;
+    
+    float edge = LEAK_HIST_MIN_LPM;
+    for (int i = 1; i < bucket; i++) {
+        edge *= LEAK_BUCKET_GROWTH;
+    }
+    return edge;
+}
@@ -0,0 +1,142 @@
+// loop_profiler.cpp
+#include "loop_profiler.h"
+
+LoopProfiler loopProfiler;
+
+LoopProfiler::LoopProfiler()
+    : _probeCount(0),
+      _overheadNs(0) {
+    memset(_probes, 0, sizeof(_probes));
+}
+
+void LoopProfiler::begin() {
+    // Time a batch of empty probes into a scratch slot, then release it
+    const int rounds = 1000;
+    int8_t scratch = registerProbe("_calibrate");
+    if (scratch < 0) return;
+    
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < rounds; i++) {
+        ProfileScope scope(*this, scratch);
+    }
+    _overheadNs = (uint32_t)((esp_timer_get_time() - start) * 1000 / rounds);
+    
+    memset(&_probes[scratch], 0, sizeof(Probe));
+    _probeCount--;
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Loop profiler: ");
+    Serial.print(_overheadNs);
+    Serial.println(" ns per probe");
+    #endif
+}
+
+int8_t LoopProfiler::registerProbe(const char* name) {
+    // Probes with the same name share one histogram
+    for (int i = 0; i < _probeCount; i++) {
+        if (strcmp(_probes[i].name, name) == 0) return i;
+    }
+    
+    if (_probeCount >= PROFILER_MAX_PROBES) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.print("Profiler full - probe ignored: ");
+        Serial.println(name);
+        #endif
+        return -1;
+    }
+    
+    _probes[_probeCount].name = name;
+    return _probeCount++;
+}
+
+void LoopProfiler::record(int8_t id, uint32_t us) {
+    if (id < 0 || id >= _probeCount) return;
+    
+    Probe& probe = _probes[id];
+    if (probe.count == 0 || us < probe.minUs) probe.minUs = us;
+    if (us > probe.maxUs) probe.maxUs = us;
+    probe.count++;
+    probe.totalUs += us;
+    probe.buckets[bucketOf(us)]++;
+}
+
+void LoopProfiler::reset() {
+    for (int i = 0; i < _probeCount; i++) {
+        const char* name = _probes[i].name;
+        memset(&_probes[i], 0, sizeof(Probe));
+        _probes[i].name = name;
+    }
+}
+
+int LoopProfiler::getProbeCount() {
+    return _probeCount;
+}
+
+bool LoopProfiler::getSummary(int8_t id, ProbeSummary& summary) {
+    if (id < 0 || id >= _probeCount) return false;
+    
+    const Probe& probe = _probes[id];
+    summary.name = probe.name;
+    summary.count = probe.count;
+    summary.minUs = probe.minUs;
+    summary.p50Us = percentile(probe, 50);
+    summary.p99Us = percentile(probe, 99);
+    summary.maxUs = probe.maxUs;
+    summary.avgUs = probe.count ? (uint32_t)(probe.totalUs / probe.count) : 0;
+    return true;
+}
+
+uint32_t LoopProfiler::getOverheadNs() {
+    return _overheadNs;
+}
+
+void LoopProfiler::buildReport(JsonDocument& doc) {
+    doc["enabled"] = (bool)ENABLE_LOOP_PROFILER;
+    doc["probeOverheadNs"] = _overheadNs;
+    
+    JsonArray probes = doc["probes"].to<JsonArray>();
+    for (int i = 0; i < _probeCount; i++) {
+        ProbeSummary summary;
+        getSummary(i, summary);
+        
+        JsonObject item = probes.add<JsonObject>();
+        item["name"] = summary.name;
+        item["count"] = summary.count;
+        item["minUs"] = summary.minUs;
+        item["p50Us"] = summary.p50Us;
+        item["p99Us"] = summary.p99Us;
+        item["maxUs"] = summary.maxUs;
+        item["avgUs"] = summary.avgUs;
+        
+        // Bucket b counts samples in [2^(b-1), 2^b) us
+        JsonArray buckets = item["buckets"].to<JsonArray>();
+        for (int b = 0; b < PROFILER_BUCKETS; b++) {
+            buckets.add(_probes[i].buckets[b]);
+        }
+    }
+}
+
+uint8_t LoopProfiler::bucketOf(uint32_t us) {
+    if (us == 0) return 0;
+    
+    uint8_t bucket = 32 - __builtin_clz(us);
+    return bucket < PROFILER_BUCKETS ? bucket : PROFILER_BUCKETS - 1;
+}
+
+uint32_t LoopProfiler::percentile(const Probe& probe, uint8_t pct) {
+    if (probe.count == 0) return 0;
+    
+    uint32_t target = (uint32_t)(((uint64_t)probe.count * pct + 99) / 100);
+    uint32_t seen = 0;
+    
+    for (int b = 0; b < PROFILER_BUCKETS - 1; b++) {
+        seen += probe.buckets[b];
+        if (seen >= target) {
+            uint32_t upper = b == 0 ? 0 : (1UL << b) - 1;
+            return constrain(upper, probe.minUs, probe.maxUs);
+        }
+    }
+    
+    // Open-ended top bucket
+    return probe.maxUs;
+}
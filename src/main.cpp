@@ -15,6 +15,14 @@
 #include "webserver_local.h"
 #include "ota_updater.h"
 #include "ml_predictor.h"
+#include "task_scheduler.h"
+#include "network_worker.h"
+#include "loop_profiler.h"
+#include "system_snapshot.h"
+#include "event_bus.h"
+#include "control_loop.h"
+#include "trace_recorder.h"
+#include "trend_history.h"
 #include "utils.h"
 
 // ==================== GLOBAL OBJECTS ====================
@@ -31,17 +39,21 @@ WaterTracker waterTracker;
 WebServerLocal webServer;
 OTAUpdater otaUpdater;
 MLPredictor mlPredictor;
+TaskScheduler scheduler;
+NetworkWorker networkWorker;
+SnapshotBuffer systemSnapshot;   // Control loop -> web server
+ControlQueue controlQueue;       // Web server -> control loop
+EventBus eventBus;               // Readings and pump changes -> subscribers
+ControlLoop controlLoop(&sensor, &calculator, &pumpController, &waterTracker, &storage, &eventBus);
+TraceRecorder traceRecorder;     // Inputs + pump changes -> SPIFFS ring
+TrendHistory trendHistory;       // Downsampled level / flow / daily usage for the OLED
 
 // ==================== GLOBAL STATE ====================
 TankConfig currentConfig;
-float currentWaterLevel = 0.0;
-float previousWaterLevel = 0.0;
-float currentInflow = 0.0;
-float maxInflow = 0.0;
-unsigned long lastSensorRead = 0;
-unsigned long lastTelemetrySend = 0;
 bool systemInitialized = false;
 bool wifiInitialized = false;  // Track if TCP/IP stack is ready
+bool leakReported = false;     // "leak_detected" sent for the current alarm
+bool displayDirty = true;      // Display data changed since the last refresh
 
 enum SystemState {
     STATE_FIRST_TIME_SETUP,
@@ -54,16 +66,21 @@ SystemState systemState = STATE_FIRST_TIME_SETUP;
 
 // ==================== FUNCTION DECLARATIONS ====================
 void initializeSystem();
-void firstTimeSetup();
+void scheduleTasks();
+void subscribeEvents();
+void firstTimeSetup(ButtonEvent event);
 void normalOperation();
-void configMode();
-void handleButtonEvents();
-void readSensor();
-void updatePumpControl();
+bool configMode(ButtonEvent event);
+void handleButtonEvents(ButtonEvent event);
 void updateDisplay();
 void handleIoTCommands(const CommandData& cmd);
 void handleIoTConfig(const String& configJson);
+void handleNetworkEvent(const NetEvent& evt);
+void startWebServer();
 void sendTelemetry();
+void applyControlCommands();
+void publishSnapshot();
+void reportLeakAlarm();
 
 // ==================== SETUP ====================
 void setup() {
@@ -75,6 +92,10 @@ void setup() {
     Serial.println("=================================\n");
     #endif
     
+    #if ENABLE_LOOP_PROFILER
+    loopProfiler.begin();
+    #endif
+    
     // Initialize storage
     if (!storage.begin()) {
         #if ENABLE_SERIAL_DEBUG
@@ -88,8 +109,16 @@ void setup() {
     pumpController.begin();
     sensor.begin();
     displayManager.begin();
+    displayManager.setHistory(&trendHistory);
     buttonHandler.begin();
-
+    
+    // Display refresh runs in every system state
+    scheduler.addPeriodic("display", DISPLAY_UPDATE_INTERVAL_MS, [](void*) {
+        PROFILE_SCOPE("display");
+        if (systemInitialized && systemState == STATE_NORMAL_OPERATION && displayDirty) updateDisplay();
+        displayManager.loop();
+    });
+    
     // Initialize WiFi manager early (needed for TCP/IP stack even in simulation)
     // NOTE: Once TCP/IP stack is initialized, it keeps running even if:
     //       - WiFi disconnects later
@@ -101,7 +130,7 @@ void setup() {
     Serial.println("Initializing WiFi (TCP/IP stack for web server)...");
     #endif
     #endif
-
+    
     if (!wifiManager.begin()) {
         #if ENABLE_SERIAL_DEBUG
         Serial.println("WARNING: WiFi initialization failed!");
@@ -117,7 +146,7 @@ void setup() {
         Serial.println("WiFi Manager initialized - TCP/IP stack ready");
         #endif
     }
-
+    
     // ✅ Check if first-time setup is needed (for tank configuration)
     if (storage.isFirstTimeSetup()) {
         systemState = STATE_FIRST_TIME_SETUP;
@@ -139,24 +168,40 @@ void setup() {
 
 // ==================== MAIN LOOP ====================
 void loop() {
+    PROFILE_SCOPE("loop");
+    
     // Update all components
-    buttonHandler.loop();
-    displayManager.loop();
+    {
+        PROFILE_SCOPE("buttons");
+        buttonHandler.loop();
+    }
+    
+    // Scheduled tasks (sensor, display, ...) have their own probes as well
+    {
+        PROFILE_SCOPE("scheduler");
+        scheduler.run();
+    }
+    
+    // One button event per pass (the rest stay queued), delivered once:
+    // to the active state, then to the global handler if the state left it
+    ButtonEvent event = buttonHandler.getEvent();
+    if (event != BTN_NONE) traceRecorder.recordButton(event);
     
     // State machine
     switch (systemState) {
         case STATE_FIRST_TIME_SETUP:
-            firstTimeSetup();
+            firstTimeSetup(event);
+            event = BTN_NONE;           // Setup owns every button
             break;
-            
+        
         case STATE_NORMAL_OPERATION:
             normalOperation();
             break;
-            
+        
         case STATE_CONFIG_MODE:
-            configMode();
+            if (configMode(event)) event = BTN_NONE;
             break;
-            
+        
         case STATE_ERROR:
             displayManager.showError("System Error");
             delay(5000);
@@ -165,7 +210,7 @@ void loop() {
     }
     
     // Handle button events across all states
-    handleButtonEvents();
+    handleButtonEvents(event);
 }
 
 // ==================== INITIALIZATION ====================
@@ -177,43 +222,18 @@ void initializeSystem() {
     // Load configuration
     currentConfig = storage.loadTankConfig();
     calculator.setTankConfig(currentConfig);
-
+    
+    // From here on WiFi, cloud, OTA and ML traffic runs on the network worker
+    networkWorker.setEventCallback(handleNetworkEvent);
+    networkWorker.begin(&wifiManager, &iotClient, &otaUpdater, &mlPredictor);
+    
     // WiFi manager already initialized in setup(), now configure it
     if (!currentConfig.firstTimeSetup) {
         displayManager.showMessage("WiFi", "Connecting...", 2000);
-
+        
         #if IOT_ENABLED
-        if (wifiManager.connectToSavedWiFi()) {
-            displayManager.showMessage("WiFi", "Connected!", 2000);
-
-            // Start mDNS
-            wifiManager.startMDNS("waterpump");
-
-            // Try to initialize IoT client (will fail gracefully if server unavailable)
-            if (iotClient.begin()) {
-                displayManager.showMessage("Cloud", "Connected!", 2000);
-
-                // Set up callbacks
-                iotClient.setCommandCallback(handleIoTCommands);
-                iotClient.setConfigCallback(handleIoTConfig);
-
-                // Initialize sync manager
-                syncManager.begin(&storage, &iotClient);
-
-                // Initial config sync (optional, continues if fails)
-                syncManager.syncConfig();
-            } else {
-                #if ENABLE_SERIAL_DEBUG
-                Serial.println("IoT connection failed - continuing in standalone mode");
-                #endif
-                displayManager.showMessage("System", "Standalone Mode", 2000);
-            }
-        } else {
-            #if ENABLE_SERIAL_DEBUG
-            Serial.println("WiFi connection failed - running standalone");
-            #endif
-            displayManager.showMessage("System", "No WiFi - OK", 2000);
-        }
+        // Connects in the background; outcome arrives as NET_EVT_LINK
+        networkWorker.connect();
         #else
         displayManager.showMessage("System", "IoT Disabled", 2000);
         #endif
@@ -223,32 +243,27 @@ void initializeSystem() {
     waterTracker.begin(&storage, &calculator);
     
     // Try to start web server (optional - only if WiFi/TCP-IP available)
+    // (retried when the background WiFi connect completes)
     if (wifiInitialized) {
-        if (webServer.begin(&storage, &calculator, &pumpController, &waterTracker)) {
-            displayManager.showMessage("WebServer", "Started!", 2000);
-        } else {
-            #if ENABLE_SERIAL_DEBUG
-            Serial.println("Web server failed to start");
-            #endif
-        }
+        startWebServer();
     } else {
         #if ENABLE_SERIAL_DEBUG
         Serial.println("Web server disabled - WiFi not initialized");
         #endif
     }
     
-    // Try to initialize OTA updater (optional - only if WiFi available)
+    // Try to initialize OTA updater (optional - checks need WiFi)
     if (otaUpdater.begin(&storage, IOT_SERVER_URL, currentConfig.deviceToken)) {
         displayManager.showMessage("OTA", "Ready", 2000);
         
         #if OTA_CHECK_AT_STARTUP
-        if (otaUpdater.checkForUpdate()) {
-            displayManager.showMessage("Update", "Available!", 2000);
-        }
+        // Runs after the WiFi connect; NET_EVT_RESULT reports availability
+        networkWorker.checkForUpdate();
         #endif
     }
     
     // Try to initialize ML predictor (optional - works without model)
+    mlPredictor.setDemandProfile(waterTracker.getDemandProfile());
     if (mlPredictor.begin(&storage, IOT_SERVER_URL, currentConfig.deviceToken)) {
         if (mlPredictor.isReady()) {
             displayManager.showMessage("ML", "Model Loaded", 2000);
@@ -257,9 +272,17 @@ void initializeSystem() {
         }
     }
     
-    // Initial sensor reading
-    readSensor();
+    // Input trace for host replay (optional - needs SPIFFS)
+    if (traceRecorder.begin()) {
+        controlLoop.setTrace(&traceRecorder);
+    }
+    
+    // Initial sensor reading (delivered on the first normalOperation pass)
+    controlLoop.begin(currentConfig);
+    subscribeEvents();
+    controlLoop.readSensor();
     
+    scheduleTasks();
     systemInitialized = true;
     
     #if ENABLE_SERIAL_DEBUG
@@ -267,25 +290,96 @@ void initializeSystem() {
     #endif
 }
 
+// Periodic work; everything else in normalOperation() runs every pass.
+// Sensor and telemetry pause while the config menu is open.
+void scheduleTasks() {
+    scheduler.addPeriodic("sensor", SENSOR_SAMPLE_INTERVAL_MS, [](void*) {
+        if (systemState != STATE_NORMAL_OPERATION) return;
+        PROFILE_SCOPE("sensor");
+        controlLoop.readSensor();
+    }, nullptr, TASK_PRIORITY_HIGH, SENSOR_SAMPLE_INTERVAL_MS);
+    
+    scheduler.addPeriodic("tracker", TRACKER_UPDATE_INTERVAL_MS, [](void*) {
+        PROFILE_SCOPE("tracker");
+        waterTracker.loop();
+        trendHistory.updateDays(&waterTracker);
+    });
+    
+    scheduler.addPeriodic("trace", TRACE_FLUSH_INTERVAL_MS, [](void*) {
+        traceRecorder.flush();
+    }, nullptr, TASK_PRIORITY_LOW, TRACE_FLUSH_INTERVAL_MS);
+    
+    #if IOT_ENABLED
+    // IoT work is optional - each task skips while offline
+    scheduler.addPeriodic("telemetry", TELEMETRY_SEND_INTERVAL_MS, [](void*) {
+        if (systemState != STATE_NORMAL_OPERATION) return;
+        if (!networkWorker.isOnline()) return;
+        PROFILE_SCOPE("telemetry");
+        sendTelemetry();
+        reportLeakAlarm();
+    });
+    
+    scheduler.addPeriodic("sync", CONFIG_SYNC_INTERVAL_MS, [](void*) {
+        syncManager.periodicSync();
+    }, nullptr, TASK_PRIORITY_LOW, CONFIG_SYNC_INTERVAL_MS);
+    
+    scheduler.addPeriodic("iotPoll", IOT_POLL_INTERVAL_MS, [](void*) {
+        if (networkWorker.isOnline()) networkWorker.poll();
+    }, nullptr, TASK_PRIORITY_LOW, IOT_POLL_INTERVAL_MS);
+    #endif
+    
+    // Network-bound work only queues a request for the worker
+    scheduler.addPeriodic("ota", OTA_CHECK_INTERVAL_MS, [](void*) {
+        if (otaUpdater.isAutoUpdateEnabled()) networkWorker.autoUpdate();
+    }, nullptr, TASK_PRIORITY_LOW, OTA_CHECK_INTERVAL_MS);
+    
+    scheduler.addPeriodic("ml", ML_UPDATE_CHECK_INTERVAL_MS, [](void*) {
+        if (mlPredictor.isEnabled()) networkWorker.updateModel();
+    }, nullptr, TASK_PRIORITY_LOW, ML_UPDATE_CHECK_INTERVAL_MS);
+}
+
+// Work that used to run every loop pass now runs on change. These run
+// after the control loop's own subscribers (pump control, tracker), so
+// the web snapshot and display see the state they produced.
+void subscribeEvents() {
+    // Web server snapshot and display follow any change
+    eventBus.subscribe<LevelEvent>([](const LevelEvent&, void*) {
+        publishSnapshot();
+        displayDirty = true;
+    });
+    eventBus.subscribe<PumpEvent>([](const PumpEvent&, void*) {
+        publishSnapshot();
+        displayDirty = true;
+    });
+    eventBus.subscribe<LevelEvent>(TrendHistory::onLevel, &trendHistory);
+    
+    #if IOT_ENABLED
+    // Pump changes reach the cloud now rather than at the next telemetry run
+    eventBus.subscribe<PumpEvent>([](const PumpEvent&, void*) {
+        if (networkWorker.isOnline()) sendTelemetry();
+    });
+    #endif
+}
+
 // ==================== FIRST TIME SETUP ====================
-void firstTimeSetup() {
+void firstTimeSetup(ButtonEvent event) {
     // ✅ FIX: Static variables to ensure one-time initialization
     static bool networkStarted = false;
     static bool displayInitialized = false;
-
+    
     // Start network (WiFi or AP) for configuration (only once)
     if (!networkStarted) {
         networkStarted = true;
-
+        
         #if ENABLE_SERIAL_DEBUG
         Serial.println("=================================");
         Serial.println("FIRST TIME SETUP MODE");
         #endif
-
+        
         // Check if WiFi credentials exist
         String ssid, password;
         bool hasWiFiCreds = storage.loadWiFiCredentials(ssid, password);
-
+        
         #if SIMULATION_MODE
         // In simulation mode, always try WiFi (use Wokwi-GUEST if no creds)
         if (!hasWiFiCreds || ssid.isEmpty()) {
@@ -333,14 +427,14 @@ void firstTimeSetup() {
             }
         }
         #endif
-
+        
         #if ENABLE_SERIAL_DEBUG
         Serial.println("=================================");
         #endif
-
+        
         // Start web server for setup (only if WiFi/TCP-IP initialized)
         if (!webServer.isRunning() && wifiInitialized) {
-            if (!webServer.begin(&storage, &calculator, &pumpController, &waterTracker)) {
+            if (!webServer.begin(&calculator, &waterTracker, &systemSnapshot, &controlQueue)) {
                 #if ENABLE_SERIAL_DEBUG
                 Serial.println("WARNING: Web server failed to start!");
                 Serial.println("Check WiFi/network connectivity");
@@ -352,12 +446,12 @@ void firstTimeSetup() {
             #endif
         }
     }
-
+    
     // ✅ Setup via buttons and display
     static int setupStep = 0;  // 0=shape, 1=height, 2=dimensions, 3=thresholds, 4=done
     static TankConfig setupConfig;
     static float tempValue = 0;
-
+    
     // Initialize setup config on first call
     if (!displayInitialized) {
         displayInitialized = true;
@@ -371,10 +465,8 @@ void firstTimeSetup() {
         setupStep = 0;
         tempValue = 0;
     }
-
+    
     // Handle button input for setup
-    ButtonEvent event = buttonHandler.getEvent();
-
     switch (setupStep) {
         case 0: // Tank shape selection
             displayManager.showSetupScreen("Tank Shape:\n" + String(setupConfig.shape == RECTANGULAR ? ">Rectangular" : " Rectangular") + "\n" + String(setupConfig.shape == CYLINDRICAL ? ">Cylindrical" : " Cylindrical") + "\nMID=Select");
@@ -385,7 +477,7 @@ void firstTimeSetup() {
                 tempValue = setupConfig.tankHeight;
             }
             break;
-
+        
         case 1: // Tank height
             displayManager.showSetupScreen("Tank Height:\n" + String(tempValue, 1) + " cm\nUP/DOWN adjust\nMID=Confirm");
             if (event == BTN_TOP_PRESS) {
@@ -404,7 +496,7 @@ void firstTimeSetup() {
                 }
             }
             break;
-
+        
         case 2: // Tank dimensions
             if (setupConfig.shape == RECTANGULAR) {
                 static bool doingWidth = false;
@@ -451,7 +543,7 @@ void firstTimeSetup() {
                 }
             }
             break;
-
+        
         case 3: // Thresholds
             static bool doingUpper = false;
             if (!doingUpper) {
@@ -482,7 +574,7 @@ void firstTimeSetup() {
                 }
             }
             break;
-
+        
         case 4: // Done - save config
             displayManager.showSetupScreen("Setup Complete!\nPress MID\nto save & exit");
             if (event == BTN_MID_PRESS) {
@@ -490,19 +582,19 @@ void firstTimeSetup() {
                 setupConfig.firstTimeSetup = false;
                 storage.saveTankConfig(setupConfig);
                 storage.markSetupComplete();
-
+                
                 #if ENABLE_SERIAL_DEBUG
                 Serial.println("Setup completed via buttons!");
                 Serial.println("Tank configuration saved");
                 #endif
-
+                
                 displayManager.showMessage("Setup", "Complete!", 2000);
                 systemState = STATE_NORMAL_OPERATION;
                 setupStep = 0;
             }
             break;
     }
-
+    
     // ✅ FIX: Check setup status only periodically (every 2 seconds) - for web interface completion
     static unsigned long lastSetupCheck = 0;
     if (millis() - lastSetupCheck > 2000) {
@@ -513,11 +605,11 @@ void firstTimeSetup() {
             #if ENABLE_SERIAL_DEBUG
             Serial.println("Setup completed! Transitioning to normal operation...");
             #endif
-
+            
             // Switch back to main screen and show completion message
             displayManager.setScreen(SCREEN_MAIN);
             displayManager.showMessage("Setup", "Complete!", 2000);
-
+            
             systemState = STATE_NORMAL_OPERATION;
             // initializeSystem() will be called by normalOperation() on next loop
         }
@@ -531,65 +623,37 @@ void normalOperation() {
         initializeSystem();
         return; // Skip rest of loop during initialization
     }
-
-    // Read sensor periodically
-    if (millis() - lastSensorRead > SENSOR_SAMPLE_INTERVAL_MS) {
-        readSensor();
-    }
-    
-    // Update pump control
-    updatePumpControl();
     
-    // Update display
-    updateDisplay();
+    // Sensor, display, telemetry, sync, OTA and ML run from the scheduler
     
-    // Update IoT (OPTIONAL - only if connected)
-    if (wifiManager.isConnected()) {
-        wifiManager.loop();
-        
-        #if IOT_ENABLED
-        if (iotClient.isConnected()) {
-            iotClient.loop();
-            syncManager.loop();
-            
-            // Send telemetry (optional)
-            if (millis() - lastTelemetrySend > TELEMETRY_SEND_INTERVAL_MS) {
-                sendTelemetry();
-            }
-        }
-        #endif
-    }
-    
-    // Update water tracker
-    waterTracker.loop();
-    waterTracker.updateState(currentWaterLevel, pumpController.isOn(), currentInflow);
-    
-    // Update pump controller
-    pumpController.loop();
-    
-    // Update optional features (gracefully skip if not available)
-    if (webServer.isRunning()) {
-        webServer.updateData(currentWaterLevel, currentInflow, maxInflow);
+    // Pump requests from the web server
+    {
+        PROFILE_SCOPE("commands");
+        applyControlCommands();
     }
     
-    if (otaUpdater.isAutoUpdateEnabled()) {
-        otaUpdater.loop();
+    // Cloud commands/config and request results from the network worker
+    {
+        PROFILE_SCOPE("netEvents");
+        networkWorker.dispatch();
     }
     
-    if (mlPredictor.isEnabled()) {
-        mlPredictor.loop();
+    // Pump housekeeping, then readings and pump changes (including those
+    // from the commands above) go to their subscribers; idle passes do nothing
+    {
+        PROFILE_SCOPE("controlLoop");
+        controlLoop.loop();
     }
 }
 
 // ==================== CONFIGURATION MODE ====================
-void configMode() {
+// Returns whether the menu used the event
+bool configMode(ButtonEvent event) {
     static int selectedItem = 0;
     
     displayManager.showConfigMenu(selectedItem);
     
     // Handle config menu navigation
-    ButtonEvent event = buttonHandler.getEvent();
-    
     if (event == BTN_TOP_PRESS) {
         selectedItem = (selectedItem - 1 + 6) % 6;
     } else if (event == BTN_BOTTOM_PRESS) {
@@ -614,6 +678,7 @@ void configMode() {
                 break;
             case 5: // Exit
                 systemState = STATE_NORMAL_OPERATION;
+                displayManager.setScreen(SCREEN_MAIN);  // Redraw over the menu
                 break;
         }
     } else if (event == BTN_MID_LONG_PRESS && selectedItem == 4) {
@@ -622,140 +687,80 @@ void configMode() {
         storage.factoryReset();
         delay(1000); // Brief delay before restart
         ESP.restart();
+    } else {
+        return false;
     }
+    return true;
 }
 
 // ==================== BUTTON EVENT HANDLING ====================
-void handleButtonEvents() {
-    ButtonEvent event = buttonHandler.getEvent();
-
+void handleButtonEvents(ButtonEvent event) {
     if (event == BTN_NONE) return;
-
+    
     // Don't allow screen switching during first-time setup
     if (systemState == STATE_FIRST_TIME_SETUP) {
         return;
     }
-
+    
     switch (event) {
         case BTN_LEFT_PRESS:
-            displayManager.previousScreen();
+            if (systemState == STATE_NORMAL_OPERATION) displayManager.previousScreen();
             break;
-
+        
         case BTN_RIGHT_PRESS:
-            displayManager.nextScreen();
+            if (systemState == STATE_NORMAL_OPERATION) displayManager.nextScreen();
             break;
-            
+        
+        case BTN_LEFT_DOUBLE_CLICK:
+            // Home
+            if (systemState == STATE_NORMAL_OPERATION) displayManager.setScreen(SCREEN_MAIN);
+            break;
+        
         case BTN_MID_PRESS:
             if (systemState == STATE_NORMAL_OPERATION) {
                 systemState = STATE_CONFIG_MODE;
             }
             break;
-            
+        
         case BTN_MANUAL_SWITCH_TOGGLE:
-            if (pumpController.getMode() == MANUAL_MODE || pumpController.getMode() == OVERRIDE_MODE) {
-                pumpController.toggleManual();
-            } else {
-                // Switch to manual mode
-                pumpController.setMode(MANUAL_MODE);
-                pumpController.toggleManual();
-            }
+            // Switches to manual mode first if needed
+            controlLoop.command(PUMP_CMD_TOGGLE_MANUAL, SOURCE_BUTTON);
             break;
-            
+        
         case BTN_MANUAL_SWITCH_LONG_PRESS:
             // Enter/exit override mode
+            controlLoop.command(PUMP_CMD_OVERRIDE, SOURCE_BUTTON);
             if (pumpController.getMode() == OVERRIDE_MODE) {
-                pumpController.exitOverrideMode();
-                displayManager.showMessage("Mode", "AUTO Mode", 2000);
-            } else {
-                pumpController.enterOverrideMode();
                 displayManager.showMessage("Mode", "OVERRIDE!", 2000);
+            } else {
+                displayManager.showMessage("Mode", "AUTO Mode", 2000);
             }
             break;
-            
+        
         default:
             break;
     }
 }
 
-// ==================== SENSOR READING ====================
-void readSensor() {
-    lastSensorRead = millis();
-    
-    float distance = sensor.getAverageDistance(3);
-    
-    if (distance < 0) {
-        #if ENABLE_SERIAL_DEBUG
-        Serial.println("Sensor read error");
-        #endif
-        return;
-    }
-    
-    // Update water level
-    previousWaterLevel = currentWaterLevel;
-    currentWaterLevel = calculator.distanceToLevel(distance);
-    
-    // Calculate inflow
-    unsigned long deltaTime = millis() - lastSensorRead;
-    currentInflow = calculator.calculateInflow(currentWaterLevel, previousWaterLevel, deltaTime);
-    
-    // Update max inflow
-    if (currentInflow > maxInflow) {
-        maxInflow = currentInflow;
-        currentConfig.maxInflow = maxInflow;
-        storage.saveTankConfig(currentConfig);
-    }
-    
-    #if ENABLE_SERIAL_DEBUG
-    Serial.print("Distance: ");
-    Serial.print(distance);
-    Serial.print(" cm, Level: ");
-    Serial.print(currentWaterLevel);
-    Serial.print(" %, Inflow: ");
-    Serial.println(currentInflow);
-    #endif
-}
-
-// ==================== PUMP CONTROL ====================
-void updatePumpControl() {
-    // Safety checks
-    pumpController.updateSafetyCheck(currentWaterLevel, previousWaterLevel, 
-                                     SENSOR_SAMPLE_INTERVAL_MS);
-    
-    // Automatic control if in AUTO mode
-    if (pumpController.getMode() == AUTO_MODE) {
-        pumpController.autoControl(currentWaterLevel, 
-                                   currentConfig.upperThreshold, 
-                                   currentConfig.lowerThreshold);
-    }
-    
-    // Save pump cycle data
-    if (pumpController.getLastStateChangeTime() > 0) {
-        PumpCycle cycle;
-        cycle.timestamp = millis();
-        cycle.motorState = pumpController.isOn();
-        cycle.waterLevel = currentWaterLevel;
-        cycle.inflow = currentInflow;
-        storage.savePumpCycle(cycle);
-    }
-}
-
 // ==================== DISPLAY UPDATE ====================
 void updateDisplay() {
     DisplayData data;
-    data.waterLevel = currentWaterLevel;
-    data.currentInflow = currentInflow;
-    data.maxInflow = maxInflow;
+    data.waterLevel = controlLoop.getWaterLevel();
+    data.currentInflow = controlLoop.getInflow();
+    data.maxInflow = controlLoop.getMaxInflow();
     data.motorState = pumpController.isOn();
     data.manualMode = (pumpController.getMode() == MANUAL_MODE);
     data.overrideMode = (pumpController.getMode() == OVERRIDE_MODE);
     data.dailyUsage = waterTracker.getTodayUsage();
     data.monthlyUsage = waterTracker.getMonthUsage();
-    data.wifiStatus = wifiManager.isConnected() ? "Connected" : "Disconnected";
-    data.iotStatus = iotClient.isConnected() ? "Online" : "Offline";
+    data.wifiConnected = wifiManager.isConnected();
+    data.iotOnline = networkWorker.isOnline();
     data.dryRunAlarm = pumpController.isDryRunDetected();
     data.overflowAlarm = pumpController.isOverflowRisk();
+    data.leakAlarm = waterTracker.isLeakAlarm();
     
     displayManager.updateData(data);
+    displayDirty = false;
 }
 
 // ==================== IOT COMMAND HANDLING ====================
@@ -766,19 +771,21 @@ void handleIoTCommands(const CommandData& cmd) {
     #endif
     
     if (cmd.command == "pump_on") {
-        pumpController.turnOn();
+        controlLoop.command(PUMP_CMD_ON, SOURCE_CLOUD);
     } else if (cmd.command == "pump_off") {
-        pumpController.turnOff();
+        controlLoop.command(PUMP_CMD_OFF, SOURCE_CLOUD);
     } else if (cmd.command == "set_mode_auto") {
-        pumpController.setMode(AUTO_MODE);
+        controlLoop.command(PUMP_CMD_AUTO, SOURCE_CLOUD);
     } else if (cmd.command == "set_mode_manual") {
-        pumpController.setMode(MANUAL_MODE);
+        controlLoop.command(PUMP_CMD_MANUAL, SOURCE_CLOUD);
     } else if (cmd.command == "update_config") {
         handleIoTConfig(cmd.payload);
     } else if (cmd.command == "reset_safety") {
-        pumpController.resetSafetyAlarms();
+        controlLoop.command(PUMP_CMD_RESET_SAFETY, SOURCE_CLOUD);
     } else if (cmd.command == "restart") {
         displayManager.showMessage("System", "Restarting...", 2000);
+        traceRecorder.flush();
+        waterTracker.flush();
         delay(2000);
         ESP.restart();
     }
@@ -795,22 +802,133 @@ void handleIoTConfig(const String& configJson) {
     // Reload config
     currentConfig = storage.loadTankConfig();
     calculator.setTankConfig(currentConfig);
+    controlLoop.setConfig(currentConfig);
+}
+
+// ==================== NETWORK EVENTS ====================
+// Delivered on the control loop by networkWorker.dispatch()
+void handleNetworkEvent(const NetEvent& evt) {
+    displayDirty = true;    // WiFi / cloud status may have changed
+    
+    switch (evt.type) {
+        case NET_EVT_LINK:
+            if (!wifiManager.isConnected()) {
+                #if ENABLE_SERIAL_DEBUG
+                Serial.println("WiFi connection failed - running standalone");
+                #endif
+                displayManager.showMessage("System", "No WiFi - OK", 2000);
+                break;
+            }
+            
+            if (wifiInitialized && !webServer.isRunning()) {
+                startWebServer();
+            }
+            
+            if (evt.ok) {
+                displayManager.showMessage("Cloud", "Connected!", 2000);
+                
+                // Initialize sync manager and run the initial config sync
+                syncManager.begin(&storage, &networkWorker);
+                syncManager.syncConfig();
+            } else {
+                displayManager.showMessage("System", "Standalone Mode", 2000);
+            }
+            break;
+        
+        case NET_EVT_COMMAND:
+            handleIoTCommands(evt.command);
+            break;
+        
+        case NET_EVT_CONFIG:
+            handleIoTConfig(evt.text);
+            break;
+        
+        case NET_EVT_RESULT:
+            if (evt.request == NET_REQ_CONFIG_PUSH) {
+                syncManager.onPushComplete(evt.ok);
+            } else if (evt.request == NET_REQ_STATUS && !evt.ok && evt.text == "leak_detected") {
+                leakReported = false;
+            } else if (evt.request == NET_REQ_OTA_CHECK && evt.ok) {
+                displayManager.showMessage("Update", "Available!", 2000);
+            }
+            break;
+    }
+}
+
+void startWebServer() {
+    if (webServer.begin(&calculator, &waterTracker, &systemSnapshot, &controlQueue)) {
+        webServer.setScheduler(&scheduler);
+        webServer.setEventBus(&eventBus);
+        webServer.setTraceRecorder(&traceRecorder);
+        displayManager.showMessage("WebServer", "Started!", 2000);
+    } else {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("Web server failed to start");
+        #endif
+    }
 }
 
 // ==================== TELEMETRY SENDING ====================
 void sendTelemetry() {
-    if (!iotClient.isConnected()) return;
+    if (!networkWorker.isOnline()) return;
     
     TelemetryData telemetry;
     telemetry.timestamp = millis();
     telemetry.motorState = pumpController.isOn();
-    telemetry.waterLevel = currentWaterLevel;
-    telemetry.currentInflow = currentInflow;
-    telemetry.maxInflow = maxInflow;
+    telemetry.waterLevel = controlLoop.getWaterLevel();
+    telemetry.currentInflow = controlLoop.getInflow();
+    telemetry.maxInflow = controlLoop.getMaxInflow();
     telemetry.dailyUsage = waterTracker.getTodayUsage();
     telemetry.monthlyUsage = waterTracker.getMonthUsage();
     
-    if (iotClient.sendTelemetry(telemetry)) {
-        lastTelemetrySend = millis();
+    networkWorker.sendTelemetry(telemetry);
+}
+
+// Sends one "leak_detected" event per alarm (a failed send clears
+// leakReported in handleNetworkEvent, so the next telemetry run retries)
+void reportLeakAlarm() {
+    if (!waterTracker.isLeakAlarm()) {
+        leakReported = false;
+        return;
+    }
+    
+    if (!leakReported) {
+        leakReported = networkWorker.sendStatus("leak_detected");
+    }
+}
+
+// ==================== SHARED STATE ====================
+// Actuation only ever happens here, on the control loop
+void applyControlCommands() {
+    ControlCommand command;
+    while (controlQueue.pop(command)) {
+        switch (command.type) {
+            case CMD_PUMP_ON:
+                controlLoop.command(PUMP_CMD_ON, SOURCE_WEB);
+                break;
+            case CMD_PUMP_OFF:
+                controlLoop.command(PUMP_CMD_OFF, SOURCE_WEB);
+                break;
+        }
     }
-}
\ No newline at end of file
+}
+
+void publishSnapshot() {
+    SystemSnapshot snapshot;
+    snapshot.timestamp = millis();
+    snapshot.waterLevel = controlLoop.getWaterLevel();
+    snapshot.currentInflow = controlLoop.getInflow();
+    snapshot.maxInflow = controlLoop.getMaxInflow();
+    snapshot.motorState = pumpController.isOn();
+    snapshot.mode = (uint8_t)pumpController.getMode();
+    snapshot.dryRunAlarm = pumpController.isDryRunDetected();
+    snapshot.overflowAlarm = pumpController.isOverflowRisk();
+    snapshot.leakAlarm = waterTracker.isLeakAlarm();
+    snapshot.dailyUsage = waterTracker.getTodayUsage();
+    snapshot.weeklyUsage = waterTracker.getWeekUsage();
+    snapshot.monthlyUsage = waterTracker.getMonthUsage();
+    snapshot.todayCycles = waterTracker.getTodayCycles();
+    snapshot.pumpRate = waterTracker.getPumpRate();
+    
+    systemSnapshot.publish(snapshot);
+}
@@ -4,10 +4,10 @@
 
 MLPredictor::MLPredictor() 
     : _storage(nullptr),
+      _profile(nullptr),
       _modelLoaded(false),
       _enabled(ML_MODEL_ENABLED),
-      _modelTimestamp(0),
-      _lastUpdateCheck(0) {
+      _modelTimestamp(0) {
 }
 
 bool MLPredictor::begin(StorageManager* storage, const String& serverUrl, const String& deviceToken) {
@@ -56,7 +56,17 @@ bool MLPredictor::isReady() {
     return _modelLoaded && _enabled;
 }
 
-MLPrediction MLPredictor::predict(const MLInput& input) {
+void MLPredictor::setDemandProfile(const DemandProfile* profile) {
+    _profile = profile;
+}
+
+MLPrediction MLPredictor::predict(const MLInput& rawInput) {
+    // Fill the historical same-hour average from the demand profile
+    MLInput input = rawInput;
+    if (_profile && input.avgUsageSameHour <= 0) {
+        input.avgUsageSameHour = _profile->getExpected((int)input.dayOfWeek, (int)input.hourOfDay);
+    }
+    
     // If model not loaded or disabled, use fallback prediction
     if (!_modelLoaded || !_enabled) {
         #if ENABLE_SERIAL_DEBUG && ML_FALLBACK_TO_AUTO
@@ -238,22 +248,17 @@ unsigned long MLPredictor::getModelTimestamp() {
     return _modelTimestamp;
 }
 
-void MLPredictor::loop() {
-    // Check for model updates periodically (only if WiFi available)
+void MLPredictor::periodicCheck() {
+    // Check for model updates (only if WiFi available)
     if (WiFi.status() != WL_CONNECTED) {
         return;
     }
     
-    // Check once per day
-    if (millis() - _lastUpdateCheck > 86400000) {
-        _lastUpdateCheck = millis();
-        
-        if (needsModelUpdate()) {
-            #if ENABLE_SERIAL_DEBUG
-            Serial.println("ML model update needed, downloading...");
-            #endif
-            downloadModel();
-        }
+    if (needsModelUpdate()) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("ML model update needed, downloading...");
+        #endif
+        downloadModel();
     }
 }
 
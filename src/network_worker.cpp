@@ -0,0 +1,320 @@
+// network_worker.cpp
+#include "network_worker.h"
+
+NetworkWorker* NetworkWorker::_instance = nullptr;
+
+NetworkWorker::NetworkWorker()
+    : _wifi(nullptr),
+      _iot(nullptr),
+      _ota(nullptr),
+      _ml(nullptr),
+      _task(nullptr),
+      _eventCallback(nullptr),
+      _connectRequested(false),
+      _online(false),
+      _dropped(0),
+      _linkStarted(false),
+      _iotReady(false),
+      _lastIoTAttempt(0) {
+}
+
+bool NetworkWorker::begin(WiFiManager* wifi, IoTClient* iot, OTAUpdater* ota, MLPredictor* ml) {
+    _wifi = wifi;
+    _iot = iot;
+    _ota = ota;
+    _ml = ml;
+    _instance = this;
+    
+    BaseType_t created = xTaskCreatePinnedToCore(taskEntry, "network", NET_WORKER_STACK_SIZE, this,
+                                                 NET_WORKER_PRIORITY, &_task, NET_WORKER_CORE);
+    if (created != pdPASS) {
+        _task = nullptr;
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("Failed to start network worker - network features disabled");
+        #endif
+        return false;
+    }
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Network worker started on core ");
+    Serial.println(NET_WORKER_CORE);
+    #endif
+    
+    return true;
+}
+
+void NetworkWorker::connect() {
+    _connectRequested = true;
+    if (_task) xTaskNotifyGive(_task);
+}
+
+bool NetworkWorker::sendTelemetry(const TelemetryData& data) {
+    NetRequest req;
+    req.type = NET_REQ_TELEMETRY;
+    req.telemetry = data;
+    return post(req);
+}
+
+bool NetworkWorker::sendStatus(const String& status) {
+    NetRequest req;
+    req.type = NET_REQ_STATUS;
+    req.text = status;
+    return post(req);
+}
+
+bool NetworkWorker::sendConfig(const TankConfig& config) {
+    NetRequest req;
+    req.type = NET_REQ_CONFIG_PUSH;
+    req.config = config;
+    return post(req);
+}
+
+bool NetworkWorker::requestConfig() {
+    NetRequest req;
+    req.type = NET_REQ_CONFIG_PULL;
+    return post(req);
+}
+
+bool NetworkWorker::poll() {
+    NetRequest req;
+    req.type = NET_REQ_POLL;
+    return post(req);
+}
+
+bool NetworkWorker::checkForUpdate() {
+    NetRequest req;
+    req.type = NET_REQ_OTA_CHECK;
+    return post(req);
+}
+
+bool NetworkWorker::autoUpdate() {
+    NetRequest req;
+    req.type = NET_REQ_OTA_AUTO_UPDATE;
+    return post(req);
+}
+
+bool NetworkWorker::updateModel() {
+    NetRequest req;
+    req.type = NET_REQ_ML_UPDATE;
+    return post(req);
+}
+
+void NetworkWorker::dispatch() {
+    NetEvent evt;
+    while (_inbox.pop(evt)) {
+        if (_eventCallback) {
+            _eventCallback(evt);
+        }
+    }
+}
+
+void NetworkWorker::setEventCallback(NetEventCallback callback) {
+    _eventCallback = callback;
+}
+
+bool NetworkWorker::isOnline() {
+    return _online;
+}
+
+uint32_t NetworkWorker::getDroppedCount() {
+    return _dropped;
+}
+
+// ==================== WORKER TASK ====================
+
+void NetworkWorker::taskEntry(void* param) {
+    NetworkWorker* self = static_cast<NetworkWorker*>(param);
+    
+    for (;;) {
+        self->service();
+        
+        // Sleep until a request is posted or the idle period elapses
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NET_WORKER_IDLE_MS));
+    }
+}
+
+void NetworkWorker::service() {
+    if (_connectRequested.exchange(false)) {
+        connectLink();
+    }
+    
+    if (_linkStarted) {
+        // Non-blocking WiFi auto-reconnect
+        _wifi->loop();
+        
+        #if IOT_ENABLED
+        if (!_iotReady && _wifi->isConnected() && millis() - _lastIoTAttempt > IOT_RETRY_AFTER_FAIL_MS) {
+            if (startIoT()) {
+                NetEvent evt;
+                evt.type = NET_EVT_LINK;
+                evt.ok = true;
+                postEvent(evt);
+            }
+        }
+        
+        // MQTT/WebSocket keep-alive and reconnect (may block here, not in loop())
+        if (_iotReady && _wifi->isConnected()) {
+            _iot->loop();
+        }
+        #endif
+    }
+    
+    NetRequest req;
+    while (_outbox.pop(req)) {
+        handleRequest(req);
+    }
+    
+    #if IOT_ENABLED
+    _online = cloudReady() && _iot->isConnected();
+    #else
+    _online = false;
+    #endif
+}
+
+void NetworkWorker::connectLink() {
+    _linkStarted = true;
+    
+    // Waits up to WIFI_CONNECT_TIMEOUT_MS
+    if (_wifi->connectToSavedWiFi()) {
+        _wifi->startMDNS("waterpump");
+        
+        #if IOT_ENABLED
+        startIoT();
+        #endif
+    }
+    
+    NetEvent evt;
+    evt.type = NET_EVT_LINK;
+    evt.ok = _iotReady;
+    postEvent(evt);
+}
+
+bool NetworkWorker::startIoT() {
+    _lastIoTAttempt = millis();
+    
+    if (!_iot->begin()) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("IoT connection failed - continuing in standalone mode");
+        #endif
+        return false;
+    }
+    
+    // Cloud messages arrive on this task and are forwarded to the inbox
+    _iot->setCommandCallback(onCommand);
+    _iot->setConfigCallback(onConfig);
+    _iotReady = true;
+    return true;
+}
+
+// Cloud client started and WiFi up (worker task only)
+bool NetworkWorker::cloudReady() {
+    return _iotReady && _wifi->isConnected();
+}
+
+void NetworkWorker::handleRequest(const NetRequest& req) {
+    switch (req.type) {
+        case NET_REQ_TELEMETRY:
+        case NET_REQ_STATUS:
+        case NET_REQ_CONFIG_PUSH:
+        case NET_REQ_CONFIG_PULL:
+        case NET_REQ_POLL:
+            // Without a started client there is nothing to send through
+            if (!cloudReady()) {
+                postResult(req.type, false, req.text);
+                return;
+            }
+            break;
+        
+        default:
+            break;
+    }
+    
+    switch (req.type) {
+        case NET_REQ_TELEMETRY:
+            _iot->sendTelemetry(req.telemetry);
+            break;
+        
+        case NET_REQ_STATUS:
+            postResult(req.type, _iot->sendStatus(req.text), req.text);
+            break;
+        
+        case NET_REQ_CONFIG_PUSH:
+            postResult(req.type, _iot->sendConfig(req.config));
+            break;
+        
+        case NET_REQ_CONFIG_PULL:
+            _iot->requestConfig();
+            break;
+        
+        case NET_REQ_POLL:
+            _iot->poll();
+            break;
+        
+        case NET_REQ_OTA_CHECK:
+            postResult(req.type, _ota->checkForUpdate());
+            break;
+        
+        case NET_REQ_OTA_AUTO_UPDATE:
+            _ota->periodicCheck();
+            break;
+        
+        case NET_REQ_ML_UPDATE:
+            _ml->periodicCheck();
+            break;
+    }
+}
+
+// Control loop side only (single producer)
+bool NetworkWorker::post(NetRequest& req) {
+    if (!_task || !_outbox.push(req)) {
+        _dropped++;
+        #if ENABLE_SERIAL_DEBUG
+        Serial.print("Network request dropped: ");
+        Serial.println((int)req.type);
+        #endif
+        return false;
+    }
+    
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+// Worker side only (single producer)
+void NetworkWorker::postEvent(NetEvent& evt) {
+    if (!_inbox.push(evt)) {
+        _dropped++;
+        #if ENABLE_SERIAL_DEBUG
+        Serial.print("Network event dropped: ");
+        Serial.println((int)evt.type);
+        #endif
+    }
+}
+
+void NetworkWorker::postResult(NetRequestType request, bool ok, const String& text) {
+    NetEvent evt;
+    evt.type = NET_EVT_RESULT;
+    evt.request = request;
+    evt.ok = ok;
+    evt.text = text;
+    postEvent(evt);
+}
+
+void NetworkWorker::onCommand(const CommandData& cmd) {
+    if (!_instance) return;
+    
+    NetEvent evt;
+    evt.type = NET_EVT_COMMAND;
+    evt.ok = true;
+    evt.command = cmd;
+    _instance->postEvent(evt);
+}
+
+void NetworkWorker::onConfig(const String& configJson) {
+    if (!_instance) return;
+    
+    NetEvent evt;
+    evt.type = NET_EVT_CONFIG;
+    evt.ok = true;
+    evt.text = configJson;
+    _instance->postEvent(evt);
+}
@@ -7,19 +7,12 @@ OTAUpdater::OTAUpdater()
       _status(UPDATE_IDLE),
       _progress(0),
       _autoUpdateEnabled(AUTO_OTA_ENABLED),
-      _lastCheckTime(0),
       _updateAvailable(false) {
 }
 
 bool OTAUpdater::begin(StorageManager* storage, const String& serverUrl, const String& deviceToken) {
-    // Check if WiFi is available
-    if (WiFi.status() != WL_CONNECTED) {
-        #if ENABLE_SERIAL_DEBUG
-        Serial.println("OTA Updater NOT initialized - No WiFi connection");
-        #endif
-        return false;
-    }
-    
+    // WiFi may still be connecting on the network worker; every check
+    // tests the link itself
     _storage = storage;
     _serverUrl = serverUrl;
     _deviceToken = deviceToken;
@@ -175,23 +168,18 @@ bool OTAUpdater::isAutoUpdateEnabled() {
     return _autoUpdateEnabled;
 }
 
-void OTAUpdater::loop() {
+void OTAUpdater::periodicCheck() {
     // Only run if auto-update is enabled and WiFi available
     if (!_autoUpdateEnabled || WiFi.status() != WL_CONNECTED) {
         return;
     }
     
-    // Check for updates periodically (once per day)
-    if (millis() - _lastCheckTime > 86400000) { // 24 hours
-        _lastCheckTime = millis();
-        
-        if (checkForUpdate()) {
-            // Update available, perform update
-            #if ENABLE_SERIAL_DEBUG
-            Serial.println("Auto-update: Installing update...");
-            #endif
-            performUpdate();
-        }
+    if (checkForUpdate()) {
+        // Update available, perform update
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("Auto-update: Installing update...");
+        #endif
+        performUpdate();
     }
 }
 
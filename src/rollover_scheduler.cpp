@@ -0,0 +1,130 @@
+// rollover_scheduler.cpp
+#include "rollover_scheduler.h"
+#include "config.h"
+#include "utils.h"
+
+RolloverScheduler::RolloverScheduler()
+    : _callback(nullptr),
+      _context(nullptr),
+      _anchored(false),
+      _nextDeadline(0) {
+    for (int i = 0; i < PERIOD_COUNT; i++) {
+        _start[i] = 0;
+        _deadline[i] = 0;
+    }
+}
+
+void RolloverScheduler::begin(Callback callback, void* context) {
+    _callback = callback;
+    _context = context;
+    _anchored = false;
+}
+
+void RolloverScheduler::loop() {
+    time_t now = time(nullptr);
+    
+    // Fast path: inside the current day and before the next deadline
+    if (_anchored && now < _nextDeadline && now >= _start[0]) return;
+    
+    if (!TimeUtils::isTimeSynced()) return;
+    
+    if (!_anchored || now < _start[0]) {
+        anchor(now);
+        return;
+    }
+    
+    // Close every missed period, oldest deadline first (day before week
+    // before month when they coincide)
+    int fired = 0;
+    while (now >= _nextDeadline) {
+        if (fired >= ROLLOVER_MAX_CATCHUP) {
+            #if ENABLE_SERIAL_DEBUG
+            Serial.println("Rollover catch-up limit reached - re-anchoring");
+            #endif
+            anchor(now);
+            return;
+        }
+        
+        int p = 0;
+        for (int i = 1; i < PERIOD_COUNT; i++) {
+            if (_deadline[i] < _deadline[p]) p = i;
+        }
+        
+        time_t closedStart = _start[p];
+        _start[p] = _deadline[p];
+        _deadline[p] = nextPeriodStart((RolloverEvent)(p + 1), _start[p]);
+        updateNextDeadline();
+        fired++;
+        
+        if (_callback) {
+            _callback((RolloverEvent)(p + 1), closedStart, _start[p], _context);
+        }
+    }
+}
+
+time_t RolloverScheduler::getDeadline(RolloverEvent event) const {
+    if (event == ROLLOVER_ANCHOR) return 0;
+    return _deadline[event - 1];
+}
+
+time_t RolloverScheduler::periodStart(RolloverEvent event, time_t t) {
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    
+    if (event == ROLLOVER_WEEK) {
+        timeinfo.tm_mday -= (timeinfo.tm_wday - ROLLOVER_WEEK_START_DAY + 7) % 7;
+    } else if (event == ROLLOVER_MONTH) {
+        timeinfo.tm_mday = 1;
+    }
+    timeinfo.tm_hour = 0;
+    timeinfo.tm_min = 0;
+    timeinfo.tm_sec = 0;
+    timeinfo.tm_isdst = -1;
+    return mktime(&timeinfo);
+}
+
+void RolloverScheduler::anchor(time_t now) {
+    for (int p = 0; p < PERIOD_COUNT; p++) {
+        _start[p] = periodStart((RolloverEvent)(p + 1), now);
+        _deadline[p] = nextPeriodStart((RolloverEvent)(p + 1), _start[p]);
+    }
+    updateNextDeadline();
+    _anchored = true;
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Rollover anchored, next day deadline: ");
+    Serial.println(TimeUtils::formatTimestamp(_deadline[0]));
+    #endif
+    
+    if (_callback) {
+        _callback(ROLLOVER_ANCHOR, 0, _start[0], _context);
+    }
+}
+
+void RolloverScheduler::updateNextDeadline() {
+    _nextDeadline = _deadline[0];
+    for (int i = 1; i < PERIOD_COUNT; i++) {
+        if (_deadline[i] < _nextDeadline) _nextDeadline = _deadline[i];
+    }
+}
+
+// Start of the period after the one starting at 'start'. Calendar fields
+// are normalized by mktime, with tm_isdst = -1 so DST is resolved anew.
+time_t RolloverScheduler::nextPeriodStart(RolloverEvent event, time_t start) {
+    struct tm timeinfo;
+    localtime_r(&start, &timeinfo);
+    
+    if (event == ROLLOVER_DAY) {
+        timeinfo.tm_mday += 1;
+    } else if (event == ROLLOVER_WEEK) {
+        timeinfo.tm_mday += 7;
+    } else {
+        timeinfo.tm_mon += 1;
+        timeinfo.tm_mday = 1;
+    }
+    timeinfo.tm_hour = 0;
+    timeinfo.tm_min = 0;
+    timeinfo.tm_sec = 0;
+    timeinfo.tm_isdst = -1;
+    return mktime(&timeinfo);
+}
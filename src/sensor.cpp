@@ -2,6 +2,7 @@
 #include "sensor.h"
 #include "config.h"
 #include "pins.h"
+#include "fault_injection.h"
 
 UltrasonicSensor::UltrasonicSensor(uint8_t trigPin, uint8_t echoPin) 
     : _trigPin(trigPin), _echoPin(echoPin), _lastReadTime(0) {
@@ -83,14 +84,26 @@ float UltrasonicSensor::readRaw() {
     delayMicroseconds(10);
     digitalWrite(_trigPin, LOW);
     
+    FAULT_STALL(FAULT_SENSOR_SLOW);
+    
     // Read echo pulse
-    unsigned long duration = pulseIn(_echoPin, HIGH, SENSOR_TIMEOUT_MS * 1000);
+    unsigned long duration;
+    if (FAULT_FIRES(FAULT_SENSOR_TIMEOUT)) {
+        delay(FAULT_DELAY(FAULT_SENSOR_TIMEOUT, SENSOR_TIMEOUT_MS));
+        duration = 0;
+    } else {
+        duration = pulseIn(_echoPin, HIGH, SENSOR_TIMEOUT_MS * 1000);
+    }
     _lastReadTime = millis();
     
     if (duration == 0) {
         return -1.0; // Timeout
     }
     
+    if (FAULT_FIRES(FAULT_SENSOR_CORRUPT)) {
+        return 2.0 + FAULT_RANDOM() * 398.0; // Anywhere in the sensor's range
+    }
+    
     // Calculate distance: duration in microseconds, speed of sound = 343 m/s
     // Distance = (duration * 0.0343) / 2
     float distance = (duration * 0.0343) / 2.0;
@@ -0,0 +1,225 @@
+// storage_journal.cpp
+#include "storage_journal.h"
+
+#define JOURNAL_KEY "jrnl"
+#define JOURNAL_MAGIC 0x4A52
+
+StorageJournal::StorageJournal()
+    : _length(sizeof(Header)), _count(0), _overflow(false) {
+}
+
+bool StorageJournal::stageBool(const char* key, bool value) {
+    uint8_t raw = value ? 1 : 0;
+    return stage(ENTRY_BOOL, key, &raw, sizeof(raw));
+}
+
+bool StorageJournal::stageUChar(const char* key, uint8_t value) {
+    return stage(ENTRY_UCHAR, key, &value, sizeof(value));
+}
+
+bool StorageJournal::stageInt(const char* key, int32_t value) {
+    return stage(ENTRY_INT, key, &value, sizeof(value));
+}
+
+bool StorageJournal::stageULong(const char* key, uint32_t value) {
+    return stage(ENTRY_ULONG, key, &value, sizeof(value));
+}
+
+bool StorageJournal::stageFloat(const char* key, float value) {
+    return stage(ENTRY_FLOAT, key, &value, sizeof(value));
+}
+
+bool StorageJournal::stageString(const char* key, const String& value) {
+    return stage(ENTRY_STRING, key, value.c_str(), value.length());
+}
+
+bool StorageJournal::stageBytes(const char* key, const void* value, size_t len) {
+    return stage(ENTRY_BYTES, key, value, len);
+}
+
+bool StorageJournal::commit(TrackedPreferences& prefs) {
+    if (_overflow) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("Journal overflow - transaction dropped");
+        #endif
+        return false;
+    }
+    if (_count == 0) return true;
+    
+    // Finish a transaction whose apply failed earlier before its journal
+    // is overwritten; give up if it still can't be applied
+    if (prefs.getBytesLength(JOURNAL_KEY) > 0 && replay(prefs) == REPLAY_FAILED) {
+        return false;
+    }
+    
+    int applied = 0;
+    
+    // A single NVS item write is already atomic; skip the journal round-trip
+    if (_count == 1) {
+        return apply(prefs, _buffer + sizeof(Header), _length - sizeof(Header), applied);
+    }
+    
+    Header header;
+    header.magic = JOURNAL_MAGIC;
+    header.count = _count;
+    header.reserved = 0;
+    header.length = _length - sizeof(Header);
+    header.crc = crc16(_buffer + sizeof(Header), header.length);
+    memcpy(_buffer, &header, sizeof(Header));
+    
+    // 1. Make the transaction durable as a single NVS item
+    if (prefs.putBytes(JOURNAL_KEY, _buffer, _length) != _length) {
+        return false;
+    }
+    
+    // 2. Apply to the real keys, 3. retire the journal once all of them landed.
+    // On failure the journal stays for replay() to finish the transaction.
+    if (!apply(prefs, _buffer + sizeof(Header), header.length, applied)) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.printf("Journal apply failed after %d of %d updates - kept for replay\n", applied, _count);
+        #endif
+        return false;
+    }
+    
+    prefs.remove(JOURNAL_KEY);
+    return true;
+}
+
+int StorageJournal::replay(TrackedPreferences& prefs) {
+    size_t size = prefs.getBytesLength(JOURNAL_KEY);
+    if (size == 0) return 0;
+    
+    int applied = REPLAY_DAMAGED;
+    
+    if (size >= sizeof(Header) && size <= JOURNAL_MAX_BYTES) {
+        uint8_t buffer[JOURNAL_MAX_BYTES];
+        prefs.getBytes(JOURNAL_KEY, buffer, size);
+        
+        Header header;
+        memcpy(&header, buffer, sizeof(Header));
+        
+        bool valid = header.magic == JOURNAL_MAGIC &&
+                     header.count <= JOURNAL_MAX_ENTRIES &&
+                     header.length == size - sizeof(Header) &&
+                     header.crc == crc16(buffer + sizeof(Header), header.length);
+        
+        if (valid) {
+            applied = 0;
+            if (!apply(prefs, buffer + sizeof(Header), header.length, applied)) {
+                // Keep the journal so the next boot or commit retries it
+                return REPLAY_FAILED;
+            }
+        }
+    }
+    
+    prefs.remove(JOURNAL_KEY);
+    return applied;
+}
+
+bool StorageJournal::stage(EntryType type, const char* key, const void* value, size_t len) {
+    size_t keyLen = strlen(key);
+    size_t needed = 2 + keyLen + 2 + len;
+    
+    if (_overflow || _count >= JOURNAL_MAX_ENTRIES || keyLen > 15 ||
+        _length + needed > JOURNAL_MAX_BYTES) {
+        _overflow = true;
+        return false;
+    }
+    
+    // Entry: [type][keyLen][key...][valueLen lo][valueLen hi][value...]
+    uint8_t* p = _buffer + _length;
+    *p++ = type;
+    *p++ = (uint8_t)keyLen;
+    memcpy(p, key, keyLen);
+    p += keyLen;
+    *p++ = len & 0xFF;
+    *p++ = (len >> 8) & 0xFF;
+    memcpy(p, value, len);
+    
+    _length += needed;
+    _count++;
+    return true;
+}
+
+bool StorageJournal::apply(TrackedPreferences& prefs, const uint8_t* data, size_t length, int& applied) {
+    size_t pos = 0;
+    char key[16];
+    
+    while (pos + 4 <= length) {
+        EntryType type = (EntryType)data[pos];
+        size_t keyLen = data[pos + 1];
+        if (keyLen > 15 || pos + 2 + keyLen + 2 > length) return false;
+        
+        memcpy(key, data + pos + 2, keyLen);
+        key[keyLen] = '\0';
+        pos += 2 + keyLen;
+        
+        size_t valueLen = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+        if (pos + valueLen > length) return false;
+        const uint8_t* value = data + pos;
+        pos += valueLen;
+        
+        // put*() returns the bytes stored, 0 on failure
+        bool ok;
+        
+        switch (type) {
+            case ENTRY_BOOL:
+                ok = prefs.putBool(key, value[0] != 0) == 1;
+                break;
+            case ENTRY_UCHAR:
+                ok = prefs.putUChar(key, value[0]) == 1;
+                break;
+            case ENTRY_INT: {
+                int32_t v;
+                memcpy(&v, value, sizeof(v));
+                ok = prefs.putInt(key, v) == sizeof(v);
+                break;
+            }
+            case ENTRY_ULONG: {
+                uint32_t v;
+                memcpy(&v, value, sizeof(v));
+                ok = prefs.putULong(key, v) == sizeof(v);
+                break;
+            }
+            case ENTRY_FLOAT: {
+                float v;
+                memcpy(&v, value, sizeof(v));
+                ok = prefs.putFloat(key, v) == sizeof(v);
+                break;
+            }
+            case ENTRY_STRING: {
+                String v;
+                v.reserve(valueLen);
+                for (size_t i = 0; i < valueLen; i++) v += (char)value[i];
+                size_t written = prefs.putString(key, v);
+                // putString() returns strlen(), which is 0 for an empty
+                // value even on success, so confirm that one by reading back
+                ok = valueLen > 0 ? written == valueLen
+                                  : prefs.isKey(key) && prefs.getString(key, "-").length() == 0;
+                break;
+            }
+            case ENTRY_BYTES:
+                ok = prefs.putBytes(key, value, valueLen) == valueLen;
+                break;
+            default:
+                return false;
+        }
+        if (!ok) return false;
+        applied++;
+    }
+    
+    return pos == length;
+}
+
+uint16_t StorageJournal::crc16(const uint8_t* data, size_t length) {
+    // CRC-16/CCITT-FALSE
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
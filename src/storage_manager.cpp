@@ -1,35 +1,54 @@
 // storage_manager.cpp
 #include "storage_manager.h"
 #include "config.h"
+#include "utils.h"
 
-StorageManager::StorageManager() {}
+StorageManager::StorageManager() : _currentDay(0), _tableMigrated(false), _tableCached(false) {}
 
 bool StorageManager::begin() {
-    return preferences.begin(NAMESPACE, false);
-}
-
-bool StorageManager::saveTankConfig(const TankConfig& config) {
     if (!preferences.begin(NAMESPACE, false)) return false;
     
-    preferences.putBool("firstSetup", config.firstTimeSetup);
-    preferences.putFloat("tankHeight", config.tankHeight);
-    preferences.putFloat("tankLength", config.tankLength);
-    preferences.putFloat("tankWidth", config.tankWidth);
-    preferences.putFloat("tankRadius", config.tankRadius);
-    preferences.putUChar("tankShape", (uint8_t)config.shape);
-    preferences.putFloat("upperThresh", config.upperThreshold);
-    preferences.putFloat("lowerThresh", config.lowerThreshold);
-    preferences.putFloat("maxInflow", config.maxInflow);
-    preferences.putString("devToken", config.deviceToken);
-    preferences.putULong("configVer", config.configVersion);
-    preferences.putString("modSource", config.lastModifiedSource);
-    preferences.putBool("needsSync", config.needsSync);
-    preferences.putUChar("syncMode", (uint8_t)config.syncMode);
+    // Finish (or drop) a transaction interrupted by a power cut
+    unsigned long replayStart = micros();
+    int replayed = StorageJournal::replay(preferences);
+    if (replayed != 0) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.printf("Storage journal: %s %d updates in %lu us\n",
+                      replayed > 0 ? "replayed" :
+                      replayed == StorageJournal::REPLAY_FAILED ? "failed to apply, kept" : "discarded damaged,",
+                      replayed > 0 ? replayed : 0, micros() - replayStart);
+        #endif
+    }
+    
+    ensureDailyTable();
     
     preferences.end();
     return true;
 }
 
+bool StorageManager::saveTankConfig(const TankConfig& config) {
+    StorageJournal journal;
+    journal.stageBool("firstSetup", config.firstTimeSetup);
+    journal.stageFloat("tankHeight", config.tankHeight);
+    journal.stageFloat("tankLength", config.tankLength);
+    journal.stageFloat("tankWidth", config.tankWidth);
+    journal.stageFloat("tankRadius", config.tankRadius);
+    journal.stageUChar("tankShape", (uint8_t)config.shape);
+    journal.stageFloat("upperThresh", config.upperThreshold);
+    journal.stageFloat("lowerThresh", config.lowerThreshold);
+    journal.stageFloat("maxInflow", config.maxInflow);
+    journal.stageString("devToken", config.deviceToken);
+    journal.stageULong("configVer", config.configVersion);
+    journal.stageString("modSource", config.lastModifiedSource);
+    journal.stageBool("needsSync", config.needsSync);
+    journal.stageUChar("syncMode", (uint8_t)config.syncMode);
+    
+    if (!preferences.begin(NAMESPACE, false)) return false;
+    bool ok = journal.commit(preferences);
+    preferences.end();
+    return ok;
+}
+
 TankConfig StorageManager::loadTankConfig() {
     TankConfig config;
     
@@ -68,11 +87,14 @@ void StorageManager::markSetupComplete() {
 }
 
 bool StorageManager::saveWiFiCredentials(const String& ssid, const String& password) {
+    StorageJournal journal;
+    journal.stageString("wifiSSID", ssid);
+    journal.stageString("wifiPass", password);
+    
     preferences.begin(NAMESPACE, false);
-    preferences.putString("wifiSSID", ssid);
-    preferences.putString("wifiPass", password);
+    bool ok = journal.commit(preferences);
     preferences.end();
-    return true;
+    return ok;
 }
 
 bool StorageManager::loadWiFiCredentials(String& ssid, String& password) {
@@ -80,7 +102,7 @@ bool StorageManager::loadWiFiCredentials(String& ssid, String& password) {
     ssid = preferences.getString("wifiSSID", "");
     password = preferences.getString("wifiPass", "");
     preferences.end();
-
+    
     // If no credentials found and in simulation mode, use Wokwi defaults
     #if SIMULATION_MODE
     if (ssid.isEmpty()) {
@@ -92,7 +114,7 @@ bool StorageManager::loadWiFiCredentials(String& ssid, String& password) {
         return true; // Return true so it attempts connection
     }
     #endif
-
+    
     return !ssid.isEmpty();
 }
 
@@ -113,10 +135,14 @@ String StorageManager::loadDeviceToken() {
 bool StorageManager::updateConfigVersion(const String& source) {
     preferences.begin(NAMESPACE, false);
     unsigned long version = preferences.getULong("configVer", 0) + 1;
-    preferences.putULong("configVer", version);
-    preferences.putString("modSource", source);
+    
+    StorageJournal journal;
+    journal.stageULong("configVer", version);
+    journal.stageString("modSource", source);
+    bool ok = journal.commit(preferences);
+    
     preferences.end();
-    return true;
+    return ok;
 }
 
 bool StorageManager::markNeedsSync(bool needs) {
@@ -134,10 +160,10 @@ bool StorageManager::setSyncMode(SyncMode mode) {
 }
 
 bool StorageManager::savePumpCycle(const PumpCycle& cycle) {
-    int currentIndex = getCurrentCycleIndex();
-    String key = generateCycleKey(currentIndex);
+    if (!preferences.begin(NAMESPACE, false)) return false;
     
-    preferences.begin(NAMESPACE, false);
+    int currentIndex = preferences.getInt("cycleIdx", 0);
+    String key = generateCycleKey(currentIndex);
     
     // Create JSON string to store cycle data
     JsonDocument doc;
@@ -148,11 +174,16 @@ bool StorageManager::savePumpCycle(const PumpCycle& cycle) {
     
     String jsonStr;
     serializeJson(doc, jsonStr);
-    preferences.putString(key.c_str(), jsonStr);
     
-    incrementCycleIndex();
+    // Record and index move together, so a power cut can't leave the index
+    // pointing past a slot that still holds an older cycle
+    StorageJournal journal;
+    journal.stageString(key.c_str(), jsonStr);
+    journal.stageInt("cycleIdx", (currentIndex + 1) % MAX_PUMP_CYCLE_LOGS);
+    bool ok = journal.commit(preferences);
+    
     preferences.end();
-    return true;
+    return ok;
 }
 
 bool StorageManager::getPumpCycles(PumpCycle* cycles, int maxCount, int& actualCount) {
@@ -181,59 +212,123 @@ bool StorageManager::getPumpCycles(PumpCycle* cycles, int maxCount, int& actualC
     return actualCount > 0;
 }
 
-bool StorageManager::saveDailyUsage(const DailyUsage& usage) {
-    String key = generateDailyKey(usage.date);
-    
-    preferences.begin(NAMESPACE, false);
-    JsonDocument doc;
-    doc["date"] = usage.date;
-    doc["usage"] = usage.totalUsageLiters;
-    doc["cycles"] = usage.pumpCycles;
-    
-    String jsonStr;
-    serializeJson(doc, jsonStr);
-    preferences.putString(key.c_str(), jsonStr);
+int StorageManager::getPumpCycleIndex() {
+    preferences.begin(NAMESPACE, true);
+    int currentIndex = preferences.getInt("cycleIdx", 0);
     preferences.end();
-    return true;
+    return currentIndex;
 }
 
-bool StorageManager::getDailyUsage(unsigned long date, DailyUsage& usage) {
-    String key = generateDailyKey(date);
+// Reads relative to a cycleIdx snapshot, so a cycle logged in between
+// doesn't shift the ages of a caller walking the ring
+bool StorageManager::getPumpCycle(int cycleIdx, int age, PumpCycle& cycle) {
+    if (age < 0 || age >= MAX_PUMP_CYCLE_LOGS) return false;
+    
+    int idx = (cycleIdx - 1 - age + MAX_PUMP_CYCLE_LOGS) % MAX_PUMP_CYCLE_LOGS;
     
     preferences.begin(NAMESPACE, true);
+    String key = generateCycleKey(idx);
     String jsonStr = preferences.getString(key.c_str(), "");
     preferences.end();
     
     if (jsonStr.isEmpty()) return false;
     
     JsonDocument doc;
-    deserializeJson(doc, jsonStr);
+    if (deserializeJson(doc, jsonStr)) return false;
     
-    usage.date = doc["date"];
-    usage.totalUsageLiters = doc["usage"];
-    usage.pumpCycles = doc["cycles"];
+    cycle.timestamp = doc["ts"];
+    cycle.motorState = doc["state"];
+    cycle.waterLevel = doc["level"];
+    cycle.inflow = doc["inflow"];
+    return true;
+}
+
+bool StorageManager::saveDailyUsage(const DailyUsage& usage) {
+    StorageJournal journal;
     
+    preferences.begin(NAMESPACE, false);
+    putDailyRecord(usage, journal);
+    bool ok = journal.commit(preferences);
+    preferences.end();
+    return ok;
+}
+
+bool StorageManager::saveDailyUsage(const DailyUsage& usage, const UsageTotals& totals) {
+    StorageJournal journal;
+    
+    preferences.begin(NAMESPACE, false);
+    putDailyRecord(usage, journal);
+    
+    // Totals commit together with the daily record
+    journal.stageInt("totYear", totals.year);
+    journal.stageUChar("totMonth", (uint8_t)totals.month);
+    journal.stageFloat("totMonthL", totals.monthUsageLiters);
+    journal.stageFloat("totYearL", totals.yearUsageLiters);
+    journal.stageInt("totWeekD", totals.weekStartDay);
+    journal.stageFloat("totWeekL", totals.weekUsageLiters);
+    bool ok = journal.commit(preferences);
+    
+    preferences.end();
+    return ok;
+}
+
+bool StorageManager::loadUsageTotals(UsageTotals& totals) {
+    preferences.begin(NAMESPACE, true);
+    bool found = preferences.isKey("totYear");
+    
+    if (found) {
+        totals.year = preferences.getInt("totYear", 0);
+        totals.month = preferences.getUChar("totMonth", 0);
+        totals.monthUsageLiters = preferences.getFloat("totMonthL", 0.0);
+        totals.yearUsageLiters = preferences.getFloat("totYearL", 0.0);
+        totals.weekStartDay = preferences.getInt("totWeekD", 0);
+        totals.weekUsageLiters = preferences.getFloat("totWeekL", 0.0);
+    }
+    
+    preferences.end();
+    return found;
+}
+
+bool StorageManager::getDailyUsage(unsigned long date, DailyUsage& usage) {
+    uint16_t day = (uint16_t)TimeUtils::localDayNumber(date);
+    
+    // The open day lives in its own small record
+    DailyRecord current;
+    if (loadCurrentRecord(current) && current.day == day) {
+        usage = unpackDailyRecord(current);
+        return true;
+    }
+    
+    const DailyRecord* table = loadDailyTable();
+    if (!table) return false;
+    
+    DailyRecord record = table[day % DAILY_TABLE_DAYS];
+    if (record.day != day) return false;
+    
+    usage = unpackDailyRecord(record);
     return true;
 }
 
 bool StorageManager::getMonthlyUsage(int year, int month, float& totalLiters) {
-    // Calculate timestamps for first and last day of month
-    struct tm timeinfo = {0};
-    timeinfo.tm_year = year - 1900;
-    timeinfo.tm_mon = month - 1;
-    timeinfo.tm_mday = 1;
-    unsigned long startDate = mktime(&timeinfo);
-    
-    // Get days in month
-    timeinfo.tm_mon = month;
-    timeinfo.tm_mday = 0;
-    int daysInMonth = mktime(&timeinfo) / 86400 - startDate / 86400;
+    long firstDay = TimeUtils::daysFromCivil(year, month, 1);
+    long nextMonthDay = (month == 12) ? TimeUtils::daysFromCivil(year + 1, 1, 1)
+                                      : TimeUtils::daysFromCivil(year, month + 1, 1);
     
     totalLiters = 0.0;
-    for (int day = 0; day < daysInMonth; day++) {
-        DailyUsage usage;
-        if (getDailyUsage(startDate + day * 86400, usage)) {
-            totalLiters += usage.totalUsageLiters;
+    
+    const DailyRecord* table = loadDailyTable();
+    if (table) {
+        for (long day = firstDay; day < nextMonthDay; day++) {
+            const DailyRecord& record = table[day % DAILY_TABLE_DAYS];
+            if (record.day == day) totalLiters += record.usageLiters;
+        }
+    }
+    
+    // Add the open day unless it was already folded into the table
+    DailyRecord current;
+    if (loadCurrentRecord(current) && current.day >= firstDay && current.day < nextMonthDay) {
+        if (!table || table[current.day % DAILY_TABLE_DAYS].day != current.day) {
+            totalLiters += current.usageLiters;
         }
     }
     
@@ -241,28 +336,132 @@ bool StorageManager::getMonthlyUsage(int year, int month, float& totalLiters) {
 }
 
 bool StorageManager::getLast30DaysUsage(DailyUsage* usageArray, int& count) {
-    unsigned long currentTime = time(nullptr);
+    return getUsageHistory(time(nullptr), 30, usageArray, count);
+}
+
+// Fills usageArray (newest first) with the recorded days in (endDate - days, endDate]
+bool StorageManager::getUsageHistory(unsigned long endDate, int days, DailyUsage* usageArray, int& count) {
+    count = 0;
+    if (days > DAILY_TABLE_DAYS) days = DAILY_TABLE_DAYS;
+    
+    long endDay = TimeUtils::localDayNumber(endDate);
+    
+    DailyRecord current;
+    bool hasCurrent = loadCurrentRecord(current);
+    const DailyRecord* table = loadDailyTable();
+    
+    for (int i = 0; i < days; i++) {
+        long day = endDay - i;
+        if (day <= 0) break;
+        
+        if (hasCurrent && current.day == day) {
+            usageArray[count++] = unpackDailyRecord(current);
+        } else if (table && table[day % DAILY_TABLE_DAYS].day == day) {
+            usageArray[count++] = unpackDailyRecord(table[day % DAILY_TABLE_DAYS]);
+        }
+    }
+    
+    return count > 0;
+}
+
+// Fills usageArray (oldest first) with the recorded days in [firstDay, firstDay + days)
+bool StorageManager::getUsageDays(long firstDay, int days, DailyUsage* usageArray, int& count) {
     count = 0;
     
-    for (int i = 0; i < 30; i++) {
-        unsigned long date = currentTime - (i * 86400);
-        DailyUsage usage;
-        if (getDailyUsage(date, usage)) {
-            usageArray[count++] = usage;
+    DailyRecord current;
+    bool hasCurrent = loadCurrentRecord(current);
+    const DailyRecord* table = loadDailyTable();
+    
+    for (long day = max(firstDay, 1L); day < firstDay + days; day++) {
+        if (hasCurrent && current.day == day) {
+            usageArray[count++] = unpackDailyRecord(current);
+        } else if (table && table[day % DAILY_TABLE_DAYS].day == day) {
+            usageArray[count++] = unpackDailyRecord(table[day % DAILY_TABLE_DAYS]);
         }
     }
     
     return count > 0;
 }
 
-bool StorageManager::saveWebCredentials(const String& username, const String& password) {
+bool StorageManager::saveDrawEvents(const DrawEvent* events, int count) {
+    count = constrain(count, 0, DRAW_EVENT_LOG_SIZE);
+    
     preferences.begin(NAMESPACE, false);
-    preferences.putString("webUser", username);
-    preferences.putString("webPass", password);
+    size_t written = preferences.putBytes("drawEvt", events, count * sizeof(DrawEvent));
+    preferences.end();
+    return written == count * sizeof(DrawEvent);
+}
+
+bool StorageManager::loadDrawEvents(DrawEvent* events, int maxCount, int& count) {
+    preferences.begin(NAMESPACE, true);
+    size_t size = preferences.getBytesLength("drawEvt");
+    count = 0;
+    if (size <= maxCount * sizeof(DrawEvent)) {
+        count = preferences.getBytes("drawEvt", events, size) / sizeof(DrawEvent);
+    }
+    preferences.end();
+    return count > 0;
+}
+
+bool StorageManager::savePumpRate(float litersPerMinute) {
+    preferences.begin(NAMESPACE, false);
+    preferences.putFloat("pumpRate", litersPerMinute);
     preferences.end();
     return true;
 }
 
+float StorageManager::loadPumpRate() {
+    preferences.begin(NAMESPACE, true);
+    float rate = preferences.getFloat("pumpRate", 0.0);
+    preferences.end();
+    return rate;
+}
+
+bool StorageManager::saveDemandProfile(const ProfileSlot* slots, int count) {
+    preferences.begin(NAMESPACE, false);
+    size_t written = preferences.putBytes("demandProf", slots, count * sizeof(ProfileSlot));
+    preferences.end();
+    return written == count * sizeof(ProfileSlot);
+}
+
+bool StorageManager::loadDemandProfile(ProfileSlot* slots, int count) {
+    preferences.begin(NAMESPACE, true);
+    bool found = preferences.getBytesLength("demandProf") == count * sizeof(ProfileSlot);
+    if (found) {
+        preferences.getBytes("demandProf", slots, count * sizeof(ProfileSlot));
+    }
+    preferences.end();
+    return found;
+}
+
+bool StorageManager::saveLeakState(const LeakState& state) {
+    preferences.begin(NAMESPACE, false);
+    size_t written = preferences.putBytes("leakState", &state, sizeof(state));
+    preferences.end();
+    return written == sizeof(state);
+}
+
+bool StorageManager::loadLeakState(LeakState& state) {
+    preferences.begin(NAMESPACE, true);
+    bool found = preferences.getBytesLength("leakState") == sizeof(state);
+    if (found) {
+        preferences.getBytes("leakState", &state, sizeof(state));
+    }
+    preferences.end();
+    return found;
+}
+
+bool StorageManager::saveWebCredentials(const String& username, const String& password) {
+    StorageJournal journal;
+    journal.stageString("webUser", username);
+    journal.stageString("webPass", password);
+    
+    preferences.begin(NAMESPACE, false);
+    bool ok = journal.commit(preferences);
+    preferences.end();
+    return ok;
+}
+
 bool StorageManager::loadWebCredentials(String& username, String& password) {
     preferences.begin(NAMESPACE, true);
     username = preferences.getString("webUser", WEB_DEFAULT_USERNAME);
@@ -303,6 +502,9 @@ void StorageManager::factoryReset() {
     preferences.begin(NAMESPACE, false);
     preferences.clear();
     preferences.end();
+    
+    _tableCached = false;
+    _currentDay = 0;
 }
 
 // Private helper functions
@@ -316,17 +518,156 @@ String StorageManager::generateDailyKey(unsigned long date) {
     return "day" + String(midnightDate);
 }
 
-int StorageManager::getCurrentCycleIndex() {
+// Stages the open day's record; caller owns the preferences session.
+// The 12-byte "dayCur" record takes the frequent updates; the full table
+// blob is only rewritten once per day when a new day starts. The fold is
+// written directly: it is idempotent, since "dayCur" still holds the old
+// day until the journal commits.
+void StorageManager::putDailyRecord(const DailyUsage& usage, StorageJournal& journal) {
+    ensureDailyTable();
+    DailyRecord record = packDailyUsage(usage);
+    
+    if (_currentDay == 0) {
+        DailyRecord stored;
+        if (preferences.getBytes("dayCur", &stored, sizeof(stored)) == sizeof(stored)) {
+            _currentDay = stored.day;
+        }
+    }
+    
+    if (_currentDay != 0 && _currentDay != record.day) {
+        DailyRecord previous;
+        if (preferences.getBytes("dayCur", &previous, sizeof(previous)) == sizeof(previous)) {
+            foldIntoTable(previous);
+        }
+    }
+    
+    journal.stageBytes("dayCur", &record, sizeof(record));
+    _currentDay = record.day;
+}
+
+// Copies a finished day into its ring slot; caller owns the preferences session
+void StorageManager::foldIntoTable(const DailyRecord& record) {
+    if (!_tableCached && !readDailyTable()) {
+        memset(_table, 0, sizeof(_table));
+    }
+    
+    _table[record.day % DAILY_TABLE_DAYS] = record;
+    _tableCached = preferences.putBytes("dayTbl", _table, sizeof(_table)) == sizeof(_table);
+}
+
+// Fills the cache with one NVS read; caller owns the preferences session
+bool StorageManager::readDailyTable() {
+    _tableCached = preferences.getBytes("dayTbl", _table, sizeof(_table)) == sizeof(_table);
+    return _tableCached;
+}
+
+// The cached table, read from NVS on first use (nullptr if there is none)
+const DailyRecord* StorageManager::loadDailyTable() {
+    if (!_tableCached) {
+        preferences.begin(NAMESPACE, true);
+        readDailyTable();
+        preferences.end();
+    }
+    return _tableCached ? _table : nullptr;
+}
+
+bool StorageManager::loadCurrentRecord(DailyRecord& record) {
     preferences.begin(NAMESPACE, true);
-    int idx = preferences.getInt("cycleIdx", 0);
+    size_t read = preferences.getBytes("dayCur", &record, sizeof(record));
     preferences.end();
-    return idx;
+    return read == sizeof(record) && record.day != 0;
 }
 
-void StorageManager::incrementCycleIndex() {
-    preferences.begin(NAMESPACE, false);
-    int idx = preferences.getInt("cycleIdx", 0);
-    idx = (idx + 1) % MAX_PUMP_CYCLE_LOGS;
-    preferences.putInt("cycleIdx", idx);
-    preferences.end();
-}
\ No newline at end of file
+// One-time conversion of the old JSON "day<epoch>" keys. Needs real time to
+// locate them, so it is retried until the clock has been synced once.
+void StorageManager::ensureDailyTable() {
+    if (_tableMigrated || !TimeUtils::isTimeSynced()) return;
+    
+    if (!preferences.isKey("dayTblVer")) {
+        migrateDailyRecords();
+        sweepLegacyDailyKeys(time(nullptr) - (unsigned long)DAILY_TABLE_DAYS * 86400);
+        preferences.putUChar("dayTblVer", 1);
+    }
+    _tableMigrated = true;
+}
+
+// Moves the old per-day JSON strings into the binary table and deletes them.
+// Old keys were normalized by UTC epoch division, so probe each UTC midnight.
+void StorageManager::migrateDailyRecords() {
+    // Keep anything already folded into a table created before migration
+    if (!readDailyTable()) {
+        memset(_table, 0, sizeof(_table));
+    }
+    DailyRecord* table = _table;
+    
+    unsigned long now = time(nullptr);
+    int migrated = 0;
+    
+    for (int i = 0; i < DAILY_TABLE_DAYS; i++) {
+        String key = generateDailyKey(now - (unsigned long)i * 86400);
+        String jsonStr = preferences.getString(key.c_str(), "");
+        if (jsonStr.isEmpty()) continue;
+        
+        JsonDocument doc;
+        if (!deserializeJson(doc, jsonStr)) {
+            DailyUsage usage;
+            usage.date = doc["date"];
+            usage.totalUsageLiters = doc["usage"];
+            usage.pumpCycles = doc["cycles"];
+            
+            DailyRecord record = packDailyUsage(usage);
+            DailyRecord& slot = table[record.day % DAILY_TABLE_DAYS];
+            if (slot.day != record.day) {
+                slot = record;
+                migrated++;
+            }
+        }
+        preferences.remove(key.c_str());
+    }
+    
+    _tableCached = preferences.putBytes("dayTbl", _table, sizeof(_table)) == sizeof(_table);
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Daily usage table created, migrated records: ");
+    Serial.println(migrated);
+    #endif
+}
+
+// Deletes old "day<epoch>" keys older than the table's window (they would
+// have been dropped from history anyway). NVS can't list keys through
+// Preferences, so probe each UTC midnight back to LEGACY_DAY_KEYS_SINCE.
+void StorageManager::sweepLegacyDailyKeys(unsigned long before) {
+    int removed = 0;
+    
+    for (unsigned long date = before; date >= LEGACY_DAY_KEYS_SINCE; date -= 86400) {
+        String key = generateDailyKey(date);
+        if (preferences.isKey(key.c_str()) && preferences.remove(key.c_str())) {
+            removed++;
+        }
+    }
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Old daily usage keys removed: ");
+    Serial.println(removed);
+    #endif
+}
+
+DailyRecord StorageManager::packDailyUsage(const DailyUsage& usage) {
+    DailyRecord record;
+    record.day = (uint16_t)TimeUtils::localDayNumber(usage.date);
+    record.pumpCycles = (uint16_t)constrain(usage.pumpCycles, 0, 65535);
+    record.pumpMinutes = (uint16_t)constrain(usage.pumpMinutes, 0, 65535);
+    record.peakInflow = (uint16_t)constrain(usage.peakInflow, 0.0f, 65535.0f);
+    record.usageLiters = usage.totalUsageLiters;
+    return record;
+}
+
+DailyUsage StorageManager::unpackDailyRecord(const DailyRecord& record) {
+    DailyUsage usage;
+    usage.date = TimeUtils::dayNumberToTimestamp(record.day);
+    usage.totalUsageLiters = record.usageLiters;
+    usage.pumpCycles = record.pumpCycles;
+    usage.pumpMinutes = record.pumpMinutes;
+    usage.peakInflow = record.peakInflow;
+    return usage;
+}
@@ -4,16 +4,15 @@
 
 SyncManager::SyncManager() 
     : _storage(nullptr),
-      _iotClient(nullptr),
+      _network(nullptr),
       _status(SYNC_IDLE),
       _lastSyncTime(0),
-      _lastSyncAttempt(0),
       _conflictDetected(false) {
 }
 
-void SyncManager::begin(StorageManager* storage, IoTClient* iotClient) {
+void SyncManager::begin(StorageManager* storage, CloudLink* network) {
     _storage = storage;
-    _iotClient = iotClient;
+    _network = network;
     
     // Load current local config
     _localConfig = _storage->loadTankConfig();
@@ -25,21 +24,16 @@ void SyncManager::begin(StorageManager* storage, IoTClient* iotClient) {
     #endif
 }
 
-void SyncManager::loop() {
-    // Periodic sync check
-    if (millis() - _lastSyncAttempt > CONFIG_SYNC_INTERVAL_MS) {
-        _lastSyncAttempt = millis();
-        
-        if (_iotClient && _iotClient->isConnected()) {
-            if (_localConfig.needsSync) {
-                syncConfig();
-            }
+void SyncManager::periodicSync() {
+    if (_network && _network->isOnline()) {
+        if (_localConfig.needsSync) {
+            syncConfig();
         }
     }
 }
 
 bool SyncManager::syncConfig() {
-    if (!_iotClient || !_iotClient->isConnected()) {
+    if (!_network || !_network->isOnline()) {
         #if ENABLE_SERIAL_DEBUG
         Serial.println("Cannot sync: Not connected to IoT");
         #endif
@@ -60,9 +54,7 @@ bool SyncManager::syncConfig() {
             #endif
             
             if (pushConfig()) {
-                _storage->markNeedsSync(false);
-                _status = SYNC_SUCCESS;
-                _lastSyncTime = millis();
+                // Completed in onPushComplete()
                 return true;
             } else {
                 _status = SYNC_FAILED;
@@ -90,27 +82,35 @@ bool SyncManager::syncConfig() {
 }
 
 bool SyncManager::pushConfig() {
-    if (!_iotClient) return false;
+    if (!_network) return false;
     
     #if ENABLE_SERIAL_DEBUG
     Serial.println("Pushing config to cloud...");
     #endif
     
-    if (_iotClient->sendConfig(_localConfig)) {
+    // Sent by the network worker; the result comes back via onPushComplete()
+    return _network->sendConfig(_localConfig);
+}
+
+void SyncManager::onPushComplete(bool success) {
+    if (success) {
         #if ENABLE_SERIAL_DEBUG
         Serial.println("Config pushed successfully");
         #endif
-        return true;
+        _storage->markNeedsSync(false);
+        _localConfig.needsSync = false;
+        _status = SYNC_SUCCESS;
+        _lastSyncTime = millis();
     } else {
         #if ENABLE_SERIAL_DEBUG
         Serial.println("Failed to push config");
         #endif
-        return false;
+        _status = SYNC_FAILED;
     }
 }
 
 bool SyncManager::pullConfig() {
-    if (!_iotClient) return false;
+    if (!_network) return false;
     
     #if ENABLE_SERIAL_DEBUG
     Serial.println("Requesting config from cloud...");
@@ -118,7 +118,7 @@ bool SyncManager::pullConfig() {
     
     // Request config from cloud
     // The actual config will arrive via callback
-    return _iotClient->requestConfig();
+    return _network->requestConfig();
 }
 
 void SyncManager::onLocalConfigChange(const TankConfig& config) {
@@ -133,7 +133,7 @@ void SyncManager::onLocalConfigChange(const TankConfig& config) {
     #endif
     
     // Immediate sync if connected
-    if (_iotClient && _iotClient->isConnected()) {
+    if (_network && _network->isOnline()) {
         syncConfig();
     }
 }
@@ -216,7 +216,6 @@ unsigned long SyncManager::getLastSyncTime() {
 }
 
 void SyncManager::forceSyncNow() {
-    _lastSyncAttempt = 0; // Reset timer to force immediate sync
     syncConfig();
 }
 
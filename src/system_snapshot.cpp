@@ -0,0 +1,57 @@
+// system_snapshot.cpp
+#include "system_snapshot.h"
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<SystemSnapshot>::value, "SystemSnapshot is copied as words");
+
+SnapshotBuffer::SnapshotBuffer()
+    : _current(0) {
+    for (int i = 0; i < 2; i++) {
+        _slots[i].seq.store(0, std::memory_order_relaxed);
+        for (size_t w = 0; w < WORDS; w++) {
+            _slots[i].words[w].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SnapshotBuffer::publish(const SystemSnapshot& snapshot) {
+    uint8_t next = _current.load(std::memory_order_relaxed) ^ 1;
+    Slot& slot = _slots[next];
+    
+    uint32_t words[WORDS] = {};
+    memcpy(words, &snapshot, sizeof(SystemSnapshot));
+    
+    // A reader that sees any new word also sees the odd sequence
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    for (size_t w = 0; w < WORDS; w++) {
+        slot.words[w].store(words[w], std::memory_order_release);
+    }
+    
+    slot.seq.store(seq + 2, std::memory_order_release);
+    _current.store(next, std::memory_order_release);
+}
+
+bool SnapshotBuffer::read(SystemSnapshot& snapshot) const {
+    uint32_t words[WORDS];
+    
+    for (int attempt = 0; attempt < SNAPSHOT_READ_RETRIES; attempt++) {
+        const Slot& slot = _slots[_current.load(std::memory_order_acquire)];
+        
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before == 0) return false;    // Nothing published yet
+        if (before & 1) continue;         // Lapped: slot is being rewritten
+        
+        // Acquire loads keep the sequence re-check after the copy
+        for (size_t w = 0; w < WORDS; w++) {
+            words[w] = slot.words[w].load(std::memory_order_acquire);
+        }
+        
+        if (slot.seq.load(std::memory_order_relaxed) == before) {
+            memcpy(&snapshot, words, sizeof(SystemSnapshot));
+            return true;
+        }
+    }
+    
+    return false;
+}
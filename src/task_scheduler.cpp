@@ -0,0 +1,300 @@
+// task_scheduler.cpp
+#include "task_scheduler.h"
+#include <esp_timer.h>
+
+TaskScheduler::TaskScheduler()
+    : _currentTick(0),
+      _pending(0) {
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        _tasks[i].active = false;
+        _tasks[i].level = -1;
+    }
+    for (int level = 0; level < LEVELS; level++) {
+        _levelCount[level] = 0;
+        for (int slot = 0; slot < SLOTS; slot++) {
+            _wheel[level][slot] = -1;
+        }
+    }
+}
+
+TaskId TaskScheduler::addPeriodic(const char* name, uint32_t periodMs, TaskCallback callback, void* context,
+                                  TaskPriority priority, uint32_t initialDelayMs) {
+    if (periodMs == 0) return -1;
+    return addTask(name, initialDelayMs, periodMs, callback, context, priority);
+}
+
+TaskId TaskScheduler::addOneShot(const char* name, uint32_t delayMs, TaskCallback callback, void* context,
+                                 TaskPriority priority) {
+    return addTask(name, delayMs, 0, callback, context, priority);
+}
+
+bool TaskScheduler::cancel(TaskId id) {
+    if (id < 0 || id >= SCHEDULER_MAX_TASKS || !_tasks[id].active) return false;
+    
+    unlink(id);
+    _tasks[id].active = false;
+    return true;
+}
+
+bool TaskScheduler::reschedule(TaskId id, uint32_t delayMs) {
+    if (id < 0 || id >= SCHEDULER_MAX_TASKS || !_tasks[id].active) return false;
+    
+    unlink(id);
+    _tasks[id].expiry = nowMs() / SCHEDULER_TICK_MS + msToTicks(delayMs);
+    link(id);
+    return true;
+}
+
+void TaskScheduler::run() {
+    uint64_t nowTick = nowMs() / SCHEDULER_TICK_MS;
+    if (nowTick <= _currentTick) return;
+    
+    TaskId ready[SCHEDULER_MAX_TASKS];
+    int readyCount = 0;
+    
+    while (_currentTick < nowTick) {
+        if (_pending == 0) {
+            _currentTick = nowTick;
+            break;
+        }
+        
+        // Level 0 empty: nothing can fire before the next cascade boundary
+        if (_levelCount[0] == 0) {
+            uint64_t blockEnd = _currentTick | SLOT_MASK;
+            if (blockEnd > _currentTick) {
+                _currentTick = min(blockEnd, nowTick);
+                continue;
+            }
+        }
+        
+        _currentTick++;
+        
+        if ((_currentTick & SLOT_MASK) == 0) {
+            if (((_currentTick >> SLOT_BITS) & SLOT_MASK) == 0) {
+                if (((_currentTick >> (2 * SLOT_BITS)) & SLOT_MASK) == 0) {
+                    cascade(3);
+                }
+                cascade(2);
+            }
+            cascade(1);
+        }
+        
+        collect(ready, readyCount);
+    }
+    
+    if (readyCount == 0) return;
+    
+    // Highest priority first, earliest deadline within a priority
+    for (int i = 1; i < readyCount; i++) {
+        TaskId id = ready[i];
+        int j = i - 1;
+        while (j >= 0 && (_tasks[ready[j]].priority < _tasks[id].priority ||
+                          (_tasks[ready[j]].priority == _tasks[id].priority &&
+                           _tasks[ready[j]].expiry > _tasks[id].expiry))) {
+            ready[j + 1] = ready[j];
+            j--;
+        }
+        ready[j + 1] = id;
+    }
+    
+    for (int i = 0; i < readyCount; i++) {
+        execute(ready[i]);
+    }
+}
+
+uint64_t TaskScheduler::nowMs() {
+    return (uint64_t)esp_timer_get_time() / 1000;
+}
+
+int TaskScheduler::getTaskCount() {
+    int count = 0;
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (_tasks[i].active) count++;
+    }
+    return count;
+}
+
+void TaskScheduler::buildReport(JsonDocument& doc) {
+    uint64_t nowTick = nowMs() / SCHEDULER_TICK_MS;
+    
+    doc["tickMs"] = SCHEDULER_TICK_MS;
+    doc["uptimeMs"] = nowMs();
+    
+    JsonArray tasks = doc["tasks"].to<JsonArray>();
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        const Task& t = _tasks[i];
+        if (!t.active) continue;
+        
+        JsonObject item = tasks.add<JsonObject>();
+        item["name"] = t.name;
+        item["periodMs"] = t.periodTicks * SCHEDULER_TICK_MS;
+        item["priority"] = (int)t.priority;
+        item["runs"] = t.runs;
+        item["skipped"] = t.skipped;
+        item["avgUs"] = t.runs ? (uint32_t)(t.totalUs / t.runs) : 0;
+        item["maxUs"] = t.maxUs;
+        item["maxLateMs"] = t.maxLateMs;
+        item["nextInMs"] = t.expiry > nowTick ? (uint32_t)((t.expiry - nowTick) * SCHEDULER_TICK_MS) : 0;
+    }
+}
+
+TaskId TaskScheduler::addTask(const char* name, uint32_t delayMs, uint32_t periodMs, TaskCallback callback,
+                              void* context, TaskPriority priority) {
+    if (!callback) return -1;
+    
+    TaskId id = -1;
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (!_tasks[i].active) {
+            id = i;
+            break;
+        }
+    }
+    
+    if (id < 0) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.print("Scheduler full - cannot add task: ");
+        Serial.println(name);
+        #endif
+        return -1;
+    }
+    
+    uint64_t nowTick = nowMs() / SCHEDULER_TICK_MS;
+    if (_pending == 0) _currentTick = nowTick;   // Idle wheel: catch up for free
+    
+    Task& t = _tasks[id];
+    t.callback = callback;
+    t.context = context;
+    t.name = name;
+    t.expiry = nowTick + msToTicks(delayMs);
+    t.periodTicks = periodMs ? msToTicks(periodMs) : 0;
+    t.priority = priority;
+    t.active = true;
+    t.level = -1;
+    t.runs = 0;
+    t.skipped = 0;
+    t.totalUs = 0;
+    t.maxUs = 0;
+    t.maxLateMs = 0;
+    
+    link(id);
+    return id;
+}
+
+void TaskScheduler::link(TaskId id) {
+    Task& t = _tasks[id];
+    
+    // A task cascaded down on its own deadline tick goes into the current
+    // slot, which collect() reads next; anything else is in the future
+    uint64_t expiry = max(t.expiry, _currentTick);
+    uint64_t delta = expiry - _currentTick;
+    
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    
+    // Beyond the wheel's range: park in the farthest top-level slot and
+    // re-cascade when it comes around
+    if (delta >= (1ULL << (SLOT_BITS * LEVELS))) {
+        expiry = _currentTick + (1ULL << (SLOT_BITS * LEVELS)) - 1;
+    }
+    
+    int slot = (expiry >> (SLOT_BITS * level)) & SLOT_MASK;
+    
+    t.level = level;
+    t.slot = slot;
+    t.prev = -1;
+    t.next = _wheel[level][slot];
+    if (t.next >= 0) _tasks[t.next].prev = id;
+    _wheel[level][slot] = id;
+    
+    _levelCount[level]++;
+    _pending++;
+}
+
+void TaskScheduler::unlink(TaskId id) {
+    Task& t = _tasks[id];
+    if (t.level < 0) return;
+    
+    if (t.prev >= 0) {
+        _tasks[t.prev].next = t.next;
+    } else {
+        _wheel[t.level][t.slot] = t.next;
+    }
+    if (t.next >= 0) _tasks[t.next].prev = t.prev;
+    
+    _levelCount[t.level]--;
+    _pending--;
+    t.level = -1;
+}
+
+void TaskScheduler::cascade(int level) {
+    int slot = (_currentTick >> (SLOT_BITS * level)) & SLOT_MASK;
+    TaskId id = _wheel[level][slot];
+    
+    while (id >= 0) {
+        TaskId next = _tasks[id].next;
+        unlink(id);
+        link(id);
+        id = next;
+    }
+}
+
+void TaskScheduler::collect(TaskId* ready, int& readyCount) {
+    int slot = _currentTick & SLOT_MASK;
+    TaskId id = _wheel[0][slot];
+    
+    while (id >= 0) {
+        TaskId next = _tasks[id].next;
+        unlink(id);
+        if (_tasks[id].expiry <= _currentTick) {
+            ready[readyCount++] = id;
+        } else {
+            link(id);
+        }
+        id = next;
+    }
+}
+
+void TaskScheduler::execute(TaskId id) {
+    Task& t = _tasks[id];
+    
+    // Cancelled, or rescheduled by an earlier task in this pass
+    if (!t.active || t.level >= 0) return;
+    
+    uint64_t startUs = esp_timer_get_time();
+    uint64_t dueMs = t.expiry * SCHEDULER_TICK_MS;
+    uint64_t startMs = startUs / 1000;
+    if (startMs > dueMs && startMs - dueMs > t.maxLateMs) {
+        t.maxLateMs = startMs - dueMs;
+    }
+    
+    t.callback(t.context);
+    
+    uint32_t elapsedUs = esp_timer_get_time() - startUs;
+    t.runs++;
+    t.totalUs += elapsedUs;
+    if (elapsedUs > t.maxUs) t.maxUs = elapsedUs;
+    
+    // The callback may have cancelled or rescheduled this task
+    if (!t.active || t.level >= 0) return;
+    
+    if (t.periodTicks == 0) {
+        t.active = false;
+        return;
+    }
+    
+    // Next deadline from the previous one; runs missed in a stall coalesce
+    t.expiry += t.periodTicks;
+    if (t.expiry <= _currentTick) {
+        uint64_t missed = (_currentTick - t.expiry) / t.periodTicks + 1;
+        t.skipped += missed;
+        t.expiry += missed * t.periodTicks;
+    }
+    link(id);
+}
+
+uint64_t TaskScheduler::msToTicks(uint32_t ms) {
+    uint64_t ticks = (ms + SCHEDULER_TICK_MS - 1) / SCHEDULER_TICK_MS;
+    return ticks > 0 ? ticks : 1;
+}
@@ -0,0 +1,485 @@
+// trace_recorder.cpp
+#include "trace_recorder.h"
+
+namespace {
+    const uint8_t TRACE_FRAME_MAGIC[4] = { 'S', 'W', 'P', 'T' };
+    const size_t TRACE_SYNC_BYTES = 16;       // Keyframe record, encoded
+    const size_t TRACE_MAX_RECORD = 32;       // Largest record (CONFIG), encoded
+    
+    uint32_t zigzag(int32_t value) {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+    
+    int32_t unzigzag(uint32_t value) {
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+}
+
+// ==================== READER ====================
+
+TraceReader::TraceReader(const uint8_t* data, size_t length, bool framed)
+    : _data(data),
+      _length(length),
+      _pos(0),
+      _segmentEnd(framed ? 0 : length),
+      _framed(framed),
+      _inSegment(!framed),
+      _damaged(0),
+      _time(0),
+      _distanceMm(0) {
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    while (true) {
+        if (!_inSegment) {
+            if (!_framed || _pos + 8 > _length) return false;
+            if (memcmp(_data + _pos, TRACE_FRAME_MAGIC, 4) != 0) {
+                _damaged++;
+                return false;               // Lost framing; nothing after this is trustworthy
+            }
+            uint32_t frameLength;
+            memcpy(&frameLength, _data + _pos + 4, 4);
+            _pos += 8;
+            if (_pos + frameLength > _length) _damaged++;     // Download cut short
+            _segmentEnd = std::min(_length, _pos + frameLength);
+            _inSegment = true;
+        }
+        
+        if (_pos < _segmentEnd) {
+            size_t start = _pos;
+            if (decode(record)) return true;
+            
+            // A power cut mid-append (or a cut-off download) leaves a torn
+            // tail; TRACE_END padding is not damage. Skip to the next segment.
+            bool padding = _data[start] == 0 && start + 1 < _segmentEnd && _data[start + 1] == TRACE_END;
+            if (!padding) _damaged++;
+        }
+        
+        _pos = _segmentEnd;
+        _inSegment = false;
+        if (!_framed) return false;
+    }
+}
+
+bool TraceReader::decode(TraceRecord& record) {
+    uint32_t delta;
+    uint8_t type;
+    record.type = TRACE_END;
+    if (!readVarint(delta) || !readBytes(&type, 1) || type == TRACE_END) return false;
+    
+    record.type = (TraceRecordType)type;
+    _time += delta;
+    
+    uint8_t flags;
+    switch (record.type) {
+        case TRACE_SYNC: {
+            uint32_t millisAtSync;
+            if (!readBytes(&millisAtSync, 4) || !readBytes(&record.epoch, 4) ||
+                !readBytes(&record.sequence, 4) || !readBytes(&flags, 1) || !readBytes(&record.mode, 1)) {
+                return false;
+            }
+            _time = millisAtSync;
+            _distanceMm = 0;
+            record.boot = flags & 0x01;
+            record.motorState = flags & 0x02;
+            break;
+        }
+        
+        case TRACE_CONFIG:
+            if (!readBytes(&record.config.shape, 1) ||
+                !readBytes(&record.config.tankHeight, 4) || !readBytes(&record.config.tankLength, 4) ||
+                !readBytes(&record.config.tankWidth, 4) || !readBytes(&record.config.tankRadius, 4) ||
+                !readBytes(&record.config.upperThreshold, 4) || !readBytes(&record.config.lowerThreshold, 4)) {
+                return false;
+            }
+            break;
+        
+        case TRACE_SENSOR: {
+            uint32_t change;
+            if (!readVarint(change)) return false;
+            _distanceMm += unzigzag(change);
+            record.distance = _distanceMm / 10.0f;
+            break;
+        }
+        
+        case TRACE_SENSOR_FAIL:
+            record.distance = -1;
+            break;
+        
+        case TRACE_COMMAND:
+            if (!readBytes(&flags, 1)) return false;
+            record.command = flags & 0x0F;
+            record.source = flags >> 4;
+            break;
+        
+        case TRACE_BUTTON:
+            if (!readBytes(&record.button, 1)) return false;
+            break;
+        
+        case TRACE_PUMP:
+            if (!readBytes(&flags, 1)) return false;
+            record.motorState = flags & 0x01;
+            record.dryRunAlarm = flags & 0x02;
+            record.overflowAlarm = flags & 0x04;
+            record.mode = flags >> 4;
+            break;
+        
+        default:
+            return false;                   // Unknown type: can't know its length
+    }
+    
+    record.timestamp = _time;
+    return true;
+}
+
+bool TraceReader::readVarint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (_pos >= _segmentEnd) return false;
+        uint8_t b = _data[_pos++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool TraceReader::readBytes(void* out, size_t len) {
+    if (_pos + len > _segmentEnd) return false;
+    memcpy(out, _data + _pos, len);
+    _pos += len;
+    return true;
+}
+
+// ==================== RECORDER ====================
+
+TraceRecorder::TraceRecorder()
+    : _enabled(false),
+      _length(0),
+      _segment(0),
+      _sequence(0),
+      _segmentBytes(0),
+      _bootSegment(true),
+      _lastTime(0),
+      _lastDistanceMm(0),
+      _config(),
+      _haveConfig(false),
+      _mode(0),
+      _motorState(false),
+      _records(0),
+      _bytes(0),
+      _flushes(0),
+      _flushErrors(0),
+      _maxFlushUs(0) {
+}
+
+bool TraceRecorder::begin() {
+    #if TRACE_ENABLED
+    if (!SPIFFS.begin(true)) {
+        #if ENABLE_SERIAL_DEBUG
+        Serial.println("Trace disabled - SPIFFS not available");
+        #endif
+        return false;
+    }
+    
+    // Continue the ring after the newest segment
+    int newest = -1;
+    uint32_t newestSequence = 0;
+    for (int i = 0; i < TRACE_SEGMENT_COUNT; i++) {
+        bool valid;
+        uint32_t sequence = readSequence(i, valid);
+        if (valid && (newest < 0 || sequence > newestSequence)) {
+            newest = i;
+            newestSequence = sequence;
+        }
+    }
+    
+    _segment = (newest + 1) % TRACE_SEGMENT_COUNT;
+    _sequence = newestSequence + 1;
+    _bootSegment = true;
+    _enabled = true;
+    startSegment();
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Trace recording to segment ");
+    Serial.print(_segment);
+    Serial.print(", sequence ");
+    Serial.println(_sequence);
+    #endif
+    
+    return true;
+    #else
+    return false;
+    #endif
+}
+
+void TraceRecorder::recordConfig(const TankConfig& config) {
+    _config.shape = (uint8_t)config.shape;
+    _config.tankHeight = config.tankHeight;
+    _config.tankLength = config.tankLength;
+    _config.tankWidth = config.tankWidth;
+    _config.tankRadius = config.tankRadius;
+    _config.upperThreshold = config.upperThreshold;
+    _config.lowerThreshold = config.lowerThreshold;
+    _haveConfig = true;
+    
+    if (!_enabled || !reserve(TRACE_MAX_RECORD)) return;
+    writeConfig();
+}
+
+void TraceRecorder::recordSensor(float distance) {
+    if (!_enabled || !reserve(8)) return;
+    
+    if (distance < 0) {
+        beginRecord(TRACE_SENSOR_FAIL);
+        return;
+    }
+    
+    int32_t distanceMm = lround(distance * 10.0);
+    beginRecord(TRACE_SENSOR);
+    putVarint(zigzag(distanceMm - _lastDistanceMm));
+    _lastDistanceMm = distanceMm;
+}
+
+void TraceRecorder::recordCommand(uint8_t command, uint8_t source) {
+    if (!_enabled || !reserve(8)) return;
+    uint8_t packed = (command & 0x0F) | (source << 4);
+    beginRecord(TRACE_COMMAND);
+    putBytes(&packed, 1);
+}
+
+void TraceRecorder::recordButton(uint8_t event) {
+    if (!_enabled || !reserve(8)) return;
+    beginRecord(TRACE_BUTTON);
+    putBytes(&event, 1);
+}
+
+void TraceRecorder::recordPump(const PumpEvent& evt) {
+    _mode = evt.mode;
+    _motorState = evt.motorState;
+    
+    if (!_enabled || !reserve(8)) return;
+    uint8_t flags = (evt.motorState ? 0x01 : 0) | (evt.dryRunAlarm ? 0x02 : 0) |
+                    (evt.overflowAlarm ? 0x04 : 0) | (evt.mode << 4);
+    beginRecord(TRACE_PUMP);
+    putBytes(&flags, 1);
+}
+
+void TraceRecorder::flush() {
+    if (!_enabled || _length == 0) return;
+    
+    unsigned long start = micros();
+    char path[16];
+    segmentPath(_segment, path, sizeof(path));
+    
+    size_t written = 0;
+    File file = SPIFFS.open(path, "a");
+    if (file) {
+        written = file.write(_buffer, _length);
+        file.close();
+    }
+    
+    // A failed append is dropped rather than retried forever
+    if (written != _length) _flushErrors++;
+    _segmentBytes += written;
+    _bytes += _length;
+    _length = 0;
+    _flushes++;
+    
+    uint32_t elapsed = micros() - start;
+    if (elapsed > _maxFlushUs) _maxFlushUs = elapsed;
+}
+
+void TraceRecorder::buildReport(JsonDocument& doc) {
+    doc["enabled"] = _enabled;
+    doc["records"] = _records;
+    doc["bytes"] = _bytes + _length;
+    doc["bytesPerRecord"] = _records > 0 ? (float)(_bytes + _length) / _records : 0;
+    doc["buffered"] = _length;
+    doc["segment"] = _segment;
+    doc["sequence"] = _sequence;
+    doc["segmentBytes"] = _segmentBytes;
+    doc["segmentSize"] = TRACE_SEGMENT_SIZE;
+    doc["segmentCount"] = TRACE_SEGMENT_COUNT;
+    doc["flushes"] = _flushes;
+    doc["flushErrors"] = _flushErrors;
+    doc["maxFlushUs"] = _maxFlushUs;
+}
+
+void TraceRecorder::startSegment() {
+    char path[16];
+    segmentPath(_segment, path, sizeof(path));
+    
+    // Truncate the oldest segment we're about to reuse
+    File file = SPIFFS.open(path, "w");
+    if (file) file.close();
+    
+    _segmentBytes = 0;
+    writeSync();
+    if (_haveConfig) writeConfig();
+    _bootSegment = false;
+}
+
+void TraceRecorder::writeSync() {
+    _lastTime = millis();
+    _lastDistanceMm = 0;
+    
+    uint32_t now = _lastTime;
+    uint32_t epoch = (uint32_t)time(nullptr);
+    uint8_t flags = (_bootSegment ? 0x01 : 0) | (_motorState ? 0x02 : 0);
+    
+    putVarint(0);
+    uint8_t type = TRACE_SYNC;
+    putBytes(&type, 1);
+    putBytes(&now, 4);
+    putBytes(&epoch, 4);
+    putBytes(&_sequence, 4);
+    putBytes(&flags, 1);
+    putBytes(&_mode, 1);
+}
+
+void TraceRecorder::writeConfig() {
+    beginRecord(TRACE_CONFIG);
+    putBytes(&_config.shape, 1);
+    putBytes(&_config.tankHeight, 4);
+    putBytes(&_config.tankLength, 4);
+    putBytes(&_config.tankWidth, 4);
+    putBytes(&_config.tankRadius, 4);
+    putBytes(&_config.upperThreshold, 4);
+    putBytes(&_config.lowerThreshold, 4);
+}
+
+// Room for one more record: flushes a full buffer, and moves to the next
+// segment (with a fresh keyframe) when this one is full
+bool TraceRecorder::reserve(size_t recordBytes) {
+    if (_segmentBytes + _length + recordBytes > TRACE_SEGMENT_SIZE) {
+        flush();
+        _segment = (_segment + 1) % TRACE_SEGMENT_COUNT;
+        _sequence++;
+        startSegment();
+    } else if (_length + recordBytes > TRACE_BUFFER_SIZE) {
+        flush();
+    }
+    
+    return _length + recordBytes <= TRACE_BUFFER_SIZE;
+}
+
+void TraceRecorder::beginRecord(TraceRecordType type) {
+    unsigned long now = millis();
+    putVarint(now - _lastTime);
+    _lastTime = now;
+    
+    uint8_t value = type;
+    putBytes(&value, 1);
+    _records++;
+}
+
+void TraceRecorder::putVarint(uint32_t value) {
+    while (value >= 0x80) {
+        _buffer[_length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    _buffer[_length++] = (uint8_t)value;
+}
+
+void TraceRecorder::putBytes(const void* data, size_t len) {
+    memcpy(_buffer + _length, data, len);
+    _length += len;
+}
+
+uint32_t TraceRecorder::readSequence(int segment, bool& valid) {
+    valid = false;
+    char path[16];
+    segmentPath(segment, path, sizeof(path));
+    if (!SPIFFS.exists(path)) return 0;
+    
+    File file = SPIFFS.open(path, "r");
+    if (!file) return 0;
+    
+    uint8_t header[TRACE_SYNC_BYTES];
+    size_t got = file.read(header, sizeof(header));
+    file.close();
+    if (got != sizeof(header) || header[0] != 0 || header[1] != TRACE_SYNC) return 0;
+    
+    uint32_t sequence;
+    memcpy(&sequence, header + 10, 4);
+    valid = true;
+    return sequence;
+}
+
+void TraceRecorder::segmentPath(int segment, char* path, size_t size) {
+    snprintf(path, size, "/trace%d.bin", segment);
+}
+
+// ==================== EXPORTER ====================
+
+TraceExporter::TraceExporter()
+    : _count(0),
+      _next(0),
+      _headerPos(sizeof(_header)),
+      _remaining(0) {
+    uint32_t sequences[TRACE_SEGMENT_COUNT];
+    
+    // Oldest first (insertion sort by sequence)
+    for (int i = 0; i < TRACE_SEGMENT_COUNT; i++) {
+        bool valid;
+        uint32_t sequence = TraceRecorder::readSequence(i, valid);
+        if (!valid) continue;
+        
+        int j = _count++;
+        while (j > 0 && sequences[j - 1] > sequence) {
+            sequences[j] = sequences[j - 1];
+            _order[j] = _order[j - 1];
+            j--;
+        }
+        sequences[j] = sequence;
+        _order[j] = i;
+    }
+}
+
+size_t TraceExporter::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    
+    while (written < maxLen) {
+        if (_headerPos < sizeof(_header)) {
+            size_t n = std::min(sizeof(_header) - _headerPos, maxLen - written);
+            memcpy(buffer + written, _header + _headerPos, n);
+            _headerPos += n;
+            written += n;
+            continue;
+        }
+        
+        if (_remaining > 0) {
+            size_t n = std::min(_remaining, maxLen - written);
+            size_t got = _file.read(buffer + written, n);
+            
+            // Segment shrank under us (reused by the recorder): pad with TRACE_END
+            if (got < n) memset(buffer + written + got, 0, n - got);
+            _remaining -= n;
+            written += n;
+            continue;
+        }
+        
+        if (_file) _file.close();
+        if (!openNext()) break;
+    }
+    
+    return written;
+}
+
+bool TraceExporter::openNext() {
+    while (_next < _count) {
+        char path[16];
+        TraceRecorder::segmentPath(_order[_next++], path, sizeof(path));
+        
+        _file = SPIFFS.open(path, "r");
+        if (!_file) continue;
+        
+        uint32_t length = _file.size();
+        memcpy(_header, TRACE_FRAME_MAGIC, 4);
+        memcpy(_header + 4, &length, 4);
+        _headerPos = 0;
+        _remaining = length;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,113 @@
+// trend_history.cpp
+#include "trend_history.h"
+#include "water_tracker.h"
+#include "utils.h"
+
+static int16_t toTenths(float value) {
+    return (int16_t)constrain(lroundf(value * 10.0f), -32768L, 32767L);
+}
+
+TrendHistory::TrendHistory()
+    : _head(0),
+      _count(0),
+      _intervalStart(0),
+      _levelSum(0),
+      _inflowSum(0),
+      _samples(0),
+      _started(false),
+      _dayNumber(-1),
+      _version(0) {
+    memset(_level, 0, sizeof(_level));
+    memset(_inflow, 0, sizeof(_inflow));
+    memset(_days, 0, sizeof(_days));
+}
+
+void TrendHistory::onLevel(const LevelEvent& evt, void* context) {
+    static_cast<TrendHistory*>(context)->addSample(evt.waterLevel, evt.currentInflow);
+}
+
+void TrendHistory::addSample(float level, float inflow) {
+    unsigned long now = millis();
+    if (!_started) {
+        _intervalStart = now;
+        _started = true;
+    }
+    
+    // A gap longer than the whole ring only needs the ring filled once
+    if (now - _intervalStart >= TREND_INTERVAL_MS * TREND_POINTS) {
+        _intervalStart = now - TREND_INTERVAL_MS * TREND_POINTS;
+    }
+    while (now - _intervalStart >= TREND_INTERVAL_MS) {
+        closeInterval();
+        _intervalStart += TREND_INTERVAL_MS;
+    }
+    
+    _levelSum += level;
+    _inflowSum += inflow;
+    _samples++;
+}
+
+void TrendHistory::closeInterval() {
+    if (_samples > 0) {
+        push(toTenths(_levelSum / _samples), toTenths(_inflowSum / _samples));
+    } else if (_count > 0) {
+        int last = (_head + TREND_POINTS - 1) % TREND_POINTS;
+        push(_level[last], _inflow[last]);
+    }
+    
+    _levelSum = 0;
+    _inflowSum = 0;
+    _samples = 0;
+}
+
+void TrendHistory::push(int16_t level, int16_t inflow) {
+    _level[_head] = level;
+    _inflow[_head] = inflow;
+    _head = (_head + 1) % TREND_POINTS;
+    if (_count < TREND_POINTS) _count++;
+    _version++;
+}
+
+float TrendHistory::getLevel(int index) const {
+    if (index < 0 || index >= _count) return 0;
+    return _level[(_head + TREND_POINTS - _count + index) % TREND_POINTS] / 10.0f;
+}
+
+float TrendHistory::getInflow(int index) const {
+    if (index < 0 || index >= _count) return 0;
+    return _inflow[(_head + TREND_POINTS - _count + index) % TREND_POINTS] / 10.0f;
+}
+
+void TrendHistory::updateDays(WaterTracker* tracker) {
+    long today = TimeUtils::localDayNumber(time(nullptr));
+    if (today == _dayNumber || !tracker) return;
+    _dayNumber = today;
+    
+    // Newest first; keep the closed days in the chart's range
+    DailyUsage usage[30];
+    int count = 0;
+    float days[TREND_DAYS - 1] = {};
+    if (tracker->getLast30Days(usage, count)) {
+        for (int i = 0; i < count; i++) {
+            long age = today - TimeUtils::localDayNumber(usage[i].date);
+            if (age >= 1 && age < TREND_DAYS) days[TREND_DAYS - 1 - age] = usage[i].totalUsageLiters;
+        }
+    }
+    setDays(days, TREND_DAYS - 1);
+}
+
+void TrendHistory::setDays(const float* liters, int count) {
+    memset(_days, 0, sizeof(_days));
+    
+    // Right-aligned: the last entry is yesterday
+    int n = min(count, TREND_DAYS - 1);
+    for (int i = 0; i < n; i++) {
+        _days[TREND_DAYS - 1 - n + i] = liters[count - n + i];
+    }
+    _version++;
+}
+
+float TrendHistory::getDay(int index) const {
+    if (index < 0 || index >= TREND_DAYS - 1) return 0;
+    return _days[index];
+}
@@ -75,6 +75,31 @@ unsigned long TimeUtils::getTodayMidnight() {
     return mktime(timeinfo);
 }
 
+long TimeUtils::localDayNumber(unsigned long timestamp) {
+    time_t rawtime = timestamp;
+    struct tm* timeinfo = localtime(&rawtime);
+    return daysFromCivil(timeinfo->tm_year + 1900, timeinfo->tm_mon + 1, timeinfo->tm_mday);
+}
+
+long TimeUtils::daysFromCivil(int year, int month, int day) {
+    // Howard Hinnant's days_from_civil, proleptic Gregorian calendar
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yoe = (unsigned)(year - era * 400);
+    unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long)doe - 719468;
+}
+
+unsigned long TimeUtils::dayNumberToTimestamp(long dayNumber) {
+    // Local midnight of the given day (mktime normalizes the day overflow)
+    struct tm timeinfo = {};
+    timeinfo.tm_year = 70;
+    timeinfo.tm_mday = 1 + dayNumber;
+    timeinfo.tm_isdst = -1;
+    return mktime(&timeinfo);
+}
+
 bool TimeUtils::syncTimeNTP(const char* ntpServer) {
     configTime(0, 0, ntpServer);
     
@@ -1,6 +1,7 @@
 // water_tracker.cpp
 #include "water_tracker.h"
 #include "config.h"
+#include "utils.h"
 
 WaterTracker::WaterTracker() 
     : _storage(nullptr),
@@ -10,10 +11,26 @@ WaterTracker::WaterTracker()
       _currentPumpState(false),
       _previousPumpState(false),
       _lastUpdateTime(0),
-      _lastMidnightCheck(0),
       _todayUsageLiters(0),
       _todayCycles(0),
-      _todayStartTimestamp(0) {
+      _todayPumpMs(0),
+      _todayPeakInflow(0),
+      _todayStartTimestamp(0),
+      _usageDirty(false),
+      _lastUsageSaveMs(0),
+      _todayPending(false),
+      _pumpRate(0),
+      _savedPumpRate(0),
+      _pumpRateProvisional(false),
+      _pumpStartMs(0),
+      _pumpRefMs(0),
+      _pumpRefVolume(0),
+      _pumpShortfall(0),
+      _fillRefMs(0),
+      _fillRefVolume(0),
+      _fillDrawn(0),
+      _idleRefLevel(0),
+      _idleRefValid(false) {
 }
 
 void WaterTracker::begin(StorageManager* storage, TankCalculator* calculator) {
@@ -27,10 +44,21 @@ void WaterTracker::begin(StorageManager* storage, TankCalculator* calculator) {
     if (_storage->getDailyUsage(todayTimestamp, todayData)) {
         _todayUsageLiters = todayData.totalUsageLiters;
         _todayCycles = todayData.pumpCycles;
+        _todayPumpMs = (unsigned long)todayData.pumpMinutes * 60000;
+        _todayPeakInflow = todayData.peakInflow;
         _todayStartTimestamp = todayData.date;
     } else {
         _todayStartTimestamp = todayTimestamp;
     }
+    _todayPending = !TimeUtils::isTimeSynced();
+    
+    _storage->loadUsageTotals(_totals);   // Rolled/seeded once the clock is valid
+    _rollover.begin(onRollover, this);
+    _pumpRate = _storage->loadPumpRate();
+    _savedPumpRate = _pumpRate;
+    _draws.begin(storage);
+    _leak.begin(storage);
+    _profile.begin(storage);
     
     #if ENABLE_SERIAL_DEBUG
     Serial.println("Water tracker initialized");
@@ -41,12 +69,14 @@ void WaterTracker::begin(StorageManager* storage, TankCalculator* calculator) {
 }
 
 void WaterTracker::loop() {
-    // Check if it's past midnight
-    if (millis() - _lastMidnightCheck > 60000) { // Check every minute
-        _lastMidnightCheck = millis();
-        if (isMidnight()) {
-            resetDaily();
-        }
+    // Day/week/month rollovers (deadline based, catches up after stalls)
+    _rollover.loop();
+    _profile.loop();
+    
+    // Draws arrive every few seconds; persisting each one cost ~8 NVS
+    // writes (day record, totals, journal). Save them in batches instead.
+    if (_usageDirty && millis() - _lastUsageSaveMs >= USAGE_SAVE_INTERVAL_MS) {
+        saveDailyData();
     }
 }
 
@@ -57,36 +87,72 @@ void WaterTracker::updateState(float waterLevel, bool pumpState, float currentIn
     _currentLevel = waterLevel;
     _currentPumpState = pumpState;
     
+    unsigned long now = millis();
+    float volume = _calculator->levelToVolume(waterLevel);
+    float drawLiters = 0;
+    
+    // Pump run time and peak inflow for the daily record
+    if (_previousPumpState && _lastUpdateTime > 0) {
+        _todayPumpMs += now - _lastUpdateTime;
+    }
+    if (currentInflow > _todayPeakInflow) {
+        _todayPeakInflow = currentInflow;
+    }
+    
     // Detect pump state changes
     if (pumpState && !_previousPumpState) {
-        // Pump turned ON
+        // Pump turned ON - start the delivery accounting window
         _todayCycles++;
+        _pumpStartMs = now;
+        _pumpRefMs = now;
+        _pumpRefVolume = volume;
+        _pumpShortfall = 0;
+        
+        // Without a learned rate the refill masks outflow, so end any open draw
+        if (_pumpRate <= 0) _draws.closeEvent();
         
         #if ENABLE_SERIAL_DEBUG
         Serial.println("Pump cycle detected");
         #endif
+    } else if (!pumpState && _previousPumpState) {
+        // Pump turned OFF - account the last partial window, record run time
+        drawLiters = accountPumping(volume, now, true);
+        savePumpRate();
+        saveDailyData();
+    } else if (pumpState) {
+        // Pumping - consumption = expected delivery - observed rise
+        drawLiters = accountPumping(volume, now, false);
     }
     
-    // Detect water usage (level decrease when pump is off)
-    if (!pumpState && _previousLevel > _currentLevel) {
-        float levelDrop = _previousLevel - _currentLevel;
-        float volumeUsed = _calculator->levelToVolume(levelDrop);
-        
-        if (volumeUsed > 0 && volumeUsed < 100) { // Sanity check (less than 100L at once)
-            _todayUsageLiters += volumeUsed;
-            
-            #if ENABLE_SERIAL_DEBUG
-            Serial.print("Water usage detected: ");
-            Serial.print(volumeUsed);
-            Serial.println(" L");
-            #endif
+    // Detect water usage (level decrease when pump is off). Drops are
+    // measured from a reference level that only moves by more than
+    // USAGE_DEADBAND_PCT, so reading-to-reading noise isn't booked as draws.
+    // TODO: Noise well above the deadband still ratchets the reference and
+    // is booked as usage; book against a filtered level instead
+    if (!pumpState) {
+        if (_previousPumpState || !_idleRefValid) {
+            _idleRefLevel = _currentLevel;
+            _idleRefValid = true;
+        } else if (_currentLevel < _idleRefLevel - USAGE_DEADBAND_PCT) {
+            float volumeUsed = _calculator->levelToVolume(_idleRefLevel - _currentLevel);
             
-            // Save updated daily data
-            saveDailyData();
+            if (volumeUsed < 100) { // Sanity check (less than 100L at once)
+                drawLiters += volumeUsed;
+            }
+            _idleRefLevel = _currentLevel;
+        } else if (_currentLevel > _idleRefLevel + USAGE_DEADBAND_PCT) {
+            _idleRefLevel = _currentLevel;
         }
     }
     
-    _lastUpdateTime = millis();
+    if (drawLiters > 0) {
+        addUsage(drawLiters);
+    }
+    
+    _draws.addSample(drawLiters, now);
+    _leak.addSample(volume, pumpState, now);
+    
+    _lastUpdateTime = now;
 }
 
 float WaterTracker::getTodayUsage() {
@@ -94,16 +160,19 @@ float WaterTracker::getTodayUsage() {
 }
 
 float WaterTracker::getMonthUsage() {
-    if (!_storage) return 0;
-    
-    // Get current date
-    time_t now = time(nullptr);
-    struct tm* timeinfo = localtime(&now);
-    
-    float totalUsage = 0;
-    _storage->getMonthlyUsage(timeinfo->tm_year + 1900, timeinfo->tm_mon + 1, totalUsage);
-    
-    return totalUsage;
+    return _totals.monthUsageLiters;
+}
+
+float WaterTracker::getWeekUsage() {
+    return _totals.weekUsageLiters;
+}
+
+float WaterTracker::getYearUsage() {
+    return _totals.yearUsageLiters;
+}
+
+float WaterTracker::getPumpRate() {
+    return _pumpRate;
 }
 
 int WaterTracker::getTodayCycles() {
@@ -116,29 +185,44 @@ bool WaterTracker::getLast30Days(DailyUsage* usageArray, int& count) {
     return _storage->getLast30DaysUsage(usageArray, count);
 }
 
+void WaterTracker::buildDrawEventReport(JsonDocument& doc) {
+    _draws.buildReport(doc);
+}
+
+const DemandProfile* WaterTracker::getDemandProfile() {
+    return &_profile;
+}
+
+void WaterTracker::buildProfileReport(JsonDocument& doc) {
+    _profile.buildReport(doc);
+}
+
+bool WaterTracker::isLeakAlarm() {
+    return _leak.isAlarmActive();
+}
+
+void WaterTracker::buildLeakReport(JsonDocument& doc) {
+    _leak.buildReport(doc);
+}
+
 void WaterTracker::resetDaily() {
-    #if ENABLE_SERIAL_DEBUG
-    Serial.println("Midnight detected - Resetting daily usage");
-    Serial.print("Total usage yesterday: ");
-    Serial.print(_todayUsageLiters);
-    Serial.println(" L");
-    #endif
-    
-    // Save final data for the day
-    saveDailyData();
-    
-    // Reset counters
-    _todayUsageLiters = 0;
-    _todayCycles = 0;
-    _todayStartTimestamp = getMidnightTimestamp();
-    
-    // Save new empty daily record
-    saveDailyData();
+    closeDay(getMidnightTimestamp());
+}
+
+void WaterTracker::flush() {
+    if (_usageDirty) saveDailyData();
 }
 
 void WaterTracker::resetAll() {
+    // Today's usage no longer counts towards the running totals
+    _totals.monthUsageLiters = max(0.0f, _totals.monthUsageLiters - _todayUsageLiters);
+    _totals.yearUsageLiters = max(0.0f, _totals.yearUsageLiters - _todayUsageLiters);
+    _totals.weekUsageLiters = max(0.0f, _totals.weekUsageLiters - _todayUsageLiters);
+    
     _todayUsageLiters = 0;
     _todayCycles = 0;
+    _todayPumpMs = 0;
+    _todayPeakInflow = 0;
     _todayStartTimestamp = getMidnightTimestamp();
     saveDailyData();
     
@@ -147,36 +231,261 @@ void WaterTracker::resetAll() {
     #endif
 }
 
+void WaterTracker::addUsage(float liters) {
+    _todayUsageLiters += liters;
+    _totals.weekUsageLiters += liters;
+    _totals.monthUsageLiters += liters;
+    _totals.yearUsageLiters += liters;
+    _profile.addUsage(liters);
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Water usage detected: ");
+    Serial.print(liters);
+    Serial.println(_currentPumpState ? " L (during fill)" : " L");
+    #endif
+    
+    // Saved by loop() on the coalescing interval, or at pump stop / rollover
+    _usageDirty = true;
+}
+
+// Splits the level change while pumping into delivery and consumption.
+// Called per reading; works in PUMP_ACCOUNT_INTERVAL_MS windows so the
+// sensor's quantization averages out. Returns liters drawn in the window.
+float WaterTracker::accountPumping(float volume, unsigned long now, bool pumpStopped) {
+    unsigned long elapsed = now - _pumpRefMs;
+    if (!pumpStopped && elapsed < PUMP_ACCOUNT_INTERVAL_MS) return 0;
+    
+    float observed = volume - _pumpRefVolume;
+    bool settled = _pumpRefMs - _pumpStartMs >= PUMP_SETTLE_MS;
+    if (!settled) {
+        _fillRefMs = now;
+        _fillRefVolume = volume;
+        _fillDrawn = 0;
+    }
+    
+    _pumpRefMs = now;
+    _pumpRefVolume = volume;
+    
+    // With no rate yet, the first fill's mean rate so far stands in for it
+    if ((_pumpRate <= 0 || _pumpRateProvisional) && settled && !pumpStopped && volume > _fillRefVolume) {
+        _pumpRate = (volume - _fillRefVolume) / ((now - _fillRefMs) / 60000.0);
+        _pumpRateProvisional = true;
+    }
+    
+    // Skip the spin-up window and stubs too short to measure
+    float drawn = 0;
+    if (settled && elapsed >= SENSOR_SAMPLE_INTERVAL_MS && _pumpRate > 0) {
+        // Shortfalls carry over between windows, so the reading noise in
+        // consecutive windows cancels instead of being booked when positive.
+        // Same deadband as idle draws, and surplus is bounded the same way.
+        float deadband = _calculator->levelToVolume(USAGE_DEADBAND_PCT);
+        _pumpShortfall += _pumpRate * elapsed / 60000.0 - observed;
+        if (_pumpShortfall > deadband) {
+            drawn = _pumpShortfall;
+            _pumpShortfall = 0;
+        } else if (_pumpShortfall < -deadband) {
+            _pumpShortfall = -deadband;
+        }
+        if (drawn >= 100) drawn = 0; // Same sanity limit as idle draws
+        _fillDrawn += drawn;
+    }
+    
+    // At pump stop, the whole fill after spin-up is balanced at once. The
+    // windows' deadband and surplus bound let small or early draws slip
+    // through, so whatever the fill's balance exceeds their bookings by is
+    // booked now. A single window's rise also carries the full reading
+    // noise (~20 % of the rate at 60 s), so the rate is learned per fill.
+    if (pumpStopped && settled && now - _fillRefMs >= PUMP_ACCOUNT_INTERVAL_MS) {
+        float fillMinutes = (now - _fillRefMs) / 60000.0;
+        float fillRise = volume - _fillRefVolume;
+        if (_pumpRate > 0 && !_pumpRateProvisional) {
+            float missed = _pumpRate * fillMinutes - fillRise - _fillDrawn;
+            if (missed > 0 && drawn + missed < 100) drawn += missed;
+        }
+        if (_pumpRateProvisional) _pumpRate = 0;
+        _pumpRateProvisional = false;
+        learnPumpRate(fillRise / fillMinutes);
+    }
+    return drawn;
+}
+
+// Upper-envelope EWMA: fills near the estimate refine it, clearly faster
+// fills pull it up quickly, slower fills are assumed to include a draw
+void WaterTracker::learnPumpRate(float observedRate) {
+    if (observedRate <= 0) return;
+    
+    if (_pumpRate <= 0) {
+        _pumpRate = observedRate;
+    } else if (observedRate > _pumpRate * (1 + PUMP_RATE_TOLERANCE)) {
+        _pumpRate += PUMP_RATE_ALPHA_UP * (observedRate - _pumpRate);
+    } else if (observedRate >= _pumpRate * (1 - PUMP_RATE_TOLERANCE)) {
+        _pumpRate += PUMP_RATE_ALPHA * (observedRate - _pumpRate);
+    }
+}
+
+void WaterTracker::savePumpRate() {
+    if (!_storage || _pumpRate <= 0 || _pumpRateProvisional) return;
+    
+    // Once per fill at most, and only when the estimate actually moved
+    if (fabs(_pumpRate - _savedPumpRate) > _savedPumpRate * 0.01) {
+        _storage->savePumpRate(_pumpRate);
+        _savedPumpRate = _pumpRate;
+    }
+}
+
 void WaterTracker::detectUsage() {
     // This is called periodically to detect usage patterns
     // Can be extended for ML feature extraction
 }
 
 void WaterTracker::saveDailyData() {
-    if (!_storage) return;
+    // Before the first clock sync the day and totals would be keyed to 1970;
+    // keep counting in RAM, the ROLLOVER_ANCHOR event saves once time is valid
+    if (!_storage || !TimeUtils::isTimeSynced()) return;
     
     DailyUsage todayData;
     todayData.date = _todayStartTimestamp;
     todayData.totalUsageLiters = _todayUsageLiters;
     todayData.pumpCycles = _todayCycles;
+    todayData.pumpMinutes = _todayPumpMs / 60000;
+    todayData.peakInflow = _todayPeakInflow;
+    
+    if (_storage->saveDailyUsage(todayData, _totals)) {
+        _usageDirty = false;
+    }
+    _lastUsageSaveMs = millis();
+}
+
+void WaterTracker::onRollover(RolloverEvent event, time_t /* closedStart */, time_t nextStart, void* context) {
+    WaterTracker* tracker = (WaterTracker*)context;
+    
+    switch (event) {
+        case ROLLOVER_ANCHOR:
+            // Clock just became valid (or stepped back): re-base today and the totals
+            if (TimeUtils::localDayNumber(tracker->_todayStartTimestamp) !=
+                TimeUtils::localDayNumber(nextStart)) {
+                tracker->rebaseToday(nextStart);
+            }
+            if (tracker->_totals.year == 0) {
+                tracker->seedTotals();
+            } else {
+                tracker->rollTotals();
+            }
+            tracker->saveDailyData();
+            break;
+        case ROLLOVER_DAY:
+            tracker->closeDay(nextStart);
+            break;
+        case ROLLOVER_WEEK:
+        case ROLLOVER_MONTH:
+            tracker->rollTotals();
+            tracker->saveDailyData();
+            break;
+    }
+}
+
+// Moves today to dayStart. If begin() ran before the clock was valid, today's
+// stored record (from before a reboot) wasn't loaded: add it to what was
+// counted since boot.
+void WaterTracker::rebaseToday(unsigned long dayStart) {
+    DailyUsage stored;
+    if (_todayPending && _storage->getDailyUsage(dayStart, stored)) {
+        _todayUsageLiters += stored.totalUsageLiters;
+        _todayCycles += stored.pumpCycles;
+        _todayPumpMs += (unsigned long)stored.pumpMinutes * 60000;
+        _todayPeakInflow = max(_todayPeakInflow, stored.peakInflow);
+    }
+    _todayStartTimestamp = dayStart;
+    _todayPending = false;
+}
+
+void WaterTracker::closeDay(unsigned long nextDayStart) {
+    #if ENABLE_SERIAL_DEBUG
+    Serial.println("Day closed - Resetting daily usage");
+    Serial.print("Total usage: ");
+    Serial.print(_todayUsageLiters);
+    Serial.println(" L");
+    #endif
+    
+    // Save final data for the day
+    saveDailyData();
+    _draws.closeEvent();
+    _draws.flush();
     
-    _storage->saveDailyUsage(todayData);
+    // Reset counters
+    _todayUsageLiters = 0;
+    _todayCycles = 0;
+    _todayPumpMs = 0;
+    _todayPeakInflow = 0;
+    _todayStartTimestamp = nextDayStart;
+    
+    // Save new empty daily record
+    saveDailyData();
 }
 
-bool WaterTracker::isMidnight() {
+void WaterTracker::seedTotals() {
+    // First run with totals support: seed once from the daily records
     time_t now = time(nullptr);
     struct tm* timeinfo = localtime(&now);
+    int year = timeinfo->tm_year + 1900;
+    int month = timeinfo->tm_mon + 1;
+    
+    _totals.year = year;
+    _totals.month = month;
+    _totals.yearUsageLiters = 0;
+    
+    for (int m = 1; m <= month; m++) {
+        float monthLiters = 0;
+        _storage->getMonthlyUsage(year, m, monthLiters);
+        _totals.yearUsageLiters += monthLiters;
+        if (m == month) _totals.monthUsageLiters = monthLiters;
+    }
     
-    // Check if it's within 1 minute of midnight
-    if (timeinfo->tm_hour == 0 && timeinfo->tm_min == 0) {
-        // Make sure we only trigger once per day
-        unsigned long todayMidnight = getMidnightTimestamp();
-        if (todayMidnight != _todayStartTimestamp) {
-            return true;
+    _totals.weekStartDay = TimeUtils::localDayNumber(RolloverScheduler::periodStart(ROLLOVER_WEEK, now));
+    _totals.weekUsageLiters = 0;
+    long today = TimeUtils::localDayNumber(now);
+    DailyUsage days[7];
+    int count = 0;
+    if (_storage->getUsageDays(_totals.weekStartDay, today - _totals.weekStartDay + 1, days, count)) {
+        for (int i = 0; i < count; i++) {
+            _totals.weekUsageLiters += days[i].totalUsageLiters;
         }
     }
     
-    return false;
+    #if ENABLE_SERIAL_DEBUG
+    Serial.print("Usage totals seeded from history: ");
+    Serial.print(_totals.monthUsageLiters);
+    Serial.println(" L this month");
+    #endif
+}
+
+// Starts new week/month/year totals for periods that no longer contain now
+void WaterTracker::rollTotals() {
+    if (!TimeUtils::isTimeSynced()) return;
+    
+    time_t now = time(nullptr);
+    struct tm* timeinfo = localtime(&now);
+    int year = timeinfo->tm_year + 1900;
+    int month = timeinfo->tm_mon + 1;
+    long weekStartDay = TimeUtils::localDayNumber(RolloverScheduler::periodStart(ROLLOVER_WEEK, now));
+    
+    if (weekStartDay != _totals.weekStartDay) {
+        _totals.weekUsageLiters = 0;
+        _totals.weekStartDay = weekStartDay;
+    }
+    
+    if (year == _totals.year && month == _totals.month) return;
+    
+    if (year != _totals.year) {
+        _totals.yearUsageLiters = 0;
+    }
+    _totals.monthUsageLiters = 0;
+    _totals.year = year;
+    _totals.month = month;
+    
+    #if ENABLE_SERIAL_DEBUG
+    Serial.println("New month - usage totals rolled over");
+    #endif
 }
 
 unsigned long WaterTracker::getMidnightTimestamp() {
@@ -1,21 +1,23 @@
 // webserver_local.cpp
 #include "webserver_local.h"
 #include "config.h"
+#include "fault_injection.h"
+#include <memory>
 
 WebServerLocal::WebServerLocal() 
     : _server(nullptr),
-      _storage(nullptr),
       _calculator(nullptr),
-      _pump(nullptr),
       _tracker(nullptr),
-      _isRunning(false),
-      _waterLevel(0),
-      _currentInflow(0),
-      _maxInflow(0) {
+      _snapshot(nullptr),
+      _commands(nullptr),
+      _scheduler(nullptr),
+      _eventBus(nullptr),
+      _trace(nullptr),
+      _isRunning(false) {
 }
 
-bool WebServerLocal::begin(StorageManager* storage, TankCalculator* calculator,
-                           PumpController* pump, WaterTracker* tracker) {
+bool WebServerLocal::begin(TankCalculator* calculator, WaterTracker* tracker,
+                           const SnapshotBuffer* snapshot, ControlQueue* commands) {
     #if !SIMULATION_MODE
     // Check if WiFi is available (either connected to network OR in AP mode)
     bool isAPMode = (WiFi.getMode() == WIFI_AP || WiFi.getMode() == WIFI_AP_STA);
@@ -27,10 +29,10 @@ bool WebServerLocal::begin(StorageManager* storage, TankCalculator* calculator,
     }
     #endif
     
-    _storage = storage;
     _calculator = calculator;
-    _pump = pump;
     _tracker = tracker;
+    _snapshot = snapshot;
+    _commands = commands;
     
     // Create server instance
     _server = new AsyncWebServer(WEBSERVER_PORT);
@@ -48,7 +50,7 @@ bool WebServerLocal::begin(StorageManager* storage, TankCalculator* calculator,
     // Start server
     _server->begin();
     _isRunning = true;
-
+    
     #if ENABLE_SERIAL_DEBUG
     Serial.println("=================================");
     Serial.println("WEB SERVER STARTED");
@@ -69,10 +71,16 @@ bool WebServerLocal::begin(StorageManager* storage, TankCalculator* calculator,
     return true;
 }
 
-void WebServerLocal::updateData(float waterLevel, float currentInflow, float maxInflow) {
-    _waterLevel = waterLevel;
-    _currentInflow = currentInflow;
-    _maxInflow = maxInflow;
+void WebServerLocal::setScheduler(TaskScheduler* scheduler) {
+    _scheduler = scheduler;
+}
+
+void WebServerLocal::setEventBus(EventBus* bus) {
+    _eventBus = bus;
+}
+
+void WebServerLocal::setTraceRecorder(TraceRecorder* trace) {
+    _trace = trace;
 }
 
 bool WebServerLocal::isRunning() {
@@ -97,44 +105,44 @@ void WebServerLocal::setupRoutes() {
     _server->on("/", HTTP_GET, [this](AsyncWebServerRequest* request) {
         handleRoot(request);
     });
-
+    
     // API endpoints
     _server->on("/api/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
         handleStatus(request);
     });
-
+    
     _server->on("/api/telemetry", HTTP_GET, [this](AsyncWebServerRequest* request) {
         handleTelemetry(request);
     });
-
+    
     _server->on("/api/pump/on", HTTP_POST, [this](AsyncWebServerRequest* request) {
         handlePumpOn(request);
     });
-
+    
     _server->on("/api/pump/off", HTTP_POST, [this](AsyncWebServerRequest* request) {
         handlePumpOff(request);
     });
-
+    
     _server->on("/api/mode", HTTP_POST, [this](AsyncWebServerRequest* request) {
         handleSetMode(request);
     });
-
+    
     _server->on("/api/config", HTTP_GET, [this](AsyncWebServerRequest* request) {
         handleGetConfig(request);
     });
-
+    
     _server->on("/api/config", HTTP_POST, [this](AsyncWebServerRequest* request) {
         handleSetConfig(request);
     });
-
+    
     _server->on("/api/wifi/scan", HTTP_GET, [this](AsyncWebServerRequest* request) {
         handleWiFiScan(request);
     });
-
+    
     _server->on("/api/wifi/connect", HTTP_POST, [this](AsyncWebServerRequest* request) {
         handleWiFiConnect(request);
     });
-
+    
     // Setup endpoint with body parser
     _server->on("/api/setup", HTTP_POST,
         [this](AsyncWebServerRequest* request) {},
@@ -142,11 +150,65 @@ void WebServerLocal::setupRoutes() {
         [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
             handleSetup(request, data, len, index, total);
         });
-
+    
+    // More specific /api/usage/* routes first: handlers also match sub-paths
+    _server->on("/api/usage/events", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleUsageEvents(request);
+    });
+    
+    _server->on("/api/usage/profile", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleUsageProfile(request);
+    });
+    
     _server->on("/api/usage", HTTP_GET, [this](AsyncWebServerRequest* request) {
         handleUsageStats(request);
     });
-
+    
+    // History export (chunked CSV / NDJSON)
+    _server->on("/api/export/daily", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleExport(request, EXPORT_DAILY);
+    });
+    
+    _server->on("/api/export/cycles", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleExport(request, EXPORT_CYCLES);
+    });
+    
+    _server->on("/api/diagnostics/storage", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleStorageDiagnostics(request);
+    });
+    
+    _server->on("/api/diagnostics/tasks", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleTaskDiagnostics(request);
+    });
+    
+    _server->on("/api/diagnostics/perf", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handlePerfDiagnostics(request);
+    });
+    
+    _server->on("/api/diagnostics/events", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleEventDiagnostics(request);
+    });
+    
+    _server->on("/api/diagnostics/trace", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleTraceDiagnostics(request);
+    });
+    
+    // Input trace download (binary, replay with the native build)
+    _server->on("/api/trace", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleTraceDownload(request);
+    });
+    
+    #if ENABLE_FAULT_INJECTION
+    // Fault injection (test builds only)
+    _server->on("/api/debug/faults", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleFaults(request);
+    });
+    
+    _server->on("/api/debug/faults", HTTP_POST, [this](AsyncWebServerRequest* request) {
+        handleFaults(request);
+    });
+    #endif
+    
     // 404 handler
     _server->onNotFound([](AsyncWebServerRequest* request) {
         request->send(404, "application/json", "{\"error\":\"Not found\"}");
@@ -155,7 +217,7 @@ void WebServerLocal::setupRoutes() {
 
 void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
     // Check if we're in first-time setup mode
-    if (_storage && _storage->isFirstTimeSetup()) {
+    if (_storage.isFirstTimeSetup()) {
         // Serve setup page
         const char setupHtml[] = R"rawliteral(
 <!DOCTYPE html>
@@ -190,7 +252,7 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
         <h1>🚰 Smart Water Pump</h1>
         <div class="subtitle">First Time Setup</div>
         <div class="info">Configure your water tank and WiFi settings to get started</div>
-
+        
         <form id="setupForm">
             <div class="card">
                 <div class="section-title">Tank Configuration</div>
@@ -199,10 +261,10 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                     <option value="rectangular">Rectangular</option>
                     <option value="cylindrical">Cylindrical</option>
                 </select>
-
+                
                 <label>Tank Height (cm) *</label>
                 <input type="number" id="height" step="0.1" min="10" max="1000" required>
-
+                
                 <div id="rectangularFields">
                     <div class="form-row">
                         <div>
@@ -215,12 +277,12 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                         </div>
                     </div>
                 </div>
-
+                
                 <div id="cylindricalFields" style="display:none;">
                     <label>Radius (cm) *</label>
                     <input type="number" id="radius" step="0.1" min="5" max="500">
                 </div>
-
+                
                 <div class="form-row">
                     <div>
                         <label>Lower Threshold (%)</label>
@@ -232,37 +294,37 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                     </div>
                 </div>
             </div>
-
+            
             <div class="card">
                 <div class="section-title">WiFi Configuration (Optional)</div>
                 <label>WiFi SSID</label>
                 <input type="text" id="ssid" placeholder="Leave empty to skip WiFi setup">
-
+                
                 <label>WiFi Password</label>
                 <input type="password" id="password" placeholder="WiFi password">
             </div>
-
+            
             <button type="submit" class="btn-submit" id="submitBtn">Complete Setup</button>
             <div id="message" class="message"></div>
         </form>
     </div>
-
+    
     <script>
         function toggleShapeFields() {
             const shape = document.getElementById('shape').value;
             document.getElementById('rectangularFields').style.display = shape === 'rectangular' ? 'block' : 'none';
             document.getElementById('cylindricalFields').style.display = shape === 'cylindrical' ? 'block' : 'none';
         }
-
+        
         document.getElementById('setupForm').addEventListener('submit', async (e) => {
             e.preventDefault();
             const btn = document.getElementById('submitBtn');
             const msg = document.getElementById('message');
-
+            
             btn.disabled = true;
             btn.textContent = 'Saving...';
             msg.style.display = 'none';
-
+            
             const shape = document.getElementById('shape').value;
             const data = {
                 tankHeight: parseFloat(document.getElementById('height').value),
@@ -272,23 +334,23 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                 ssid: document.getElementById('ssid').value,
                 password: document.getElementById('password').value
             };
-
+            
             if (shape === 'rectangular') {
                 data.tankLength = parseFloat(document.getElementById('length').value);
                 data.tankWidth = parseFloat(document.getElementById('width').value);
             } else {
                 data.tankRadius = parseFloat(document.getElementById('radius').value);
             }
-
+            
             try {
                 const response = await fetch('/api/setup', {
                     method: 'POST',
                     headers: { 'Content-Type': 'application/json' },
                     body: JSON.stringify(data)
                 });
-
+                
                 const result = await response.json();
-
+                
                 if (result.success) {
                     msg.className = 'message success';
                     msg.textContent = 'Setup complete! Restarting...';
@@ -346,14 +408,14 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
 <body>
     <div class="container">
         <h1>Smart Water Pump</h1>
-
+        
         <div class="card">
             <div class="level-display" id="level">--</div>
             <div class="tank">
                 <div class="water" id="water" style="height: 0%"></div>
             </div>
         </div>
-
+        
         <div class="card">
             <div class="stats">
                 <div class="stat">
@@ -373,7 +435,7 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                     <div class="stat-value" id="daily">--</div>
                 </div>
             </div>
-
+            
             <div class="controls">
                 <button class="btn-on" onclick="controlPump('on')">Turn ON</button>
                 <button class="btn-off" onclick="controlPump('off')">Turn OFF</button>
@@ -381,7 +443,7 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
             </div>
         </div>
     </div>
-
+    
     <script>
         function updateData() {
             fetch('/api/telemetry')
@@ -396,7 +458,7 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                 })
                 .catch(e => console.error('Update failed:', e));
         }
-
+        
         function controlPump(action) {
             fetch('/api/pump/' + action, { method: 'POST' })
                 .then(r => r.json())
@@ -405,7 +467,7 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                     else alert(data.message || 'Failed');
                 });
         }
-
+        
         function setMode(mode) {
             fetch('/api/mode', {
                 method: 'POST',
@@ -417,7 +479,7 @@ void WebServerLocal::handleRoot(AsyncWebServerRequest* request) {
                     if (data.success) updateData();
                 });
         }
-
+        
         updateData();
         setInterval(updateData, 2000);
     </script>
@@ -443,16 +505,22 @@ void WebServerLocal::handleStatus(AsyncWebServerRequest* request) {
 }
 
 void WebServerLocal::handleTelemetry(AsyncWebServerRequest* request) {
+    SystemSnapshot snapshot;
+    if (!_snapshot || !_snapshot->read(snapshot)) {
+        request->send(503, "application/json", "{\"error\":\"No data yet\"}");
+        return;
+    }
+    
     JsonDocument doc;
-    doc["waterLevel"] = _waterLevel;
-    doc["currentInflow"] = _currentInflow;
-    doc["maxInflow"] = _maxInflow;
-    doc["motorState"] = _pump ? _pump->isOn() : false;
-    doc["mode"] = _pump ? (_pump->getMode() == AUTO_MODE ? "AUTO" : 
-                           _pump->getMode() == MANUAL_MODE ? "MANUAL" : "OVERRIDE") : "UNKNOWN";
-    doc["dailyUsage"] = _tracker ? _tracker->getTodayUsage() : 0.0;
-    doc["monthlyUsage"] = _tracker ? _tracker->getMonthUsage() : 0.0;
-    doc["timestamp"] = millis();
+    doc["waterLevel"] = snapshot.waterLevel;
+    doc["currentInflow"] = snapshot.currentInflow;
+    doc["maxInflow"] = snapshot.maxInflow;
+    doc["motorState"] = snapshot.motorState;
+    doc["mode"] = snapshot.mode == AUTO_MODE ? "AUTO" :
+                  snapshot.mode == MANUAL_MODE ? "MANUAL" : "OVERRIDE";
+    doc["dailyUsage"] = snapshot.dailyUsage;
+    doc["monthlyUsage"] = snapshot.monthlyUsage;
+    doc["timestamp"] = snapshot.timestamp;
     
     String response;
     serializeJson(doc, response);
@@ -463,37 +531,30 @@ void WebServerLocal::handleTelemetry(AsyncWebServerRequest* request) {
 }
 
 void WebServerLocal::handlePumpOn(AsyncWebServerRequest* request) {
-    JsonDocument doc;
-    
-    if (_pump) {
-        _pump->turnOn();
-        doc["success"] = true;
-        doc["message"] = "Pump turned on";
-    } else {
-        doc["success"] = false;
-        doc["message"] = "Pump controller not available";
-    }
-    
-    String response;
-    serializeJson(doc, response);
-    
-    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
-    addCORSHeaders(resp);
-    request->send(resp);
+    queuePumpCommand(request, CMD_PUMP_ON);
 }
 
 void WebServerLocal::handlePumpOff(AsyncWebServerRequest* request) {
-    JsonDocument doc;
+    queuePumpCommand(request, CMD_PUMP_OFF);
+}
+
+void WebServerLocal::queuePumpCommand(AsyncWebServerRequest* request, ControlCommandType type) {
+    if (!_commands) {
+        request->send(500, "application/json", "{\"success\":false,\"message\":\"Pump controller not available\"}");
+        return;
+    }
     
-    if (_pump) {
-        _pump->turnOff();
-        doc["success"] = true;
-        doc["message"] = "Pump turned off";
-    } else {
-        doc["success"] = false;
-        doc["message"] = "Pump controller not available";
+    // The control loop applies it on its next pass
+    ControlCommand command = { type };
+    if (!_commands->push(command)) {
+        request->send(503, "application/json", "{\"success\":false,\"message\":\"Busy, try again\"}");
+        return;
     }
     
+    JsonDocument doc;
+    doc["success"] = true;
+    doc["message"] = (type == CMD_PUMP_ON) ? "Pump on requested" : "Pump off requested";
+    
     String response;
     serializeJson(doc, response);
     
@@ -508,12 +569,7 @@ void WebServerLocal::handleSetMode(AsyncWebServerRequest* request) {
 }
 
 void WebServerLocal::handleGetConfig(AsyncWebServerRequest* request) {
-    if (!_storage) {
-        request->send(500, "application/json", "{\"error\":\"Storage not available\"}");
-        return;
-    }
-    
-    TankConfig config = _storage->loadTankConfig();
+    TankConfig config = _storage.loadTankConfig();
     
     JsonDocument doc;
     doc["tankHeight"] = config.tankHeight;
@@ -566,30 +622,30 @@ void WebServerLocal::handleWiFiConnect(AsyncWebServerRequest* request) {
 
 void WebServerLocal::handleSetup(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
     static String jsonBuffer;
-
+    
     // Accumulate the data
     if (index == 0) {
         jsonBuffer = "";
     }
-
+    
     for (size_t i = 0; i < len; i++) {
         jsonBuffer += (char)data[i];
     }
-
+    
     // Only process when all data is received
     if (index + len != total) {
         return;
     }
-
+    
     #if ENABLE_SERIAL_DEBUG
     Serial.println("Processing setup request...");
     Serial.println("Data: " + jsonBuffer);
     #endif
-
+    
     // Parse JSON
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, jsonBuffer);
-
+    
     if (error) {
         #if ENABLE_SERIAL_DEBUG
         Serial.print("JSON parse error: ");
@@ -599,21 +655,21 @@ void WebServerLocal::handleSetup(AsyncWebServerRequest* request, uint8_t* data,
         jsonBuffer = "";
         return;
     }
-
+    
     // Validate required fields
     if (!doc.containsKey("tankHeight") || !doc.containsKey("tankShape")) {
         request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing required fields\"}");
         jsonBuffer = "";
         return;
     }
-
+    
     // Load current config and update it
-    TankConfig config = _storage->loadTankConfig();
-
+    TankConfig config = _storage.loadTankConfig();
+    
     config.tankHeight = doc["tankHeight"];
     config.upperThreshold = doc.containsKey("upperThreshold") ? (float)doc["upperThreshold"] : DEFAULT_UPPER_THRESHOLD;
     config.lowerThreshold = doc.containsKey("lowerThreshold") ? (float)doc["lowerThreshold"] : DEFAULT_LOWER_THRESHOLD;
-
+    
     String shape = doc["tankShape"].as<String>();
     if (shape == "rectangular") {
         config.shape = RECTANGULAR;
@@ -636,35 +692,35 @@ void WebServerLocal::handleSetup(AsyncWebServerRequest* request, uint8_t* data,
         config.tankLength = 0.0;
         config.tankWidth = 0.0;
     }
-
+    
     // Mark setup as complete
     config.firstTimeSetup = false;
-
+    
     // Save configuration
-    if (!_storage->saveTankConfig(config)) {
+    if (!_storage.saveTankConfig(config)) {
         request->send(500, "application/json", "{\"success\":false,\"message\":\"Failed to save configuration\"}");
         jsonBuffer = "";
         return;
     }
-
+    
     // Save WiFi credentials if provided
     if (doc.containsKey("ssid") && doc["ssid"].as<String>().length() > 0) {
         String ssid = doc["ssid"];
         String password = doc.containsKey("password") ? doc["password"].as<String>() : "";
-        _storage->saveWiFiCredentials(ssid, password);
-
+        _storage.saveWiFiCredentials(ssid, password);
+        
         #if ENABLE_SERIAL_DEBUG
         Serial.println("WiFi credentials saved: " + ssid);
         #endif
     }
-
+    
     #if ENABLE_SERIAL_DEBUG
     Serial.println("Setup completed successfully!");
     #endif
-
+    
     // Send success response
     request->send(200, "application/json", "{\"success\":true,\"message\":\"Setup complete\"}");
-
+    
     jsonBuffer = "";
 }
 
@@ -674,10 +730,19 @@ void WebServerLocal::handleUsageStats(AsyncWebServerRequest* request) {
         return;
     }
     
+    SystemSnapshot snapshot;
+    if (!_snapshot || !_snapshot->read(snapshot)) {
+        request->send(503, "application/json", "{\"error\":\"No data yet\"}");
+        return;
+    }
+    
     JsonDocument doc;
-    doc["dailyUsage"] = _tracker->getTodayUsage();
-    doc["monthlyUsage"] = _tracker->getMonthUsage();
-    doc["todayCycles"] = _tracker->getTodayCycles();
+    doc["dailyUsage"] = snapshot.dailyUsage;
+    doc["weeklyUsage"] = snapshot.weeklyUsage;
+    doc["monthlyUsage"] = snapshot.monthlyUsage;
+    doc["todayCycles"] = snapshot.todayCycles;
+    doc["pumpRate"] = snapshot.pumpRate;
+    _tracker->buildLeakReport(doc);
     
     String response;
     serializeJson(doc, response);
@@ -687,6 +752,206 @@ void WebServerLocal::handleUsageStats(AsyncWebServerRequest* request) {
     request->send(resp);
 }
 
+void WebServerLocal::handleUsageEvents(AsyncWebServerRequest* request) {
+    if (!_tracker) {
+        request->send(500, "application/json", "{\"error\":\"Tracker not available\"}");
+        return;
+    }
+    
+    JsonDocument doc;
+    _tracker->buildDrawEventReport(doc);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+// 7x24 heatmap: rows are weekdays (Sunday first), columns hours
+void WebServerLocal::handleUsageProfile(AsyncWebServerRequest* request) {
+    if (!_tracker) {
+        request->send(500, "application/json", "{\"error\":\"Tracker not available\"}");
+        return;
+    }
+    
+    JsonDocument doc;
+    _tracker->buildProfileReport(doc);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+void WebServerLocal::handleStorageDiagnostics(AsyncWebServerRequest* request) {
+    JsonDocument doc;
+    FlashWearMonitor::buildReport(doc);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+void WebServerLocal::handleTaskDiagnostics(AsyncWebServerRequest* request) {
+    if (!_scheduler) {
+        request->send(503, "application/json", "{\"error\":\"Scheduler not available\"}");
+        return;
+    }
+    
+    JsonDocument doc;
+    _scheduler->buildReport(doc);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+void WebServerLocal::handleEventDiagnostics(AsyncWebServerRequest* request) {
+    if (!_eventBus) {
+        request->send(503, "application/json", "{\"error\":\"Event bus not available\"}");
+        return;
+    }
+    
+    JsonDocument doc;
+    _eventBus->buildReport(doc);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+void WebServerLocal::handleTraceDiagnostics(AsyncWebServerRequest* request) {
+    if (!_trace) {
+        request->send(503, "application/json", "{\"error\":\"Trace not available\"}");
+        return;
+    }
+    
+    JsonDocument doc;
+    _trace->buildReport(doc);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+// GET /api/trace - every flushed segment, oldest first
+void WebServerLocal::handleTraceDownload(AsyncWebServerRequest* request) {
+    if (!_trace || !_trace->isEnabled()) {
+        request->send(503, "application/json", "{\"error\":\"Trace not available\"}");
+        return;
+    }
+    
+    std::shared_ptr<TraceExporter> exporter = std::make_shared<TraceExporter>();
+    
+    AsyncWebServerResponse* resp = request->beginChunkedResponse(
+        "application/octet-stream",
+        [exporter](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return exporter->read(buffer, maxLen);
+        });
+    resp->addHeader("Content-Disposition", "attachment; filename=\"trace.bin\"");
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+#if ENABLE_FAULT_INJECTION
+// GET  /api/debug/faults - armed points and hit counters
+// POST /api/debug/faults?point=<name>&probability=<0..1>[&count=<n>][&delay=<ms>]
+// POST /api/debug/faults?clear=1 (or probability=0 to disarm one point)
+void WebServerLocal::handleFaults(AsyncWebServerRequest* request) {
+    if (request->method() == HTTP_POST) {
+        if (request->hasParam("clear")) {
+            FaultInjector::reset();
+        } else {
+            FaultPoint point;
+            if (!request->hasParam("point") ||
+                !FaultInjector::pointFromName(request->getParam("point")->value().c_str(), point)) {
+                request->send(400, "application/json", "{\"error\":\"Unknown fault point\"}");
+                return;
+            }
+            
+            float probability = request->hasParam("probability") ? request->getParam("probability")->value().toFloat() : 1.0;
+            long count = request->hasParam("count") ? request->getParam("count")->value().toInt() : -1;
+            long delayMs = request->hasParam("delay") ? request->getParam("delay")->value().toInt() : 0;
+            
+            if (probability > 0) FaultInjector::arm(point, probability, count, delayMs);
+            else FaultInjector::disarm(point);
+        }
+    }
+    
+    JsonDocument doc;
+    FaultInjector::buildReport(doc);
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+#endif
+
+// GET /api/diagnostics/perf[?reset=1]
+void WebServerLocal::handlePerfDiagnostics(AsyncWebServerRequest* request) {
+    JsonDocument doc;
+    loopProfiler.buildReport(doc);
+    
+    // Reset after reporting, so the reply still covers the finished window
+    if (request->hasParam("reset")) {
+        loopProfiler.reset();
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    
+    AsyncWebServerResponse* resp = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
+// GET /api/export/{daily|cycles}?format=csv|ndjson&from=<ts>&to=<ts>
+void WebServerLocal::handleExport(AsyncWebServerRequest* request, ExportKind kind) {
+    ExportFormat format = EXPORT_CSV;
+    if (request->hasParam("format")) {
+        String value = request->getParam("format")->value();
+        if (value == "ndjson") {
+            format = EXPORT_NDJSON;
+        } else if (value != "csv") {
+            request->send(400, "application/json", "{\"error\":\"format must be csv or ndjson\"}");
+            return;
+        }
+    }
+    
+    unsigned long from = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0;
+    unsigned long to = request->hasParam("to") ? request->getParam("to")->value().toInt() : 0;
+    
+    // Rows are produced on demand as the TCP stack asks for the next chunk
+    std::shared_ptr<HistoryExporter> exporter = std::make_shared<HistoryExporter>(kind, format, from, to);
+    
+    AsyncWebServerResponse* resp = request->beginChunkedResponse(
+        HistoryExporter::getContentType(format),
+        [exporter](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return exporter->read(buffer, maxLen);
+        });
+    addCORSHeaders(resp);
+    request->send(resp);
+}
+
 bool WebServerLocal::checkAuth(AsyncWebServerRequest* request) {
     // Implement authentication if WEB_ENABLE_AUTH is true
     return true;
@@ -3,6 +3,7 @@
 // ============================================
 #include "wifi_manager.h"
 #include "config.h"
+#include "fault_injection.h"
 
 WiFiManager::WiFiManager() 
     : _currentMode(WIFI_MODE_NULL),  // ✅ FIXED: Use WIFI_MODE_NULL
@@ -59,9 +60,10 @@ bool WiFiManager::connectToWiFi(const String& ssid, const String& password) {
     WiFi.begin(ssid.c_str(), password.c_str());
     
     _connectionStartTime = millis();
+    bool injectedFailure = FAULT_FIRES(FAULT_WIFI_CONNECT_FAIL);
     
     // Wait for connection with timeout
-    while (WiFi.status() != WL_CONNECTED) {
+    while (WiFi.status() != WL_CONNECTED || injectedFailure) {
         if (millis() - _connectionStartTime > WIFI_CONNECT_TIMEOUT_MS) {
             #if ENABLE_SERIAL_DEBUG
             Serial.println("WiFi connection timeout");
@@ -107,6 +109,7 @@ void WiFiManager::disconnect() {
 }
 
 bool WiFiManager::isConnected() {
+    if (FAULT_FIRES(FAULT_WIFI_DROP)) return false;
     return WiFi.status() == WL_CONNECTED;
 }
 